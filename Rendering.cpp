@@ -7,14 +7,23 @@
 #include <stdexcept>
 #include <functional>
 #include <cstdlib>
+#include <cmath>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <unordered_map>
 #include <set>
 #include <algorithm>
 #include <memory>
 #include <chrono>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include "glm/gtc/matrix_transform.hpp"
@@ -23,6 +32,25 @@
 #include "tiny_obj_loader.h"
 
 #include "types/VulkanTypes.h"
+#include "types/TextureCache.h"
+#include "types/VertexWelder.h"
+#include "types/MeshCache.h"
+#include "types/MeshOptimizer.h"
+#include "types/MeshSimplifier.h"
+#include "types/ObjReader.h"
+#include "types/Frustum.h"
+#include "types/SceneCuller.h"
+#include "types/RenderGraph.h"
+#include "types/AsyncTimewarp.h"
+#include "types/FrameTracer.h"
+#include "types/LatencyTracker.h"
+#include "types/PoseSource.h"
+#include "types/TripleBuffer.h"
+#include "types/QueueTimeline.h"
+#include "types/LatencyProfile.h"
+#include "types/StripScheduler.h"
+#include "types/GpuPassTimer.h"
+#include "types/QualityGovernor.h"
 using namespace vulkan;
 
 class RenderingApplication
@@ -52,27 +80,58 @@ private:
 	VkSurfaceFormatKHR choosenSurfaceFormat;
 	std::vector<VkImage> swapChainImages;
 	std::vector<VkImageView> swapChainImageViews;
-	std::vector<VkFramebuffer> swapChainframeBuffers;
+	// Distortion render pass, Owned by renderGraph
 	VkRenderPass renderPass;
 
 	VkDescriptorSetLayout descriptorSetLayout;
 
 	VkPipelineLayout pipelineLayout;
-	VkPipeline pipeLine;
-
-	// Vertex Buffer
-	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
+	// Mesh pipelines indexed by VertexLayout, Replaced geometry may come in either layout
+	std::array<VkPipeline, 2> meshPipeLines;
+	VkPipeline surfacePipeLine;
+
+	// Vertex and index buffers, Streams of mesh are gone after upload so only its counts, layout and bounds are valid
+	struct GeometrySlot {
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+		VkBuffer indicesBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory indicesBufferMemory = VK_NULL_HANDLE;
+		// MAX_INSTANCES transforms laid out for this mesh
+		VkBuffer instanceBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory instanceBufferMemory = VK_NULL_HANDLE;
+		VkDescriptorSet instanceDescriptorSet = VK_NULL_HANDLE;
+		MeshData mesh;
+	};
 
-	// Indices 
-	VkBuffer indicesBuffer;
-	VkDeviceMemory indicesBufferMemory;
+	// Active slot is drawn while replacement geometry gets uploaded into the other one
+	std::array<GeometrySlot, 2> geometrySlots;
+	uint32_t activeGeometrySlot = 0;
+
+	// GPU driven instancing, Instances are culled and assigned a detail level in compute and drawn with an indirect draw per level
+	static constexpr uint32_t MAX_INSTANCES = 16384;
+	// Geometry slots that can be alive at once including retired ones
+	static constexpr uint32_t MAX_INSTANCE_DESCRIPTOR_SETS = 8;
+
+	VkDescriptorSetLayout instanceDescriptorSetLayout;
+	VkPipeline cullPipeLine;
+	VkBuffer visibleInstanceBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory visibleInstanceBufferMemory = VK_NULL_HANDLE;
+	VkBuffer drawCommandBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory drawCommandBufferMemory = VK_NULL_HANDLE;
+	uint32_t instanceCount = 1;
+	// Pixels of simplification error allowed on display, 0 keeps every instance at full detail
+	float lodErrorThreshold = 1.0f;
 
 	// Uniform buffer
 	std::vector<VkBuffer> uniformBuffers;
 	std::vector<VkDeviceMemory> uniformBuffersMemory;
 	VkDescriptorPool descriptorPool;
 	std::vector<VkDescriptorSet> descriptorSets;
+	// Distortion pass uniforms of every swap chain image, Mapped for as long as they exist
+	std::vector<VkBuffer> distortionUniformBuffers;
+	std::vector<VkDeviceMemory> distortionUniformBuffersMemory;
+	std::vector<DistortionData*> distortionUniformData;
+	std::vector<VkDescriptorSet> distortionDescriptorSets;
 
 	// Image buffers
 	struct TextureData {
@@ -84,17 +143,63 @@ private:
 	};
 
 	std::vector<TextureData> textures;
+	TextureCache textureCache;
+
+	// Actions keys are bound to
+	enum class InputAction : uint32_t
+	{
+		IncreaseDistortion,
+		DecreaseDistortion,
+		ToggleDistortion,
+		CycleSurface,
+		NarrowSurface,
+		WidenSurface,
+		CycleInstances,
+		CycleLodError,
+		SwapModel,
+		CycleLatencyProfile,
+		Count
+	};
+
+	// Key releases counted per action so that simulation applies each of them even when it skips states in between
+	struct InputState
+	{
+		uint32_t actionCounts[(uint32_t)InputAction::Count] = {};
+		LatencyTracker::SampleId inputSample = 0;
+		// Frame tracer time of latest key release
+		double eventTime = -1.0;
+	};
 
-	VkSampleCountFlagBits msaaSampleBitsCount;
+	// Lens and scene settings input leads to, Render thread applies what differs from what it draws
+	struct FrameState
+	{
+		float distortionAlpha = 0;
+		uint32_t surfaceType = 0;
+		float surfaceAngle = 0;
+		uint32_t instanceCount = 1;
+		float lodErrorThreshold = 0;
+		uint32_t modelSwapCount = 0;
+		uint32_t latencyProfileCycleCount = 0;
+		LatencyTracker::SampleId inputSample = 0;
+		double inputTime = -1.0;
+	};
+
+	// Samples are spent on eye pass where geometry edges are, Distortion pass only resamples already antialiased eye images
+	uint32_t requestedEyePassSamples = 4;
+	uint32_t requestedDistortionPassSamples = 1;
+	VkSampleCountFlagBits eyePassSampleCount = VK_SAMPLE_COUNT_1_BIT;
+	VkSampleCountFlagBits distortionPassSampleCount = VK_SAMPLE_COUNT_1_BIT;
+	// Distortion pass samples asked for, Quality governor may drop distortionPassSampleCount to one sample and back
+	VkSampleCountFlagBits configuredDistortionPassSampleCount = VK_SAMPLE_COUNT_1_BIT;
+	// Clamped to device limit once device is picked
+	float samplerAnisotropy = 16.0f;
 
-	VkImage depthTexture;
-	VkDeviceMemory depthTextureMemory;
-	VkImageView depthTextureImageView;
 	VkFormat depthFormat;
 
-	VkImage msaaColorRenderTarget;
-	VkDeviceMemory colorRenderTargetMemory;
-	VkImageView colorRenderTargetImageView;
+	// Eye and distortion passes with all their attachments, Rebuilt with swap chain
+	RenderGraph renderGraph;
+	RenderGraph::PassId eyePassId;
+	RenderGraph::PassId distortionPassId;
 
 
 	VkCommandPool graphicsCmdPool;
@@ -106,36 +211,63 @@ private:
 	std::vector<VkSemaphore> imageAvailableSemaphores;
 	std::vector<VkSemaphore> imageRenderedSemaphores;
 	std::vector<VkFence> fences;
+	// One timeline per queue with VK_KHR_timeline_semaphore, Late stage gets its own even when it shares graphics queue
+	bool bUseTimelineSemaphores = true;
+	bool bHasTimelineSemaphores = false;
+	QueueTimeline graphicsTimeline;
+	QueueTimeline transferTimeline;
+	QueueTimeline lateTimeline;
+	// Value of distortion pass of last frame that used each frame slot
+	std::vector<uint64_t> frameTimelineValues;
+	// Distortion pass that last rendered into each swap chain image, By its graphics timeline value or fence of its frame slot
+	std::vector<uint64_t> imageTimelineValues;
+	std::vector<VkFence> imageFences;
+	uint64_t eyePassTimelineValue = 0;
+
+	// Frames in flight, swap chain and frame limiter, Measured latency and frame rate of every profile used is kept for the stats report
+	LatencyProfile latencyProfile;
+	VkPresentModeKHR swapChainPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+	bool bHasPresentWait = false;
+	static const uint64_t PRESENT_WAIT_TIMEOUT = 100000000;
+	uint64_t presentCount = 0;
+	uint64_t lastPresentId = 0;
+	std::vector<LatencyProfile::Stats> latencyProfileStats;
+	uint64_t latencyProfileStartFrame = 0;
+	double latencyProfileStartTime = 0;
+	uint32_t appliedLatencyProfileCycleCount = 0;
 
 	// Instance data
 	int currentFrame;
-	bool bIsWindowResized = false;
+	std::atomic<bool> bIsWindowResized{ false };
+	// Kept by main thread, Render thread cannot query window
+	std::atomic<int> framebufferWidth{ 0 };
+	std::atomic<int> framebufferHeight{ 0 };
 
 	std::vector<Vertex> vertices;
 
 	std::vector<uint32_t> indices;
 
+	// Geometry to upload, Streams point either into encoded vertices and indices or into mapped mesh cache entry
+	MeshData modelMesh;
+	MappedFile modelMeshMapping;
+	MeshCache meshCache;
+
+	VertexLayout preferredVertexLayout = VertexLayout::Compact;
+	std::vector<uint8_t> encodedVertices;
+	std::vector<uint8_t> encodedIndices;
+
 	// Multi view port data 
 	
 	VkRenderPass mvRenderPass;
 
-	/*
-	 *Depth Data
-	 */
-	VkImage mvDepthTexture;
-	VkImageView mvDepthTextureImageView;
-	VkDeviceMemory mvDepthTextureMemory;
-
 	/*
 	 *Color Texture
 	 */
-	VkImage mvColorTexture;
+	// Both eye images that eye pass renders and distortion pass samples, Owned by renderGraph
+	VkImage mvColorTextureImage;
 	VkImageView mvColorTextureImageView;
-	VkDeviceMemory mvColorTextureMemory;
 	VkSampler mvColorTextureSampler;
 
-	VkFramebuffer mvFramebuffer;
-
 	uint32_t noOfViews=2;
 
 	VkPipelineLayout mvPipelineLayout;
@@ -144,8 +276,8 @@ private:
 	VkDescriptorSetLayout textureDescriptorSetLayout;
 	VkDescriptorSet textureDescriptorSet;
 
-	VkFence mvTaskFence;
-	VkSemaphore mvRenderingSemaphore;
+	VkFence mvTaskFence = VK_NULL_HANDLE;
+	VkSemaphore mvRenderingSemaphore = VK_NULL_HANDLE;
 
 
 	std::vector<VkCommandBuffer> mvCmdBuffers;
@@ -157,8 +289,6 @@ private:
 
 public:
 
-	const int MAX_PARALLEL_FRAMES = 2;
-
 	const uint16_t WND_WIDTH = 1280, WND_HEIGHT = 720;
 
 	// Extensions that developer needs other than required Extensions for API Instance
@@ -193,1594 +323,4160 @@ public:
 		cleanUp();
 	}
 
-private:
+	// Takes effect when device is picked, Counts are rounded down to what device supports
+	void setMsaaSamples(uint32_t eyePassSamples, uint32_t distortionPassSamples)
+	{
+		requestedEyePassSamples = std::max(eyePassSamples, 1u);
+		requestedDistortionPassSamples = std::max(distortionPassSamples, 1u);
+	}
 
-	void initApp()
+	// Takes effect when device is created, Distortion pass then runs on late stage thread at display rate and positionalDepth in meters
+	// enables positional correction as if everything was that far away
+	void setAsyncTimewarp(bool bEnable, float positionalDepth)
 	{
-		currentDistAlpha = defaultDistortionAlpha;
-		initGLFW();
-		initVulkan();
+		bUseAsyncTimewarp = bEnable;
+		timewarpPositionalDepth = std::max(positionalDepth, 0.0f);
 	}
 
-	void mainLoop()
+	// Takes effect with asynchronous timewarp, Late stage submits distortion pass in stripCount horizontal strips that are each released
+	// lead seconds before scanout reaches them. Whole frames at once for 0
+	void setDistortionStrips(uint32_t stripCount, double lead)
 	{
-		while (!glfwWindowShouldClose(window))
+		distortionStripCount = std::min(stripCount, StripScheduler::MAX_STRIPS);
+		distortionStripLead = std::max(lead, 0.0);
+	}
+
+	// Takes effect when app starts, Head follows trajectory replayed from path which gets written with generated head motion first if it
+	// does not exist. Predictor extrapolates replayed poses to when frames are expected to reach the display unless it is null
+	void setPoseTrajectory(const std::string& path, const PosePredictor::Model* predictorModel)
+	{
+		if (!std::filesystem::exists(path))
 		{
-			glfwPollEvents();
-			drawFrame();
+			std::cout << "Writing synthetic pose trajectory " << path << std::endl;
+			TrajectoryPoseSource(TrajectoryPoseSource::generateHeadMotion(60.0, 1000.0, 1)).save(path);
 		}
 
-		vkDeviceWaitIdle(logicalDevice);
+		trajectory = std::make_unique<TrajectoryPoseSource>(path);
+		posePredictor = predictorModel != nullptr ? std::make_unique<PosePredictor>(*trajectory, *predictorModel) : nullptr;
+		poseSource = posePredictor ? (PoseSource*)posePredictor.get() : trajectory.get();
 	}
 
-	void cleanUp()
+	// Takes effect when device is created, Quality levels are stepped through so that GPU time of eye and distortion pass stays within
+	// targetFrameTime. Level changes are logged and written to logPath as CSV when app exits unless it is empty
+	void setQualityGovernor(double targetFrameTime, const std::string& logPath)
 	{
-		cleanSemaphores();
+		bUseQualityGovernor = targetFrameTime > 0.0;
+		qualityGovernorConfig.targetFrameTime = targetFrameTime;
+		qualityLogPath = logPath;
+	}
 
-		vkDestroyCommandPool(logicalDevice, graphicsCmdPool, nullptr);
-		vkDestroyBuffer(logicalDevice, vertexBuffer, nullptr);
-		vkFreeMemory(logicalDevice, vertexBufferMemory, nullptr);
-		vkDestroyBuffer(logicalDevice, indicesBuffer, nullptr);
-		vkFreeMemory(logicalDevice, indicesBufferMemory, nullptr);
+	// Histograms of input and pose latency are written there as CSV when app exits, Summary is printed either way
+	void setLatencyHistogramPath(const std::string& path)
+	{
+		latencyHistogramPath = path;
+	}
 
-		vkDestroySampler(logicalDevice, mvColorTextureSampler, nullptr);
+	// Main thread, simulation and rendering share one thread when disabled the way they used to, For comparing frame pacing
+	void setRenderThread(bool bEnable)
+	{
+		bUseRenderThread = bEnable;
+	}
 
-		vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
-		cleanUniformBuffers();
+	void setLatencyProfile(const LatencyProfile& profile)
+	{
+		latencyProfile = profile;
+	}
 
-		for (TextureData td : textures)
-		{
-			vkDestroySampler(logicalDevice, td.textureSampler, nullptr);
-			vkDestroyImageView(logicalDevice, td.textureImageView, nullptr);
-			vkDestroyImage(logicalDevice, td.textureImage, nullptr);
-			vkFreeMemory(logicalDevice, td.textureImageMemory, nullptr);
-		}
+	// Latency and frame rate measured with every profile used in order, Complete once run returned
+	const std::vector<LatencyProfile::Stats>& getLatencyProfileStats() const
+	{
+		return latencyProfileStats;
+	}
 
-		vkDestroyCommandPool(logicalDevice, transferCmdPool, nullptr);
+	// Keeps fences and binary semaphores between batches even when device has timeline semaphores
+	void setTimelineSemaphores(bool bEnable)
+	{
+		bUseTimelineSemaphores = bEnable;
+	}
 
-		cleanFrameBuffers(logicalDevice);
-		cleanDepthResource();
-		cleanImageResources();
-		vkDestroyDescriptorSetLayout(logicalDevice, textureDescriptorSetLayout, nullptr);
-		vkDestroyDescriptorSetLayout(logicalDevice, descriptorSetLayout, nullptr);
-		vkDestroyPipeline(logicalDevice, pipeLine, nullptr);
-		for (uint32_t i = 0; i < noOfViews; i++)
-		{
-			vkDestroyPipeline(logicalDevice, mvFramePipelines[i], nullptr);
-		}
-		vkDestroyPipelineLayout(logicalDevice, mvPipelineLayout, nullptr);
-		vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
-		vkDestroyRenderPass(logicalDevice, renderPass, nullptr);
-		vkDestroyRenderPass(logicalDevice, mvRenderPass, nullptr);
-		cleanImageViews();
-		vkDestroySwapchainKHR(logicalDevice, swapChain, nullptr);
+	// Longest time main loop sleeps while nothing changes, Bounds how late changes that do not come with a window event get drawn
+	void setMaxIdleLatency(double seconds)
+	{
+		maxIdleLatency = std::max(seconds, 0.0);
+	}
 
-		vkDestroyDevice(logicalDevice, nullptr);
+	// Compares hash map based welding that loadModel used before against VertexWelder in serial and sharded modes
+	static void benchmarkVertexWelding(const std::string& path, int iterations)
+	{
+		std::vector<Vertex> unweldedVertices;
+		readObjVertices(path, unweldedVertices);
 
-		if (bUseDebugMessenger)
-			cleanDebugMessengerUtils();
-		vkDestroySurfaceKHR(vulkanInstance, surface, nullptr);
-		vkDestroyInstance(vulkanInstance, nullptr);
-		glfwDestroyWindow(window);
-		glfwTerminate();
+		std::cout << "Welding benchmark on " << path << " with " << unweldedVertices.size() << " indices" << std::endl;
 
-		vulkanInstance = nullptr;
-		window = nullptr;
+		auto timeWelding = [&](const char* name, const std::function<size_t()>& weldFunc)
+		{
+			size_t uniqueCount = 0;
+			auto startTime = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < iterations; i++)
+			{
+				uniqueCount = weldFunc();
+			}
+			float totalTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - startTime).count();
+			std::cout << name << " : " << totalTime / iterations << "ms per weld, " << uniqueCount << " unique vertices" << std::endl;
+		};
+
+		timeWelding("unordered_map", [&]()
+		{
+			std::vector<Vertex> outVertices;
+			std::vector<uint32_t> outIndices;
+			std::unordered_map<Vertex, uint32_t> uniqueVertexIndexMap;
+			for (const Vertex& vert : unweldedVertices)
+			{
+				if (uniqueVertexIndexMap.find(vert) == uniqueVertexIndexMap.end())
+				{
+					uniqueVertexIndexMap[vert] = (uint32_t)outVertices.size();
+					outVertices.push_back(vert);
+				}
+				outIndices.push_back(uniqueVertexIndexMap[vert]);
+			}
+			return outVertices.size();
+		});
+
+		timeWelding("VertexWelder", [&]()
+		{
+			std::vector<Vertex> outVertices;
+			std::vector<uint32_t> outIndices;
+			VertexWelder<Vertex>::weldStream(unweldedVertices, outVertices, outIndices, 1);
+			return outVertices.size();
+		});
+
+		uint32_t threadCount = std::max(2u, std::thread::hardware_concurrency());
+		timeWelding("VertexWelder sharded", [&]()
+		{
+			std::vector<Vertex> outVertices;
+			std::vector<uint32_t> outIndices;
+			VertexWelder<Vertex>::weldStream(unweldedVertices, outVertices, outIndices, threadCount);
+			return outVertices.size();
+		});
 	}
 
-	void initGLFW()
+	// Compares OBJ parsing through tinyobj against ObjReader on a single thread and on all hardware threads
+	static void benchmarkObjParsing(const std::string& path, int iterations)
 	{
-		glfwInit();
+		std::error_code errorCode;
+		float fileSizeMB = std::filesystem::file_size(path, errorCode) / (1024.0f * 1024.0f);
 
-		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+		std::cout << "OBJ parsing benchmark on " << path << " of " << fileSizeMB << "MB" << std::endl;
 
-		window = glfwCreateWindow(WND_WIDTH, WND_HEIGHT, "Vulkan Test", nullptr, nullptr);
+		std::vector<Vertex> referenceVertices;
+		auto timeParsing = [&](const char* name, const std::function<void(std::vector<Vertex>&)>& readFunc)
+		{
+			std::vector<Vertex> outVertices;
+			auto startTime = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < iterations; i++)
+			{
+				outVertices.clear();
+				readFunc(outVertices);
+			}
+			float totalTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - startTime).count();
 
-		glfwSetKeyCallback(window, keyCallback);
+			// Number parsers may round differently, So outputs are compared with a tolerance instead of bitwise
+			float maxDifference = 0.0f;
+			bool bIsMatching = referenceVertices.empty() || referenceVertices.size() == outVertices.size();
+			for (size_t i = 0; bIsMatching && !referenceVertices.empty() && i < outVertices.size(); i++)
+			{
+				glm::vec3 positionDifference = glm::abs(outVertices[i].position - referenceVertices[i].position);
+				glm::vec2 coordDifference = glm::abs(outVertices[i].textureCoord - referenceVertices[i].textureCoord);
+				maxDifference = std::max({ maxDifference, positionDifference.x, positionDifference.y, positionDifference.z,
+					coordDifference.x, coordDifference.y });
+			}
+			if (referenceVertices.empty())
+			{
+				referenceVertices.swap(outVertices);
+			}
 
-		glfwSetWindowUserPointer(window, this);
-		glfwSetFramebufferSizeCallback(window, onWidowResize);
+			float timePerRead = totalTime / iterations;
+			std::cout << name << " : " << timePerRead << "ms per read, " << fileSizeMB * 1000.0f / timePerRead << "MB/s";
+			std::cout << (bIsMatching ? ", max difference to tinyobj " + std::to_string(maxDifference) : ", vertex count differs from tinyobj") << std::endl;
+		};
+
+		timeParsing("tinyobj", [&](std::vector<Vertex>& outVertices) { readObjVerticesTinyObj(path, outVertices); });
+		timeParsing("ObjReader", [&](std::vector<Vertex>& outVertices) { readObjVertices(path, outVertices, 1); });
+
+		uint32_t threadCount = std::max(2u, std::thread::hardware_concurrency());
+		timeParsing("ObjReader parallel", [&](std::vector<Vertex>& outVertices) { readObjVertices(path, outVertices, threadCount); });
 	}
 
-	void initVulkan()
+	// Culls objectCount random spheres against the stereo frustum linearly and through the hierarchy, On one thread and on all hardware threads
+	static void benchmarkCulling(uint32_t objectCount, int iterations)
 	{
-		//loadModel(MDL_PATH);
-		createCylinder(cylinderH, cylinderR, noOfSlices, cylinderAngle);
-		createVulkanInstance();
-		vulkan::VulkanTypes::setupNecessaryApi(vulkanInstance);
-		if (bUseDebugMessenger)
-			setupDebugMessengerUtils();
+		std::cout << "Culling benchmark with " << objectCount << " objects, AVX2 " << (SceneCuller::isAvx2Supported() ? "supported" : "not supported") << std::endl;
+
+		// Same eye setup as getProjectionData with square eye images
+		const glm::vec3 eyeCenter(1, 400, 1);
+		glm::vec3 right = glm::normalize(glm::cross(glm::vec3(0, 0, 1), -eyeCenter)) * 0.032f;
+		glm::mat4 projection = glm::perspective(glm::radians(80.0f), 1.0f, 0.1f, 10000.0f);
+		projection[1][1] *= -1;
+		Frustum frustum = Frustum::combineStereo(
+			Frustum::fromViewProjection(projection * glm::lookAt(eyeCenter - right, -right, glm::vec3(0, 0, 1))),
+			Frustum::fromViewProjection(projection * glm::lookAt(eyeCenter + right, right, glm::vec3(0, 0, 1))));
+
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> positionDistribution(-2000.0f, 2000.0f);
+		std::uniform_real_distribution<float> radiusDistribution(0.5f, 5.0f);
+		auto randomPosition = [&]()
+		{
+			return glm::vec3(positionDistribution(random), positionDistribution(random), positionDistribution(random));
+		};
 
-		createSurface();
-		pickVulkanDevice();
-		createLogicalDevice();
-		createSwapChain();
-		obtainImageAndImgViews();
-		createRenderPass();
-		createDescriptorLayout();
-		createRenderPipeline();
-		createCommandPool();
+		uint32_t workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+		SceneCuller singleCuller;
+		SceneCuller parallelCuller(workerCount);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			glm::vec3 position = randomPosition();
+			float radius = radiusDistribution(random);
+			singleCuller.addObject(position, radius);
+			parallelCuller.addObject(position, radius);
+		}
 
-		createImageResources();
-		createDepthResources();
-		createFramebuffers();
-		createVertexBuffers();
-		createIndexBuffers();
+		auto startTime = std::chrono::high_resolution_clock::now();
+		singleCuller.rebuildHierarchy();
+		parallelCuller.rebuildHierarchy();
+		std::cout << "Hierarchy build : " << std::chrono::duration<float, std::chrono::milliseconds::period>(
+			std::chrono::high_resolution_clock::now() - startTime).count() * 0.5f << "ms" << std::endl;
 
-		textures.resize(noOfViews);
-		createImageTextureAndView("Textures/left.jpg",0);
-		createImageTextureAndView("Textures/right.jpg", 1);
-		createTextureSampler();
+		std::vector<uint32_t> visibleObjects;
+		auto timeCulling = [&](const char* name, const std::function<void()>& cullFunc)
+		{
+			auto startTime = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < iterations; i++)
+			{
+				cullFunc();
+			}
+			float totalTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - startTime).count();
+			std::cout << name << " : " << totalTime / iterations << "ms per cull, " << visibleObjects.size() << " visible" << std::endl;
+		};
 
-		createUniformBuffers();
-		createDescriptorPool();
-		allocDescriptorSets();
+		for (SceneCuller* culler : { &singleCuller, &parallelCuller })
+		{
+			std::string threads = culler->getWorkerCount() == 0 ? "" : " " + std::to_string(culler->getWorkerCount() + 1) + " threads";
 
-		allocAndRecordCmdBuffers();
-		createSemaphores();
-	}
+			culler->setUseAvx2(false);
+			timeCulling(("Linear scalar" + threads).c_str(), [&]() { culler->cullLinear(frustum, visibleObjects); });
+			culler->setUseAvx2(true);
+			if (culler->isUsingAvx2())
+			{
+				timeCulling(("Linear AVX2" + threads).c_str(), [&]() { culler->cullLinear(frustum, visibleObjects); });
+			}
+			timeCulling(("Hierarchy" + threads).c_str(), [&]() { culler->cullHierarchy(frustum, visibleObjects); });
 
-	static void onWidowResize(GLFWwindow* window, int width, int height)
-	{
-		RenderingApplication* app = reinterpret_cast<RenderingApplication*>(glfwGetWindowUserPointer(window));
-		app->bIsWindowResized = true;
+			// Every cull moves 1% of objects so that refits and the occasional rebuild are part of the timing
+			timeCulling(("Hierarchy 1% moving" + threads).c_str(), [&]()
+			{
+				for (uint32_t i = 0; i < objectCount / 100; i++)
+				{
+					culler->moveObject(random() % objectCount, randomPosition(), radiusDistribution(random));
+				}
+				culler->cullHierarchy(frustum, visibleObjects);
+			});
+		}
 	}
 
-	void createVulkanInstance()
+	// Headless asynchronous timewarp on a simulated 90Hz display while head turns at a constant rate. Eye frames take 8ms with every 4th one
+	// taking 30ms, Pose error at display time is compared between showing eye frames as they are and reprojecting them
+	static void simulateTimewarp(double seconds, float positionalDepth)
 	{
-		VkApplicationInfo appInfo = {};
-		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-		appInfo.pApplicationName = "Test Render";
-		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.pEngineName = "No Engine";
-		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		DisplayClock clock(1.0 / 90.0);
+		AsyncTimewarp timewarp;
 
-		VkInstanceCreateInfo createInstanceInfo = VkInstanceCreateInfo();
-		createInstanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-		createInstanceInfo.pApplicationInfo = &appInfo;
+		const float yawRate = glm::radians(120.0f);
+		const glm::vec3 headOffset(0.1f, 0.0f, 0.0f);
+		glm::mat4 projection = glm::perspective(glm::radians(80.0f), 1.0f, 0.1f, 10000.0f);
+		projection[1][1] *= -1;
+		glm::mat4 inverseProjection = glm::inverse(projection);
 
-		uint32_t requiredExtensionCount;
-		const char **requiredExtensionNames = glfwGetRequiredInstanceExtensions(&requiredExtensionCount);
+		// Eyes sit off the rotation axis so that turning also moves them
+		auto getView = [&](double time)
+		{
+			float yaw = (float)time * yawRate;
+			glm::vec3 forward(std::cos(yaw), std::sin(yaw), 0.0f);
+			glm::vec3 eye = glm::vec3(glm::rotate(glm::mat4(1.0f), yaw, glm::vec3(0, 0, 1)) * glm::vec4(headOffset, 1.0f));
+			return glm::lookAt(eye, eye + forward, glm::vec3(0, 0, 1));
+		};
 
-		uint32_t sprtExtensionCount;
-		vkEnumerateInstanceExtensionProperties(nullptr, &sprtExtensionCount, nullptr);
-		std::vector<VkExtensionProperties> sprtExtensions(sprtExtensionCount);
-		vkEnumerateInstanceExtensionProperties(nullptr, &sprtExtensionCount, sprtExtensions.data());
+		// Point a pixel shows in world space when it looks at a plane positionalDepth in front of the eye, Far away without positional depth
+		auto getWorldPoint = [&](const glm::mat4& view, glm::vec2 ndc)
+		{
+			glm::vec4 viewPoint = inverseProjection * glm::vec4(ndc, 1.0f, 1.0f);
+			glm::vec3 direction = glm::normalize(glm::vec3(viewPoint) / viewPoint.w);
+			float distance = positionalDepth > 0.0f ? positionalDepth / -direction.z : 1000.0f;
+			return glm::vec3(glm::inverse(view) * glm::vec4(direction * distance, 1.0f));
+		};
 
-		std::vector<const char*> useableExtensions = getAvailableExtensions(sprtExtensions, ADDITIONAL_INSTANCE_EXTENSIONS);
+		double uncorrectedErrorSum = 0, reprojectedErrorSum = 0;
+		double maxUncorrectedError = 0, maxReprojectedError = 0;
+		uint64_t sampleCount = 0;
 
-		std::vector<const char*> finalExtensionList(useableExtensions.size() + requiredExtensionCount);
-		for (uint32_t i = 0; i < requiredExtensionCount; i++)
+		timewarp.start(clock, 0.004, [&](const AsyncTimewarp::LateFrame& lateFrame)
 		{
-			finalExtensionList[i] = requiredExtensionNames[i];
-		}
-		for (uint32_t i = 0; i < useableExtensions.size(); i++)
+			glm::mat4 displayView = getView(lateFrame.displayTime);
+			const glm::mat4& renderView = lateFrame.eyeFrame.viewTransforms[0];
+			glm::mat4 warp = AsyncTimewarp::computeTimewarpTransform(projection, renderView, displayView, positionalDepth);
+
+			for (glm::vec2 ndc : { glm::vec2(0.0f), glm::vec2(0.5f, -0.5f) })
+			{
+				glm::vec3 viewedPoint = getWorldPoint(displayView, ndc);
+				glm::vec3 eyePosition = glm::vec3(glm::inverse(displayView)[3]);
+				glm::vec3 expected = glm::normalize(viewedPoint - eyePosition);
+
+				glm::vec4 warped = warp * glm::vec4(ndc, 1.0f, 1.0f);
+				glm::vec3 uncorrected = glm::normalize(getWorldPoint(renderView, ndc) - eyePosition);
+				glm::vec3 reprojected = glm::normalize(getWorldPoint(renderView, glm::vec2(warped) / warped.w) - eyePosition);
+
+				double uncorrectedError = glm::degrees(std::acos(glm::clamp(glm::dot(expected, uncorrected), -1.0f, 1.0f)));
+				double reprojectedError = glm::degrees(std::acos(glm::clamp(glm::dot(expected, reprojected), -1.0f, 1.0f)));
+				uncorrectedErrorSum += uncorrectedError;
+				reprojectedErrorSum += reprojectedError;
+				maxUncorrectedError = std::max(maxUncorrectedError, uncorrectedError);
+				maxReprojectedError = std::max(maxReprojectedError, reprojectedError);
+				sampleCount++;
+			}
+
+			// Distortion pass on GPU
+			clock.sleepUntil(clock.now() + 0.001);
+			timewarp.retireLateFrame(lateFrame.index);
+		});
+
+		uint64_t eyeFrameIndex = 0;
+		while (clock.now() < seconds)
 		{
-			finalExtensionList[requiredExtensionCount + i] = useableExtensions[i];
+			AsyncTimewarp::EyeFrame eyeFrame;
+			eyeFrame.index = ++eyeFrameIndex;
+			eyeFrame.eyeBuffer = timewarp.beginEyeFrame();
+			eyeFrame.viewTransforms[0] = eyeFrame.viewTransforms[1] = getView(clock.now());
+
+			// Eye pass on GPU
+			clock.sleepUntil(clock.now() + (eyeFrameIndex % 4 == 0 ? 0.030 : 0.008));
+			timewarp.publishEyeFrame(eyeFrame);
 		}
+		timewarp.stop();
+
+		AsyncTimewarp::Stats stats = timewarp.getStats();
+		std::cout << "Timewarp simulation of " << seconds << "s at 90Hz" << (positionalDepth > 0.0f ? " with positional correction" : "") << std::endl;
+		std::cout << "Vertical blanks served : " << stats.lateFrameCount << " Eye frames : " << stats.publishedEyeFrameCount
+			<< " Repeated eye frames : " << stats.repeatedFrameCount << " Missed vertical blanks : " << stats.missedVsyncCount
+			<< " Longest late stage : " << stats.maxLateStageTime * 1000.0 << "ms" << std::endl;
+		std::cout << "Pose error at display time avg/max, Without reprojection : " << uncorrectedErrorSum / std::max(sampleCount, (uint64_t)1)
+			<< "/" << maxUncorrectedError << " degrees, Reprojected : " << reprojectedErrorSum / std::max(sampleCount, (uint64_t)1) << "/"
+			<< maxReprojectedError << " degrees" << std::endl;
+	}
 
-		createInstanceInfo.enabledExtensionCount = (uint32_t)finalExtensionList.size();
-		createInstanceInfo.ppEnabledExtensionNames = finalExtensionList.data();
-
-		std::vector<const char*> finalLayerList = {};
-		if (bUseDebugMessenger)
+	// Releases strips of every vertical blank of a simulated 90Hz display for seconds and completes them on a simulated GPU taking
+	// stripGpuTime per strip, Every 16th frame twice as long as if eye pass held up the GPU. Wakeups of the releasing thread are real
+	static void simulateDistortionStrips(double seconds, uint32_t stripCount, double lead, double stripGpuTime)
+	{
+		DisplayClock clock(1.0 / 90.0);
+		StripScheduler scheduler;
+		scheduler.configure(std::min(stripCount, StripScheduler::MAX_STRIPS), 1080, lead);
+
+		std::mt19937 random(1);
+		std::uniform_real_distribution<double> gpuJitter(0.8, 1.2);
+		double gpuIdleTime = 0;
+		uint64_t frameCount = 0;
+		while (clock.now() < seconds)
 		{
-			uint32_t availableLayersCount;
-			vkEnumerateInstanceLayerProperties(&availableLayersCount, nullptr);
-			std::vector<VkLayerProperties> availableLayers(availableLayersCount);
-			vkEnumerateInstanceLayerProperties(&availableLayersCount, availableLayers.data());
+			double vsync = clock.getNextVsync(lead);
+			frameCount++;
+			for (uint32_t i = 0; i < scheduler.getStripCount(); i++)
+			{
+				StripScheduler::Strip strip = scheduler.getStrip(clock, vsync, i);
+				clock.sleepUntil(strip.releaseTime);
 
-			finalLayerList = getAvailableLayers(availableLayers, LAYERS_TO_ENABLE);
+				// Strip starts on GPU once it is submitted and earlier ones are done
+				double gpuTime = stripGpuTime * gpuJitter(random) * (frameCount % 16 == 0 ? 2.0 : 1.0);
+				gpuIdleTime = std::max(gpuIdleTime, clock.now()) + gpuTime;
+				scheduler.addCompletion(strip, gpuIdleTime);
+			}
 		}
 
-		createInstanceInfo.enabledLayerCount = (uint32_t)finalLayerList.size();
-		createInstanceInfo.ppEnabledLayerNames = finalLayerList.data();
+		std::cout << "Distortion strip simulation of " << seconds << "s at 90Hz, " << scheduler.getStripCount() << " strips released "
+			<< lead * 1000.0 << "ms before scanout taking " << stripGpuTime * 1000.0 << "ms each on GPU" << std::endl;
+		reportStripDeadlines(scheduler.getStats());
+	}
 
-		VkResult result = vkCreateInstance(&createInstanceInfo, nullptr, &vulkanInstance);
-		if (result == VK_SUCCESS)
-		{
-			std::cout << "Successfully created Vulkan Instance" << std::endl;
-		}
-		else
+	static void reportStripDeadlines(const std::vector<StripScheduler::StripStats>& stripStats)
+	{
+		for (size_t i = 0; i < stripStats.size(); i++)
 		{
-			std::string errorMsg = "Failure in instantiating Vulkan!\n Cause : ";
-			switch (result)
+			const StripScheduler::StripStats& stats = stripStats[i];
+			if (stats.frameCount == 0)
 			{
-			case VK_ERROR_LAYER_NOT_PRESENT:
-				errorMsg.append("One/More of requested Vulkan layer/s is not available");
-				break;
-			case VK_ERROR_EXTENSION_NOT_PRESENT:
-				errorMsg.append("One/More of requested Vulkan extension/s is not available");
-				break;
-			default:
-				errorMsg.append("Other Reasons");
-				break;
+				continue;
 			}
-			throw std::runtime_error(errorMsg.c_str());
+			std::cout << "Distortion strip " << i << " rows " << stats.firstRow << "-" << stats.firstRow + stats.rowCount - 1 << " missed "
+				<< stats.missCount << " of " << stats.frameCount << " scanout deadlines, Margin avg/min " << stats.marginSum / stats.frameCount * 1000.0
+				<< "/" << stats.minMargin * 1000.0 << "ms" << std::endl;
 		}
-
 	}
 
-	void createSurface()
+	// Replays a trajectory(Generated head motion when path is empty) at 90 frames per second and compares poses every source expects
+	// photonLatency seconds after sampling against recorded ones at that time. Runs are deterministic, Frames stay within one replay loop
+	static void benchmarkPosePrediction(const std::string& path, double photonLatency)
 	{
-		if (glfwCreateWindowSurface(vulkanInstance, window, nullptr, &surface) != VK_SUCCESS)
+		TrajectoryPoseSource trajectory = path.empty() ? TrajectoryPoseSource(TrajectoryPoseSource::generateHeadMotion(60.0, 1000.0, 1)) :
+			TrajectoryPoseSource(path);
+
+		PosePredictor constantVelocity(trajectory, PosePredictor::Model::ConstantVelocity);
+		PosePredictor constantAcceleration(trajectory, PosePredictor::Model::ConstantAcceleration);
+		PosePredictor kalman(trajectory, PosePredictor::Model::Kalman);
+		std::pair<const char*, PoseSource*> sources[] =
 		{
-			throw std::runtime_error("Failed to create Surface KHR from Window for process");
+			{ "Replay without prediction", &trajectory },
+			{ PosePredictor::getModelName(constantVelocity.getModel()), &constantVelocity },
+			{ PosePredictor::getModelName(constantAcceleration.getModel()), &constantAcceleration },
+			{ PosePredictor::getModelName(kalman.getModel()), &kalman },
+		};
+		PoseError errors[4];
+
+		const double framePeriod = 1.0 / 90.0;
+		for (double now = 0.0; now + photonLatency < trajectory.getDuration(); now += framePeriod)
+		{
+			Pose truePose = trajectory.getTruePose(now + photonLatency);
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				errors[i].add(sources[i].second->getPose(now, now + photonLatency), truePose);
+			}
+		}
+
+		std::cout << "Pose prediction over " << trajectory.getDuration() << "s trajectory of " << trajectory.getSampleCount() << " samples, "
+			<< photonLatency * 1000.0 << "ms from sample to display, Error avg/max" << std::endl;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			std::cout << sources[i].first << " : Position " << errors[i].positionSum / errors[i].count << "/" << errors[i].positionMax
+				<< " Orientation " << errors[i].angleSum / errors[i].count << "/" << errors[i].angleMax << " degrees" << std::endl;
 		}
 	}
 
-	std::vector<const char*> getAvailableExtensions(std::vector<VkExtensionProperties>& detectedExt, const std::vector<const char*>&
-		queryingExtensions)
+	// Writes a textured grid OBJ of about sizeMB megabytes with quads as faces, Rows of vertices and faces are interleaved like scanned meshes
+	static void writeSyntheticObj(const std::string& path, uint64_t sizeMB)
 	{
-		std::vector<const char*> returnData;
-		const char* extensionChars = nullptr;
-		std::string exts = "";
-		for (const VkExtensionProperties& ext : detectedExt)
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
 		{
-			exts.append(ext.extensionName);
+			throw std::runtime_error("Failed to open " + path + " for writing");
 		}
-		extensionChars = exts.c_str();
 
-		for (const char* ext : queryingExtensions)
+		const uint32_t rowLength = 1024;
+		const uint64_t targetSize = sizeMB * 1024 * 1024;
+		std::vector<char> lineBuffer(128);
+		std::string rowText;
+
+		for (uint64_t row = 0; (uint64_t)file.tellp() < targetSize; row++)
 		{
-			if (strstr(extensionChars, ext) != nullptr)
+			rowText.clear();
+			for (uint32_t column = 0; column < rowLength; column++)
 			{
-				returnData.push_back(ext);
+				float height = 10.0f * std::sin(column * 0.05f) * std::cos(row * 0.05f);
+				int length = snprintf(lineBuffer.data(), lineBuffer.size(), "v %.6f %.6f %.6f\nvt %.6f %.6f\n", column * 0.1f, row * 0.1f, height,
+					column / (float)(rowLength - 1), (row % 1024) / 1023.0f);
+				rowText.append(lineBuffer.data(), length);
 			}
-			else
+
+			for (uint32_t column = 0; row > 0 && column + 1 < rowLength; column++)
 			{
-				std::cerr << "Extension " << ext << " is not available" << std::endl;
+				uint64_t a = (row - 1) * rowLength + column + 1, b = a + 1, c = b + rowLength, d = a + rowLength;
+				int length = snprintf(lineBuffer.data(), lineBuffer.size(), "f %llu/%llu %llu/%llu %llu/%llu %llu/%llu\n",
+					(unsigned long long)a, (unsigned long long)a, (unsigned long long)b, (unsigned long long)b,
+					(unsigned long long)c, (unsigned long long)c, (unsigned long long)d, (unsigned long long)d);
+				rowText.append(lineBuffer.data(), length);
 			}
+			file.write(rowText.data(), rowText.size());
 		}
-		returnData.shrink_to_fit();
-		return returnData;
 	}
 
-	std::vector<const char*> getAvailableLayers(std::vector<VkLayerProperties>& detectedLayers, const std::vector<const char*>&
-		queryingLayers)
-	{
+private:
 
-		std::vector<const char*> returnData;
-		const char* layerChars = nullptr;
-		std::string layers = "";
-		for (const VkLayerProperties& layer : detectedLayers)
-		{
-			layers.append(layer.layerName);
-		}
-		layerChars = layers.c_str();
+	void initApp()
+	{
+		currentDistAlpha = defaultDistortionAlpha;
+		traceEyePoseSampled = frameTracer.registerEvent("Eye pose sampled");
+		traceDistortionLatched = frameTracer.registerEvent("Distortion uniforms latched");
+		traceFrameStarted = frameTracer.registerEvent("Frame started");
+		tracePreviousFrameStarted = frameTracer.registerEvent("Previous frame started");
+		traceInputReceived = frameTracer.registerEvent("Input received");
+		initGLFW();
+		initVulkan();
 
-		for (const char* layer : queryingLayers)
+		// Simulation starts from what gets drawn first
+		simulatedState.distortionAlpha = currentDistAlpha;
+		simulatedState.surfaceType = surfaceParameters.surfaceType;
+		simulatedState.surfaceAngle = surfaceParameters.angle;
+		simulatedState.instanceCount = instanceCount;
+		simulatedState.lodErrorThreshold = lodErrorThreshold;
+		poseStartTime = latencyTracker.now();
+		latencyProfileStartTime = latencyTracker.now();
+		completionWatcherThread = std::thread(&RenderingApplication::watchCompletions, this);
+		if (bUseAsyncTimewarp)
 		{
-			if (strstr(layerChars, layer) != nullptr)
-			{
-				returnData.push_back(layer);
-			}
-			else
-			{
-				std::cerr << "Layer " << layer << " is not available" << std::endl;
-			}
+			startTimewarp();
 		}
-		returnData.shrink_to_fit();
-		return returnData;
 	}
 
-
-	void pickVulkanDevice()
+	void mainLoop()
 	{
-		uint32_t supportedDeviceCount = 0;
-		vkEnumeratePhysicalDevices(vulkanInstance, &supportedDeviceCount, nullptr);
-		if (supportedDeviceCount == 0)
+		if (bUseRenderThread)
 		{
-			throw std::runtime_error("No Vulkan supported Graphics devices is available");
+			runThreads();
 		}
-		std::vector<VkPhysicalDevice> availableDevices(supportedDeviceCount);
-		vkEnumeratePhysicalDevices(vulkanInstance, &supportedDeviceCount, availableDevices.data());
-		for (const VkPhysicalDevice device : availableDevices)
+
+		while (!bUseRenderThread && !glfwWindowShouldClose(window))
 		{
-			if (isDeviceSuitable(device))
+			glfwPollEvents();
+			// Input is simulated and applied right away in between frames
+			if (inputStates.update() && simulate(inputStates.read()))
 			{
-				vulkanDevice = device;
-				msaaSampleBitsCount = getMsaaSampleCount();
-				break;
+				applyFrameState(simulatedState);
+			}
+			if (isFrameUnchanged())
+			{
+				// Last presented image stays on screen, Any event wakes the loop up right away so input is not delayed
+				glfwWaitEventsTimeout(maxIdleLatency);
+				idleWaitCount++;
+				lastFrameStartTime = -1.0;
+				continue;
 			}
+			drawNextFrame();
 		}
 
-		if (vulkanDevice == VK_NULL_HANDLE)
+		if (bUseAsyncTimewarp)
 		{
-			std::runtime_error("Non of the available vulkan devices is suitable for the application");
+			AsyncTimewarp::Stats stats = asyncTimewarp.getStats();
+			stopTimewarp();
+			std::cout << "Timewarp late frames " << stats.lateFrameCount << " Repeated eye frames " << stats.repeatedFrameCount
+				<< " Missed vertical blanks " << stats.missedVsyncCount << " Longest late stage " << stats.maxLateStageTime * 1000.0 << "ms" << std::endl;
+			reportStripDeadlines(stripScheduler.getStats());
 		}
-		else
+
+		vkDeviceWaitIdle(logicalDevice);
+		stopCompletionWatcher();
+
+		if (!bUseAsyncTimewarp)
 		{
-			VkPhysicalDeviceProperties deviceProps;
-			VkPhysicalDeviceFeatures deviceFeatures;
-			vkGetPhysicalDeviceProperties(vulkanDevice, &deviceProps);
-			vkGetPhysicalDeviceFeatures(vulkanDevice, &deviceFeatures);
-			std::cout << "Current GPU : " << deviceProps.deviceID << " - " << deviceProps.deviceName << std::endl;
-			std::cout << "GPU Type : " << deviceProps.deviceType << std::endl;
-			std::cout << "GPU Vendor ID : " << deviceProps.vendorID << std::endl;
-			std::cout << "GPU Support - Float64 : " << (deviceFeatures.shaderFloat64 == 0 ? "False" : "True") << " Int16 : "
-				<< (deviceFeatures.shaderInt16 == 0 ? "False" : "True") << std::endl;
+			reportPoseLatch();
+			reportFramePacing();
 		}
+		reportLatency();
+		closeLatencyProfileStats();
+		reportLatencyProfiles();
+		reportPosePrediction();
+		reportQualityGovernor();
+
+		std::cout << "Eye pass skipped on " << skippedEyePassCount << " of " << frameNumber << " frames, Idle waits " << idleWaitCount << std::endl;
 	}
 
-	bool isDeviceSuitable(const VkPhysicalDevice& device)
+	// Main thread only waits for window events while simulation and render threads run, So input is handled as it arrives even while
+	// render thread is blocked on acquire or present
+	void runThreads()
 	{
-		VkPhysicalDeviceProperties deviceProps;
-		VkPhysicalDeviceFeatures deviceFeatures;
-		vkGetPhysicalDeviceProperties(device, &deviceProps);
-		vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+		bStopThreads = false;
+		simulationThread = std::thread(&RenderingApplication::simulationLoop, this);
+		renderThread = std::thread(&RenderingApplication::renderLoop, this);
 
-		bool bHasSwapChainSupport = false;
-		if (checkDeviceExtensionAvailability(device))
+		while (!glfwWindowShouldClose(window))
 		{
-			SwapChainSupport swapChainSupport = findSwapChainSupport(device);
-			bHasSwapChainSupport = !(swapChainSupport.presentModes.empty() || swapChainSupport.surfaceFormats.empty());
+			glfwWaitEvents();
 		}
 
-		return deviceProps.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU && deviceFeatures.geometryShader && deviceFeatures.samplerAnisotropy
-			&&	findQueueFamilyIndices(device).isComplete() && bHasSwapChainSupport;
+		bStopThreads = true;
+		wakeThreads();
+		renderThread.join();
+		simulationThread.join();
+		if (renderThreadError)
+		{
+			std::rethrow_exception(renderThreadError);
+		}
 	}
 
-	QueueFamilyIndices findQueueFamilyIndices(VkPhysicalDevice device)
+	// Steps whenever main thread published input and publishes frame state if input changed it
+	void simulationLoop()
 	{
-		QueueFamilyIndices queueFamilyIndices = {};
-
-		uint32_t availableQueueFamiliesCount = 0;
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &availableQueueFamiliesCount, nullptr);
-		std::vector<VkQueueFamilyProperties> availableQueueFamilies(availableQueueFamiliesCount);
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &availableQueueFamiliesCount, availableQueueFamilies.data());
-
-		int i = 0;
-		for (const VkQueueFamilyProperties& queueFamProps : availableQueueFamilies)
+		uint64_t seenWakeCount = getWakeCount();
+		while (!bStopThreads)
 		{
-			if (queueFamProps.queueCount > 0)
+			if (inputStates.update() && simulate(inputStates.read()))
 			{
-				if (queueFamProps.queueFlags & VK_QUEUE_GRAPHICS_BIT)
-				{
-					queueFamilyIndices.graphicsCmdQueue = i;
-				}
+				frameStates.publish(simulatedState);
+				wakeThreads();
+			}
+			seenWakeCount = waitForWake(seenWakeCount);
+		}
+	}
 
-				if (queueFamilyIndices.transferQueue == -1 && queueFamProps.queueFlags & VK_QUEUE_TRANSFER_BIT
-					&& !(queueFamProps.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+	// Draws latest frame state, While idle it sleeps until a frame state, window event or geometry upload wakes it up
+	void renderLoop()
+	{
+		try
+		{
+			uint64_t seenWakeCount = getWakeCount();
+			while (!bStopThreads)
+			{
+				if (frameStates.update())
 				{
-					queueFamilyIndices.transferQueue = i;
+					applyFrameState(frameStates.read());
 				}
-
-				VkBool32 isPresentable = false;
-				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &isPresentable);
-				if (isPresentable)
+				if (isFrameUnchanged())
 				{
-					queueFamilyIndices.presentationCmdQueue = i;
+					seenWakeCount = waitForWake(seenWakeCount);
+					idleWaitCount++;
+					lastFrameStartTime = -1.0;
+					continue;
 				}
+				drawNextFrame();
 			}
-
-			if (queueFamilyIndices.isComplete())
-			{
-				break;
-			}
-			i++;
 		}
-
-		if (queueFamilyIndices.transferQueue == -1)
+		catch (...)
 		{
-			queueFamilyIndices.transferQueue = queueFamilyIndices.graphicsCmdQueue;
+			renderThreadError = std::current_exception();
+			glfwSetWindowShouldClose(window, GLFW_TRUE);
+			glfwPostEmptyEvent();
 		}
-		return queueFamilyIndices;
 	}
 
-	bool checkDeviceExtensionAvailability(VkPhysicalDevice device)
+	// Wakes simulation and render threads up from idle waits, Called after whatever they would otherwise only see on their next check
+	void wakeThreads()
 	{
-		uint32_t availableExtCount = 0;
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &availableExtCount, nullptr);
-		std::vector<VkExtensionProperties> availableExtensions(availableExtCount);
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &availableExtCount, availableExtensions.data());
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			wakeCount++;
+		}
+		wakeCondition.notify_all();
+	}
 
-		std::vector<const char*> verifiedExts = getAvailableExtensions(availableExtensions, ADDITIONAL_DEVICE_EXTENSIONS);
-		return verifiedExts.size() == ADDITIONAL_DEVICE_EXTENSIONS.size();
+	uint64_t getWakeCount()
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		return wakeCount;
 	}
 
-	SwapChainSupport findSwapChainSupport(VkPhysicalDevice device)
+	// Blocks until thread is woken up after it saw seenWakeCount or max idle latency passed, Returns wake count to wait on next. Anything
+	// that wakes threads between the two waits makes the next one return at once
+	uint64_t waitForWake(uint64_t seenWakeCount)
 	{
-		SwapChainSupport support;
-		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &support.surfaceCapabilities);
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		wakeCondition.wait_for(lock, std::chrono::duration<double>(maxIdleLatency), [&]() { return wakeCount != seenWakeCount || bStopThreads; });
+		return wakeCount;
+	}
 
-		uint32_t count = 0;
-		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &count, nullptr);
-		if (count > 0)
+	void drawNextFrame()
+	{
+		if (bUseAsyncTimewarp)
 		{
-			support.surfaceFormats.resize(count);
-			vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &count, support.surfaceFormats.data());
+			drawEyeFrame();
 		}
-
-		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &count, nullptr);
-		if (count > 0)
+		else
 		{
-			support.presentModes.resize(count);
-			vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &count, support.presentModes.data());
+			drawFrame();
 		}
+	}
 
-		return support;
+	// Main thread, Counts key release of action and hands input state over to simulation
+	void recordInput(InputAction action)
+	{
+		inputState.actionCounts[(uint32_t)action]++;
+		inputState.inputSample = latencyTracker.getLatestSample(LatencyTracker::Source::Input);
+		inputState.eventTime = frameTracer.now();
+		inputStates.publish(inputState);
+		wakeThreads();
 	}
 
-	VkExtent2D chooseSwapExtent(VkSurfaceCapabilitiesKHR &surfaceCapabilities)
+	// Applies key releases counted since last step to simulated state, Returns whether there were any
+	bool simulate(const InputState& input)
 	{
-		if (surfaceCapabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+		bool bIsChanged = false;
+		for (uint32_t action = 0; action < (uint32_t)InputAction::Count; action++)
 		{
-
-			std::cout << "Current Frame buffer " << surfaceCapabilities.currentExtent.width << "x" <<
-				surfaceCapabilities.currentExtent.height << std::endl;
-			return surfaceCapabilities.currentExtent;
+			for (; simulatedActionCounts[action] < input.actionCounts[action]; simulatedActionCounts[action]++)
+			{
+				applyInputAction((InputAction)action, simulatedState);
+				bIsChanged = true;
+			}
 		}
-		else
-		{
-			int width, height;
-			glfwGetFramebufferSize(window, &width, &height);
-
-			VkExtent2D extent = { static_cast<uint32_t>(width) ,static_cast<uint32_t>(height) };
 
-			std::cout << "Current Frame buffer " << width << "x" << height << std::endl;
+		if (bIsChanged)
+		{
+			simulatedState.inputSample = input.inputSample;
+			simulatedState.inputTime = input.eventTime;
+		}
+		return bIsChanged;
+	}
 
-			extent.width = std::max(surfaceCapabilities.minImageExtent.width,
-				std::min(surfaceCapabilities.maxImageExtent.width, extent.width));
-			extent.height = std::max(surfaceCapabilities.minImageExtent.height,
-				std::min(surfaceCapabilities.maxImageExtent.height, extent.height));
-			return extent;
+	void applyInputAction(InputAction action, FrameState& state) const
+	{
+		switch (action)
+		{
+		case InputAction::IncreaseDistortion:
+			state.distortionAlpha = glm::clamp(state.distortionAlpha + 0.1f, -1.f, 1.f);
+			break;
+		case InputAction::DecreaseDistortion:
+			state.distortionAlpha = glm::clamp(state.distortionAlpha - 0.1f, -1.f, 1.f);
+			break;
+		case InputAction::ToggleDistortion:
+			state.distortionAlpha = state.distortionAlpha == 0.0f ? defaultDistortionAlpha : 0.0f;
+			break;
+		case InputAction::CycleSurface:
+			// Cylinder, sphere and plane
+			state.surfaceType = (state.surfaceType + 1) % 3;
+			break;
+		case InputAction::NarrowSurface:
+		case InputAction::WidenSurface:
+			state.surfaceAngle = glm::clamp(state.surfaceAngle + (action == InputAction::WidenSurface ? 10.0f : -10.0f), 10.0f, 360.0f);
+			break;
+		case InputAction::CycleInstances:
+			// 1, 16, 256, 4096 and MAX_INSTANCES
+			state.instanceCount = state.instanceCount >= MAX_INSTANCES ? 1 : std::min(state.instanceCount * 16, MAX_INSTANCES);
+			break;
+		case InputAction::CycleLodError:
+			// 0(Full detail), 1, 2, 4 and 8 pixels
+			state.lodErrorThreshold = state.lodErrorThreshold >= 8.0f ? 0.0f : std::max(state.lodErrorThreshold * 2.0f, 1.0f);
+			break;
+		case InputAction::SwapModel:
+			state.modelSwapCount++;
+			break;
+		case InputAction::CycleLatencyProfile:
+			state.latencyProfileCycleCount++;
+			break;
+		default:
+			break;
 		}
 	}
 
-	VkFormat chooseImageFormat(const std::vector<VkFormat>& checkFormats, VkImageTiling imageTiling, VkFormatFeatureFlags formatFeatureFlag)
+	// Brings what gets drawn to frame state, Only on the thread that draws
+	void applyFrameState(const FrameState& state)
 	{
-		for (const VkFormat format : checkFormats)
+		currentDistAlpha = state.distortionAlpha;
+		if (state.surfaceType != surfaceParameters.surfaceType)
 		{
-			VkFormatProperties props;
-			vkGetPhysicalDeviceFormatProperties(vulkanDevice, format, &props);
+			setSurfaceType((SurfaceType)state.surfaceType);
+		}
+		if (state.surfaceAngle != surfaceParameters.angle)
+		{
+			surfaceParameters.angle = state.surfaceAngle;
+			eyePassVersion++;
+		}
+		if (state.instanceCount != instanceCount)
+		{
+			instanceCount = state.instanceCount;
+			eyePassVersion++;
+			std::cout << "Instance count : " << instanceCount << std::endl;
+		}
+		if (state.lodErrorThreshold != lodErrorThreshold)
+		{
+			lodErrorThreshold = state.lodErrorThreshold;
+			eyePassVersion++;
+			std::cout << "LOD error threshold : " << lodErrorThreshold << " pixels" << std::endl;
+		}
 
-			if (imageTiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & formatFeatureFlag) == formatFeatureFlag)
+		// Swaps between procedural surface and model without waiting for device to idle
+		for (; appliedModelSwapCount < state.modelSwapCount; appliedModelSwapCount++)
+		{
+			if (bUseProceduralSurface)
 			{
-				return format;
+				requestModel(MDL_PATH);
 			}
-			else if (imageTiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & formatFeatureFlag) == formatFeatureFlag)
+			else
 			{
-				return format;
+				useProceduralSurface();
 			}
 		}
 
-		throw std::runtime_error("None of requested formats supports necessary features for given tiling in this hardware");
+		// Presets in turn after current profile, Profile given on command line is left for first preset. Switched once however many
+		// presses arrived since
+		if (appliedLatencyProfileCycleCount < state.latencyProfileCycleCount)
+		{
+			const std::vector<std::string>& presetNames = LatencyProfile::getPresetNames();
+			size_t steps = state.latencyProfileCycleCount - appliedLatencyProfileCycleCount;
+			size_t presetIndex = std::find(presetNames.begin(), presetNames.end(), latencyProfile.name) - presetNames.begin();
+			presetIndex = presetIndex < presetNames.size() ? (presetIndex + steps) % presetNames.size() : (steps - 1) % presetNames.size();
+			appliedLatencyProfileCycleCount = state.latencyProfileCycleCount;
+
+			LatencyProfile profile;
+			LatencyProfile::getPreset(presetNames[presetIndex], profile);
+			applyLatencyProfile(profile);
+		}
+
+		if (state.inputTime > appliedInputTime)
+		{
+			appliedInputTime = state.inputTime;
+			appliedInputSample = state.inputSample;
+			pendingInputTime = state.inputTime;
+		}
 	}
 
-	VkFormat chooseDepthImageFormat()
+	// Interval between frames drawn back to back and how long input waited for the frame applying it, Jitter as standard deviation
+	void reportFramePacing()
 	{
-		return chooseImageFormat({ VK_FORMAT_D32_SFLOAT_S8_UINT,VK_FORMAT_D32_SFLOAT,VK_FORMAT_D24_UNORM_S8_UINT },
-			VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		FrameTracer::Interval frameInterval = frameTracer.measure(tracePreviousFrameStarted, traceFrameStarted);
+		FrameTracer::Interval inputWait = frameTracer.measure(traceInputReceived, traceFrameStarted);
+		if (frameInterval.frameCount == 0)
+		{
+			return;
+		}
+
+		std::cout << (bUseRenderThread ? "Render thread" : "Single thread") << " frame interval over " << frameInterval.frameCount
+			<< " frames avg/min/max " << frameInterval.average * 1000.0 << "/" << frameInterval.min * 1000.0 << "/" << frameInterval.max * 1000.0
+			<< "ms Jitter " << frameInterval.deviation * 1000.0 << "ms";
+		if (inputWait.frameCount > 0)
+		{
+			std::cout << ", Input to frame start over " << inputWait.frameCount << " inputs avg/max " << inputWait.average * 1000.0 << "/"
+				<< inputWait.max * 1000.0 << "ms Jitter " << inputWait.deviation * 1000.0 << "ms";
+		}
+		std::cout << std::endl;
 	}
 
-	bool hasStencilFormat(VkFormat format)
+	// How much newer pose latched for distortion pass is than pose eye pass was rendered with, Both get sampled on CPU before their submit
+	void reportPoseLatch()
 	{
-		return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
-	}
+		FrameTracer::Interval latchedPoseGain = frameTracer.measure(traceEyePoseSampled, traceDistortionLatched);
+		if (latchedPoseGain.frameCount == 0)
+		{
+			return;
+		}
 
-	void createLogicalDevice() {
-		QueueFamilyIndices queueIndices = findQueueFamilyIndices(vulkanDevice);
+		std::cout << "Distortion uniforms latched over " << latchedPoseGain.frameCount << " frames avg/max " << latchedPoseGain.average * 1000.0 << "/"
+			<< latchedPoseGain.max * 1000.0 << "ms after eye pose was sampled" << std::endl;
+	}
 
-		std::vector<VkDeviceQueueCreateInfo> allQueueCreateInfo;
-		std::set<int> uniqueQueueIndex = { queueIndices.graphicsCmdQueue,queueIndices.presentationCmdQueue,queueIndices.transferQueue };
+	void cleanUp()
+	{
+		cleanSemaphores();
+		graphicsTimeline.destroy();
+		transferTimeline.destroy();
+		lateTimeline.destroy();
+		passTimer.destroy();
 
-		float queuePriority = 1.f;
+		vkDestroyCommandPool(logicalDevice, graphicsCmdPool, nullptr);
+		cleanGeometry();
+		vkDestroyBuffer(logicalDevice, visibleInstanceBuffer, nullptr);
+		vkFreeMemory(logicalDevice, visibleInstanceBufferMemory, nullptr);
+		vkDestroyBuffer(logicalDevice, drawCommandBuffer, nullptr);
+		vkFreeMemory(logicalDevice, drawCommandBufferMemory, nullptr);
 
-		for (int queueIdx : uniqueQueueIndex)
-		{
-			VkDeviceQueueCreateInfo queueCreateInfo = {};
-			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-			queueCreateInfo.queueCount = 1;
-			queueCreateInfo.queueFamilyIndex = queueIdx;
+		vkDestroySampler(logicalDevice, mvColorTextureSampler, nullptr);
 
-			queueCreateInfo.pQueuePriorities = &queuePriority;
+		vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+		cleanUniformBuffers();
 
-			allQueueCreateInfo.push_back(queueCreateInfo);
+		for (TextureData td : textures)
+		{
+			vkDestroySampler(logicalDevice, td.textureSampler, nullptr);
+			vkDestroyImageView(logicalDevice, td.textureImageView, nullptr);
+			vkDestroyImage(logicalDevice, td.textureImage, nullptr);
+			vkFreeMemory(logicalDevice, td.textureImageMemory, nullptr);
 		}
 
-		VkPhysicalDeviceFeatures deviceFeatures = {};
-		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		vkDestroyCommandPool(logicalDevice, transferCmdPool, nullptr);
 
-		VkDeviceCreateInfo deviceCreateInfo = {};
-		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		renderGraph.destroy(logicalDevice);
+		vkDestroyDescriptorSetLayout(logicalDevice, textureDescriptorSetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(logicalDevice, instanceDescriptorSetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(logicalDevice, descriptorSetLayout, nullptr);
+		for (VkPipeline meshPipeLine : meshPipeLines)
+		{
+			vkDestroyPipeline(logicalDevice, meshPipeLine, nullptr);
+		}
+		vkDestroyPipeline(logicalDevice, surfacePipeLine, nullptr);
+		vkDestroyPipeline(logicalDevice, cullPipeLine, nullptr);
+		for (uint32_t i = 0; i < noOfViews; i++)
+		{
+			vkDestroyPipeline(logicalDevice, mvFramePipelines[i], nullptr);
+		}
+		vkDestroyPipelineLayout(logicalDevice, mvPipelineLayout, nullptr);
+		vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
+		cleanImageViews();
+		vkDestroySwapchainKHR(logicalDevice, swapChain, nullptr);
 
-		// Just do get supported extensions of device and check with required extensions when using one
-		deviceCreateInfo.enabledExtensionCount = (uint32_t)ADDITIONAL_DEVICE_EXTENSIONS.size();
-		deviceCreateInfo.ppEnabledExtensionNames = ADDITIONAL_DEVICE_EXTENSIONS.data();
+		vkDestroyDevice(logicalDevice, nullptr);
 
-		//Start Layers to Enable for logical device
-		std::vector<const char*> finalLayerList = {};
 		if (bUseDebugMessenger)
-		{
-			uint32_t availableLayersCount;
-			vkEnumerateDeviceLayerProperties(vulkanDevice, &availableLayersCount, nullptr);
-			std::vector<VkLayerProperties> availableLayers(availableLayersCount);
-			vkEnumerateDeviceLayerProperties(vulkanDevice, &availableLayersCount, availableLayers.data());
-
-			finalLayerList = getAvailableLayers(availableLayers, LAYERS_TO_ENABLE);
-		}
-
-		deviceCreateInfo.enabledLayerCount = (uint32_t)finalLayerList.size();
-		deviceCreateInfo.ppEnabledLayerNames = finalLayerList.data();
-		// End Layers
-		deviceCreateInfo.pQueueCreateInfos = allQueueCreateInfo.data();
-		deviceCreateInfo.queueCreateInfoCount = (uint32_t)allQueueCreateInfo.size();
-
-		deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
-		if (vkCreateDevice(vulkanDevice, &deviceCreateInfo, nullptr, &logicalDevice) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Unable to create logical device");
-		}
+			cleanDebugMessengerUtils();
+		vkDestroySurfaceKHR(vulkanInstance, surface, nullptr);
+		vkDestroyInstance(vulkanInstance, nullptr);
+		glfwDestroyWindow(window);
+		glfwTerminate();
 
-		vkGetDeviceQueue(logicalDevice, queueIndices.graphicsCmdQueue, 0, &graphicsQueue);
-		vkGetDeviceQueue(logicalDevice, queueIndices.presentationCmdQueue, 0, &presentQueue);
-		vkGetDeviceQueue(logicalDevice, queueIndices.transferQueue, 0, &transferQueue);
+		vulkanInstance = nullptr;
+		window = nullptr;
 	}
 
-	void setupDebugMessengerUtils()
+	void initGLFW()
 	{
-		if (vulkan::VulkanTypes::fnVkCreateDebugUtilsMessengerExt != nullptr)
-		{
-			VkDebugUtilsMessengerCreateInfoEXT messengerInfo = {};
-			messengerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-			messengerInfo.pfnUserCallback = debugCallback;
-			messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT |
-				VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
-			messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT
-				| VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-			vulkan::VulkanTypes::fnVkCreateDebugUtilsMessengerExt(vulkanInstance, &messengerInfo, nullptr, &debugMessenger);
-		}
-		else
-		{
-			throw std::runtime_error("Debug Messenger utilities function is not available");
-		}
-	}
+		glfwInit();
 
-	void createSwapChain()
-	{
-		SwapChainSupport swapChainSupport = findSwapChainSupport(vulkanDevice);
-		choosenSurfaceFormat = swapChainSupport.chooseSurfaceFormat();
-		VkPresentModeKHR presentMode = swapChainSupport.choosePresentMode();
-		imageExtend = chooseSwapExtent(swapChainSupport.surfaceCapabilities);
-		uint32_t imageCount = swapChainSupport.surfaceCapabilities.minImageCount + 1;
-		imageCount = swapChainSupport.surfaceCapabilities.maxImageCount > 0 ?
-			std::min(swapChainSupport.surfaceCapabilities.maxImageCount, imageCount) : imageCount;
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
+		window = glfwCreateWindow(WND_WIDTH, WND_HEIGHT, "Vulkan Test", nullptr, nullptr);
 
+		glfwSetKeyCallback(window, keyCallback);
 
-		VkSwapchainCreateInfoKHR createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-		createInfo.surface = surface;
-		createInfo.clipped = VK_TRUE;
-		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-		createInfo.imageArrayLayers = 1;
-		createInfo.imageColorSpace = choosenSurfaceFormat.colorSpace;
-		createInfo.imageFormat = choosenSurfaceFormat.format;
-		createInfo.imageExtent = imageExtend;
-		createInfo.minImageCount = imageCount;
-		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-		createInfo.presentMode = presentMode;
-		createInfo.preTransform = swapChainSupport.surfaceCapabilities.currentTransform;// Use necessary flags if needed advanced operations
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+		framebufferWidth = width;
+		framebufferHeight = height;
 
-		QueueFamilyIndices queuesRequired = findQueueFamilyIndices(vulkanDevice);
-		uint32_t queues[] = { (uint32_t)queuesRequired.graphicsCmdQueue,(uint32_t)queuesRequired.presentationCmdQueue };
-		if (queuesRequired.graphicsCmdQueue != queuesRequired.presentationCmdQueue)
+		glfwSetWindowUserPointer(window, this);
+		glfwSetFramebufferSizeCallback(window, onWidowResize);
+		glfwSetWindowRefreshCallback(window, onWindowRefresh);
+	}
+
+	void initVulkan()
+	{
+		//loadModel(MDL_PATH);
+		if (bUseProceduralSurface)
 		{
-			createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-			createInfo.queueFamilyIndexCount = 2;
-			createInfo.pQueueFamilyIndices = queues;
+			initSurfaceParameters();
 		}
 		else
 		{
-			createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-			createInfo.queueFamilyIndexCount = 0;
-			createInfo.pQueueFamilyIndices = nullptr;
+			createCylinder(cylinderH, cylinderR, noOfSlices, cylinderAngle);
 		}
+		createVulkanInstance();
+		vulkan::VulkanTypes::setupNecessaryApi(vulkanInstance);
+		if (bUseDebugMessenger)
+			setupDebugMessengerUtils();
 
-		if (vkCreateSwapchainKHR(logicalDevice, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to create swap chain to draw images to!");
-		}
-	}
+		createSurface();
+		pickVulkanDevice();
+		createLogicalDevice();
+		createQualityGovernor();
+		createSwapChain();
+		obtainImageAndImgViews();
+		createRenderGraph();
+		reportRenderGraph();
+		createDescriptorLayout();
+		createRenderPipeline();
+		createCommandPool();
 
-	// Get the created images to draw and store handle to it
-	void obtainImageAndImgViews()
-	{
-		uint32_t imagesCount;
-		vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imagesCount, nullptr);
-		swapChainImages.resize(imagesCount);
-		vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imagesCount, swapChainImages.data());
+		createInstanceCullBuffers();
+		createGeometryBuffers();
+		// Streams are in device local buffers now, Cache mapping is not needed anymore
+		releaseModelMeshSource();
 
-		swapChainImageViews.resize(imagesCount);
+		textures.resize(noOfViews);
+		createImageTextureAndView("Textures/left.jpg",0);
+		createImageTextureAndView("Textures/right.jpg", 1);
+		createTextureSampler();
+		std::cout << "Texture cache hits : " << textureCache.getHits() << " misses : " << textureCache.getMisses() << std::endl;
 
-		for (size_t i = 0; i < imagesCount; i++)
-		{
-			createImageView(swapChainImages[i], 1, choosenSurfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, swapChainImageViews[i]);
-		}
+		createUniformBuffers();
+		createDescriptorPool();
+		allocDescriptorSets();
+		createInstanceDescriptorSet(geometrySlots[activeGeometrySlot]);
 
+		allocAndRecordCmdBuffers();
+		createSemaphores();
 	}
 
-	void cleanImageViews()
+	static void onWidowResize(GLFWwindow* window, int width, int height)
 	{
-		for (VkImageView &imgView : swapChainImageViews)
-		{
-			vkDestroyImageView(logicalDevice, imgView, nullptr);
-		}
-		swapChainImageViews.clear();
+		RenderingApplication* app = reinterpret_cast<RenderingApplication*>(glfwGetWindowUserPointer(window));
+		app->framebufferWidth = width;
+		app->framebufferHeight = height;
+		app->bIsWindowResized = true;
+		app->bIsFrameDirty = true;
+		app->wakeThreads();
 	}
 
-	void cleanDebugMessengerUtils()
+	// Window contents got damaged by system, Presents again even though nothing changed
+	static void onWindowRefresh(GLFWwindow* window)
 	{
-		if (vulkan::VulkanTypes::fnVkDestroyDebugUtilsMessengerExt != nullptr)
-		{
-			vulkan::VulkanTypes::fnVkDestroyDebugUtilsMessengerExt(vulkanInstance, debugMessenger, nullptr);
-		}
+		RenderingApplication* app = reinterpret_cast<RenderingApplication*>(glfwGetWindowUserPointer(window));
+		app->bIsFrameDirty = true;
+		app->wakeThreads();
 	}
 
-	void createRenderPass()
+	void createVulkanInstance()
 	{
-		VkAttachmentDescription colorAttachmentDesc = {};
-		colorAttachmentDesc.format = choosenSurfaceFormat.format;
-		colorAttachmentDesc.samples = msaaSampleBitsCount;
-
-		colorAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachmentDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-
-		colorAttachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-
-		colorAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentDescription depthAttachmentDesc = {};
-		depthAttachmentDesc.format = (depthFormat = chooseDepthImageFormat());
-		depthAttachmentDesc.samples = msaaSampleBitsCount;
-
-		depthAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachmentDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-
-		depthAttachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		depthAttachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-
-		depthAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentDescription colorAttachmentResolveDesc = {};
-		colorAttachmentResolveDesc.format = choosenSurfaceFormat.format;
-		colorAttachmentResolveDesc.samples = VK_SAMPLE_COUNT_1_BIT;
-
-		colorAttachmentResolveDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachmentResolveDesc.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-
-		colorAttachmentResolveDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachmentResolveDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-
-		colorAttachmentResolveDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachmentResolveDesc.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-		// Attachment references for subpasses
-		VkAttachmentReference colorAttachmentRef = {};
-		colorAttachmentRef.attachment = 0;
-		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference depthAttachmentRef = {};
-		depthAttachmentRef.attachment = 1;
-		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference colorAttachmentResolveRef = {};
-		colorAttachmentResolveRef.attachment = 2;
-		colorAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		// Subpass 
-		VkSubpassDescription subpassDesc = {};
-		subpassDesc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpassDesc.colorAttachmentCount = 1;
-		subpassDesc.pColorAttachments = &colorAttachmentRef;
-		subpassDesc.pDepthStencilAttachment = &depthAttachmentRef;
-		subpassDesc.pResolveAttachments = &colorAttachmentResolveRef;
-
-		// Render pass
-		VkRenderPassCreateInfo renderPassCreateInfo = {};
-		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassCreateInfo.subpassCount = 1;
-		renderPassCreateInfo.pSubpasses = &subpassDesc;
+		VkApplicationInfo appInfo = {};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "Test Render";
+		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.pEngineName = "No Engine";
+		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.apiVersion = VK_API_VERSION_1_0;
 
-		std::array<VkAttachmentDescription, 3> attachments = { colorAttachmentDesc,depthAttachmentDesc,colorAttachmentResolveDesc };
+		VkInstanceCreateInfo createInstanceInfo = VkInstanceCreateInfo();
+		createInstanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		createInstanceInfo.pApplicationInfo = &appInfo;
 
-		renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		renderPassCreateInfo.pAttachments = attachments.data();
+		uint32_t requiredExtensionCount;
+		const char **requiredExtensionNames = glfwGetRequiredInstanceExtensions(&requiredExtensionCount);
 
-		VkSubpassDependency dependencies = {};
-		dependencies.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependencies.dstSubpass = 0;
-		dependencies.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependencies.srcAccessMask = 0;
-		dependencies.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependencies.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		uint32_t sprtExtensionCount;
+		vkEnumerateInstanceExtensionProperties(nullptr, &sprtExtensionCount, nullptr);
+		std::vector<VkExtensionProperties> sprtExtensions(sprtExtensionCount);
+		vkEnumerateInstanceExtensionProperties(nullptr, &sprtExtensionCount, sprtExtensions.data());
 
-		renderPassCreateInfo.dependencyCount = 1;
-		renderPassCreateInfo.pDependencies = &dependencies;
+		std::vector<const char*> useableExtensions = getAvailableExtensions(sprtExtensions, ADDITIONAL_INSTANCE_EXTENSIONS);
 
-		if (vkCreateRenderPass(logicalDevice, &renderPassCreateInfo, nullptr, &renderPass) != VK_SUCCESS)
+		std::vector<const char*> finalExtensionList(useableExtensions.size() + requiredExtensionCount);
+		for (uint32_t i = 0; i < requiredExtensionCount; i++)
 		{
-			throw std::runtime_error("Failed creating render pass for current frame rendering");
+			finalExtensionList[i] = requiredExtensionNames[i];
+		}
+		for (uint32_t i = 0; i < useableExtensions.size(); i++)
+		{
+			finalExtensionList[requiredExtensionCount + i] = useableExtensions[i];
 		}
 
-		// Render pass for multi view
-
-		colorAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-		colorAttachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT;
-
-		depthAttachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT;
-
-		subpassDesc.pResolveAttachments = nullptr;
-
-		std::array<VkAttachmentDescription, 2> multiViewAttachments = { colorAttachmentDesc,depthAttachmentDesc };
-
-		renderPassCreateInfo.attachmentCount = (uint32_t)multiViewAttachments.size();
-		renderPassCreateInfo.pAttachments = multiViewAttachments.data();
+		createInstanceInfo.enabledExtensionCount = (uint32_t)finalExtensionList.size();
+		createInstanceInfo.ppEnabledExtensionNames = finalExtensionList.data();
 
-		const uint32_t viewMask = 0b00000011;
-		const uint32_t correlationMask = 0b00000011;
+		std::vector<const char*> finalLayerList = {};
+		if (bUseDebugMessenger)
+		{
+			uint32_t availableLayersCount;
+			vkEnumerateInstanceLayerProperties(&availableLayersCount, nullptr);
+			std::vector<VkLayerProperties> availableLayers(availableLayersCount);
+			vkEnumerateInstanceLayerProperties(&availableLayersCount, availableLayers.data());
 
-		VkRenderPassMultiviewCreateInfo multiViewRenderPassCI = {};
-		multiViewRenderPassCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
-		multiViewRenderPassCI.subpassCount = 1;
-		multiViewRenderPassCI.correlationMaskCount = 1;
-		multiViewRenderPassCI.pCorrelationMasks = &correlationMask;
-		multiViewRenderPassCI.pViewMasks = &viewMask;
+			finalLayerList = getAvailableLayers(availableLayers, LAYERS_TO_ENABLE);
+		}
 
-		renderPassCreateInfo.pNext = &multiViewRenderPassCI;
+		createInstanceInfo.enabledLayerCount = (uint32_t)finalLayerList.size();
+		createInstanceInfo.ppEnabledLayerNames = finalLayerList.data();
 
-		if (vkCreateRenderPass(logicalDevice, &renderPassCreateInfo, nullptr, &mvRenderPass) != VK_SUCCESS)
+		VkResult result = vkCreateInstance(&createInstanceInfo, nullptr, &vulkanInstance);
+		if (result == VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed creating render pass for multiview port rendering");
+			std::cout << "Successfully created Vulkan Instance" << std::endl;
+		}
+		else
+		{
+			std::string errorMsg = "Failure in instantiating Vulkan!\n Cause : ";
+			switch (result)
+			{
+			case VK_ERROR_LAYER_NOT_PRESENT:
+				errorMsg.append("One/More of requested Vulkan layer/s is not available");
+				break;
+			case VK_ERROR_EXTENSION_NOT_PRESENT:
+				errorMsg.append("One/More of requested Vulkan extension/s is not available");
+				break;
+			default:
+				errorMsg.append("Other Reasons");
+				break;
+			}
+			throw std::runtime_error(errorMsg.c_str());
 		}
 
 	}
 
-	void createDescriptorLayout()
+	void createSurface()
 	{
-		VkDescriptorSetLayoutBinding descriptorUboLayoutBind = {};
-		descriptorUboLayoutBind.binding = 0;
-		descriptorUboLayoutBind.descriptorCount = 1;
-		descriptorUboLayoutBind.pImmutableSamplers = nullptr;
-		descriptorUboLayoutBind.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorUboLayoutBind.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-
-		VkDescriptorSetLayoutBinding descriptorImageLayoutBind = {};
-		descriptorImageLayoutBind.binding = 1;
-		descriptorImageLayoutBind.descriptorCount = 1;
-		descriptorImageLayoutBind.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorImageLayoutBind.pImmutableSamplers = nullptr;
-		descriptorImageLayoutBind.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-		std::array<VkDescriptorSetLayoutBinding, 2> descriptors = { descriptorUboLayoutBind ,descriptorImageLayoutBind };
-
-		VkDescriptorSetLayoutCreateInfo descriptorLayoutCreateInfo = {};
-		descriptorLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		descriptorLayoutCreateInfo.bindingCount = static_cast<uint32_t>(descriptors.size());
-		descriptorLayoutCreateInfo.pBindings = descriptors.data();
-
-		if (vkCreateDescriptorSetLayout(logicalDevice, &descriptorLayoutCreateInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+		if (glfwCreateWindowSurface(vulkanInstance, window, nullptr, &surface) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failure in creating Descriptor Set Layout");
+			throw std::runtime_error("Failed to create Surface KHR from Window for process");
 		}
+	}
 
+	std::vector<const char*> getAvailableExtensions(std::vector<VkExtensionProperties>& detectedExt, const std::vector<const char*>&
+		queryingExtensions)
+	{
+		std::vector<const char*> returnData;
+		const char* extensionChars = nullptr;
+		std::string exts = "";
+		for (const VkExtensionProperties& ext : detectedExt)
+		{
+			exts.append(ext.extensionName);
+		}
+		extensionChars = exts.c_str();
+
+		for (const char* ext : queryingExtensions)
+		{
+			if (strstr(extensionChars, ext) != nullptr)
+			{
+				returnData.push_back(ext);
+			}
+			else
+			{
+				std::cerr << "Extension " << ext << " is not available" << std::endl;
+			}
+		}
+		returnData.shrink_to_fit();
+		return returnData;
+	}
+
+	std::vector<const char*> getAvailableLayers(std::vector<VkLayerProperties>& detectedLayers, const std::vector<const char*>&
+		queryingLayers)
+	{
+
+		std::vector<const char*> returnData;
+		const char* layerChars = nullptr;
+		std::string layers = "";
+		for (const VkLayerProperties& layer : detectedLayers)
+		{
+			layers.append(layer.layerName);
+		}
+		layerChars = layers.c_str();
+
+		for (const char* layer : queryingLayers)
+		{
+			if (strstr(layerChars, layer) != nullptr)
+			{
+				returnData.push_back(layer);
+			}
+			else
+			{
+				std::cerr << "Layer " << layer << " is not available" << std::endl;
+			}
+		}
+		returnData.shrink_to_fit();
+		return returnData;
+	}
+
+
+	void pickVulkanDevice()
+	{
+		uint32_t supportedDeviceCount = 0;
+		vkEnumeratePhysicalDevices(vulkanInstance, &supportedDeviceCount, nullptr);
+		if (supportedDeviceCount == 0)
+		{
+			throw std::runtime_error("No Vulkan supported Graphics devices is available");
+		}
+		std::vector<VkPhysicalDevice> availableDevices(supportedDeviceCount);
+		vkEnumeratePhysicalDevices(vulkanInstance, &supportedDeviceCount, availableDevices.data());
+		for (const VkPhysicalDevice device : availableDevices)
+		{
+			if (isDeviceSuitable(device))
+			{
+				vulkanDevice = device;
+				eyePassSampleCount = getMsaaSampleCount(requestedEyePassSamples);
+				distortionPassSampleCount = getMsaaSampleCount(requestedDistortionPassSamples);
+				std::cout << "MSAA eye pass " << eyePassSampleCount << "x, distortion pass " << distortionPassSampleCount << "x" << std::endl;
+				break;
+			}
+		}
+
+		if (vulkanDevice == VK_NULL_HANDLE)
+		{
+			std::runtime_error("Non of the available vulkan devices is suitable for the application");
+		}
+		else
+		{
+			VkPhysicalDeviceProperties deviceProps;
+			VkPhysicalDeviceFeatures deviceFeatures;
+			vkGetPhysicalDeviceProperties(vulkanDevice, &deviceProps);
+			vkGetPhysicalDeviceFeatures(vulkanDevice, &deviceFeatures);
+			std::cout << "Current GPU : " << deviceProps.deviceID << " - " << deviceProps.deviceName << std::endl;
+			std::cout << "GPU Type : " << deviceProps.deviceType << std::endl;
+			std::cout << "GPU Vendor ID : " << deviceProps.vendorID << std::endl;
+			std::cout << "GPU Support - Float64 : " << (deviceFeatures.shaderFloat64 == 0 ? "False" : "True") << " Int16 : "
+				<< (deviceFeatures.shaderInt16 == 0 ? "False" : "True") << std::endl;
+		}
+	}
+
+	bool isDeviceSuitable(const VkPhysicalDevice& device)
+	{
+		VkPhysicalDeviceProperties deviceProps;
+		VkPhysicalDeviceFeatures deviceFeatures;
+		vkGetPhysicalDeviceProperties(device, &deviceProps);
+		vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+
+		bool bHasSwapChainSupport = false;
+		if (checkDeviceExtensionAvailability(device))
+		{
+			SwapChainSupport swapChainSupport = findSwapChainSupport(device);
+			bHasSwapChainSupport = !(swapChainSupport.presentModes.empty() || swapChainSupport.surfaceFormats.empty());
+		}
+
+		return deviceProps.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU && deviceFeatures.geometryShader && deviceFeatures.samplerAnisotropy
+			&& deviceFeatures.multiDrawIndirect && deviceFeatures.drawIndirectFirstInstance
+			&&	findQueueFamilyIndices(device).isComplete() && bHasSwapChainSupport;
+	}
+
+	QueueFamilyIndices findQueueFamilyIndices(VkPhysicalDevice device)
+	{
+		QueueFamilyIndices queueFamilyIndices = {};
+
+		uint32_t availableQueueFamiliesCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &availableQueueFamiliesCount, nullptr);
+		std::vector<VkQueueFamilyProperties> availableQueueFamilies(availableQueueFamiliesCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &availableQueueFamiliesCount, availableQueueFamilies.data());
+
+		int i = 0;
+		for (const VkQueueFamilyProperties& queueFamProps : availableQueueFamilies)
+		{
+			if (queueFamProps.queueCount > 0)
+			{
+				// Instance culling is dispatched from graphics queue
+				if ((queueFamProps.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamProps.queueFlags & VK_QUEUE_COMPUTE_BIT))
+				{
+					queueFamilyIndices.graphicsCmdQueue = i;
+				}
+
+				if (queueFamilyIndices.transferQueue == -1 && queueFamProps.queueFlags & VK_QUEUE_TRANSFER_BIT
+					&& !(queueFamProps.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+				{
+					queueFamilyIndices.transferQueue = i;
+				}
+
+				VkBool32 isPresentable = false;
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &isPresentable);
+				if (isPresentable)
+				{
+					queueFamilyIndices.presentationCmdQueue = i;
+				}
+			}
+
+			if (queueFamilyIndices.isComplete())
+			{
+				break;
+			}
+			i++;
+		}
+
+		if (queueFamilyIndices.transferQueue == -1)
+		{
+			queueFamilyIndices.transferQueue = queueFamilyIndices.graphicsCmdQueue;
+		}
+		return queueFamilyIndices;
+	}
+
+	bool checkDeviceExtensionAvailability(VkPhysicalDevice device)
+	{
+		uint32_t availableExtCount = 0;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &availableExtCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(availableExtCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &availableExtCount, availableExtensions.data());
+
+		std::vector<const char*> verifiedExts = getAvailableExtensions(availableExtensions, ADDITIONAL_DEVICE_EXTENSIONS);
+		return verifiedExts.size() == ADDITIONAL_DEVICE_EXTENSIONS.size();
+	}
+
+	SwapChainSupport findSwapChainSupport(VkPhysicalDevice device)
+	{
+		SwapChainSupport support;
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &support.surfaceCapabilities);
+
+		uint32_t count = 0;
+		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &count, nullptr);
+		if (count > 0)
+		{
+			support.surfaceFormats.resize(count);
+			vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &count, support.surfaceFormats.data());
+		}
+
+		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &count, nullptr);
+		if (count > 0)
+		{
+			support.presentModes.resize(count);
+			vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &count, support.presentModes.data());
+		}
+
+		return support;
+	}
+
+	VkExtent2D chooseSwapExtent(VkSurfaceCapabilitiesKHR &surfaceCapabilities)
+	{
+		if (surfaceCapabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+		{
+
+			std::cout << "Current Frame buffer " << surfaceCapabilities.currentExtent.width << "x" <<
+				surfaceCapabilities.currentExtent.height << std::endl;
+			return surfaceCapabilities.currentExtent;
+		}
+		else
+		{
+			int width = framebufferWidth, height = framebufferHeight;
+
+			VkExtent2D extent = { static_cast<uint32_t>(width) ,static_cast<uint32_t>(height) };
+
+			std::cout << "Current Frame buffer " << width << "x" << height << std::endl;
+
+			extent.width = std::max(surfaceCapabilities.minImageExtent.width,
+				std::min(surfaceCapabilities.maxImageExtent.width, extent.width));
+			extent.height = std::max(surfaceCapabilities.minImageExtent.height,
+				std::min(surfaceCapabilities.maxImageExtent.height, extent.height));
+			return extent;
+		}
+	}
+
+	VkFormat chooseImageFormat(const std::vector<VkFormat>& checkFormats, VkImageTiling imageTiling, VkFormatFeatureFlags formatFeatureFlag)
+	{
+		for (const VkFormat format : checkFormats)
+		{
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(vulkanDevice, format, &props);
+
+			if (imageTiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & formatFeatureFlag) == formatFeatureFlag)
+			{
+				return format;
+			}
+			else if (imageTiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & formatFeatureFlag) == formatFeatureFlag)
+			{
+				return format;
+			}
+		}
+
+		throw std::runtime_error("None of requested formats supports necessary features for given tiling in this hardware");
+	}
+
+	VkFormat chooseDepthImageFormat()
+	{
+		return chooseImageFormat({ VK_FORMAT_D32_SFLOAT_S8_UINT,VK_FORMAT_D32_SFLOAT,VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+	}
+
+	bool hasStencilFormat(VkFormat format)
+	{
+		return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+	}
+
+	void createLogicalDevice() {
+		QueueFamilyIndices queueIndices = findQueueFamilyIndices(vulkanDevice);
+
+		std::vector<VkDeviceQueueCreateInfo> allQueueCreateInfo;
+		std::set<int> uniqueQueueIndex = { queueIndices.graphicsCmdQueue,queueIndices.presentationCmdQueue,queueIndices.transferQueue };
+
+		float queuePriority = 1.f;
+		// Late stage of asynchronous timewarp gets a second graphics queue of higher priority than eye frames when family has one
+		const float timewarpQueuePriorities[] = { 0.5f, 1.0f };
+
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(vulkanDevice, &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> familyProperties(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(vulkanDevice, &familyCount, familyProperties.data());
+		bool bHasLateQueue = bUseAsyncTimewarp && familyProperties[queueIndices.graphicsCmdQueue].queueCount > 1;
+
+		for (int queueIdx : uniqueQueueIndex)
+		{
+			VkDeviceQueueCreateInfo queueCreateInfo = {};
+			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueCreateInfo.queueCount = 1;
+			queueCreateInfo.queueFamilyIndex = queueIdx;
+
+			queueCreateInfo.pQueuePriorities = &queuePriority;
+			if (bHasLateQueue && queueIdx == queueIndices.graphicsCmdQueue)
+			{
+				queueCreateInfo.queueCount = 2;
+				queueCreateInfo.pQueuePriorities = timewarpQueuePriorities;
+			}
+
+			allQueueCreateInfo.push_back(queueCreateInfo);
+		}
+
+		VkPhysicalDeviceFeatures deviceFeatures = {};
+		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		// Detail levels are drawn with one indirect draw each from their own range of visible instances
+		deviceFeatures.multiDrawIndirect = VK_TRUE;
+		deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+
+		VkDeviceCreateInfo deviceCreateInfo = {};
+		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+
+		// Just do get supported extensions of device and check with required extensions when using one
+		std::vector<const char*> deviceExtensions = ADDITIONAL_DEVICE_EXTENSIONS;
+
+		// Display timing tells when presented frames reached the screen, Latency is measured up to present otherwise
+		uint32_t availableExtCount = 0;
+		vkEnumerateDeviceExtensionProperties(vulkanDevice, nullptr, &availableExtCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(availableExtCount);
+		vkEnumerateDeviceExtensionProperties(vulkanDevice, nullptr, &availableExtCount, availableExtensions.data());
+		bHasDisplayTiming = std::any_of(availableExtensions.begin(), availableExtensions.end(), [](const VkExtensionProperties& ext)
+		{
+			return strcmp(ext.extensionName, VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME) == 0;
+		});
+		if (bHasDisplayTiming)
+		{
+			deviceExtensions.push_back(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+		}
+
+		auto hasExtension = [&availableExtensions](const char* extensionName)
+		{
+			return std::any_of(availableExtensions.begin(), availableExtensions.end(), [extensionName](const VkExtensionProperties& ext)
+			{
+				return strcmp(ext.extensionName, extensionName) == 0;
+			});
+		};
+
+		// Timeline semaphores replace fences and binary semaphores between batches, Present wait lets frame limiter of latency profile wait
+		// until previous frame is on screen. Their features are queried through extension of instance
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+		VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+		presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+		VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+		presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+		bool bCanQueryFeatures = vulkan::VulkanTypes::fnVkGetPhysicalDeviceFeatures2Khr != nullptr;
+		bHasTimelineSemaphores = bCanQueryFeatures && bUseTimelineSemaphores && hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+		bHasPresentWait = bCanQueryFeatures && hasExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME) && hasExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+		if (bCanQueryFeatures)
+		{
+			timelineFeatures.pNext = &presentIdFeatures;
+			presentIdFeatures.pNext = &presentWaitFeatures;
+
+			VkPhysicalDeviceFeatures2KHR features = {};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+			features.pNext = &timelineFeatures;
+			vulkan::VulkanTypes::fnVkGetPhysicalDeviceFeatures2Khr(vulkanDevice, &features);
+			bHasTimelineSemaphores = bHasTimelineSemaphores && timelineFeatures.timelineSemaphore == VK_TRUE;
+			bHasPresentWait = bHasPresentWait && presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+		}
+
+		// Only features of enabled extensions are chained into device creation
+		void* enabledFeatures = nullptr;
+		if (bHasPresentWait)
+		{
+			deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+			presentWaitFeatures.pNext = nullptr;
+			presentIdFeatures.pNext = &presentWaitFeatures;
+			enabledFeatures = &presentIdFeatures;
+		}
+		if (bHasTimelineSemaphores)
+		{
+			deviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+			timelineFeatures.pNext = enabledFeatures;
+			enabledFeatures = &timelineFeatures;
+		}
+		deviceCreateInfo.pNext = enabledFeatures;
+
+		deviceCreateInfo.enabledExtensionCount = (uint32_t)deviceExtensions.size();
+		deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+
+		//Start Layers to Enable for logical device
+		std::vector<const char*> finalLayerList = {};
+		if (bUseDebugMessenger)
+		{
+			uint32_t availableLayersCount;
+			vkEnumerateDeviceLayerProperties(vulkanDevice, &availableLayersCount, nullptr);
+			std::vector<VkLayerProperties> availableLayers(availableLayersCount);
+			vkEnumerateDeviceLayerProperties(vulkanDevice, &availableLayersCount, availableLayers.data());
+
+			finalLayerList = getAvailableLayers(availableLayers, LAYERS_TO_ENABLE);
+		}
+
+		deviceCreateInfo.enabledLayerCount = (uint32_t)finalLayerList.size();
+		deviceCreateInfo.ppEnabledLayerNames = finalLayerList.data();
+		// End Layers
+		deviceCreateInfo.pQueueCreateInfos = allQueueCreateInfo.data();
+		deviceCreateInfo.queueCreateInfoCount = (uint32_t)allQueueCreateInfo.size();
+
+		deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
+		if (vkCreateDevice(vulkanDevice, &deviceCreateInfo, nullptr, &logicalDevice) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Unable to create logical device");
+		}
+		vulkan::VulkanTypes::setupDeviceApi(logicalDevice, bHasDisplayTiming, bHasTimelineSemaphores, bHasPresentWait);
+
+		vkGetDeviceQueue(logicalDevice, queueIndices.graphicsCmdQueue, 0, &graphicsQueue);
+		vkGetDeviceQueue(logicalDevice, queueIndices.presentationCmdQueue, 0, &presentQueue);
+		vkGetDeviceQueue(logicalDevice, queueIndices.transferQueue, 0, &transferQueue);
+
+		lateQueue = graphicsQueue;
+		if (bHasLateQueue)
+		{
+			vkGetDeviceQueue(logicalDevice, queueIndices.graphicsCmdQueue, 1, &lateQueue);
+		}
+		// Late stage presents itself, From its own queue when that family can present
+		latePresentQueue = queueIndices.presentationCmdQueue == queueIndices.graphicsCmdQueue ? lateQueue : presentQueue;
+
+		if (bHasTimelineSemaphores)
+		{
+			graphicsTimeline.create(logicalDevice, graphicsQueue);
+			transferTimeline.create(logicalDevice, transferQueue);
+			lateTimeline.create(logicalDevice, lateQueue);
+		}
+		std::cout << "Frame synchronization with " << (bHasTimelineSemaphores ? "timeline semaphores" : "fences and binary semaphores") << std::endl;
+	}
+
+	void setupDebugMessengerUtils()
+	{
+		if (vulkan::VulkanTypes::fnVkCreateDebugUtilsMessengerExt != nullptr)
+		{
+			VkDebugUtilsMessengerCreateInfoEXT messengerInfo = {};
+			messengerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+			messengerInfo.pfnUserCallback = debugCallback;
+			messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT |
+				VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+			messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT
+				| VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+			vulkan::VulkanTypes::fnVkCreateDebugUtilsMessengerExt(vulkanInstance, &messengerInfo, nullptr, &debugMessenger);
+		}
+		else
+		{
+			throw std::runtime_error("Debug Messenger utilities function is not available");
+		}
+	}
+
+	void createSwapChain()
+	{
+		SwapChainSupport swapChainSupport = findSwapChainSupport(vulkanDevice);
+		choosenSurfaceFormat = swapChainSupport.chooseSurfaceFormat();
+		VkPresentModeKHR presentMode = swapChainSupport.choosePresentMode(latencyProfile.presentModes);
+		imageExtend = chooseSwapExtent(swapChainSupport.surfaceCapabilities);
+		uint32_t imageCount = latencyProfile.swapchainImageCount > 0 ? latencyProfile.swapchainImageCount :
+			swapChainSupport.surfaceCapabilities.minImageCount + 1;
+		imageCount = std::max(swapChainSupport.surfaceCapabilities.minImageCount, std::min(imageCount, LatencyProfile::MAX_SWAPCHAIN_IMAGES));
+		imageCount = swapChainSupport.surfaceCapabilities.maxImageCount > 0 ?
+			std::min(swapChainSupport.surfaceCapabilities.maxImageCount, imageCount) : imageCount;
+		swapChainPresentMode = presentMode;
+		// Nothing was presented to new swap chain yet for frame limiter to wait on
+		lastPresentId = 0;
+
+
+
+		VkSwapchainCreateInfoKHR createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+		createInfo.surface = surface;
+		createInfo.clipped = VK_TRUE;
+		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		createInfo.imageArrayLayers = 1;
+		createInfo.imageColorSpace = choosenSurfaceFormat.colorSpace;
+		createInfo.imageFormat = choosenSurfaceFormat.format;
+		createInfo.imageExtent = imageExtend;
+		createInfo.minImageCount = imageCount;
+		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		createInfo.presentMode = presentMode;
+		createInfo.preTransform = swapChainSupport.surfaceCapabilities.currentTransform;// Use necessary flags if needed advanced operations
+		createInfo.oldSwapchain = VK_NULL_HANDLE;
+
+		QueueFamilyIndices queuesRequired = findQueueFamilyIndices(vulkanDevice);
+		uint32_t queues[] = { (uint32_t)queuesRequired.graphicsCmdQueue,(uint32_t)queuesRequired.presentationCmdQueue };
+		if (queuesRequired.graphicsCmdQueue != queuesRequired.presentationCmdQueue)
+		{
+			createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+			createInfo.queueFamilyIndexCount = 2;
+			createInfo.pQueueFamilyIndices = queues;
+		}
+		else
+		{
+			createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			createInfo.queueFamilyIndexCount = 0;
+			createInfo.pQueueFamilyIndices = nullptr;
+		}
+
+		if (vkCreateSwapchainKHR(logicalDevice, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create swap chain to draw images to!");
+		}
+	}
+
+	// Get the created images to draw and store handle to it
+	void obtainImageAndImgViews()
+	{
+		uint32_t imagesCount;
+		vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imagesCount, nullptr);
+		swapChainImages.resize(imagesCount);
+		vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imagesCount, swapChainImages.data());
+		std::cout << "Latency profile " << latencyProfile.name << ", " << latencyProfile.framesInFlight << " frames in flight, " << imagesCount
+			<< " swap chain images presented with " << LatencyProfile::getPresentModeName(swapChainPresentMode)
+			<< (latencyProfile.bLimitFrameRate ? ", Frames wait for previous present" : "") << std::endl;
+
+		swapChainImageViews.resize(imagesCount);
+
+		for (size_t i = 0; i < imagesCount; i++)
+		{
+			createImageView(swapChainImages[i], 1, choosenSurfaceFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, swapChainImageViews[i]);
+		}
+
+	}
+
+	void cleanImageViews()
+	{
+		for (VkImageView &imgView : swapChainImageViews)
+		{
+			vkDestroyImageView(logicalDevice, imgView, nullptr);
+		}
+		swapChainImageViews.clear();
+	}
+
+	void cleanDebugMessengerUtils()
+	{
+		if (vulkan::VulkanTypes::fnVkDestroyDebugUtilsMessengerExt != nullptr)
+		{
+			vulkan::VulkanTypes::fnVkDestroyDebugUtilsMessengerExt(vulkanInstance, debugMessenger, nullptr);
+		}
+	}
+
+	// Eye pass renders both eyes into layered eye color image that distortion pass samples, Resolving into it when multisampled.
+	// Distortion pass draws into swap chain image, Resolving from a multisampled target only when it has more than one sample
+	void createRenderGraph()
+	{
+		depthFormat = chooseDepthImageFormat();
+		VkFormat colorFormat = choosenSurfaceFormat.format;
+		const VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 1.f } };
+
+		RenderGraph::ResourceId swapchainImage = renderGraph.importImage("Swap chain image", colorFormat, swapChainImageViews,
+			VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+		// Eye images are kept between frames so that distortion pass can run again on them, Late stage of asynchronous timewarp samples
+		// one copy while next eye frame renders into another
+		RenderGraph::ImageDesc eyeColorDesc = { colorFormat, VK_SAMPLE_COUNT_1_BIT, noOfViews, true };
+		eyeColorDesc.copyCount = bUseAsyncTimewarp ? AsyncTimewarp::EYE_BUFFER_COUNT : 1;
+		RenderGraph::ResourceId eyeColor = renderGraph.createImage("Eye color", eyeColorDesc);
+		RenderGraph::ResourceId eyeDepth = renderGraph.createImage("Eye depth", { depthFormat, eyePassSampleCount, noOfViews });
+
+		eyePassId = renderGraph.addPass("Eye", 0b00000011);
+		if (eyePassSampleCount == VK_SAMPLE_COUNT_1_BIT)
+		{
+			renderGraph.clearColor(eyePassId, eyeColor, clearColor);
+		}
+		else
+		{
+			RenderGraph::ResourceId eyeMsaaColor = renderGraph.createImage("Eye multisampled color", { colorFormat, eyePassSampleCount, noOfViews });
+			renderGraph.clearColor(eyePassId, eyeMsaaColor, clearColor, eyeColor);
+		}
+		renderGraph.clearDepth(eyePassId, eyeDepth, { 1.0f, 0 });
+
+		// Fullscreen quads write every pixel of both halves so swap chain image is never cleared
+		distortionPassId = renderGraph.addPass("Distortion");
+		renderGraph.readSampled(distortionPassId, eyeColor, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		if (distortionPassSampleCount == VK_SAMPLE_COUNT_1_BIT)
+		{
+			renderGraph.writeColor(distortionPassId, swapchainImage);
+		}
+		else
+		{
+			RenderGraph::ResourceId distortionMsaaColor = renderGraph.createImage("Distortion multisampled color", { colorFormat, distortionPassSampleCount });
+			renderGraph.writeColor(distortionPassId, distortionMsaaColor, swapchainImage);
+		}
+
+		renderGraph.compile(vulkanDevice, logicalDevice, imageExtend.width, imageExtend.height);
+
+		renderPass = renderGraph.getRenderPass(distortionPassId);
+		mvRenderPass = renderGraph.getRenderPass(eyePassId);
+		mvColorTextureImageView = renderGraph.getImageView(eyeColor);
+		mvColorTextureImage = renderGraph.getImage(eyeColor);
+		bIsEyeImageValid = false;
+	}
+
+	// Estimate of attachment bandwidth that render graph saves every frame and memory it takes
+	void reportRenderGraph()
+	{
+		AttachmentTraffic traffic;
+		for (RenderGraph::PassId pass : { eyePassId, distortionPassId })
+		{
+			for (const AttachmentPolicy& policy : renderGraph.getAttachmentPolicies(pass))
+			{
+				traffic.add(policy, imageExtend.width, imageExtend.height);
+			}
+		}
+
+		const RenderGraph::Stats& stats = renderGraph.getStats();
+		const double MB = 1024.0 * 1024.0;
+		std::cout << "Render graph : " << stats.activePassCount << " passes(" << stats.culledPassCount << " culled) with " << stats.dependencyCount
+			<< " dependencies, " << traffic.bytes / MB << "MB cleared, loaded or stored per frame instead of " << traffic.unconditionalBytes / MB
+			<< "MB, " << stats.transientBytes / MB << "MB transient images in " << stats.allocatedTransientBytes / MB << "MB after aliasing of which "
+			<< stats.lazilyAllocatedBytes / MB << "MB is lazily allocated" << std::endl;
+	}
+
+	void createDescriptorLayout()
+	{
+		VkDescriptorSetLayoutBinding descriptorUboLayoutBind = {};
+		descriptorUboLayoutBind.binding = 0;
+		descriptorUboLayoutBind.descriptorCount = 1;
+		descriptorUboLayoutBind.pImmutableSamplers = nullptr;
+		descriptorUboLayoutBind.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorUboLayoutBind.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkDescriptorSetLayoutBinding descriptorImageLayoutBind = {};
+		descriptorImageLayoutBind.binding = 1;
+		descriptorImageLayoutBind.descriptorCount = 1;
+		descriptorImageLayoutBind.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorImageLayoutBind.pImmutableSamplers = nullptr;
+		descriptorImageLayoutBind.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		std::array<VkDescriptorSetLayoutBinding, 2> descriptors = { descriptorUboLayoutBind ,descriptorImageLayoutBind };
+
+		VkDescriptorSetLayoutCreateInfo descriptorLayoutCreateInfo = {};
+		descriptorLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorLayoutCreateInfo.bindingCount = static_cast<uint32_t>(descriptors.size());
+		descriptorLayoutCreateInfo.pBindings = descriptors.data();
+
+		if (vkCreateDescriptorSetLayout(logicalDevice, &descriptorLayoutCreateInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failure in creating Descriptor Set Layout");
+		}
+
+
+		descriptorImageLayoutBind.binding = 0;
+		descriptorImageLayoutBind.descriptorCount = noOfViews;
+
+		descriptorLayoutCreateInfo.bindingCount = 1;
+		descriptorLayoutCreateInfo.pBindings = &descriptorImageLayoutBind;
+
+		if (vkCreateDescriptorSetLayout(logicalDevice, &descriptorLayoutCreateInfo, nullptr, &textureDescriptorSetLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failure in creating Descriptor Set Layout for texture alone");
+		}
+
+		// Instance transforms, Visible instance indices and indirect draw command
+		std::array<VkDescriptorSetLayoutBinding, 3> instanceBindings = {};
+		for (uint32_t i = 0; i < instanceBindings.size(); i++)
+		{
+			instanceBindings[i].binding = i;
+			instanceBindings[i].descriptorCount = 1;
+			instanceBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			instanceBindings[i].pImmutableSamplers = nullptr;
+			instanceBindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		descriptorLayoutCreateInfo.bindingCount = static_cast<uint32_t>(instanceBindings.size());
+		descriptorLayoutCreateInfo.pBindings = instanceBindings.data();
+
+		if (vkCreateDescriptorSetLayout(logicalDevice, &descriptorLayoutCreateInfo, nullptr, &instanceDescriptorSetLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failure in creating Descriptor Set Layout for instances");
+		}
+	}
+
+	void createRenderPipeline()
+	{
+		// Multiview pipeline
+		// Start : Programmable section of pipeline
+
+		std::vector<char> fragShaderCode = readShaderFile("Shaders/eye.frag.spv");
+		std::vector<char> vertShaderCode = readShaderFile("Shaders/eye.vert.spv");
+
+		VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+		VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
+
+		VkPipelineShaderStageCreateInfo fragShaderCreateInfo = {};
+		fragShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		fragShaderCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		fragShaderCreateInfo.pName = "main";
+		fragShaderCreateInfo.module = fragShaderModule;
+
+		VkPipelineShaderStageCreateInfo vertShaderCreateInfo = {};
+		vertShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		vertShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+		vertShaderCreateInfo.pName = "main";
+		vertShaderCreateInfo.module = vertShaderModule;
+
+		VkPipelineShaderStageCreateInfo pipelineShaderStages[] = { fragShaderCreateInfo,vertShaderCreateInfo };
+
+		// End : Programmable section of pipeline
+
+		// Start : Fixed functions
+
+		// 1 Vertex Input defining stage
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		// Vertex attributes are filled per vertex layout when creating mesh pipelines
+		vertexInputInfo.vertexBindingDescriptionCount = 1;
+
+		// 2 Input Assembly stage
+		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {};
+		inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
+
+		// 3 Viewport and Scissor Rectangle, Dynamic as quality governor renders into part of eye image
+		VkViewport viewport = {};
+		viewport.x = viewport.y = 0;
+		viewport.width = (float)imageExtend.width;
+		viewport.height = (float)imageExtend.height;
+		viewport.maxDepth = 1;
+		viewport.minDepth = 0;
+
+		VkRect2D scissorRect = {};
+		scissorRect.extent = imageExtend;
+		scissorRect.offset = { 0,0 };
+
+		VkPipelineViewportStateCreateInfo viewportCreateInfo = {};
+		viewportCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportCreateInfo.scissorCount = 1;
+		viewportCreateInfo.pScissors = &scissorRect;
+		viewportCreateInfo.viewportCount = 1;
+		viewportCreateInfo.pViewports = &viewport;
+
+		// 4 Rasterization stage
+		VkPipelineRasterizationStateCreateInfo rasterizationCreateInfo = {};
+		rasterizationCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizationCreateInfo.rasterizerDiscardEnable = VK_FALSE;
+		rasterizationCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizationCreateInfo.depthClampEnable = VK_FALSE;
+		rasterizationCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+		rasterizationCreateInfo.lineWidth = 1.0f;
+		rasterizationCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterizationCreateInfo.depthBiasEnable = VK_FALSE;
+		rasterizationCreateInfo.depthBiasConstantFactor = rasterizationCreateInfo.depthBiasSlopeFactor = rasterizationCreateInfo.depthBiasClamp = 0.f;
+
+		// 5 Multisampling 
+		VkPipelineMultisampleStateCreateInfo multisamplingCreateInfo = {};
+		multisamplingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisamplingCreateInfo.alphaToCoverageEnable = VK_FALSE;
+		multisamplingCreateInfo.alphaToOneEnable = VK_FALSE;
+		multisamplingCreateInfo.minSampleShading = 1.0f;
+		multisamplingCreateInfo.pSampleMask = nullptr;
+		multisamplingCreateInfo.rasterizationSamples = eyePassSampleCount;
+
+		// 6 Stencils and Depth Test
+		VkPipelineDepthStencilStateCreateInfo depthStensilCreateInfo = {};
+		depthStensilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+
+		depthStensilCreateInfo.stencilTestEnable = VK_FALSE;
+		depthStensilCreateInfo.front = {};
+		depthStensilCreateInfo.back = {};
+
+		depthStensilCreateInfo.depthBoundsTestEnable = VK_FALSE;
+		depthStensilCreateInfo.maxDepthBounds = 1.0f;
+		depthStensilCreateInfo.minDepthBounds = 0.0f;
+
+		depthStensilCreateInfo.depthTestEnable = VK_TRUE;
+		depthStensilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+		depthStensilCreateInfo.depthWriteEnable = VK_TRUE;
+
+		// 7 Color Blending
+		VkPipelineColorBlendAttachmentState attachmentState = {};
+		attachmentState.blendEnable = VK_FALSE;
+		attachmentState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+			VK_COLOR_COMPONENT_A_BIT;
+		attachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+		attachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		attachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+		attachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
+		attachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		attachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+
+		VkPipelineColorBlendStateCreateInfo blendStateInfo = {};
+		blendStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		blendStateInfo.attachmentCount = 1;
+		blendStateInfo.pAttachments = &attachmentState;
+		blendStateInfo.logicOpEnable = VK_FALSE;
+		blendStateInfo.logicOp = VK_LOGIC_OP_COPY;
+		blendStateInfo.blendConstants[0] = blendStateInfo.blendConstants[1] = blendStateInfo.blendConstants[2] = blendStateInfo.blendConstants[3] = 0.f;
+
+		// 8 Dynamic states 
+		// TODO : Later
+		// 
+
+		// 9 Pipeline Layout creation
+
+		VkDescriptorSetLayout layouts[3] = { descriptorSetLayout , textureDescriptorSetLayout, instanceDescriptorSetLayout };
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		std::array<VkPushConstantRange, 2> pushConstantRanges = {};
+		pushConstantRanges[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRanges[0].offset = 0;
+		pushConstantRanges[0].size = sizeof(SurfaceParameters);
+		static_assert(sizeof(SurfaceParameters) <= CullParameters::OFFSET, "Push constant ranges of surface and culling overlap");
+		pushConstantRanges[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRanges[1].offset = CullParameters::OFFSET;
+		pushConstantRanges[1].size = sizeof(CullParameters);
+
+		pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+		pipelineLayoutCreateInfo.setLayoutCount = 3;
+		pipelineLayoutCreateInfo.pSetLayouts = layouts;
+
+		if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline layout");
+		}
+
+		// End : Fixed functions
+
+		VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineCreateInfo.pVertexInputState = &vertexInputInfo;
+		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyInfo;
+		pipelineCreateInfo.pTessellationState = nullptr;
+		pipelineCreateInfo.pViewportState = &viewportCreateInfo;
+		pipelineCreateInfo.pRasterizationState = &rasterizationCreateInfo;
+		pipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
+		pipelineCreateInfo.pDepthStencilState = &depthStensilCreateInfo;
+		std::array<VkDynamicState, 2> eyeDynamicStates = { VK_DYNAMIC_STATE_VIEWPORT,VK_DYNAMIC_STATE_SCISSOR };
+		VkPipelineDynamicStateCreateInfo eyeDynamicStateInfo = {};
+		eyeDynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		eyeDynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(eyeDynamicStates.size());
+		eyeDynamicStateInfo.pDynamicStates = eyeDynamicStates.data();
+
+		pipelineCreateInfo.pDynamicState = &eyeDynamicStateInfo;
+		pipelineCreateInfo.pColorBlendState = &blendStateInfo;
+
+		pipelineCreateInfo.layout = pipelineLayout;
+		pipelineCreateInfo.stageCount = 2;
+		pipelineCreateInfo.pStages = pipelineShaderStages;
+		pipelineCreateInfo.renderPass = mvRenderPass;
+		pipelineCreateInfo.subpass = 0;
+
+		pipelineCreateInfo.basePipelineHandle = nullptr;
+		pipelineCreateInfo.basePipelineIndex = -1;
+
+		for (VertexLayout layout : { VertexLayout::Full, VertexLayout::Compact })
+		{
+			auto vertexAttribDesc = Vertex::getAttributeDesc(layout);
+			auto vertexBindDesc = Vertex::getBindingDesc(layout);
+			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttribDesc.size());
+			vertexInputInfo.pVertexAttributeDescriptions = vertexAttribDesc.data();
+			vertexInputInfo.pVertexBindingDescriptions = &vertexBindDesc;
+
+			if (vkCreateGraphicsPipelines(logicalDevice, nullptr, 1, &pipelineCreateInfo, nullptr, &meshPipeLines[(uint32_t)layout]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed creating graphics pipeline");
+			}
+		}
+
+		// Procedural surface pipeline, Same states without any vertex input
+		std::vector<char> surfaceVertShaderCode = readShaderFile("Shaders/surface.vert.spv");
+		VkShaderModule surfaceVertShaderModule = createShaderModule(surfaceVertShaderCode);
+		pipelineShaderStages[1].module = surfaceVertShaderModule;
+
+		VkPipelineVertexInputStateCreateInfo surfaceVertexInputInfo = {};
+		surfaceVertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		pipelineCreateInfo.pVertexInputState = &surfaceVertexInputInfo;
+
+		if (vkCreateGraphicsPipelines(logicalDevice, nullptr, 1, &pipelineCreateInfo, nullptr, &surfacePipeLine) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed creating procedural surface pipeline");
+		}
+
+		vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
+		vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
+		vkDestroyShaderModule(logicalDevice, surfaceVertShaderModule, nullptr);
+
+		// Instance culling pipeline, Shares layout with eye pass pipelines so that descriptor set numbers match
+		std::vector<char> cullShaderCode = readShaderFile("Shaders/cull.comp.spv");
+		VkShaderModule cullShaderModule = createShaderModule(cullShaderCode);
+
+		VkComputePipelineCreateInfo cullPipelineCreateInfo = {};
+		cullPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		cullPipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		cullPipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		cullPipelineCreateInfo.stage.module = cullShaderModule;
+		cullPipelineCreateInfo.stage.pName = "main";
+		cullPipelineCreateInfo.layout = pipelineLayout;
+		cullPipelineCreateInfo.basePipelineHandle = nullptr;
+		cullPipelineCreateInfo.basePipelineIndex = -1;
+
+		if (vkCreateComputePipelines(logicalDevice, nullptr, 1, &cullPipelineCreateInfo, nullptr, &cullPipeLine) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed creating instance culling pipeline");
+		}
+
+		vkDestroyShaderModule(logicalDevice, cullShaderModule, nullptr);
+
+
+
+		// Frame Rendering Pipeline
+
+		float multiviewArrayLayer = 0.0f;
+
+		VkSpecializationMapEntry specializationMapEntry = {0,0,sizeof(float)};
+
+		VkSpecializationInfo specializationInfo = {};
+		specializationInfo.dataSize = sizeof(float);
+		specializationInfo.mapEntryCount = 1;
+		specializationInfo.pMapEntries = &specializationMapEntry;
+		specializationInfo.pData = &multiviewArrayLayer;
+
+		rasterizationCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+		// Only UBO and Rendered Targets Descriptors are needed for final frame pipeline passes
+		pipelineLayoutCreateInfo.setLayoutCount = 1;
+		pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+		pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
+		pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+
+		if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCreateInfo, nullptr, &mvPipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline layout");
+		}
+
+		for (uint32_t i = 0; i < noOfViews; i++)
+		{
+			fragShaderCode = readShaderFile("Shaders/frame.frag.spv");
+			vertShaderCode = readShaderFile("Shaders/frame.vert.spv");
+			fragShaderModule = createShaderModule(fragShaderCode);
+			vertShaderModule = createShaderModule(vertShaderCode);
+			fragShaderCreateInfo.module = fragShaderModule;
+			vertShaderCreateInfo.module = vertShaderModule;
+			fragShaderCreateInfo.pSpecializationInfo = &specializationInfo;
+
+			VkPipelineShaderStageCreateInfo frameShaderStages[] = { fragShaderCreateInfo,vertShaderCreateInfo };
+			
+			VkPipelineVertexInputStateCreateInfo inputStateInfo = {};
+			inputStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			
+			std::array<VkDynamicState, 2> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT,VK_DYNAMIC_STATE_SCISSOR };
+			VkPipelineDynamicStateCreateInfo dynamicStateInfo = {};
+			dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+			dynamicStateInfo.dynamicStateCount = (uint32_t)dynamicStates.size();
+			dynamicStateInfo.pDynamicStates = dynamicStates.data();
+
+			multisamplingCreateInfo.rasterizationSamples = distortionPassSampleCount;
+
+
+			pipelineCreateInfo.stageCount = 2;
+			pipelineCreateInfo.pRasterizationState = &rasterizationCreateInfo;
+			pipelineCreateInfo.pStages = frameShaderStages;
+			pipelineCreateInfo.pVertexInputState = &inputStateInfo;
+			pipelineCreateInfo.pDynamicState = &dynamicStateInfo;
+			pipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
+			pipelineCreateInfo.layout = mvPipelineLayout;
+			pipelineCreateInfo.renderPass = renderPass;
+
+			if (vkCreateGraphicsPipelines(logicalDevice, nullptr, 1, &pipelineCreateInfo, nullptr, &(mvFramePipelines[i])) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed creating frame graphics pipeline");
+			}
+
+			multiviewArrayLayer++;
+
+
+			vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
+			vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
+		}
+
+	}
+
+	// Creates device local buffers of slot for mesh and a staging buffer holding vertex stream followed by index stream
+	void stageGeometry(const MeshData& mesh, GeometrySlot& slot, VkBuffer& stagingBuffer, VkDeviceMemory& stagingBufferMemory)
+	{
+		slot.mesh = mesh;
+		slot.mesh.vertexData = nullptr;
+		slot.mesh.indexData = nullptr;
+
+		// Procedural surfaces has no vertex and index buffers
+		if (mesh.vertexCount == 0 || mesh.indexCount == 0)
+		{
+			return;
+		}
+
+		VkDeviceSize vertexDataSize = mesh.getVertexDataSize();
+		VkDeviceSize indexDataSize = mesh.getIndexDataSize();
+		VkDeviceSize instanceOffset = getInstanceStagingOffset(mesh);
+		VkDeviceSize instanceDataSize = MAX_INSTANCES * sizeof(glm::mat4);
+
+		createBufferMemory(instanceOffset + instanceDataSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBuffer, stagingBufferMemory);
+
+		uint8_t *data;
+
+		vkMapMemory(logicalDevice, stagingBufferMemory, 0, instanceOffset + instanceDataSize, 0, reinterpret_cast<void**>(&data));
+		memcpy(data, mesh.vertexData, (size_t)vertexDataSize);
+		memcpy(data + vertexDataSize, mesh.indexData, (size_t)indexDataSize);
+		writeInstanceTransforms(mesh, reinterpret_cast<glm::mat4*>(data + instanceOffset), MAX_INSTANCES);
+		vkUnmapMemory(logicalDevice, stagingBufferMemory);
+
+		createBufferMemory(vertexDataSize, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+			, slot.vertexBuffer, slot.vertexBufferMemory);
+		createBufferMemory(indexDataSize, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+			, slot.indicesBuffer, slot.indicesBufferMemory);
+		createBufferMemory(instanceDataSize, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+			, slot.instanceBuffer, slot.instanceBufferMemory);
+	}
+
+	// Instance transforms follows index stream in staging buffer
+	static VkDeviceSize getInstanceStagingOffset(const MeshData& mesh)
+	{
+		return (mesh.getVertexDataSize() + mesh.getIndexDataSize() + 15) & ~VkDeviceSize(15);
+	}
+
+	// Photo wall of instances facing the camera spaced by size of mesh, Square spiral order keeps any prefix of it centered on first instance
+	void writeInstanceTransforms(const MeshData& mesh, glm::mat4* transforms, uint32_t count) const
+	{
+		glm::vec3 extent(mesh.bounds.max[0] - mesh.bounds.min[0], mesh.bounds.max[1] - mesh.bounds.min[1], mesh.bounds.max[2] - mesh.bounds.min[2]);
+		float spacing = std::max(glm::length(extent) * 1.25f, 1.0f);
+
+		int32_t x = 0, y = 0, dx = 0, dy = -1;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			transforms[i] = glm::translate(glm::mat4(1.0f), glm::vec3(x * spacing, 0.0f, y * spacing));
+
+			if (x == y || (x < 0 && x == -y) || (x > 0 && x == 1 - y))
+			{
+				int32_t previousDx = dx;
+				dx = -dy;
+				dy = previousDx;
+			}
+			x += dx;
+			y += dy;
+		}
+	}
+
+	// Sphere around mesh in space of its vertex positions, Compact positions are normalized against mesh bounds
+	static glm::vec4 getMeshBoundingSphere(const MeshData& mesh)
+	{
+		if ((VertexLayout)mesh.vertexLayout == VertexLayout::Compact)
+		{
+			return glm::vec4(0.5f, 0.5f, 0.5f, 0.5f * std::sqrt(3.0f));
+		}
+
+		glm::vec3 boundsMin(mesh.bounds.min[0], mesh.bounds.min[1], mesh.bounds.min[2]);
+		glm::vec3 boundsMax(mesh.bounds.max[0], mesh.bounds.max[1], mesh.bounds.max[2]);
+		return glm::vec4((boundsMin + boundsMax) * 0.5f, glm::length(boundsMax - boundsMin) * 0.5f);
+	}
+
+	// Simplification errors are in model space, Compact positions are normalized against mesh bounds so errors are scaled along
+	static float getMeshLodErrorScale(const MeshData& mesh)
+	{
+		if ((VertexLayout)mesh.vertexLayout != VertexLayout::Compact)
+		{
+			return 1.0f;
+		}
+
+		float maxExtent = std::max({ mesh.bounds.max[0] - mesh.bounds.min[0], mesh.bounds.max[1] - mesh.bounds.min[1], mesh.bounds.max[2] - mesh.bounds.min[2] });
+		return maxExtent > 0.0f ? 1.0f / maxExtent : 1.0f;
+	}
+
+	// Outputs of instance culling, Shared by every eye pass since eye passes never overlap on the GPU.
+	// Every detail level has its own draw command and its own range of MAX_INSTANCES visible instances
+	void createInstanceCullBuffers()
+	{
+		createBufferMemory(MAX_MESH_LOD_COUNT * MAX_INSTANCES * sizeof(uint32_t), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			visibleInstanceBuffer, visibleInstanceBufferMemory);
+		createBufferMemory(MAX_MESH_LOD_COUNT * sizeof(VkDrawIndexedIndirectCommand), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, drawCommandBuffer, drawCommandBufferMemory);
+	}
+
+	// Instance set of a slot refers to its own instance transforms and the shared culling outputs
+	void createInstanceDescriptorSet(GeometrySlot& slot)
+	{
+		if (slot.instanceBuffer == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		VkDescriptorSetAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = descriptorPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &instanceDescriptorSetLayout;
+
+		if (vkAllocateDescriptorSets(logicalDevice, &allocateInfo, &slot.instanceDescriptorSet) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Unable to allocate Descriptor Set for instances from Pool");
+		}
+
+		std::array<VkDescriptorBufferInfo, 3> bufferInfos = {};
+		bufferInfos[0].buffer = slot.instanceBuffer;
+		bufferInfos[1].buffer = visibleInstanceBuffer;
+		bufferInfos[2].buffer = drawCommandBuffer;
+
+		std::array<VkWriteDescriptorSet, 3> writeDescriptorSets = {};
+		for (uint32_t i = 0; i < writeDescriptorSets.size(); i++)
+		{
+			bufferInfos[i].offset = 0;
+			bufferInfos[i].range = VK_WHOLE_SIZE;
+
+			writeDescriptorSets[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptorSets[i].descriptorCount = 1;
+			writeDescriptorSets[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writeDescriptorSets[i].dstBinding = i;
+			writeDescriptorSets[i].dstArrayElement = 0;
+			writeDescriptorSets[i].dstSet = slot.instanceDescriptorSet;
+			writeDescriptorSets[i].pBufferInfo = &bufferInfos[i];
+		}
+
+		vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+	}
+
+	void recordGeometryCopy(VkCommandBuffer cmdBuffer, VkBuffer stagingBuffer, const GeometrySlot& slot)
+	{
+		VkBufferCopy copyInfo = {};
+		copyInfo.srcOffset = 0;
+		copyInfo.dstOffset = 0;
+		copyInfo.size = slot.mesh.getVertexDataSize();
+		vkCmdCopyBuffer(cmdBuffer, stagingBuffer, slot.vertexBuffer, 1, &copyInfo);
+
+		copyInfo.srcOffset = copyInfo.size;
+		copyInfo.size = slot.mesh.getIndexDataSize();
+		vkCmdCopyBuffer(cmdBuffer, stagingBuffer, slot.indicesBuffer, 1, &copyInfo);
+
+		copyInfo.srcOffset = getInstanceStagingOffset(slot.mesh);
+		copyInfo.size = MAX_INSTANCES * sizeof(glm::mat4);
+		vkCmdCopyBuffer(cmdBuffer, stagingBuffer, slot.instanceBuffer, 1, &copyInfo);
+	}
+
+	// Uploads model mesh into active slot and waits for it, Nothing is drawn yet at start up so there is nothing to overlap with
+	void createGeometryBuffers()
+	{
+		VkBuffer stagingBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+
+		GeometrySlot& slot = geometrySlots[activeGeometrySlot];
+		stageGeometry(modelMesh, slot, stagingBuffer, stagingBufferMemory);
+		if (stagingBuffer == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		VkCommandBuffer copyCmdBuffer = startOneTimeCmdBuffer();
+		recordGeometryCopy(copyCmdBuffer, stagingBuffer, slot);
+		endOneTimeCmdBuffer(copyCmdBuffer);
+
+		vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
+		vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
+	}
+
+	void destroyGeometrySlot(GeometrySlot& slot)
+	{
+		if (slot.instanceDescriptorSet != VK_NULL_HANDLE)
+		{
+			vkFreeDescriptorSets(logicalDevice, descriptorPool, 1, &slot.instanceDescriptorSet);
+		}
+		vkDestroyBuffer(logicalDevice, slot.instanceBuffer, nullptr);
+		vkFreeMemory(logicalDevice, slot.instanceBufferMemory, nullptr);
+		vkDestroyBuffer(logicalDevice, slot.vertexBuffer, nullptr);
+		vkFreeMemory(logicalDevice, slot.vertexBufferMemory, nullptr);
+		vkDestroyBuffer(logicalDevice, slot.indicesBuffer, nullptr);
+		vkFreeMemory(logicalDevice, slot.indicesBufferMemory, nullptr);
+		slot = GeometrySlot();
+	}
+
+	// Imports model on loader thread into the shadow slot, Active slot keeps being drawn until upload is done and slots are flipped
+	void requestModel(const std::string& path)
+	{
+		if (geometryUploadState != GeometryUploadState::Idle)
+		{
+			std::cout << "Geometry replacement is already in progress, Ignoring " << path << std::endl;
+			return;
+		}
+
+		if (geometryLoaderThread.joinable())
+		{
+			geometryLoaderThread.join();
+		}
+
+		geometryUploadState = GeometryUploadState::Loading;
+		GeometrySlot* shadowSlot = &geometrySlots[activeGeometrySlot ^ 1];
+		geometryLoaderThread = std::thread([this, path, shadowSlot]()
+		{
+			// Import state and mesh cache are only touched by loader thread once start up is done
+			try
+			{
+				loadModel(path);
+				stageGeometry(modelMesh, *shadowSlot, geometryStagingBuffer, geometryStagingBufferMemory);
+				releaseModelMeshSource();
+
+				if (geometryStagingBuffer == VK_NULL_HANDLE)
+				{
+					throw std::runtime_error("Model has no triangles");
+				}
+				geometryUploadState = GeometryUploadState::Staged;
+				// Wakes main loop or render thread up if it is idle so that copy gets submitted
+				glfwPostEmptyEvent();
+				wakeThreads();
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "Failed replacing geometry with " << path << " : " << e.what() << std::endl;
+				releaseModelMeshSource();
+				destroyGeometrySlot(*shadowSlot);
+				vkDestroyBuffer(logicalDevice, geometryStagingBuffer, nullptr);
+				vkFreeMemory(logicalDevice, geometryStagingBufferMemory, nullptr);
+				geometryStagingBuffer = VK_NULL_HANDLE;
+				geometryStagingBufferMemory = VK_NULL_HANDLE;
+				geometryUploadState = GeometryUploadState::Idle;
+			}
+		});
+	}
+
+	// Stops drawing active slot, Its buffers are destroyed once every frame that could have referenced them is done
+	void retireActiveGeometry()
+	{
+		GeometrySlot& slot = geometrySlots[activeGeometrySlot];
+		if (slot.vertexBuffer != VK_NULL_HANDLE)
+		{
+			retiredGeometry.push_back({ slot, frameNumber, graphicsTimeline.getSubmittedValue() });
+		}
+		slot = GeometrySlot();
+	}
+
+	bool isGeometryCopyComplete()
+	{
+		if (bHasTimelineSemaphores)
+		{
+			return transferTimeline.isReached(geometryUploadTimelineValue);
+		}
+		if (vkGetFenceStatus(logicalDevice, geometryUploadFence) != VK_SUCCESS)
+		{
+			return false;
+		}
+		vkResetFences(logicalDevice, 1, &geometryUploadFence);
+		return true;
+	}
+
+	// Runs at frame boundary, Submits staged geometry copy, Flips slots once copy is done and frees retired buffers
+	void updateGeometrySlots()
+	{
+		// Frames submitted before retiring have all had their fence waited on once frames in flight passed, Graphics timeline
+		// tells right away when they are done instead
+		for (auto it = retiredGeometry.begin(); it != retiredGeometry.end();)
+		{
+			bool bIsUnused = bHasTimelineSemaphores ? graphicsTimeline.isReached(it->retireTimelineValue) :
+				frameNumber >= it->retireFrame + latencyProfile.framesInFlight;
+			if (bIsUnused)
+			{
+				destroyGeometrySlot(it->slot);
+				it = retiredGeometry.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		if (geometryUploadState == GeometryUploadState::Staged)
+		{
+			VkCommandBufferAllocateInfo allocationInfo = {};
+			allocationInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocationInfo.commandBufferCount = 1;
+			allocationInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocationInfo.commandPool = transferCmdPool;
+
+			if (vkAllocateCommandBuffers(logicalDevice, &allocationInfo, &geometryCopyCmdBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to Allocate geometry copy command buffer");
+			}
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+			vkBeginCommandBuffer(geometryCopyCmdBuffer, &beginInfo);
+			recordGeometryCopy(geometryCopyCmdBuffer, geometryStagingBuffer, geometrySlots[activeGeometrySlot ^ 1]);
+			vkEndCommandBuffer(geometryCopyCmdBuffer);
+
+			VkSubmitInfo cmdSubmitInfo = {};
+			cmdSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			cmdSubmitInfo.commandBufferCount = 1;
+			cmdSubmitInfo.pCommandBuffers = &geometryCopyCmdBuffer;
+
+			// Fence or transfer timeline is polled on following frames instead of waiting on transfer queue
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (bHasTimelineSemaphores)
+			{
+				geometryUploadTimelineValue = transferTimeline.submit(cmdSubmitInfo);
+			}
+			else if (vkQueueSubmit(transferQueue, 1, &cmdSubmitInfo, geometryUploadFence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Error when submitting geometry copy to transfer queue");
+			}
+			geometryUploadState = GeometryUploadState::Copying;
+		}
+		else if (geometryUploadState == GeometryUploadState::Copying && isGeometryCopyComplete())
+		{
+			vkFreeCommandBuffers(logicalDevice, transferCmdPool, 1, &geometryCopyCmdBuffer);
+			vkDestroyBuffer(logicalDevice, geometryStagingBuffer, nullptr);
+			vkFreeMemory(logicalDevice, geometryStagingBufferMemory, nullptr);
+			geometryCopyCmdBuffer = VK_NULL_HANDLE;
+			geometryStagingBuffer = VK_NULL_HANDLE;
+			geometryStagingBufferMemory = VK_NULL_HANDLE;
+
+			retireActiveGeometry();
+			activeGeometrySlot ^= 1;
+			createInstanceDescriptorSet(geometrySlots[activeGeometrySlot]);
+			bUseProceduralSurface = false;
+			eyePassVersion++;
+			geometryUploadState = GeometryUploadState::Idle;
+
+			const MeshData& mesh = geometrySlots[activeGeometrySlot].mesh;
+			std::cout << "Geometry replaced with " << mesh.vertexCount << " vertices " << mesh.indexCount << " indices at frame " << frameNumber << std::endl;
+		}
+	}
+
+	// Switches back to procedural surface, Retiring mesh geometry
+	void useProceduralSurface()
+	{
+		retireActiveGeometry();
+		bUseProceduralSurface = true;
+		eyePassVersion++;
+	}
+
+	void cleanGeometry()
+	{
+		if (geometryLoaderThread.joinable())
+		{
+			geometryLoaderThread.join();
+		}
+
+		vkDestroyBuffer(logicalDevice, geometryStagingBuffer, nullptr);
+		vkFreeMemory(logicalDevice, geometryStagingBufferMemory, nullptr);
+		for (GeometrySlot& slot : geometrySlots)
+		{
+			destroyGeometrySlot(slot);
+		}
+		for (RetiredGeometry& retired : retiredGeometry)
+		{
+			destroyGeometrySlot(retired.slot);
+		}
+		retiredGeometry.clear();
+	}
+
+
+	void createUniformBuffers()
+	{
+		VkDeviceSize size = sizeof(ProjectionData);
+		// Latency profiles change swap chain image count at runtime
+		uint32_t bufferCount = std::max((uint32_t)swapChainImageViews.size(), LatencyProfile::MAX_SWAPCHAIN_IMAGES);
+
+		uniformBuffers.resize(bufferCount);
+		uniformBuffersMemory.resize(bufferCount);
+
+		for (uint32_t i = 0; i < bufferCount; i++)
+		{
+			createBufferMemory(size, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
+		}
+
+		// Written on every frame as late as possible so mapping is not repeated
+		distortionUniformBuffers.resize(bufferCount);
+		distortionUniformBuffersMemory.resize(bufferCount);
+		distortionUniformData.resize(bufferCount);
+
+		for (uint32_t i = 0; i < bufferCount; i++)
+		{
+			createBufferMemory(sizeof(DistortionData), VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, distortionUniformBuffers[i], distortionUniformBuffersMemory[i]);
+			vkMapMemory(logicalDevice, distortionUniformBuffersMemory[i], 0, sizeof(DistortionData), 0, (void**)&distortionUniformData[i]);
+		}
+	}
+
+	void cleanUniformBuffers()
+	{
+		for (size_t i = 0; i < uniformBuffers.size(); i++)
+		{
+			vkDestroyBuffer(logicalDevice, uniformBuffers[i], nullptr);
+			vkFreeMemory(logicalDevice, uniformBuffersMemory[i], nullptr);
+			vkUnmapMemory(logicalDevice, distortionUniformBuffersMemory[i]);
+			vkDestroyBuffer(logicalDevice, distortionUniformBuffers[i], nullptr);
+			vkFreeMemory(logicalDevice, distortionUniformBuffersMemory[i], nullptr);
+		}
+	}
+
+
+	void createDescriptorPool()
+	{
+
+		std::array<VkDescriptorPoolSize, 4> poolSizes;
+		// Eye and distortion pass sets of every swap chain image any latency profile can have and ones of late stage of asynchronous
+		// timewarp, One per distortion strip
+		uint32_t imageCount = static_cast<uint32_t>(uniformBuffers.size());
+		poolSizes[0].descriptorCount = 2 * imageCount + StripScheduler::MAX_STRIPS;
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		poolSizes[1].descriptorCount = 2 * imageCount + StripScheduler::MAX_STRIPS;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[2].descriptorCount = 2;
+		poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSizes[3].descriptorCount = 3 * MAX_INSTANCE_DESCRIPTOR_SETS;
+		poolSizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+		VkDescriptorPoolCreateInfo descPoolCreateInfo = {};
+		descPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		// Sets are freed individually on swap chain recreation and when geometry slots are destroyed
+		descPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		descPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		descPoolCreateInfo.pPoolSizes = poolSizes.data();
+		descPoolCreateInfo.maxSets = 2 * imageCount + 1 + StripScheduler::MAX_STRIPS + MAX_INSTANCE_DESCRIPTOR_SETS;
+
+		if (vkCreateDescriptorPool(logicalDevice, &descPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failure in creating Descriptor Set Pool");
+		}
+	}
+
+	// Points set at range bytes from offset of uniform buffer and both eye images
+	void writeFrameDescriptorSet(VkDescriptorSet descriptorSet, VkBuffer uniformBuffer, VkDeviceSize range, VkDeviceSize offset = 0)
+	{
+		VkDescriptorBufferInfo descBufferInfo = {};
+		descBufferInfo.buffer = uniformBuffer;
+		descBufferInfo.offset = offset;
+		descBufferInfo.range = range;
+
+		VkDescriptorImageInfo descImageInfo = {};
+		descImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		descImageInfo.imageView = mvColorTextureImageView;
+		descImageInfo.sampler = mvColorTextureSampler;
+
+		VkWriteDescriptorSet bufferWriteDescriptorSet = {};
+		bufferWriteDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		bufferWriteDescriptorSet.descriptorCount = 1;
+		bufferWriteDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		bufferWriteDescriptorSet.dstBinding = 0;
+		bufferWriteDescriptorSet.dstArrayElement = 0;
+		bufferWriteDescriptorSet.dstSet = descriptorSet;
+		bufferWriteDescriptorSet.pBufferInfo = &descBufferInfo;
+		bufferWriteDescriptorSet.pImageInfo = nullptr;
+		bufferWriteDescriptorSet.pTexelBufferView = nullptr;
+
+		VkWriteDescriptorSet imageWriteDescriptorSet = {};
+		imageWriteDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		imageWriteDescriptorSet.descriptorCount = 1;
+		imageWriteDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		imageWriteDescriptorSet.dstBinding = 1;
+		imageWriteDescriptorSet.dstArrayElement = 0;
+		imageWriteDescriptorSet.dstSet = descriptorSet;
+		imageWriteDescriptorSet.pBufferInfo = nullptr;
+		imageWriteDescriptorSet.pImageInfo = &descImageInfo;
+		imageWriteDescriptorSet.pTexelBufferView = nullptr;
+
+		std::array<VkWriteDescriptorSet, 2> writeDescriptorSets = { bufferWriteDescriptorSet ,imageWriteDescriptorSet };
+
+		vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(),
+			0, nullptr);
+	}
+
+	void allocDescriptorSets()
+	{
+		{
+			std::vector<VkDescriptorSetLayout> layouts(swapChainImageViews.size(), descriptorSetLayout);
+
+			VkDescriptorSetAllocateInfo allocateInfo = {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocateInfo.descriptorPool = descriptorPool;
+			allocateInfo.descriptorSetCount = static_cast<uint32_t>(swapChainImageViews.size());
+			allocateInfo.pSetLayouts = layouts.data();
+
+			descriptorSets.resize(swapChainImageViews.size());
+			distortionDescriptorSets.resize(swapChainImageViews.size());
+
+			if (vkAllocateDescriptorSets(logicalDevice, &allocateInfo, descriptorSets.data()) != VK_SUCCESS ||
+				vkAllocateDescriptorSets(logicalDevice, &allocateInfo, distortionDescriptorSets.data()) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Unable to allocate Descriptor Sets for UBO and Sample Texture from Pool");
+			}
+
+			// Eye and distortion passes share set layout but read their own uniform blocks
+			for (int i = 0; i < swapChainImageViews.size(); i++)
+			{
+				writeFrameDescriptorSet(descriptorSets[i], uniformBuffers[i], sizeof(ProjectionData));
+				writeFrameDescriptorSet(distortionDescriptorSets[i], distortionUniformBuffers[i], sizeof(DistortionData));
+			}
+		}
+
+		{
+			// Made all to descriptor sets to 1 as they are not needed
+
+
+			VkDescriptorSetAllocateInfo allocateInfo = {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocateInfo.descriptorPool = descriptorPool;
+			allocateInfo.descriptorSetCount = 1;
+			allocateInfo.pSetLayouts = &textureDescriptorSetLayout;
+
+
+
+			if (vkAllocateDescriptorSets(logicalDevice, &allocateInfo, &textureDescriptorSet) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Unable to allocate Descriptor Sets for textures from Pool");
+			}
+
+			//for (int i = 0; i < 1; i++)
+			//{
+				VkDescriptorImageInfo descImageInfo = {};
+				descImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				descImageInfo.imageView = textures[0].textureImageView;
+				descImageInfo.sampler = textures[0].textureSampler;
+
+				VkDescriptorImageInfo descImageInfo01 = {};
+				descImageInfo01.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				descImageInfo01.imageView = textures[1].textureImageView;
+				descImageInfo01.sampler = textures[1].textureSampler;
+
+				VkWriteDescriptorSet imageWriteDescriptorSet = {};
+				imageWriteDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				imageWriteDescriptorSet.descriptorCount = 1;
+				imageWriteDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				imageWriteDescriptorSet.dstBinding = 0;
+				imageWriteDescriptorSet.dstArrayElement = 0;
+				imageWriteDescriptorSet.dstSet = textureDescriptorSet;
+				imageWriteDescriptorSet.pBufferInfo = nullptr;
+				imageWriteDescriptorSet.pImageInfo = &descImageInfo;
+				imageWriteDescriptorSet.pTexelBufferView = nullptr;
+
+				VkWriteDescriptorSet imageWriteDescriptorSet01 = {};
+				imageWriteDescriptorSet01.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				imageWriteDescriptorSet01.descriptorCount = 1;
+				imageWriteDescriptorSet01.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				imageWriteDescriptorSet01.dstBinding = 0;
+				imageWriteDescriptorSet01.dstArrayElement = 1;
+				imageWriteDescriptorSet01.dstSet = textureDescriptorSet;
+				imageWriteDescriptorSet01.pBufferInfo = nullptr;
+				imageWriteDescriptorSet01.pImageInfo = &descImageInfo01;
+				imageWriteDescriptorSet01.pTexelBufferView = nullptr;
+
+				std::array<VkWriteDescriptorSet, 2> writeImages = { imageWriteDescriptorSet ,imageWriteDescriptorSet01 };
+
+				vkUpdateDescriptorSets(logicalDevice, (uint32_t)writeImages.size(), writeImages.data(),0, nullptr);
+			//}
+		}
+
+
+	}
+
+	uint32_t chooseMemoryType(uint32_t filterMemType, VkMemoryPropertyFlags propertyFlags)
+	{
+		VkPhysicalDeviceMemoryProperties memProperties;
+		vkGetPhysicalDeviceMemoryProperties(vulkanDevice, &memProperties);
+
+		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+		{
+			if (filterMemType & (1 << i) && (memProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags)
+			{
+				return i;
+			}
+		}
+
+		throw std::runtime_error("No suitable memory type is available for Vertex buffer");
+	}
+
+	void createCommandPool()
+	{
+		QueueFamilyIndices queueFamilies = findQueueFamilyIndices(vulkanDevice);
+
+		VkCommandPoolCreateInfo cmdPoolCreateInfo = {};
+		cmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		cmdPoolCreateInfo.queueFamilyIndex = queueFamilies.graphicsCmdQueue;
+		// Eye pass command buffers gets re-recorded individually when surface parameters changes
+		cmdPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if (vkCreateCommandPool(logicalDevice, &cmdPoolCreateInfo, nullptr, &graphicsCmdPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed creating Graphics Command Pool");
+		}
+
+		if (queueFamilies.transferQueue != queueFamilies.graphicsCmdQueue)
+		{
+			cmdPoolCreateInfo.queueFamilyIndex = queueFamilies.transferQueue;
+
+			if (vkCreateCommandPool(logicalDevice, &cmdPoolCreateInfo, nullptr, &transferCmdPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed creating Buffer Transfer Command Pool");
+			}
+		}
+		else
+		{
+			transferCmdPool = graphicsCmdPool;
+		}
+	}
 
-		descriptorImageLayoutBind.binding = 0;
-		descriptorImageLayoutBind.descriptorCount = noOfViews;
-
-		descriptorLayoutCreateInfo.bindingCount = 1;
-		descriptorLayoutCreateInfo.pBindings = &descriptorImageLayoutBind;
+	void allocAndRecordCmdBuffers()
+	{
+		graphicsCmdBuffers.resize(swapChainImages.size());
+		VkCommandBufferAllocateInfo cmdBufferAllocInfo = {};
+		cmdBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		cmdBufferAllocInfo.commandBufferCount = (uint32_t)graphicsCmdBuffers.size();
+		cmdBufferAllocInfo.commandPool = graphicsCmdPool;
+		cmdBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-		if (vkCreateDescriptorSetLayout(logicalDevice, &descriptorLayoutCreateInfo, nullptr, &textureDescriptorSetLayout) != VK_SUCCESS)
+		if (vkAllocateCommandBuffers(logicalDevice, &cmdBufferAllocInfo, graphicsCmdBuffers.data()) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failure in creating Descriptor Set Layout for texture alone");
+			throw std::runtime_error("Failed to allocate command buffers");
+		}
+
+		recordedEyePassVersions.assign(graphicsCmdBuffers.size(), 0);
+		for (uint32_t i = 0; i < graphicsCmdBuffers.size(); i++)
+		{
+			recordEyePassCmdBuffer(i);
+		}
+
+		// Final frame rendering command buffer
+		mvCmdBuffers.resize(swapChainImages.size());
+
+		if (vkAllocateCommandBuffers(logicalDevice, &cmdBufferAllocInfo, mvCmdBuffers.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate command buffers");
+		}
+
+		for (uint32_t i = 0; i < mvCmdBuffers.size(); i++)
+		{
+			recordDistortionPass(mvCmdBuffers[i], i, distortionDescriptorSets[i], VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT, nullptr, passTimer.isCreated());
 		}
 	}
 
-	void createRenderPipeline()
+	// Records distortion pass of both eyes into swap chain image, Uniforms of descriptor set are written after recording right before submit.
+	// Given a strip only its rows are drawn, Strips after first one keep what earlier ones drew. Timed passes end frame span of imageIndex
+	void recordDistortionPass(VkCommandBuffer cmdBuffer, uint32_t imageIndex, VkDescriptorSet descriptorSet, VkCommandBufferUsageFlags usageFlags,
+		const StripScheduler::Strip* strip = nullptr, bool bIsTimed = false)
 	{
-		// Multiview pipeline
-		// Start : Programmable section of pipeline
+		VkCommandBufferBeginInfo cmdBuffBeginInfo = {};
+		cmdBuffBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		cmdBuffBeginInfo.flags = usageFlags;
+		cmdBuffBeginInfo.pInheritanceInfo = nullptr;
 
-		std::vector<char> fragShaderCode = readShaderFile("Shaders/eye.frag.spv");
-		std::vector<char> vertShaderCode = readShaderFile("Shaders/eye.vert.spv");
+		if (vkBeginCommandBuffer(cmdBuffer, &cmdBuffBeginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin command buffer");
+		}
 
-		VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
-		VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
+		bool bLoadsEarlierStrips = strip != nullptr && strip->index > 0;
+		VkRenderPassBeginInfo renderPassBeginInfo = {};
+		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassBeginInfo.renderPass = bLoadsEarlierStrips ? stripRenderPass : renderPass;
+		renderPassBeginInfo.framebuffer = bLoadsEarlierStrips ? stripFramebuffers[imageIndex] : renderGraph.getFramebuffer(distortionPassId, imageIndex);
+		renderPassBeginInfo.renderArea.offset = { 0, strip ? (int32_t)strip->firstRow : 0 };
+		renderPassBeginInfo.renderArea.extent = { imageExtend.width, strip ? strip->rowCount : imageExtend.height };
 
-		VkPipelineShaderStageCreateInfo fragShaderCreateInfo = {};
-		fragShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragShaderCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragShaderCreateInfo.pName = "main";
-		fragShaderCreateInfo.module = fragShaderModule;
+		const std::vector<VkClearValue>& clearVals = renderGraph.getClearValues(distortionPassId);
+		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearVals.size());
+		renderPassBeginInfo.pClearValues = clearVals.data();
 
-		VkPipelineShaderStageCreateInfo vertShaderCreateInfo = {};
-		vertShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertShaderCreateInfo.pName = "main";
-		vertShaderCreateInfo.module = vertShaderModule;
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-		VkPipelineShaderStageCreateInfo pipelineShaderStages[] = { fragShaderCreateInfo,vertShaderCreateInfo };
+		VkViewport viewport = {};
+		viewport.x = viewport.y = 0;
+		viewport.width = imageExtend.width/2.0f;
+		viewport.height = (float)imageExtend.height;
+		viewport.maxDepth = 1;
+		viewport.minDepth = 0;
 
-		// End : Programmable section of pipeline
+		// Eyes keep their whole viewport in strips, Scissor cuts out rows of the strip
+		VkRect2D scissorRect = {};
+		scissorRect.extent = { imageExtend.width/2 ,renderPassBeginInfo.renderArea.extent.height};
+		scissorRect.offset = { 0,renderPassBeginInfo.renderArea.offset.y };
 
-		// Start : Fixed functions
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(cmdBuffer, 0, 1, &scissorRect);
 
-		// 1 Vertex Input defining stage
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		auto vertexAttribDesc = Vertex::getAttributeDesc();
-		auto vertexBindDesc = Vertex::getBindingDesc();
-		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttribDesc.size());
-		vertexInputInfo.pVertexAttributeDescriptions = vertexAttribDesc.data();
-		vertexInputInfo.vertexBindingDescriptionCount = 1;
-		vertexInputInfo.pVertexBindingDescriptions = &vertexBindDesc;
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mvPipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
 
-		// 2 Input Assembly stage
-		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {};
-		inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mvFramePipelines[0]);
+		vkCmdDraw(cmdBuffer, 4, 1, 0, 0);
+
+		viewport.x = imageExtend.width / 2.0f;
+		scissorRect.offset.x = imageExtend.width / 2;
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(cmdBuffer, 0, 1, &scissorRect);
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mvFramePipelines[1]);
+		vkCmdDraw(cmdBuffer, 4, 1, 0, 0);
+
+		vkCmdEndRenderPass(cmdBuffer);
+		if (bIsTimed)
+		{
+			passTimer.recordEnd(cmdBuffer, imageIndex, TIMED_FRAME_SPAN);
+		}
+
+		if (vkEndCommandBuffer(cmdBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Error in ending command buffer recording");
+		}
+	}
+
+	// Records multiview eye pass, Either procedural surface or model mesh
+	void recordEyePassCmdBuffer(uint32_t imageIndex)
+	{
+		VkCommandBuffer cmdBuffer = graphicsCmdBuffers[imageIndex];
+
+		VkCommandBufferBeginInfo cmdBuffBeginInfo = {};
+		cmdBuffBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		cmdBuffBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		cmdBuffBeginInfo.pInheritanceInfo = nullptr;
+
+		if (vkBeginCommandBuffer(cmdBuffer, &cmdBuffBeginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin command buffer");
+		}
+
+		// Quality governor scales eye pass down into top left part of eye image, Which keeps its size
+		VkExtent2D eyeRenderExtent = getEyeRenderExtent();
+		VkRenderPassBeginInfo renderPassBeginInfo = {};
+		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassBeginInfo.renderPass = mvRenderPass;
+		renderPassBeginInfo.framebuffer = renderGraph.getFramebuffer(eyePassId, imageIndex);
+		renderPassBeginInfo.renderArea.offset = { 0,0 };
+		renderPassBeginInfo.renderArea.extent = eyeRenderExtent;
+
+		const std::vector<VkClearValue>& clearVals = renderGraph.getClearValues(eyePassId);
+		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearVals.size());
+		renderPassBeginInfo.pClearValues = clearVals.data();
+
+		const GeometrySlot& slot = geometrySlots[activeGeometrySlot];
+
+		// Frame span starts before culling and ends with distortion pass
+		if (passTimer.isCreated())
+		{
+			passTimer.recordBegin(cmdBuffer, imageIndex, TIMED_FRAME_SPAN);
+		}
+
+		// Dispatches are not allowed inside a render pass so culling is recorded before it
+		if (!bUseProceduralSurface)
+		{
+			recordInstanceCulling(cmdBuffer, imageIndex, slot);
+		}
+
+		vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+		VkViewport viewport = {};
+		viewport.x = viewport.y = 0;
+		viewport.width = (float)eyeRenderExtent.width;
+		viewport.height = (float)eyeRenderExtent.height;
+		viewport.maxDepth = 1;
+		viewport.minDepth = 0;
+		vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(cmdBuffer, 0, 1, &renderPassBeginInfo.renderArea);
+
+		std::array<VkDescriptorSet, 2> descSets = { descriptorSets[imageIndex] ,textureDescriptorSet};
+
+		if (bUseProceduralSurface)
+		{
+			vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, surfacePipeLine);
+			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, (uint32_t)descSets.size(),
+				descSets.data(), 0, nullptr);
+			vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SurfaceParameters), &surfaceParameters);
+
+			vkCmdDraw(cmdBuffer, surfaceParameters.getVertexCount(), 1, 0, 0);
+		}
+		else
+		{
+			vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, meshPipeLines[slot.mesh.vertexLayout]);
+
+			VkBuffer vertexBuffers[] = { slot.vertexBuffer };
+			VkDeviceSize bufferOffsets[] = { 0 };
+
+			vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, bufferOffsets);
+			vkCmdBindIndexBuffer(cmdBuffer, slot.indicesBuffer, 0, slot.mesh.indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 :
+				VK_INDEX_TYPE_UINT32);
+
+			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, noOfViews,
+				descSets.data(), 0, nullptr);
+			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 2, 1, &slot.instanceDescriptorSet, 0, nullptr);
+
+			//vkCmdDraw(cmdBuffer, (uint32_t)vertices.size(), 1, 0, 0);
+			// Instance counts come from culling so recorded commands stay the same whatever the number of instances and their detail levels
+			vkCmdDrawIndexedIndirect(cmdBuffer, drawCommandBuffer, 0, slot.mesh.lodCount, sizeof(VkDrawIndexedIndirectCommand));
+		}
+
+		vkCmdEndRenderPass(cmdBuffer);
+
+		if (vkEndCommandBuffer(cmdBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Error in ending command buffer recording");
+		}
+
+		recordedEyePassVersions[imageIndex] = eyePassVersion;
+	}
+
+	// Resets indirect draw commands and culls instances against frustum of both eyes, Visible ones are appended to the command of their detail level
+	void recordInstanceCulling(VkCommandBuffer cmdBuffer, uint32_t imageIndex, const GeometrySlot& slot)
+	{
+		// Previous eye pass is complete before this one gets submitted so the commands can be overwritten without a barrier before it
+		std::array<VkDrawIndexedIndirectCommand, MAX_MESH_LOD_COUNT> drawCommands = {};
+		for (uint32_t lod = 0; lod < slot.mesh.lodCount; lod++)
+		{
+			drawCommands[lod].indexCount = slot.mesh.lods[lod].indexCount;
+			drawCommands[lod].firstIndex = slot.mesh.lods[lod].firstIndex;
+			drawCommands[lod].firstInstance = lod * MAX_INSTANCES;
+		}
+		vkCmdUpdateBuffer(cmdBuffer, drawCommandBuffer, 0, sizeof(drawCommands), drawCommands.data());
+
+		VkBufferMemoryBarrier resetBarrier = {};
+		resetBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		resetBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		resetBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		resetBarrier.buffer = drawCommandBuffer;
+		resetBarrier.offset = 0;
+		resetBarrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &resetBarrier,
+			0, nullptr);
+
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeLine);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets[imageIndex], 0, nullptr);
+		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 2, 1, &slot.instanceDescriptorSet, 0, nullptr);
+
+		CullParameters cullParameters = {};
+		cullParameters.boundingSphere = getMeshBoundingSphere(slot.mesh);
+		cullParameters.instanceCount = instanceCount;
+		cullParameters.lodCount = slot.mesh.lodCount;
+		cullParameters.pixelsPerNdc = imageExtend.height * 0.5f;
+		cullParameters.lodErrorThreshold = lodErrorThreshold;
+		float lodErrorScale = getMeshLodErrorScale(slot.mesh);
+		for (uint32_t lod = 0; lod < cullParameters.lodCount; lod++)
+		{
+			cullParameters.lodErrors[lod] = slot.mesh.lods[lod].error * lodErrorScale;
+		}
+		vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, CullParameters::OFFSET, sizeof(CullParameters), &cullParameters);
+
+		vkCmdDispatch(cmdBuffer, (instanceCount + 63) / 64, 1, 1);
+
+		std::array<VkBufferMemoryBarrier, 2> cullBarriers = { resetBarrier, resetBarrier };
+		cullBarriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		cullBarriers[0].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+		cullBarriers[1].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		cullBarriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		cullBarriers[1].buffer = visibleInstanceBuffer;
+
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+			0, 0, nullptr, static_cast<uint32_t>(cullBarriers.size()), cullBarriers.data(), 0, nullptr);
+	}
+
+	void drawFrame()
+	{
+		if (latencyProfile.bLimitFrameRate)
+		{
+			waitForPreviousPresent();
+		}
+
+		frameTracer.beginFrame();
+		double frameStartTime = frameTracer.now();
+		frameTracer.mark(traceFrameStarted, frameStartTime);
+		if (lastFrameStartTime >= 0.0)
+		{
+			frameTracer.mark(tracePreviousFrameStarted, lastFrameStartTime);
+		}
+		lastFrameStartTime = frameStartTime;
+		if (pendingInputTime >= 0.0)
+		{
+			frameTracer.mark(traceInputReceived, pendingInputTime);
+			pendingInputTime = -1.0;
+		}
+
+		if (bHasTimelineSemaphores)
+		{
+			graphicsTimeline.wait(frameTimelineValues[currentFrame]);
+		}
+		else
+		{
+			vkWaitForFences(logicalDevice, 1, &fences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+
+		updateGeometrySlots();
+
+		uint32_t swapChainIdx;
+		VkResult result = vkAcquireNextImageKHR(logicalDevice, swapChain, std::numeric_limits<uint64_t>::max(),
+			imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &swapChainIdx);
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			std::cout << "Swap chain and pipeline is out dated,Recreating them!" << std::endl;
+			recreateSwapchain();
+			return;
+		}
+		else if (result == VK_SUBOPTIMAL_KHR)
+		{
+			std::cout << "Swap chain is not optimal still usable";
+		}
+		else if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to acquire image from swap chain to submit render command to graphics queue");
+		}
+
+		// Prerecorded distortion pass of image is simultaneous use, It may still be reading uniforms of image after acquire returned it
+		waitForImageFrame(swapChainIdx);
+
+		updateQualityGovernor(swapChainIdx);
+
+		ProjectionData projectionData = getProjectionData(sampleHeadPose(getExpectedPhotonLatency(true)));
+		updateProjectionData(swapChainIdx, projectionData);
+		frameTracer.mark(traceEyePoseSampled);
+
+		// Eye image is kept between frames, While nothing it was rendered from changed only distortion pass runs again on it
+		uint64_t eyePassInputsHash = getEyePassInputsHash(projectionData);
+		uint64_t frameInputsHash = getFrameInputsHash(projectionData, eyePassInputsHash);
+		bool bRenderEyePass = !bIsEyeImageValid || eyePassInputsHash != renderedEyePassInputsHash;
+		double eyeSubmitTime = -1.0;
+
+		VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
+		VkSemaphore signalSemaphores[] = { imageRenderedSemaphores[currentFrame] };
+		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+
+		VkSubmitInfo cmdBufferSubmitInfo = {};
+		cmdBufferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		cmdBufferSubmitInfo.commandBufferCount = 1;
+		cmdBufferSubmitInfo.pCommandBuffers = &graphicsCmdBuffers[swapChainIdx];
+		cmdBufferSubmitInfo.waitSemaphoreCount = 1;
+		cmdBufferSubmitInfo.pWaitSemaphores = waitSemaphores;
+		cmdBufferSubmitInfo.pWaitDstStageMask = waitStages;
+		cmdBufferSubmitInfo.signalSemaphoreCount = bHasTimelineSemaphores ? 0 : 1;
+		cmdBufferSubmitInfo.pSignalSemaphores = &mvRenderingSemaphore;
+
+		// Distortion pass waits on eye pass by its value on graphics timeline instead of a binary semaphore
+		VkSemaphore eyePassWaitSemaphore = bHasTimelineSemaphores ? graphicsTimeline.getSemaphore() : mvRenderingSemaphore;
+		uint64_t eyePassWaitValue = 0;
+		uint64_t waitValues[] = { 0 };
+
+		if (bRenderEyePass)
+		{
+			if (bHasTimelineSemaphores)
+			{
+				graphicsTimeline.wait(eyePassTimelineValue);
+			}
+			else
+			{
+				vkWaitForFences(logicalDevice, 1, &mvTaskFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+				vkResetFences(logicalDevice, 1, &mvTaskFence);
+			}
+
+			// Surface parameters and geometry slot are recorded into eye pass, Previous eye pass is done so buffer can be re-recorded
+			if (recordedEyePassVersions[swapChainIdx] != eyePassVersion)
+			{
+				recordEyePassCmdBuffer(swapChainIdx);
+			}
+
+			if (bHasTimelineSemaphores)
+			{
+				eyePassTimelineValue = graphicsTimeline.submit(cmdBufferSubmitInfo);
+				eyePassWaitValue = eyePassTimelineValue;
+			}
+			else if (vkQueueSubmit(graphicsQueue, 1, &cmdBufferSubmitInfo, mvTaskFence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Error when submitting command to the queue");
+			}
+			eyeSubmitTime = latencyTracker.now();
+			timedPassMasks[swapChainIdx] |= 1u << TIMED_EYE_PASS;
+
+			bIsEyeImageValid = true;
+			renderedEyePassInputsHash = eyePassInputsHash;
+			renderedEyeImageScale = eyeResolutionScale;
+			renderedEyeViewTransforms[0] = projectionData.viewTransforms[0];
+			renderedEyeViewTransforms[1] = projectionData.viewTransforms[1];
+			// Distortion pass waits on eye pass instead of swap chain image, Eye pass already waited for it
+			cmdBufferSubmitInfo.pWaitSemaphores = &eyePassWaitSemaphore;
+			waitValues[0] = eyePassWaitValue;
+		}
+		else
+		{
+			// Dependencies of distortion pass order its reads after eye pass writes of any earlier frame
+			skippedEyePassCount++;
+		}
+
+		cmdBufferSubmitInfo.pCommandBuffers = &mvCmdBuffers[swapChainIdx];
+		cmdBufferSubmitInfo.signalSemaphoreCount = 1;
+		cmdBufferSubmitInfo.pSignalSemaphores = signalSemaphores;
+
+		if (!bHasTimelineSemaphores)
+		{
+			vkResetFences(logicalDevice, 1, &fences[currentFrame]);
+		}
+
+		LatencyTracker::FrameId latencyFrame = latchDistortionData(swapChainIdx);
+		frameTracer.mark(traceDistortionLatched);
+
+		// Frame slot is reused once graphics timeline reached value of its distortion pass
+		if (bHasTimelineSemaphores)
+		{
+			frameTimelineValues[currentFrame] = graphicsTimeline.submit(cmdBufferSubmitInfo, waitValues);
+		}
+		else if (vkQueueSubmit(graphicsQueue, 1, &cmdBufferSubmitInfo, fences[currentFrame]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Error when submitting command to the queue");
+		}
+		imageTimelineValues[swapChainIdx] = bHasTimelineSemaphores ? frameTimelineValues[currentFrame] : 0;
+		imageFences[swapChainIdx] = bHasTimelineSemaphores ? VK_NULL_HANDLE : fences[currentFrame];
+		timedPassMasks[swapChainIdx] |= 1u << TIMED_DISTORTION_PASS;
+		if (eyeSubmitTime >= 0.0)
+		{
+			latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::EyeSubmit, eyeSubmitTime);
+		}
+		latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::DistortionSubmit, latencyTracker.now());
+		submitCompletionMarker(latencyFrame);
+
+		VkPresentInfoKHR presentInfo = {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = signalSemaphores;
+
+		VkSwapchainKHR swapChains[] = { swapChain };
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = swapChains;
+		presentInfo.pResults = nullptr;
+		presentInfo.pImageIndices = &swapChainIdx;
+
+		VkPresentTimeGOOGLE presentTime = {};
+		VkPresentTimesInfoGOOGLE presentTimesInfo = {};
+		chainPresentTime(presentInfo, presentTimesInfo, presentTime, latencyFrame);
+
+		// Frame limiter waits on present id of this frame before starting next one
+		uint64_t presentId = ++presentCount;
+		VkPresentIdKHR presentIdInfo = {};
+		if (bHasPresentWait)
+		{
+			presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+			presentIdInfo.pNext = presentInfo.pNext;
+			presentIdInfo.swapchainCount = 1;
+			presentIdInfo.pPresentIds = &presentId;
+			presentInfo.pNext = &presentIdInfo;
+		}
+
+		result = vkQueuePresentKHR(presentQueue, &presentInfo);
+		lastPresentId = presentId;
+		latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::PresentReturn, latencyTracker.now());
+		collectDisplayTimes();
+
+		presentedFrameInputsHash = frameInputsHash;
+		bIsFrameDirty = false;
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || bIsWindowResized)
+		{
+			std::cout << "Swap chain and pipeline is out dated,Recreating them!" << std::endl;
+			bIsWindowResized = false;
+			recreateSwapchain();
+			return;
+		}
+		else if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to present swap chain to presentation queue");
+		}
+
+		// Level picked from GPU times read back this frame takes effect from next frame on
+		if (bUseQualityGovernor && appliedQualityLevel != qualityGovernor.getLevelIndex())
+		{
+			applyQualityLevel();
+		}
+
+		currentFrame = (currentFrame + 1) % latencyProfile.framesInFlight;
+		frameNumber++;
+	}
+
+	// Levels start from sample counts picked for device and highest anisotropy it supports, Passes are only timed while governor runs
+	void createQualityGovernor()
+	{
+		VkPhysicalDeviceProperties deviceProps;
+		vkGetPhysicalDeviceProperties(vulkanDevice, &deviceProps);
+		samplerAnisotropy = std::min(samplerAnisotropy, deviceProps.limits.maxSamplerAnisotropy);
+		configuredDistortionPassSampleCount = distortionPassSampleCount;
 
-		// 3 Viewport and Scissor Rectangle 
-		VkViewport viewport = {};
-		viewport.x = viewport.y = 0;
-		viewport.width = (float)imageExtend.width;
-		viewport.height = (float)imageExtend.height;
-		viewport.maxDepth = 1;
-		viewport.minDepth = 0;
+		if (!bUseQualityGovernor)
+		{
+			return;
+		}
+		if (bUseAsyncTimewarp)
+		{
+			std::cout << "Quality governor times eye and distortion pass of the same frame, It is off with timewarp" << std::endl;
+			bUseQualityGovernor = false;
+			return;
+		}
 
-		VkRect2D scissorRect = {};
-		scissorRect.extent = imageExtend;
-		scissorRect.offset = { 0,0 };
+		// Swap chain image indices stay below maximum of latency profiles
+		QueueFamilyIndices queueFamilies = findQueueFamilyIndices(vulkanDevice);
+		if (!passTimer.create(vulkanDevice, logicalDevice, queueFamilies.graphicsCmdQueue, LatencyProfile::MAX_SWAPCHAIN_IMAGES, 1))
+		{
+			std::cout << "Graphics queue has no timestamps, Quality governor is off" << std::endl;
+			bUseQualityGovernor = false;
+			return;
+		}
+		timedPassMasks.assign(LatencyProfile::MAX_SWAPCHAIN_IMAGES, 0);
 
-		VkPipelineViewportStateCreateInfo viewportCreateInfo = {};
-		viewportCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportCreateInfo.scissorCount = 1;
-		viewportCreateInfo.pScissors = &scissorRect;
-		viewportCreateInfo.viewportCount = 1;
-		viewportCreateInfo.pViewports = &viewport;
+		qualityGovernor.start(qualityGovernorConfig, QualityGovernor::buildLevels(MIN_EYE_RESOLUTION_SCALE, eyePassSampleCount, samplerAnisotropy,
+			distortionPassSampleCount != VK_SAMPLE_COUNT_1_BIT));
+		appliedQualityLevel = 0;
+		std::cout << "Quality governor holding " << qualityGovernorConfig.targetFrameTime * 1000.0 << "ms of GPU time per frame over "
+			<< qualityGovernor.getLevels().size() << " quality levels" << std::endl;
+	}
 
-		// 4 Rasterization stage
-		VkPipelineRasterizationStateCreateInfo rasterizationCreateInfo = {};
-		rasterizationCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizationCreateInfo.rasterizerDiscardEnable = VK_FALSE;
-		rasterizationCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
-		rasterizationCreateInfo.depthClampEnable = VK_FALSE;
-		rasterizationCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
-		rasterizationCreateInfo.lineWidth = 1.0f;
-		rasterizationCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-		rasterizationCreateInfo.depthBiasEnable = VK_FALSE;
-		rasterizationCreateInfo.depthBiasConstantFactor = rasterizationCreateInfo.depthBiasSlopeFactor = rasterizationCreateInfo.depthBiasClamp = 0.f;
+	// Frames whose eye pass ran are measured, Otherwise GPU time only tells what distortion pass alone costs. Called after last frame of
+	// this swap chain image was waited for so its queries are complete, Unavailable ones still drop the sample
+	void updateQualityGovernor(uint32_t imageIndex)
+	{
+		if (!bUseQualityGovernor)
+		{
+			return;
+		}
 
-		// 5 Multisampling 
-		VkPipelineMultisampleStateCreateInfo multisamplingCreateInfo = {};
-		multisamplingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisamplingCreateInfo.alphaToCoverageEnable = VK_FALSE;
-		multisamplingCreateInfo.alphaToOneEnable = VK_FALSE;
-		multisamplingCreateInfo.minSampleShading = 1.0f;
-		multisamplingCreateInfo.pSampleMask = nullptr;
-		multisamplingCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		uint32_t timedPasses = timedPassMasks[imageIndex];
+		timedPassMasks[imageIndex] = 0;
+		double frameTime;
+		if (timedPasses != ((1u << TIMED_EYE_PASS) | (1u << TIMED_DISTORTION_PASS)) || !passTimer.getSpanTime(imageIndex, TIMED_FRAME_SPAN, frameTime))
+		{
+			return;
+		}
 
-		// 6 Stencils and Depth Test
-		VkPipelineDepthStencilStateCreateInfo depthStensilCreateInfo = {};
-		depthStensilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		if (qualityGovernor.addFrameTime(frameTime))
+		{
+			const QualityGovernor::Change& change = qualityGovernor.getChanges().back();
+			const QualityGovernor::Level& level = qualityGovernor.getLevel();
+			std::cout << "Quality level " << change.fromLevel << " -> " << change.toLevel << " at GPU frame time " << change.averageFrameTime * 1000.0
+				<< "ms, Resolution scale " << level.resolutionScale << " MSAA " << level.eyePassSamples << "x Anisotropy " << level.anisotropy
+				<< " Distortion pass " << QualityGovernor::getDistortionModeName(level.distortionMode) << std::endl;
+		}
+	}
 
-		depthStensilCreateInfo.stencilTestEnable = VK_FALSE;
-		depthStensilCreateInfo.front = {};
-		depthStensilCreateInfo.back = {};
+	// Resolution scale takes effect by recording eye pass again, Sample counts and anisotropy rebuild swap chain resources like a resize
+	void applyQualityLevel()
+	{
+		const QualityGovernor::Level& level = qualityGovernor.getLevel();
+		appliedQualityLevel = qualityGovernor.getLevelIndex();
 
-		depthStensilCreateInfo.depthBoundsTestEnable = VK_FALSE;
-		depthStensilCreateInfo.maxDepthBounds = 1.0f;
-		depthStensilCreateInfo.minDepthBounds = 0.0f;
+		if (level.resolutionScale != eyeResolutionScale)
+		{
+			eyeResolutionScale = level.resolutionScale;
+			eyePassVersion++;
+		}
 
-		depthStensilCreateInfo.depthTestEnable = VK_TRUE;
-		depthStensilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
-		depthStensilCreateInfo.depthWriteEnable = VK_TRUE;
+		VkSampleCountFlagBits eyeSamples = getMsaaSampleCount(level.eyePassSamples);
+		VkSampleCountFlagBits distortionSamples = level.distortionMode == QualityGovernor::DistortionMode::Multisampled ?
+			configuredDistortionPassSampleCount : VK_SAMPLE_COUNT_1_BIT;
+		if (eyeSamples == eyePassSampleCount && distortionSamples == distortionPassSampleCount && level.anisotropy == samplerAnisotropy)
+		{
+			return;
+		}
 
-		// 7 Color Blending
-		VkPipelineColorBlendAttachmentState attachmentState = {};
-		attachmentState.blendEnable = VK_FALSE;
-		attachmentState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
-			VK_COLOR_COMPONENT_A_BIT;
-		attachmentState.colorBlendOp = VK_BLEND_OP_ADD;
-		attachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-		attachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-		attachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
-		attachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-		attachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		vkDeviceWaitIdle(logicalDevice);
+		if (level.anisotropy != samplerAnisotropy)
+		{
+			vkDestroySampler(logicalDevice, mvColorTextureSampler, nullptr);
+			for (TextureData& td : textures)
+			{
+				vkDestroySampler(logicalDevice, td.textureSampler, nullptr);
+			}
+			samplerAnisotropy = level.anisotropy;
+			createTextureSampler();
+		}
+		eyePassSampleCount = eyeSamples;
+		distortionPassSampleCount = distortionSamples;
+		// Descriptor sets pick up new samplers
+		recreateSwapchain();
+	}
 
-		VkPipelineColorBlendStateCreateInfo blendStateInfo = {};
-		blendStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		blendStateInfo.attachmentCount = 1;
-		blendStateInfo.pAttachments = &attachmentState;
-		blendStateInfo.logicOpEnable = VK_FALSE;
-		blendStateInfo.logicOp = VK_LOGIC_OP_COPY;
-		blendStateInfo.blendConstants[0] = blendStateInfo.blendConstants[1] = blendStateInfo.blendConstants[2] = blendStateInfo.blendConstants[3] = 0.f;
+	VkExtent2D getEyeRenderExtent() const
+	{
+		return { std::max((uint32_t)(imageExtend.width * eyeResolutionScale), 1u), std::max((uint32_t)(imageExtend.height * eyeResolutionScale), 1u) };
+	}
 
-		// 8 Dynamic states 
-		// TODO : Later
-		// 
+	void reportQualityGovernor()
+	{
+		if (!bUseQualityGovernor)
+		{
+			return;
+		}
 
-		// 9 Pipeline Layout creation
+		const QualityGovernor::Stats& stats = qualityGovernor.getStats();
+		std::cout << "Quality governor over " << stats.frameCount << " measured frames, Average GPU frame time "
+			<< (stats.frameCount > 0 ? stats.frameTimeSum / stats.frameCount * 1000.0 : 0.0) << "ms Over budget " << stats.overBudgetCount
+			<< " Level changes " << qualityGovernor.getChanges().size() << " Final level " << qualityGovernor.getLevelIndex() << std::endl;
+		if (!qualityLogPath.empty())
+		{
+			qualityGovernor.exportCsv(qualityLogPath);
+			std::cout << "Quality level changes written to " << qualityLogPath << std::endl;
+		}
+	}
 
-		VkDescriptorSetLayout layouts[2] = { descriptorSetLayout , textureDescriptorSetLayout };
+	// Frame limiter of latency profile, Returns once previous frame is on screen. Without present wait support that is approximated by its
+	// GPU work being complete
+	void waitForPreviousPresent()
+	{
+		if (bHasPresentWait)
+		{
+			// Bounded so that presents that never show, Like ones to a hidden window, only slow frames down
+			if (lastPresentId > 0)
+			{
+				VulkanTypes::fnVkWaitForPresentKhr(logicalDevice, swapChain, lastPresentId, PRESENT_WAIT_TIMEOUT);
+			}
+		}
+		else if (bHasTimelineSemaphores)
+		{
+			graphicsTimeline.wait(graphicsTimeline.getSubmittedValue());
+		}
+		else
+		{
+			uint32_t previousFrame = (currentFrame + latencyProfile.framesInFlight - 1) % latencyProfile.framesInFlight;
+			vkWaitForFences(logicalDevice, 1, &fences[previousFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+	}
 
-		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
-		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-		pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
-		pipelineLayoutCreateInfo.setLayoutCount = 2;
-		pipelineLayoutCreateInfo.pSetLayouts = layouts;
+	// Eye frame of asynchronous timewarp, Renders both eyes into a copy of eye image no late frame samples and hands it over to late stage.
+	// Distortion pass and present only run on late stage thread
+	void drawEyeFrame()
+	{
+		if (bHasLateStageError)
+		{
+			stopTimewarp();
+			std::rethrow_exception(lateStageError);
+		}
 
-		if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		if (bIsTimewarpSwapchainOutOfDate || bIsWindowResized)
 		{
-			throw std::runtime_error("Failed to create pipeline layout");
+			std::cout << "Swap chain and pipeline is out dated,Recreating them!" << std::endl;
+			stopTimewarp();
+			bIsWindowResized = false;
+			recreateSwapchain();
+			startTimewarp();
+			return;
 		}
 
-		// End : Fixed functions
+		updateGeometrySlots();
 
-		VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
-		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineCreateInfo.pVertexInputState = &vertexInputInfo;
-		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyInfo;
-		pipelineCreateInfo.pTessellationState = nullptr;
-		pipelineCreateInfo.pViewportState = &viewportCreateInfo;
-		pipelineCreateInfo.pRasterizationState = &rasterizationCreateInfo;
-		pipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
-		pipelineCreateInfo.pDepthStencilState = &depthStensilCreateInfo;
-		pipelineCreateInfo.pDynamicState = nullptr;
-		pipelineCreateInfo.pColorBlendState = &blendStateInfo;
+		// Input applied so far shows up with the next eye frame, Or right away when it changed nothing the eye pass renders
+		LatencyTracker::SampleId inputSample = appliedInputSample;
 
-		pipelineCreateInfo.layout = pipelineLayout;
-		pipelineCreateInfo.stageCount = 2;
-		pipelineCreateInfo.pStages = pipelineShaderStages;
-		pipelineCreateInfo.renderPass = mvRenderPass;
-		pipelineCreateInfo.subpass = 0;
+		// Eye frame is shown from the vertical blank after it completes on
+		double refreshPeriod = displayClock->getRefreshPeriod();
+		ProjectionData projectionData = getProjectionData(sampleHeadPose(displayClock->getNextVsync(refreshPeriod) - displayClock->now()));
+		timewarpDistortionAlpha = projectionData.distortionAlpha;
 
-		pipelineCreateInfo.basePipelineHandle = nullptr;
-		pipelineCreateInfo.basePipelineIndex = -1;
+		uint64_t eyePassInputsHash = getEyePassInputsHash(projectionData);
+		presentedFrameInputsHash = getFrameInputsHash(projectionData, eyePassInputsHash);
+		bIsFrameDirty = false;
 
-		if (vkCreateGraphicsPipelines(logicalDevice, nullptr, 1, &pipelineCreateInfo, nullptr, &pipeLine) != VK_SUCCESS)
+		// Late stage keeps reprojecting latest eye frame at display rate
+		if (bIsEyeImageValid && eyePassInputsHash == renderedEyePassInputsHash)
 		{
-			throw std::runtime_error("Failed creating graphics pipeline");
+			timewarpShownInputSample = inputSample;
+			skippedEyePassCount++;
+			frameNumber++;
+			return;
 		}
 
-		vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
-		vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
-
+		// Eye pass command buffers and uniform buffers are picked by eye buffer, Framebuffers of eye pass rotate through copies the same way
+		uint32_t eyeBuffer = asyncTimewarp.beginEyeFrame();
+		updateProjectionData(eyeBuffer, projectionData);
+		if (recordedEyePassVersions[eyeBuffer] != eyePassVersion)
+		{
+			recordEyePassCmdBuffer(eyeBuffer);
+		}
 
+		VkSubmitInfo cmdBufferSubmitInfo = {};
+		cmdBufferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		cmdBufferSubmitInfo.commandBufferCount = 1;
+		cmdBufferSubmitInfo.pCommandBuffers = &graphicsCmdBuffers[eyeBuffer];
 
-		// Frame Rendering Pipeline
+		if (bHasTimelineSemaphores)
+		{
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				eyePassTimelineValue = graphicsTimeline.submit(cmdBufferSubmitInfo);
+			}
+			graphicsTimeline.wait(eyePassTimelineValue);
+		}
+		else
+		{
+			vkResetFences(logicalDevice, 1, &mvTaskFence);
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				if (vkQueueSubmit(graphicsQueue, 1, &cmdBufferSubmitInfo, mvTaskFence) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Error when submitting command to the queue");
+				}
+			}
 
-		float multiviewArrayLayer = 0.0f;
+			// Late stage submits on another queue that no semaphore of this one can be waited on every vertical blank, Eye frame is only
+			// handed over once it completed
+			vkWaitForFences(logicalDevice, 1, &mvTaskFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
 
-		VkSpecializationMapEntry specializationMapEntry = {0,0,sizeof(float)};
+		bIsEyeImageValid = true;
+		renderedEyePassInputsHash = eyePassInputsHash;
 
-		VkSpecializationInfo specializationInfo = {};
-		specializationInfo.dataSize = sizeof(float);
-		specializationInfo.mapEntryCount = 1;
-		specializationInfo.pMapEntries = &specializationMapEntry;
-		specializationInfo.pData = &multiviewArrayLayer;
+		AsyncTimewarp::EyeFrame eyeFrame;
+		eyeFrame.index = ++timewarpEyeFrameCount;
+		eyeFrame.eyeBuffer = eyeBuffer;
+		eyeFrame.viewTransforms[0] = projectionData.viewTransforms[0];
+		eyeFrame.viewTransforms[1] = projectionData.viewTransforms[1];
+		asyncTimewarp.publishEyeFrame(eyeFrame);
+		timewarpShownInputSample = inputSample;
 
-		rasterizationCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+		frameNumber++;
+	}
 
-		// Only UBO and Rendered Targets Descriptors are needed for final frame pipeline passes
-		pipelineLayoutCreateInfo.setLayoutCount = 1;
-		pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+	// Creates what late stage needs for current swap chain and starts it on display clock of primary monitor
+	void startTimewarp()
+	{
+		QueueFamilyIndices queueFamilies = findQueueFamilyIndices(vulkanDevice);
 
-		if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCreateInfo, nullptr, &mvPipelineLayout) != VK_SUCCESS)
+		// Completion of every strip is waited for with timeouts on late timeline, Strips after first one load earlier ones which a
+		// resolving distortion pass would not
+		lateStripCount = 0;
+		if (distortionStripCount > 0 && !bHasTimelineSemaphores)
 		{
-			throw std::runtime_error("Failed to create pipeline layout");
+			std::cout << "Distortion strips need timeline semaphores, Late stage draws whole frames" << std::endl;
+		}
+		else if (distortionStripCount > 0 && distortionPassSampleCount != VK_SAMPLE_COUNT_1_BIT)
+		{
+			std::cout << "Distortion strips need a single sampled distortion pass, Late stage draws whole frames" << std::endl;
+		}
+		else if (distortionStripCount > 0)
+		{
+			lateStripCount = std::min(distortionStripCount, imageExtend.height);
+			stripScheduler.configure(lateStripCount, imageExtend.height, distortionStripLead);
+			createStripRenderPass();
 		}
+		uint32_t lateSlotCount = std::max(lateStripCount, 1u);
 
-		for (uint32_t i = 0; i < noOfViews; i++)
+		VkCommandPoolCreateInfo cmdPoolCreateInfo = {};
+		cmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		cmdPoolCreateInfo.queueFamilyIndex = queueFamilies.graphicsCmdQueue;
+		// Late stage records its command buffers again every vertical blank, One for each strip
+		cmdPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if (vkCreateCommandPool(logicalDevice, &cmdPoolCreateInfo, nullptr, &lateCmdPool) != VK_SUCCESS)
 		{
-			fragShaderCode = readShaderFile("Shaders/frame.frag.spv");
-			vertShaderCode = readShaderFile("Shaders/frame.vert.spv");
-			fragShaderModule = createShaderModule(fragShaderCode);
-			vertShaderModule = createShaderModule(vertShaderCode);
-			fragShaderCreateInfo.module = fragShaderModule;
-			vertShaderCreateInfo.module = vertShaderModule;
-			fragShaderCreateInfo.pSpecializationInfo = &specializationInfo;
+			throw std::runtime_error("Failed creating late stage Command Pool");
+		}
 
-			VkPipelineShaderStageCreateInfo frameShaderStages[] = { fragShaderCreateInfo,vertShaderCreateInfo };
-			
-			VkPipelineVertexInputStateCreateInfo inputStateInfo = {};
-			inputStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-			
-			std::array<VkDynamicState, 2> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT,VK_DYNAMIC_STATE_SCISSOR };
-			VkPipelineDynamicStateCreateInfo dynamicStateInfo = {};
-			dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-			dynamicStateInfo.dynamicStateCount = (uint32_t)dynamicStates.size();
-			dynamicStateInfo.pDynamicStates = dynamicStates.data();
+		VkCommandBufferAllocateInfo cmdBufferAllocInfo = {};
+		cmdBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		cmdBufferAllocInfo.commandBufferCount = lateSlotCount;
+		cmdBufferAllocInfo.commandPool = lateCmdPool;
+		cmdBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-			multisamplingCreateInfo.rasterizationSamples = msaaSampleBitsCount;
+		lateCmdBuffers.resize(lateSlotCount);
+		if (vkAllocateCommandBuffers(logicalDevice, &cmdBufferAllocInfo, lateCmdBuffers.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate late stage command buffer");
+		}
 
+		VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-			pipelineCreateInfo.stageCount = 2;
-			pipelineCreateInfo.pRasterizationState = &rasterizationCreateInfo;
-			pipelineCreateInfo.pStages = frameShaderStages;
-			pipelineCreateInfo.pVertexInputState = &inputStateInfo;
-			pipelineCreateInfo.pDynamicState = &dynamicStateInfo;
-			pipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
-			pipelineCreateInfo.layout = mvPipelineLayout;
-			pipelineCreateInfo.renderPass = renderPass;
+		VkFenceCreateInfo fenceCreateInfo = {};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 
-			if (vkCreateGraphicsPipelines(logicalDevice, nullptr, 1, &pipelineCreateInfo, nullptr, &(mvFramePipelines[i])) != VK_SUCCESS)
+		// Present of a swap chain image has waited on its semaphore by the time image is acquired again
+		lateRenderedSemaphores.resize(swapChainImages.size());
+		for (VkSemaphore& semaphore : lateRenderedSemaphores)
+		{
+			if (vkCreateSemaphore(logicalDevice, &semaphoreCreateInfo, nullptr, &semaphore) != VK_SUCCESS)
 			{
-				throw std::runtime_error("Failed creating frame graphics pipeline");
+				throw std::runtime_error("Failed to create semaphores for synchronizing");
 			}
+		}
+		if (vkCreateSemaphore(logicalDevice, &semaphoreCreateInfo, nullptr, &lateImageAvailableSemaphore) != VK_SUCCESS ||
+			(!bHasTimelineSemaphores && vkCreateFence(logicalDevice, &fenceCreateInfo, nullptr, &lateFence) != VK_SUCCESS))
+		{
+			throw std::runtime_error("Failed to create semaphores for synchronizing");
+		}
 
-			multiviewArrayLayer++;
+		// Written before every late frame, Previous one is complete by then. Strips have a slot each as they latch pose one after another
+		VkPhysicalDeviceProperties deviceProps;
+		vkGetPhysicalDeviceProperties(vulkanDevice, &deviceProps);
+		VkDeviceSize alignment = std::max(deviceProps.limits.minUniformBufferOffsetAlignment, (VkDeviceSize)1);
+		lateUniformStride = (sizeof(DistortionData) + alignment - 1) / alignment * alignment;
+		createBufferMemory(lateUniformStride * lateSlotCount, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, lateUniformBuffer, lateUniformBufferMemory);
+		vkMapMemory(logicalDevice, lateUniformBufferMemory, 0, lateUniformStride * lateSlotCount, 0, (void**)&lateUniformData);
+
+		std::vector<VkDescriptorSetLayout> layouts(lateSlotCount, descriptorSetLayout);
+		VkDescriptorSetAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = descriptorPool;
+		allocateInfo.descriptorSetCount = lateSlotCount;
+		allocateInfo.pSetLayouts = layouts.data();
+
+		lateDescriptorSets.resize(lateSlotCount);
+		if (vkAllocateDescriptorSets(logicalDevice, &allocateInfo, lateDescriptorSets.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Unable to allocate late stage Descriptor Set from Pool");
+		}
+		for (uint32_t i = 0; i < lateSlotCount; i++)
+		{
+			writeFrameDescriptorSet(lateDescriptorSets[i], lateUniformBuffer, sizeof(DistortionData), i * lateUniformStride);
+		}
 
+		// Descriptor covers every copy of eye image while eye pass has written only some of them yet
+		transitionImageLayout(mvColorTextureImage, 1, choosenSurfaceFormat.format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			noOfViews * AsyncTimewarp::EYE_BUFFER_COUNT);
 
-			vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
-			vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
+		// Presentation engine knows refresh period exactly where video mode rounds it to whole hertz
+		VkRefreshCycleDurationGOOGLE refreshCycle = {};
+		if (bHasDisplayTiming && VulkanTypes::fnVkGetRefreshCycleDurationGoogle(logicalDevice, swapChain, &refreshCycle) == VK_SUCCESS)
+		{
+			displayRefreshPeriod = refreshCycle.refreshDuration / 1e9;
+		}
+
+		if (!displayClock)
+		{
+			const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+			int refreshRate = videoMode && videoMode->refreshRate > 0 ? videoMode->refreshRate : 60;
+			displayClock.reset(new DisplayClock(displayRefreshPeriod > 0.0 ? displayRefreshPeriod : 1.0 / refreshRate));
+			std::cout << "Timewarp display clock at " << 1.0 / displayClock->getRefreshPeriod() << "Hz" << (lateQueue != graphicsQueue ? " on its own queue" : "")
+				<< (bHasDisplayTiming ? " following display times" : "") << std::endl;
+		}
+		if (lateStripCount > 0)
+		{
+			std::cout << "Distortion pass in " << lateStripCount << " strips released " << distortionStripLead * 1000.0 << "ms before scanout" << std::endl;
 		}
 
+		bIsTimewarpSwapchainOutOfDate = false;
+		asyncTimewarp.start(*displayClock, timewarpLeadTime, [this](const AsyncTimewarp::LateFrame& lateFrame)
+		{
+			try
+			{
+				runLateStage(lateFrame);
+			}
+			catch (...)
+			{
+				// Rethrown on main thread by next eye frame
+				lateStageError = std::current_exception();
+				bHasLateStageError = true;
+				asyncTimewarp.retireLateFrame(lateFrame.index);
+			}
+		});
 	}
 
-	// Creates framebuffer to be used with render pass in command buffers
-	void createFramebuffers()
+	void stopTimewarp()
 	{
-		swapChainframeBuffers.resize(swapChainImageViews.size());
-
-		for (int i = 0; i < swapChainframeBuffers.size(); i++)
+		if (lateCmdPool == VK_NULL_HANDLE)
 		{
-			std::array<VkImageView, 3> imgViews = {
-				colorRenderTargetImageView,
-				depthTextureImageView,
-				swapChainImageViews[i]
-			};
-
-			VkFramebufferCreateInfo frameBufferCreateInfo = {};
-			frameBufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			frameBufferCreateInfo.renderPass = renderPass;
-			frameBufferCreateInfo.layers = 1;
-			frameBufferCreateInfo.width = imageExtend.width;
-			frameBufferCreateInfo.height = imageExtend.height;
-			frameBufferCreateInfo.attachmentCount = static_cast<uint32_t>(imgViews.size());
-			frameBufferCreateInfo.pAttachments = imgViews.data();
-
-			if (vkCreateFramebuffer(logicalDevice, &frameBufferCreateInfo, nullptr, &swapChainframeBuffers[i]) != VK_SUCCESS)
-			{
-				std::string fmt = "Failed creating frame buffer for image view at index %d";
-				size_t size = snprintf(nullptr, 0, fmt.c_str(), i) + 1;
-				std::unique_ptr<char[]> buffer(new char[size]);
-				snprintf(buffer.get(), size, fmt.c_str(), i);
-				throw std::runtime_error(buffer.get());
-			}
+			return;
 		}
 
-		std::array<VkImageView, 2> imgViews = {
-			mvColorTextureImageView,
-			mvDepthTextureImageView
-		};
-
-		VkFramebufferCreateInfo fbCreateInfo = {};
-		fbCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		fbCreateInfo.attachmentCount =(uint32_t)imgViews.size();
-		fbCreateInfo.height = imageExtend.height;
-		fbCreateInfo.width = imageExtend.width;
-		fbCreateInfo.pAttachments = imgViews.data();
-		fbCreateInfo.layers = 1;
-		fbCreateInfo.renderPass = mvRenderPass;
+		asyncTimewarp.stop();
+		vkDeviceWaitIdle(logicalDevice);
 
-		if (vkCreateFramebuffer(logicalDevice, &fbCreateInfo, nullptr, &mvFramebuffer) != VK_SUCCESS)
+		vkFreeDescriptorSets(logicalDevice, descriptorPool, static_cast<uint32_t>(lateDescriptorSets.size()), lateDescriptorSets.data());
+		vkUnmapMemory(logicalDevice, lateUniformBufferMemory);
+		vkDestroyBuffer(logicalDevice, lateUniformBuffer, nullptr);
+		vkFreeMemory(logicalDevice, lateUniformBufferMemory, nullptr);
+		for (VkSemaphore semaphore : lateRenderedSemaphores)
 		{
-			throw std::runtime_error("Failed creating framebuffer for multiview");
+			vkDestroySemaphore(logicalDevice, semaphore, nullptr);
 		}
-	}
-
-	void cleanFrameBuffers(VkDevice device)
-	{
-		for (VkFramebuffer &framebuffer : swapChainframeBuffers)
+		lateRenderedSemaphores.clear();
+		vkDestroySemaphore(logicalDevice, lateImageAvailableSemaphore, nullptr);
+		vkDestroyFence(logicalDevice, lateFence, nullptr);
+		vkDestroyCommandPool(logicalDevice, lateCmdPool, nullptr);
+		for (VkFramebuffer framebuffer : stripFramebuffers)
 		{
-			vkDestroyFramebuffer(device, framebuffer, nullptr);
+			vkDestroyFramebuffer(logicalDevice, framebuffer, nullptr);
 		}
-		swapChainframeBuffers.clear();
-		vkDestroyFramebuffer(device, mvFramebuffer, nullptr);
+		stripFramebuffers.clear();
+		vkDestroyRenderPass(logicalDevice, stripRenderPass, nullptr);
+
+		lateDescriptorSets.clear();
+		lateCmdBuffers.clear();
+		lateUniformData = nullptr;
+		stripRenderPass = VK_NULL_HANDLE;
+		lateCmdPool = VK_NULL_HANDLE;
 	}
 
-	void createVertexBuffers()
+	// Render pass of distortion strips after first one, Compatible with distortion pass of render graph but loads what earlier strips
+	// drew into swap chain image. Framebuffers are made for every swap chain image
+	void createStripRenderPass()
 	{
-		size_t size = sizeof(vertices[0])*vertices.size();
-
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
+		VkAttachmentDescription colorAttachment = {};
+		colorAttachment.format = choosenSurfaceFormat.format;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
-		createBufferMemory(size, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBuffer, stagingBufferMemory);
+		VkAttachmentReference colorAttachmentRef = {};
+		colorAttachmentRef.attachment = 0;
+		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-		void *data;
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentRef;
 
-		vkMapMemory(logicalDevice, stagingBufferMemory, 0, size, 0, &data);
-		memcpy(data, vertices.data(), size);
-		vkUnmapMemory(logicalDevice, stagingBufferMemory);
+		// Earlier strip was written by an earlier submit to the same queue
+		VkSubpassDependency dependency = {};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0;
+		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
-		createBufferMemory(size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
-			, vertexBuffer, vertexBufferMemory);
+		VkRenderPassCreateInfo renderPassCreateInfo = {};
+		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassCreateInfo.attachmentCount = 1;
+		renderPassCreateInfo.pAttachments = &colorAttachment;
+		renderPassCreateInfo.subpassCount = 1;
+		renderPassCreateInfo.pSubpasses = &subpass;
+		renderPassCreateInfo.dependencyCount = 1;
+		renderPassCreateInfo.pDependencies = &dependency;
 
-		copyBuffer(stagingBuffer, vertexBuffer, size);
+		if (vkCreateRenderPass(logicalDevice, &renderPassCreateInfo, nullptr, &stripRenderPass) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create distortion strip render pass");
+		}
 
-		vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-		vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
+		stripFramebuffers.resize(swapChainImageViews.size());
+		for (size_t i = 0; i < swapChainImageViews.size(); i++)
+		{
+			VkFramebufferCreateInfo framebufferCreateInfo = {};
+			framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferCreateInfo.renderPass = stripRenderPass;
+			framebufferCreateInfo.attachmentCount = 1;
+			framebufferCreateInfo.pAttachments = &swapChainImageViews[i];
+			framebufferCreateInfo.width = imageExtend.width;
+			framebufferCreateInfo.height = imageExtend.height;
+			framebufferCreateInfo.layers = 1;
+
+			if (vkCreateFramebuffer(logicalDevice, &framebufferCreateInfo, nullptr, &stripFramebuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create distortion strip framebuffer");
+			}
+		}
+	}
 
+	DistortionData* getLateUniforms(uint32_t slot)
+	{
+		return reinterpret_cast<DistortionData*>(lateUniformData + slot * lateUniformStride);
 	}
 
+	// Uniforms reprojecting eye frame of late frame from views it got rendered with to views expected at displayTime
+	DistortionData getTimewarpData(const AsyncTimewarp::LateFrame& lateFrame, double displayTime)
+	{
+		glm::mat4 displayViews[2], projections[2];
+		getEyeTransforms(displayViews, projections, sampleHeadPose(displayTime - displayClock->now()));
+
+		DistortionData distortionData;
+		for (uint32_t eye = 0; eye < noOfViews; eye++)
+		{
+			distortionData.timewarpTransforms[eye] = AsyncTimewarp::computeTimewarpTransform(projections[eye], lateFrame.eyeFrame.viewTransforms[eye],
+				displayViews[eye], timewarpPositionalDepth);
+		}
+		distortionData.distortionAlpha = timewarpDistortionAlpha;
+		distortionData.eyeLayerOffset = (float)(lateFrame.eyeFrame.eyeBuffer * noOfViews);
+		// Quality governor does not run with timewarp, Eye frames cover whole eye image
+		distortionData.eyeImageScale = 1.0f;
+		return distortionData;
+	}
 
-	void createIndexBuffers()
+	// Distortion pass of one vertical blank on late stage thread, Reprojects latest eye frame from views it got rendered with to views at
+	// display time. Waits for GPU before returning so that one late frame is in flight at a time
+	void runLateStage(const AsyncTimewarp::LateFrame& lateFrame)
 	{
-		VkDeviceSize size = sizeof(indices[0])*indices.size();
+		if (bHasLateStageError || bIsTimewarpSwapchainOutOfDate)
+		{
+			asyncTimewarp.retireLateFrame(lateFrame.index);
+			return;
+		}
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
+		uint32_t swapChainIdx;
+		VkResult result = vkAcquireNextImageKHR(logicalDevice, swapChain, std::numeric_limits<uint64_t>::max(),
+			lateImageAvailableSemaphore, VK_NULL_HANDLE, &swapChainIdx);
 
-		createBufferMemory(size, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			stagingBuffer, stagingBufferMemory);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// Swap chain is recreated by main thread, Which might be waiting for events
+			bIsTimewarpSwapchainOutOfDate = true;
+			glfwPostEmptyEvent();
+			asyncTimewarp.retireLateFrame(lateFrame.index);
+			return;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			throw std::runtime_error("Failed to acquire image from swap chain to submit render command to graphics queue");
+		}
 
-		void *data;
+		if (lateStripCount > 0)
+		{
+			finishLateFrame(lateFrame, submitDistortionStrips(lateFrame, swapChainIdx));
+			return;
+		}
 
-		vkMapMemory(logicalDevice, stagingBufferMemory, 0, size, 0, &data);
-		memcpy(data, indices.data(), size);
-		vkUnmapMemory(logicalDevice, stagingBufferMemory);
+		// Pose expected at vertical blank of late frame
+		DistortionData distortionData = getTimewarpData(lateFrame, lateFrame.displayTime);
 
-		createBufferMemory(size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT
-			, indicesBuffer, indicesBufferMemory);
+		LatencyTracker::SampleId inputSample = timewarpShownInputSample;
+		LatencyTracker::SampleId poseSample = latencyTracker.stampSample(LatencyTracker::Source::Pose);
+		distortionData.inputSampleId = (uint32_t)inputSample;
+		distortionData.poseSampleId = (uint32_t)poseSample;
+		LatencyTracker::FrameId latencyFrame = latencyTracker.beginFrame(inputSample, poseSample);
+		*getLateUniforms(0) = distortionData;
 
-		copyBuffer(stagingBuffer, indicesBuffer, size);
+		recordDistortionPass(lateCmdBuffers[0], swapChainIdx, lateDescriptorSets[0], VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
-		vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-		vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
-	}
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
+		VkSubmitInfo cmdBufferSubmitInfo = {};
+		cmdBufferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		cmdBufferSubmitInfo.commandBufferCount = 1;
+		cmdBufferSubmitInfo.pCommandBuffers = &lateCmdBuffers[0];
+		cmdBufferSubmitInfo.waitSemaphoreCount = 1;
+		cmdBufferSubmitInfo.pWaitSemaphores = &lateImageAvailableSemaphore;
+		cmdBufferSubmitInfo.pWaitDstStageMask = &waitStage;
+		cmdBufferSubmitInfo.signalSemaphoreCount = 1;
+		cmdBufferSubmitInfo.pSignalSemaphores = &lateRenderedSemaphores[swapChainIdx];
 
-	void createUniformBuffers()
-	{
-		VkDeviceSize size = sizeof(ProjectionData);
+		VkPresentInfoKHR presentInfo = {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = &lateRenderedSemaphores[swapChainIdx];
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = &swapChain;
+		presentInfo.pImageIndices = &swapChainIdx;
 
-		uniformBuffers.resize(swapChainImageViews.size());
-		uniformBuffersMemory.resize(swapChainImageViews.size());
+		VkPresentTimeGOOGLE presentTime = {};
+		VkPresentTimesInfoGOOGLE presentTimesInfo = {};
+		chainPresentTime(presentInfo, presentTimesInfo, presentTime, latencyFrame);
 
-		for (int i = 0; i < swapChainImageViews.size(); i++)
+		uint64_t lateTimelineValue = 0;
 		{
-			createBufferMemory(size, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (bHasTimelineSemaphores)
+			{
+				lateTimelineValue = lateTimeline.submit(cmdBufferSubmitInfo);
+			}
+			else if (vkQueueSubmit(lateQueue, 1, &cmdBufferSubmitInfo, lateFence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Error when submitting command to the queue");
+			}
+			latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::DistortionSubmit, latencyTracker.now());
+			result = vkQueuePresentKHR(latePresentQueue, &presentInfo);
 		}
-	}
+		latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::PresentReturn, latencyTracker.now());
 
-	void cleanUniformBuffers()
-	{
-		for (int i = 0; i < swapChainImageViews.size(); i++)
+		if (bHasTimelineSemaphores)
 		{
-			vkDestroyBuffer(logicalDevice, uniformBuffers[i], nullptr);
-			vkFreeMemory(logicalDevice, uniformBuffersMemory[i], nullptr);
+			lateTimeline.wait(lateTimelineValue);
+			latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::GpuComplete, latencyTracker.now());
 		}
-	}
-
-
-	void createDescriptorPool()
-	{
-
-		std::array<VkDescriptorPoolSize, 3> poolSizes;
-		poolSizes[0].descriptorCount = static_cast<uint32_t>(swapChainImageViews.size());
-		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSizes[1].descriptorCount = static_cast<uint32_t>(swapChainImageViews.size());
-		poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSizes[2].descriptorCount = 2;
-		poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-
-		VkDescriptorPoolCreateInfo descPoolCreateInfo = {};
-		descPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		descPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-		descPoolCreateInfo.pPoolSizes = poolSizes.data();
-		descPoolCreateInfo.maxSets = static_cast<uint32_t>(swapChainImageViews.size()+1);
-
-		if (vkCreateDescriptorPool(logicalDevice, &descPoolCreateInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+		else
 		{
-			throw std::runtime_error("Failure in creating Descriptor Set Pool");
+			vkWaitForFences(logicalDevice, 1, &lateFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+			latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::GpuComplete, latencyTracker.now());
+			vkResetFences(logicalDevice, 1, &lateFence);
 		}
+		finishLateFrame(lateFrame, result);
 	}
 
-	void allocDescriptorSets()
+	// Distortion pass in horizontal strips, All recorded up front and each submitted once scheduler releases it. While waiting for next
+	// release late stage waits on strips in flight so that their completion is seen as it happens. Image is presented after last strip and
+	// GPU is waited for like for whole frames, Returns result of present
+	VkResult submitDistortionStrips(const AsyncTimewarp::LateFrame& lateFrame, uint32_t swapChainIdx)
 	{
+		StripScheduler::Strip strips[StripScheduler::MAX_STRIPS];
+		uint64_t stripTimelineValues[StripScheduler::MAX_STRIPS] = {};
+		for (uint32_t i = 0; i < lateStripCount; i++)
 		{
-			std::vector<VkDescriptorSetLayout> layouts(swapChainImageViews.size(), descriptorSetLayout);
+			strips[i] = stripScheduler.getStrip(*displayClock, lateFrame.displayTime, i);
+			recordDistortionPass(lateCmdBuffers[i], swapChainIdx, lateDescriptorSets[i], VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, &strips[i]);
+		}
 
-			VkDescriptorSetAllocateInfo allocateInfo = {};
-			allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			allocateInfo.descriptorPool = descriptorPool;
-			allocateInfo.descriptorSetCount = static_cast<uint32_t>(swapChainImageViews.size());
-			allocateInfo.pSetLayouts = layouts.data();
+		// Strips complete in submission order, Waits until all submitted ones are complete or time is reached
+		uint32_t completedStripCount = 0;
+		auto waitForStrips = [&](uint32_t submittedStripCount, double time)
+		{
+			while (completedStripCount < submittedStripCount)
+			{
+				uint64_t timeout = std::isinf(time) ? std::numeric_limits<uint64_t>::max() :
+					(uint64_t)(std::max(time - displayClock->now(), 0.0) * 1e9);
+				if (!lateTimeline.wait(stripTimelineValues[completedStripCount], timeout))
+				{
+					return;
+				}
+				stripScheduler.addCompletion(strips[completedStripCount], displayClock->now());
+				completedStripCount++;
+			}
+		};
 
-			descriptorSets.resize(swapChainImageViews.size());
+		// Image is presented once, After its last strip is done. So it is scanned out from first vertical blank after that rather than the one
+		// strips are released against, Poses are predicted for when scanout of that one reaches rows of each strip
+		double presentVsync = displayClock->getVsyncAfter(strips[lateStripCount - 1].deadline);
 
-			if (vkAllocateDescriptorSets(logicalDevice, &allocateInfo, descriptorSets.data()) != VK_SUCCESS)
+		LatencyTracker::SampleId inputSample = timewarpShownInputSample;
+		LatencyTracker::FrameId latencyFrame = 0;
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		for (uint32_t i = 0; i < lateStripCount; i++)
+		{
+			waitForStrips(i, strips[i].releaseTime);
+			displayClock->sleepUntil(strips[i].releaseTime);
+
+			double scanoutTime = displayClock->getScanoutTime(presentVsync, (double)strips[i].firstRow / imageExtend.height);
+			DistortionData distortionData = getTimewarpData(lateFrame, scanoutTime);
+			LatencyTracker::SampleId poseSample = latencyTracker.stampSample(LatencyTracker::Source::Pose);
+			distortionData.inputSampleId = (uint32_t)inputSample;
+			distortionData.poseSampleId = (uint32_t)poseSample;
+			// Frame latency counts from pose of first strip, Which is sampled earliest
+			if (i == 0)
 			{
-				throw std::runtime_error("Unable to allocate Descriptor Sets for UBO and Sample Texture from Pool");
+				latencyFrame = latencyTracker.beginFrame(inputSample, poseSample);
 			}
-
-			for (int i = 0; i < swapChainImageViews.size(); i++)
+			*getLateUniforms(i) = distortionData;
+
+			// First strip waits for swap chain image, Last one lets present go ahead
+			VkSubmitInfo cmdBufferSubmitInfo = {};
+			cmdBufferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			cmdBufferSubmitInfo.commandBufferCount = 1;
+			cmdBufferSubmitInfo.pCommandBuffers = &lateCmdBuffers[i];
+			if (i == 0)
 			{
-				VkDescriptorBufferInfo descBufferInfo = {};
-				descBufferInfo.buffer = uniformBuffers[i];
-				descBufferInfo.offset = 0;
-				descBufferInfo.range = sizeof(ProjectionData);
-
-				VkDescriptorImageInfo descImageInfo = {};
-				descImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				descImageInfo.imageView = mvColorTextureImageView;
-				descImageInfo.sampler = mvColorTextureSampler;
-
-				VkWriteDescriptorSet bufferWriteDescriptorSet = {};
-				bufferWriteDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				bufferWriteDescriptorSet.descriptorCount = 1;
-				bufferWriteDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-				bufferWriteDescriptorSet.dstBinding = 0;
-				bufferWriteDescriptorSet.dstArrayElement = 0;
-				bufferWriteDescriptorSet.dstSet = descriptorSets[i];
-				bufferWriteDescriptorSet.pBufferInfo = &descBufferInfo;
-				bufferWriteDescriptorSet.pImageInfo = nullptr;
-				bufferWriteDescriptorSet.pTexelBufferView = nullptr;
+				cmdBufferSubmitInfo.waitSemaphoreCount = 1;
+				cmdBufferSubmitInfo.pWaitSemaphores = &lateImageAvailableSemaphore;
+				cmdBufferSubmitInfo.pWaitDstStageMask = &waitStage;
+			}
+			if (i + 1 == lateStripCount)
+			{
+				cmdBufferSubmitInfo.signalSemaphoreCount = 1;
+				cmdBufferSubmitInfo.pSignalSemaphores = &lateRenderedSemaphores[swapChainIdx];
+			}
 
-				VkWriteDescriptorSet imageWriteDescriptorSet = {};
-				imageWriteDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				imageWriteDescriptorSet.descriptorCount = 1;
-				imageWriteDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				imageWriteDescriptorSet.dstBinding = 1;
-				imageWriteDescriptorSet.dstArrayElement = 0;
-				imageWriteDescriptorSet.dstSet = descriptorSets[i];
-				imageWriteDescriptorSet.pBufferInfo = nullptr;
-				imageWriteDescriptorSet.pImageInfo = &descImageInfo;
-				imageWriteDescriptorSet.pTexelBufferView = nullptr;
+			std::lock_guard<std::mutex> lock(queueMutex);
+			stripTimelineValues[i] = lateTimeline.submit(cmdBufferSubmitInfo);
+		}
+		latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::DistortionSubmit, latencyTracker.now());
 
-				std::array<VkWriteDescriptorSet, 2> writeDescriptorSets = { bufferWriteDescriptorSet ,imageWriteDescriptorSet };
+		VkPresentInfoKHR presentInfo = {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = &lateRenderedSemaphores[swapChainIdx];
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = &swapChain;
+		presentInfo.pImageIndices = &swapChainIdx;
 
-				vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(),
-					0, nullptr);
-			}
-		}
+		VkPresentTimeGOOGLE presentTime = {};
+		VkPresentTimesInfoGOOGLE presentTimesInfo = {};
+		chainPresentTime(presentInfo, presentTimesInfo, presentTime, latencyFrame);
 
+		VkResult result;
 		{
-			// Made all to descriptor sets to 1 as they are not needed
+			std::lock_guard<std::mutex> lock(queueMutex);
+			result = vkQueuePresentKHR(latePresentQueue, &presentInfo);
+		}
+		latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::PresentReturn, latencyTracker.now());
 
+		waitForStrips(lateStripCount, std::numeric_limits<double>::infinity());
+		latencyTracker.markStage(latencyFrame, LatencyTracker::Stage::GpuComplete, latencyTracker.now());
+		return result;
+	}
 
-			VkDescriptorSetAllocateInfo allocateInfo = {};
-			allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			allocateInfo.descriptorPool = descriptorPool;
-			allocateInfo.descriptorSetCount = 1;
-			allocateInfo.pSetLayouts = &textureDescriptorSetLayout;
+	// GPU is done with late frame, Hands swap chain back to main thread when present found it out of date
+	void finishLateFrame(const AsyncTimewarp::LateFrame& lateFrame, VkResult result)
+	{
+		asyncTimewarp.retireLateFrame(lateFrame.index);
+		collectDisplayTimes();
 
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+		{
+			bIsTimewarpSwapchainOutOfDate = true;
+			glfwPostEmptyEvent();
+		}
+		else if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to present swap chain to presentation queue");
+		}
+	}
 
+	// Head pose expected photonLatency seconds from now, Identity without pose source. Error against recorded pose at that time is kept
+	// for exit report unless replay starts over in between
+	Pose sampleHeadPose(double photonLatency)
+	{
+		if (poseSource == nullptr)
+		{
+			return Pose();
+		}
 
-			if (vkAllocateDescriptorSets(logicalDevice, &allocateInfo, &textureDescriptorSet) != VK_SUCCESS)
-			{
-				throw std::runtime_error("Unable to allocate Descriptor Sets for textures from Pool");
-			}
+		double now = latencyTracker.now() - poseStartTime;
+		double displayTime = now + std::max(photonLatency, 0.0);
+		Pose pose = poseSource->getPose(now, displayTime);
+		if (trajectory->isSameLoop(now, displayTime))
+		{
+			std::lock_guard<std::mutex> lock(poseErrorMutex);
+			poseError.add(pose, trajectory->getTruePose(displayTime));
+		}
+		return pose;
+	}
 
-			//for (int i = 0; i < 1; i++)
-			//{
-				VkDescriptorImageInfo descImageInfo = {};
-				descImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				descImageInfo.imageView = textures[0].textureImageView;
-				descImageInfo.sampler = textures[0].textureSampler;
+	// Time from latching pose until frame reaches display as measured so far, Up to present when display times are not known.
+	// Eye pass samples pose earlier by how long it takes to get to the latch
+	double getExpectedPhotonLatency(bool bForEyePass)
+	{
+		if (poseSource == nullptr)
+		{
+			return 0.0;
+		}
 
-				VkDescriptorImageInfo descImageInfo01 = {};
-				descImageInfo01.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				descImageInfo01.imageView = textures[1].textureImageView;
-				descImageInfo01.sampler = textures[1].textureSampler;
+		LatencyTracker::Histogram histogram = latencyTracker.getHistogram(LatencyTracker::Source::Pose, LatencyTracker::Stage::Display);
+		if (histogram.count == 0)
+		{
+			histogram = latencyTracker.getHistogram(LatencyTracker::Source::Pose, LatencyTracker::Stage::PresentReturn);
+		}
+		double latency = histogram.count > 0 ? histogram.sum / histogram.count : 0.0;
+		if (bForEyePass)
+		{
+			latency += frameTracer.measure(traceEyePoseSampled, traceDistortionLatched).average;
+		}
+		return latency;
+	}
 
-				VkWriteDescriptorSet imageWriteDescriptorSet = {};
-				imageWriteDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				imageWriteDescriptorSet.descriptorCount = 1;
-				imageWriteDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				imageWriteDescriptorSet.dstBinding = 0;
-				imageWriteDescriptorSet.dstArrayElement = 0;
-				imageWriteDescriptorSet.dstSet = textureDescriptorSet;
-				imageWriteDescriptorSet.pBufferInfo = nullptr;
-				imageWriteDescriptorSet.pImageInfo = &descImageInfo;
-				imageWriteDescriptorSet.pTexelBufferView = nullptr;
+	void reportPosePrediction()
+	{
+		std::lock_guard<std::mutex> lock(poseErrorMutex);
+		if (poseSource == nullptr || poseError.count == 0)
+		{
+			return;
+		}
 
-				VkWriteDescriptorSet imageWriteDescriptorSet01 = {};
-				imageWriteDescriptorSet01.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				imageWriteDescriptorSet01.descriptorCount = 1;
-				imageWriteDescriptorSet01.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				imageWriteDescriptorSet01.dstBinding = 0;
-				imageWriteDescriptorSet01.dstArrayElement = 1;
-				imageWriteDescriptorSet01.dstSet = textureDescriptorSet;
-				imageWriteDescriptorSet01.pBufferInfo = nullptr;
-				imageWriteDescriptorSet01.pImageInfo = &descImageInfo01;
-				imageWriteDescriptorSet01.pTexelBufferView = nullptr;
+		std::cout << (posePredictor ? PosePredictor::getModelName(posePredictor->getModel()) : "Unpredicted") << " pose error against trajectory over "
+			<< poseError.count << " samples avg/max, Position " << poseError.positionSum / poseError.count << "/" << poseError.positionMax
+			<< " Orientation " << poseError.angleSum / poseError.count << "/" << poseError.angleMax << " degrees" << std::endl;
+	}
 
-				std::array<VkWriteDescriptorSet, 2> writeImages = { imageWriteDescriptorSet ,imageWriteDescriptorSet01 };
+	// Samples pose once more right before distortion pass gets submitted and rotates eye image by what changed since eye pass sampled it.
+	// Distortion alpha reaches the screen from here too instead of from eye pass uniforms, Returns latency frame showing the samples
+	LatencyTracker::FrameId latchDistortionData(uint32_t imageIndex)
+	{
+		glm::mat4 latestViews[2], projections[2];
+		getEyeTransforms(latestViews, projections, sampleHeadPose(getExpectedPhotonLatency(false)));
 
-				vkUpdateDescriptorSets(logicalDevice, (uint32_t)writeImages.size(), writeImages.data(),0, nullptr);
-			//}
+		DistortionData distortionData;
+		for (uint32_t eye = 0; eye < noOfViews; eye++)
+		{
+			// Translation is left to next eye pass, Rotation within a frame needs no depth
+			distortionData.timewarpTransforms[eye] = AsyncTimewarp::computeTimewarpTransform(projections[eye], renderedEyeViewTransforms[eye],
+				latestViews[eye]);
 		}
-
-
+		distortionData.distortionAlpha = currentDistAlpha;
+		distortionData.eyeLayerOffset = 0.0f;
+		distortionData.eyeImageScale = renderedEyeImageScale;
+
+		// Frame shows every input that led to the frame state it is drawn from
+		LatencyTracker::SampleId inputSample = appliedInputSample;
+		LatencyTracker::SampleId poseSample = latencyTracker.stampSample(LatencyTracker::Source::Pose);
+		distortionData.inputSampleId = (uint32_t)inputSample;
+		distortionData.poseSampleId = (uint32_t)poseSample;
+
+		// drawFrame waited for previous distortion pass of image, So nothing reads its uniforms anymore
+		*distortionUniformData[imageIndex] = distortionData;
+		return latencyTracker.beginFrame(inputSample, poseSample);
 	}
 
-	uint32_t chooseMemoryType(uint32_t filterMemType, VkMemoryPropertyFlags propertyFlags)
+	// Blocks until distortion pass last submitted for swap chain image is complete. Acquire only orders GPU work after present of image
+	// and says nothing about when its previous submit finished. Fence of current frame slot was already waited on at frame start
+	void waitForImageFrame(uint32_t imageIndex)
 	{
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(vulkanDevice, &memProperties);
+		if (bHasTimelineSemaphores)
+		{
+			graphicsTimeline.wait(imageTimelineValues[imageIndex]);
+		}
+		else if (imageFences[imageIndex] != VK_NULL_HANDLE && imageFences[imageIndex] != fences[currentFrame])
+		{
+			vkWaitForFences(logicalDevice, 1, &imageFences[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+	}
 
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+	// Presentation engine reports back when frame got displayed under latency frame id
+	void chainPresentTime(VkPresentInfoKHR& presentInfo, VkPresentTimesInfoGOOGLE& presentTimesInfo, VkPresentTimeGOOGLE& presentTime,
+		LatencyTracker::FrameId latencyFrame)
+	{
+		if (!bHasDisplayTiming)
 		{
-			if (filterMemType & (1 << i) && (memProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags)
-			{
-				return i;
-			}
+			return;
 		}
 
-		throw std::runtime_error("No suitable memory type is available for Vertex buffer");
+		presentTime.presentID = (uint32_t)latencyFrame;
+		presentTime.desiredPresentTime = 0;
+
+		presentTimesInfo.sType = VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE;
+		presentTimesInfo.swapchainCount = 1;
+		presentTimesInfo.pTimes = &presentTime;
+		presentInfo.pNext = &presentTimesInfo;
 	}
 
-	void createCommandPool()
+	// Display times of frames presented since last call
+	void collectDisplayTimes()
 	{
-		QueueFamilyIndices queueFamilies = findQueueFamilyIndices(vulkanDevice);
-
-		VkCommandPoolCreateInfo cmdPoolCreateInfo = {};
-		cmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		cmdPoolCreateInfo.queueFamilyIndex = queueFamilies.graphicsCmdQueue;
-		cmdPoolCreateInfo.flags = 0;
+		if (!bHasDisplayTiming)
+		{
+			return;
+		}
 
-		if (vkCreateCommandPool(logicalDevice, &cmdPoolCreateInfo, nullptr, &graphicsCmdPool) != VK_SUCCESS)
+		uint32_t timingCount = 0;
+		VulkanTypes::fnVkGetPastPresentationTimingGoogle(logicalDevice, swapChain, &timingCount, nullptr);
+		if (timingCount == 0)
 		{
-			throw std::runtime_error("Failed creating Graphics Command Pool");
+			return;
 		}
 
-		if (queueFamilies.transferQueue != queueFamilies.graphicsCmdQueue)
+		std::vector<VkPastPresentationTimingGOOGLE> timings(timingCount);
+		VulkanTypes::fnVkGetPastPresentationTimingGoogle(logicalDevice, swapChain, &timingCount, timings.data());
+		for (uint32_t i = 0; i < timingCount; i++)
 		{
-			cmdPoolCreateInfo.queueFamilyIndex = queueFamilies.transferQueue;
-
-			if (vkCreateCommandPool(logicalDevice, &cmdPoolCreateInfo, nullptr, &transferCmdPool) != VK_SUCCESS)
-			{
-				throw std::runtime_error("Failed creating Buffer Transfer Command Pool");
-			}
+			latencyTracker.markStage(timings[i].presentID, LatencyTracker::Stage::Display,
+				latencyTracker.fromPresentationTime(timings[i].actualPresentTime));
 		}
-		else
+
+		// Late stage schedules against vertical blanks display actually had
+		if (displayClock && timings[timingCount - 1].actualPresentTime != 0)
 		{
-			transferCmdPool = graphicsCmdPool;
+			displayClock->synchronize(timings[timingCount - 1].actualPresentTime, displayRefreshPeriod);
 		}
 	}
 
-	void allocAndRecordCmdBuffers()
+	// Empty batch signals fence once everything submitted to graphics queue before it is complete, Watcher thread times it. With
+	// timeline semaphores watcher waits on value of last submit instead
+	void submitCompletionMarker(LatencyTracker::FrameId latencyFrame)
 	{
-		graphicsCmdBuffers.resize(swapChainframeBuffers.size());
-		VkCommandBufferAllocateInfo cmdBufferAllocInfo = {};
-		cmdBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		cmdBufferAllocInfo.commandBufferCount = (uint32_t)graphicsCmdBuffers.size();
-		cmdBufferAllocInfo.commandPool = graphicsCmdPool;
-		cmdBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-
-		if (vkAllocateCommandBuffers(logicalDevice, &cmdBufferAllocInfo, graphicsCmdBuffers.data()) != VK_SUCCESS)
+		if (bHasTimelineSemaphores)
 		{
-			throw std::runtime_error("Failed to allocate command buffers");
+			std::lock_guard<std::mutex> lock(completionMutex);
+			pendingCompletions.push_back({ VK_NULL_HANDLE, graphicsTimeline.getSubmittedValue(), latencyFrame });
+			completionCondition.notify_one();
+			return;
 		}
 
-		for (int i = 0; i < graphicsCmdBuffers.size(); i++)
+		VkFence fence;
 		{
-			VkCommandBufferBeginInfo cmdBuffBeginInfo = {};
-			cmdBuffBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			cmdBuffBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-			cmdBuffBeginInfo.pInheritanceInfo = nullptr;
-
-			if (vkBeginCommandBuffer(graphicsCmdBuffers[i], &cmdBuffBeginInfo) != VK_SUCCESS)
+			std::lock_guard<std::mutex> lock(completionMutex);
+			// Watcher fell behind, Frame goes without GPU completion time
+			if (freeCompletionFences.empty())
 			{
-				throw std::runtime_error("Failed to begin command buffer");
+				return;
 			}
+			fence = freeCompletionFences.back();
+			freeCompletionFences.pop_back();
+		}
 
-			VkRenderPassBeginInfo renderPassBeginInfo = {};
-			renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassBeginInfo.renderPass = mvRenderPass;
-			renderPassBeginInfo.framebuffer = mvFramebuffer;
-			renderPassBeginInfo.renderArea.offset = { 0,0 };
-			renderPassBeginInfo.renderArea.extent = imageExtend;
-
-			std::array<VkClearValue, 2> clearVals = {};
-			clearVals[0].color = { 0.0f, 0.0f, 0.0f, 1.f };
-			clearVals[1].depthStencil = { 1.0f,0 };
-			//clearVals[2].color = { 0.0f, 0.0f, 0.0f, 1.f };
-
-			renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearVals.size());
-			renderPassBeginInfo.pClearValues = clearVals.data();
-
-			vkCmdBeginRenderPass(graphicsCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-			vkCmdBindPipeline(graphicsCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeLine);
-
-			VkBuffer vertexBuffers[] = { vertexBuffer };
-			VkDeviceSize bufferOffsets[] = { 0 };
-
-			vkCmdBindVertexBuffers(graphicsCmdBuffers[i], 0, 1, vertexBuffers, bufferOffsets);
-			vkCmdBindIndexBuffer(graphicsCmdBuffers[i], indicesBuffer, 0, VK_INDEX_TYPE_UINT32);
-
-			std::array<VkDescriptorSet, 2> descSets = { descriptorSets[i] ,textureDescriptorSet};
-			vkCmdBindDescriptorSets(graphicsCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, noOfViews,
-				descSets.data(), 0, nullptr);
-
-			//vkCmdDraw(graphicsCmdBuffers[i], (uint32_t)vertices.size(), 1, 0, 0);
-			vkCmdDrawIndexed(graphicsCmdBuffers[i], (uint32_t)indices.size(), 1, 0, 0, 0);
-
-			vkCmdEndRenderPass(graphicsCmdBuffers[i]);
-
-			if (vkEndCommandBuffer(graphicsCmdBuffers[i]) != VK_SUCCESS)
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (vkQueueSubmit(graphicsQueue, 0, nullptr, fence) != VK_SUCCESS)
 			{
-				throw std::runtime_error("Error in ending command buffer recording");
+				throw std::runtime_error("Error when submitting completion marker to the queue");
 			}
 		}
 
-		// Final frame rendering command buffer
-		mvCmdBuffers.resize(swapChainframeBuffers.size());
-
-		if (vkAllocateCommandBuffers(logicalDevice, &cmdBufferAllocInfo, mvCmdBuffers.data()) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to allocate command buffers");
-		}
+		std::lock_guard<std::mutex> lock(completionMutex);
+		pendingCompletions.push_back({ fence, 0, latencyFrame });
+		completionCondition.notify_one();
+	}
 
-		for (int i = 0; i < mvCmdBuffers.size(); i++)
+	void watchCompletions()
+	{
+		std::unique_lock<std::mutex> lock(completionMutex);
+		while (true)
 		{
-			VkCommandBufferBeginInfo cmdBuffBeginInfo = {};
-			cmdBuffBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			cmdBuffBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-			cmdBuffBeginInfo.pInheritanceInfo = nullptr;
-
-			if (vkBeginCommandBuffer(mvCmdBuffers[i], &cmdBuffBeginInfo) != VK_SUCCESS)
+			completionCondition.wait(lock, [&]() { return bStopCompletionWatcher || !pendingCompletions.empty(); });
+			// Markers submitted before stopping are still waited on
+			if (pendingCompletions.empty())
 			{
-				throw std::runtime_error("Failed to begin command buffer");
+				return;
 			}
 
-			VkRenderPassBeginInfo renderPassBeginInfo = {};
-			renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassBeginInfo.renderPass = renderPass;
-			renderPassBeginInfo.framebuffer = swapChainframeBuffers[i];
-			renderPassBeginInfo.renderArea.offset = { 0,0 };
-			renderPassBeginInfo.renderArea.extent = imageExtend;
-
-			std::array<VkClearValue, 3> clearVals = {};
-			clearVals[0].color = { 0.0f, 0.0f, 0.0f, 1.f };
-			clearVals[1].depthStencil = { 1.0f,0 };
-			clearVals[2].color = { 0.0f, 0.0f, 0.0f, 1.f };
-
-			renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearVals.size());
-			renderPassBeginInfo.pClearValues = clearVals.data();
-
-			vkCmdBeginRenderPass(mvCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-			VkViewport viewport = {};
-			viewport.x = viewport.y = 0;
-			viewport.width = imageExtend.width/2.0f;
-			viewport.height = (float)imageExtend.height;
-			viewport.maxDepth = 1;
-			viewport.minDepth = 0;
-
-			VkRect2D scissorRect = {};
-			scissorRect.extent = { imageExtend.width/2 ,imageExtend.height};
-			scissorRect.offset = { 0,0 };
+			CompletionMarker completion = pendingCompletions.front();
+			pendingCompletions.pop_front();
+			lock.unlock();
 
-			vkCmdSetViewport(mvCmdBuffers[i], 0, 1, &viewport);
-			vkCmdSetScissor(mvCmdBuffers[i], 0, 1, &scissorRect);
-
-			vkCmdBindDescriptorSets(mvCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, mvPipelineLayout, 0, 1, &descriptorSets[i], 0, nullptr);
-
-			vkCmdBindPipeline(mvCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, mvFramePipelines[0]);
-			vkCmdDraw(mvCmdBuffers[i], 4, 1, 0, 0);
-
-			viewport.x = imageExtend.width / 2.0f;
-			scissorRect.offset.x = imageExtend.width / 2;
-			vkCmdSetViewport(mvCmdBuffers[i], 0, 1, &viewport);
-			vkCmdSetScissor(mvCmdBuffers[i], 0, 1, &scissorRect);
-			vkCmdBindPipeline(mvCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, mvFramePipelines[1]);
-			vkCmdDraw(mvCmdBuffers[i], 4, 1, 0, 0);
-
-			vkCmdEndRenderPass(mvCmdBuffers[i]);
-
-			if (vkEndCommandBuffer(mvCmdBuffers[i]) != VK_SUCCESS)
+			if (completion.fence == VK_NULL_HANDLE)
 			{
-				throw std::runtime_error("Error in ending command buffer recording");
+				graphicsTimeline.wait(completion.timelineValue);
+				latencyTracker.markStage(completion.latencyFrame, LatencyTracker::Stage::GpuComplete, latencyTracker.now());
+				lock.lock();
+				continue;
 			}
+
+			vkWaitForFences(logicalDevice, 1, &completion.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+			latencyTracker.markStage(completion.latencyFrame, LatencyTracker::Stage::GpuComplete, latencyTracker.now());
+			vkResetFences(logicalDevice, 1, &completion.fence);
+
+			lock.lock();
+			freeCompletionFences.push_back(completion.fence);
 		}
 	}
 
-	void drawFrame()
+	void stopCompletionWatcher()
 	{
-		vkWaitForFences(logicalDevice, 1, &fences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
-
-		uint32_t swapChainIdx;
-		VkResult result = vkAcquireNextImageKHR(logicalDevice, swapChain, std::numeric_limits<uint64_t>::max(),
-			imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &swapChainIdx);
-
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
-		{
-			std::cout << "Swap chain and pipeline is out dated,Recreating them!" << std::endl;
-			recreateSwapchain();
-			return;
-		}
-		else if (result == VK_SUBOPTIMAL_KHR)
 		{
-			std::cout << "Swap chain is not optimal still usable";
+			std::lock_guard<std::mutex> lock(completionMutex);
+			bStopCompletionWatcher = true;
+			completionCondition.notify_one();
 		}
-		else if (result != VK_SUCCESS)
+		if (completionWatcherThread.joinable())
 		{
-			throw std::runtime_error("Failed to acquire image from swap chain to submit render command to graphics queue");
+			completionWatcherThread.join();
 		}
+	}
 
-		updateProjectionData(swapChainIdx);
-
-		VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
-		VkSemaphore signalSemaphores[] = { imageRenderedSemaphores[currentFrame] };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-
-		VkSubmitInfo cmdBufferSubmitInfo = {};
-		cmdBufferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		cmdBufferSubmitInfo.commandBufferCount = 1;
-		cmdBufferSubmitInfo.pCommandBuffers = &graphicsCmdBuffers[swapChainIdx];
-		cmdBufferSubmitInfo.waitSemaphoreCount = 1;
-		cmdBufferSubmitInfo.pWaitSemaphores = waitSemaphores;
-		cmdBufferSubmitInfo.pWaitDstStageMask = waitStages;
-		cmdBufferSubmitInfo.signalSemaphoreCount = 1;
-		cmdBufferSubmitInfo.pSignalSemaphores = &mvRenderingSemaphore;
+	// Percentiles of every source and stage that recorded samples, Histograms go to latencyHistogramPath when set
+	void reportLatency()
+	{
+		for (uint32_t source = 0; source < (uint32_t)LatencyTracker::Source::Count; source++)
+		{
+			for (uint32_t stage = 0; stage < (uint32_t)LatencyTracker::Stage::Count; stage++)
+			{
+				LatencyTracker::Histogram histogram = latencyTracker.getHistogram((LatencyTracker::Source)source, (LatencyTracker::Stage)stage);
+				if (histogram.count == 0)
+				{
+					continue;
+				}
 
-		vkWaitForFences(logicalDevice, 1, &mvTaskFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
-		vkResetFences(logicalDevice, 1, &mvTaskFence);
+				std::cout << LatencyTracker::getSourceName((LatencyTracker::Source)source) << " to "
+					<< LatencyTracker::getStageName((LatencyTracker::Stage)stage) << " over " << histogram.count << " samples, Avg "
+					<< histogram.sum / histogram.count * 1000.0 << "ms P50 " << histogram.getPercentile(0.5) * 1000.0 << "ms P95 "
+					<< histogram.getPercentile(0.95) * 1000.0 << "ms P99 " << histogram.getPercentile(0.99) * 1000.0 << "ms Max "
+					<< histogram.max * 1000.0 << "ms" << std::endl;
+			}
+		}
 
-		if (vkQueueSubmit(graphicsQueue, 1, &cmdBufferSubmitInfo, mvTaskFence) != VK_SUCCESS)
+		if (!latencyHistogramPath.empty())
 		{
-			throw std::runtime_error("Error when submitting command to the queue");
+			latencyTracker.exportCsv(latencyHistogramPath);
+			std::cout << "Latency histograms written to " << latencyHistogramPath << std::endl;
 		}
+	}
 
-		cmdBufferSubmitInfo.pCommandBuffers = &mvCmdBuffers[swapChainIdx];
-		cmdBufferSubmitInfo.pWaitSemaphores = &mvRenderingSemaphore;
-		cmdBufferSubmitInfo.pSignalSemaphores = signalSemaphores;
-
-		vkResetFences(logicalDevice, 1, &fences[currentFrame]);
-
-		if (vkQueueSubmit(graphicsQueue, 1, &cmdBufferSubmitInfo, fences[currentFrame]) != VK_SUCCESS)
+	// Switches frames in flight, swap chain and frame limiter between frames, Measurements of previous profile are closed first
+	void applyLatencyProfile(const LatencyProfile& profile)
+	{
+		if (bUseAsyncTimewarp)
 		{
-			throw std::runtime_error("Error when submitting command to the queue");
+			stopTimewarp();
 		}
+		vkDeviceWaitIdle(logicalDevice);
+		closeLatencyProfileStats();
 
-		VkPresentInfoKHR presentInfo = {};
-		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = signalSemaphores;
-
-		VkSwapchainKHR swapChains[] = { swapChain };
-		presentInfo.swapchainCount = 1;
-		presentInfo.pSwapchains = swapChains;
-		presentInfo.pResults = nullptr;
-		presentInfo.pImageIndices = &swapChainIdx;
-
-		result = vkQueuePresentKHR(presentQueue, &presentInfo);
+		cleanFrameSync();
+		latencyProfile = profile;
+		// Frame slots are created for image count of new swap chain
+		recreateSwapchain();
+		createFrameSync();
+		lastFrameStartTime = -1.0;
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || bIsWindowResized)
+		if (bUseAsyncTimewarp)
 		{
-			std::cout << "Swap chain and pipeline is out dated,Recreating them!" << std::endl;
-			bIsWindowResized = false;
-			recreateSwapchain();
-			return;
+			startTimewarp();
 		}
-		else if (result != VK_SUCCESS)
+	}
+
+	// Frame rate and latency since current profile was applied, Latency histograms start over for next one
+	void closeLatencyProfileStats()
+	{
+		LatencyProfile::Stats stats;
+		stats.profileName = latencyProfile.name;
+		stats.framesInFlight = latencyProfile.framesInFlight;
+		stats.swapchainImageCount = (uint32_t)swapChainImages.size();
+		stats.presentMode = swapChainPresentMode;
+		stats.bLimitFrameRate = latencyProfile.bLimitFrameRate;
+		stats.frameCount = frameNumber - latencyProfileStartFrame;
+		stats.seconds = latencyTracker.now() - latencyProfileStartTime;
+		stats.framesPerSecond = stats.seconds > 0.0 ? stats.frameCount / stats.seconds : 0.0;
+
+		// Display times arrive a few frames late, Present return is used when none arrived
+		collectDisplayTimes();
+		stats.latencyStage = LatencyTracker::Stage::Display;
+		if (latencyTracker.getHistogram(LatencyTracker::Source::Pose, stats.latencyStage).count == 0 &&
+			latencyTracker.getHistogram(LatencyTracker::Source::Input, stats.latencyStage).count == 0)
 		{
-			throw std::runtime_error("Failed to present swap chain to presentation queue");
+			stats.latencyStage = LatencyTracker::Stage::PresentReturn;
 		}
+		stats.inputLatency = latencyTracker.getHistogram(LatencyTracker::Source::Input, stats.latencyStage);
+		stats.poseLatency = latencyTracker.getHistogram(LatencyTracker::Source::Pose, stats.latencyStage);
+		latencyProfileStats.push_back(stats);
 
-		currentFrame = (currentFrame + 1) % MAX_PARALLEL_FRAMES;
+		latencyTracker.resetHistograms();
+		latencyProfileStartFrame = frameNumber;
+		latencyProfileStartTime = latencyTracker.now();
 	}
 
-	void updateProjectionData(uint32_t imageIndex)
+	void reportLatencyProfiles()
 	{
-		ProjectionData projectionData = getProjectionData();
+		for (const LatencyProfile::Stats& stats : latencyProfileStats)
+		{
+			std::cout << "Latency profile " << stats.profileName << "(" << stats.framesInFlight << " frames in flight, " << stats.swapchainImageCount
+				<< " images, " << LatencyProfile::getPresentModeName(stats.presentMode) << (stats.bLimitFrameRate ? ", Limited" : "") << ") "
+				<< stats.frameCount << " frames in " << stats.seconds << "s, " << stats.framesPerSecond << " fps";
+			const char* stageName = LatencyTracker::getStageName(stats.latencyStage);
+			if (stats.inputLatency.count > 0)
+			{
+				std::cout << ", Input to " << stageName << " P50/P99 " << stats.inputLatency.getPercentile(0.5) * 1000.0 << "/"
+					<< stats.inputLatency.getPercentile(0.99) * 1000.0 << "ms";
+			}
+			if (stats.poseLatency.count > 0)
+			{
+				std::cout << ", Pose to " << stageName << " P50/P99 " << stats.poseLatency.getPercentile(0.5) * 1000.0 << "/"
+					<< stats.poseLatency.getPercentile(0.99) * 1000.0 << "ms";
+			}
+			std::cout << std::endl;
+		}
+	}
 
+	void updateProjectionData(uint32_t imageIndex, const ProjectionData& projectionData)
+	{
 		void *dataPtr;
 
 		vkMapMemory(logicalDevice, uniformBuffersMemory[imageIndex], 0, sizeof(projectionData), 0, &dataPtr);
@@ -1790,53 +4486,73 @@ private:
 
 	void recreateSwapchain()
 	{
-		int width = 0, height = 0;
-
-		while (width == 0 || height == 0)
+		// Minimized window has no area, Waits until it is restored or closed
+		while (framebufferWidth == 0 || framebufferHeight == 0)
 		{
-			glfwGetFramebufferSize(window, &width, &height);
-			glfwWaitEvents();
+			if (glfwWindowShouldClose(window))
+			{
+				return;
+			}
+
+			if (bUseRenderThread)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			else
+			{
+				glfwWaitEvents();
+			}
 		}
 
 		vkDeviceWaitIdle(logicalDevice);
 
+		bIsFrameDirty = true;
 		preRecreateSwapchain();
 
 		createSwapChain();
 		obtainImageAndImgViews();
-		createRenderPass();
+		createRenderGraph();
+		reportRenderGraph();
 		createRenderPipeline();
-		createImageResources();
-		createDepthResources();
-		createFramebuffers();
 		allocDescriptorSets();
 		allocAndRecordCmdBuffers();
+
+		// Swap chain came back with fewer images than there are frame slots, Unless slots are being rebuilt anyway
+		if (!fences.empty() && swapChainImages.size() < fences.size())
+		{
+			cleanFrameSync();
+			createFrameSync();
+		}
 	}
 
 	void preRecreateSwapchain()
 	{
 		descriptorSets.push_back(textureDescriptorSet);
+		descriptorSets.insert(descriptorSets.end(), distortionDescriptorSets.begin(), distortionDescriptorSets.end());
 		vkFreeDescriptorSets(logicalDevice, descriptorPool, (uint32_t)descriptorSets.size(), descriptorSets.data());
 		descriptorSets.clear();
+		distortionDescriptorSets.clear();
 		textureDescriptorSet =nullptr;
 
-		cleanFrameBuffers(logicalDevice);
-		cleanDepthResource();
-		cleanImageResources();
-		vkDestroyPipeline(logicalDevice, pipeLine, nullptr);
+		renderGraph.destroy(logicalDevice);
+		for (VkPipeline meshPipeLine : meshPipeLines)
+		{
+			vkDestroyPipeline(logicalDevice, meshPipeLine, nullptr);
+		}
+		vkDestroyPipeline(logicalDevice, surfacePipeLine, nullptr);
+		vkDestroyPipeline(logicalDevice, cullPipeLine, nullptr);
 		for (uint32_t i = 0; i < noOfViews; i++)
 		{
 			vkDestroyPipeline(logicalDevice, mvFramePipelines[i], nullptr);
 		}
 		vkDestroyPipelineLayout(logicalDevice, mvPipelineLayout, nullptr);
 		vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
-		vkDestroyRenderPass(logicalDevice, renderPass, nullptr);
-		vkDestroyRenderPass(logicalDevice, mvRenderPass, nullptr);
 		cleanImageViews();
 		vkDestroySwapchainKHR(logicalDevice, swapChain, nullptr);
 	}
 
-	void createSemaphores()
+	// Semaphores and fence of every frame slot, Rebuilt when latency profile changes frames in flight
+	void createFrameSync()
 	{
 		VkSemaphoreCreateInfo semaphoreCreateInfo = {};
 		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -1845,35 +4561,89 @@ private:
 		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		imageAvailableSemaphores.resize(MAX_PARALLEL_FRAMES);
-		imageRenderedSemaphores.resize(MAX_PARALLEL_FRAMES);
-		fences.resize(MAX_PARALLEL_FRAMES);
-
-		for (int i = 0; i < MAX_PARALLEL_FRAMES; i++)
+		// Frames beyond image count would only wait on acquire while holding per image uniforms of frames before them
+		if (latencyProfile.framesInFlight > swapChainImages.size())
 		{
+			std::cout << "Only " << swapChainImages.size() << " swap chain images, Frames in flight lowered from " << latencyProfile.framesInFlight
+				<< std::endl;
+			latencyProfile.framesInFlight = (uint32_t)swapChainImages.size();
+		}
 
+		uint32_t framesInFlight = latencyProfile.framesInFlight;
+		imageAvailableSemaphores.resize(framesInFlight);
+		imageRenderedSemaphores.resize(framesInFlight);
+		fences.assign(framesInFlight, VK_NULL_HANDLE);
+		// Binary semaphores are left for acquire and present, Everything else waits on values of queue timelines
+		frameTimelineValues.assign(framesInFlight, 0);
+		imageTimelineValues.assign(LatencyProfile::MAX_SWAPCHAIN_IMAGES, 0);
+		imageFences.assign(LatencyProfile::MAX_SWAPCHAIN_IMAGES, VK_NULL_HANDLE);
+		currentFrame = 0;
+
+		for (uint32_t i = 0; i < framesInFlight; i++)
+		{
 			if (vkCreateSemaphore(logicalDevice, &semaphoreCreateInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
 				vkCreateSemaphore(logicalDevice, &semaphoreCreateInfo, nullptr, &imageRenderedSemaphores[i]) != VK_SUCCESS ||
-				vkCreateFence(logicalDevice, &fenceCreateInfo, nullptr, &fences[i]) != VK_SUCCESS)
+				(!bHasTimelineSemaphores && vkCreateFence(logicalDevice, &fenceCreateInfo, nullptr, &fences[i]) != VK_SUCCESS))
 			{
 				throw std::runtime_error("Failed to create semaphores for synchronizing");
 			}
 		}
-
-		vkCreateSemaphore(logicalDevice, &semaphoreCreateInfo, nullptr, &mvRenderingSemaphore);
-		vkCreateFence(logicalDevice, &fenceCreateInfo, nullptr, &mvTaskFence);
 	}
 
-	void cleanSemaphores()
+	void cleanFrameSync()
 	{
-		for (int i = 0; i < MAX_PARALLEL_FRAMES; i++)
+		for (size_t i = 0; i < fences.size(); i++)
 		{
 			vkDestroySemaphore(logicalDevice, imageAvailableSemaphores[i], nullptr);
 			vkDestroySemaphore(logicalDevice, imageRenderedSemaphores[i], nullptr);
 			vkDestroyFence(logicalDevice, fences[i], nullptr);
 		}
+		imageAvailableSemaphores.clear();
+		imageRenderedSemaphores.clear();
+		fences.clear();
+	}
+
+	void createSemaphores()
+	{
+		createFrameSync();
+		if (bHasTimelineSemaphores)
+		{
+			return;
+		}
+
+		VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		VkFenceCreateInfo fenceCreateInfo = {};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		vkCreateSemaphore(logicalDevice, &semaphoreCreateInfo, nullptr, &mvRenderingSemaphore);
+		vkCreateFence(logicalDevice, &fenceCreateInfo, nullptr, &mvTaskFence);
+
+		// Signaled only by geometry copies
+		fenceCreateInfo.flags = 0;
+		vkCreateFence(logicalDevice, &fenceCreateInfo, nullptr, &geometryUploadFence);
+
+		// Completion markers of frames in flight, Watcher thread hands them back once they signaled
+		freeCompletionFences.resize(COMPLETION_FENCE_COUNT);
+		for (VkFence& fence : freeCompletionFences)
+		{
+			vkCreateFence(logicalDevice, &fenceCreateInfo, nullptr, &fence);
+		}
+	}
+
+	void cleanSemaphores()
+	{
+		cleanFrameSync();
 		vkDestroySemaphore(logicalDevice, mvRenderingSemaphore, nullptr);
 		vkDestroyFence(logicalDevice, mvTaskFence, nullptr);
+		vkDestroyFence(logicalDevice, geometryUploadFence, nullptr);
+		for (VkFence fence : freeCompletionFences)
+		{
+			vkDestroyFence(logicalDevice, fence, nullptr);
+		}
+		freeCompletionFences.clear();
 	}
 
 	void createImageTextureAndView(std::string path,int pushIndex)
@@ -1884,26 +4654,54 @@ private:
 		}
 		TextureData& data = textures[pushIndex];
 
-		int texWidth, texHeight, texChannels;
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		MappedFile sourceFile;
+		if (!sourceFile.open(path))
+		{
+			throw std::runtime_error("Failed loading texture pixels");
+		}
 
-		stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		TextureCacheSettings cacheSettings;
+		cacheSettings.format = VK_FORMAT_R8G8B8A8_UNORM;
+		cacheSettings.bytesPerPixel = 4;
+		// 0 means full mip chain, Actual count depends on the image size
+		cacheSettings.mipLevels = 0;
 
-		VkDeviceSize size = texWidth * texHeight * 4;
-		data.mipLevelsCount = static_cast<uint32_t>(std::floor(std::log2(std::max(texHeight, texWidth)))) + 1;
+		uint64_t cacheKey = TextureCache::computeKey(sourceFile.data(), sourceFile.size(), cacheSettings);
 
-		VkFormatProperties formatProps;
-		vkGetPhysicalDeviceFormatProperties(vulkanDevice, VK_FORMAT_R8G8B8A8_UNORM, &formatProps);
+		MappedFile cacheFile;
+		TexturePyramid pyramid;
+		std::vector<uint8_t> pyramidPixels;
 
-		if (!(formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+		bool bIsCacheHit = textureCache.find(cacheKey, cacheSettings, cacheFile, pyramid);
+		if (!bIsCacheHit)
 		{
-			data.mipLevelsCount = 1;
-			std::cerr << "Cannot create MipMaps by Image Blit as Linear Filtering is not supported by hardware.Using only base texture" << std::endl;
-		}
+			int texWidth, texHeight, texChannels;
 
-		if (!pixels)
-		{
-			throw std::runtime_error("Failed loading texture pixels");
+			stbi_uc* pixels = stbi_load_from_memory(sourceFile.data(), (int)sourceFile.size(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+			if (!pixels)
+			{
+				throw std::runtime_error("Failed loading texture pixels");
+			}
+
+			uint32_t mipLevelsCount = TextureCache::getFullMipLevels(texWidth, texHeight);
+			TextureCache::buildMipChain(pixels, texWidth, texHeight, mipLevelsCount, cacheSettings.bytesPerPixel, pyramidPixels, pyramid.mips);
+			stbi_image_free(pixels);
+
+			pyramid.format = cacheSettings.format;
+			pyramid.width = texWidth;
+			pyramid.height = texHeight;
+			pyramid.pixels = pyramidPixels.data();
+			pyramid.pixelsSize = pyramidPixels.size();
+
+			textureCache.store(cacheKey, pyramid);
 		}
+		sourceFile.close();
+
+		data.mipLevelsCount = (uint32_t)pyramid.mips.size();
+		VkDeviceSize size = pyramid.pixelsSize;
 
 		VkBuffer stagingBuffer;
 		VkDeviceMemory stagingBufferMemory;
@@ -1914,22 +4712,19 @@ private:
 		void *dataPtr;
 
 		vkMapMemory(logicalDevice, stagingBufferMemory, 0, size, 0, &dataPtr);
-		memcpy(dataPtr, pixels, size);
+		memcpy(dataPtr, pyramid.pixels, size);
 		vkUnmapMemory(logicalDevice, stagingBufferMemory);
 
-		stbi_image_free(pixels);
+		cacheFile.close();
+		pyramidPixels.clear();
 
-		createImageMemory(VK_FORMAT_R8G8B8A8_UNORM, texWidth, texHeight, VK_SAMPLE_COUNT_1_BIT, data.mipLevelsCount, VK_IMAGE_USAGE_TRANSFER_DST_BIT |
-			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, data.textureImage, data.textureImageMemory);
+		createImageMemory(VK_FORMAT_R8G8B8A8_UNORM, pyramid.width, pyramid.height, VK_SAMPLE_COUNT_1_BIT, data.mipLevelsCount, 
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, data.textureImage, data.textureImageMemory);
 
 		transitionImageLayout(data.textureImage, data.mipLevelsCount, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		copyBufferToImage(stagingBuffer, data.textureImage, texWidth, texHeight);
-
-		generateMipMaps(data.textureImage, data.mipLevelsCount, texWidth, texHeight);
-
-		// Not needed as all the transitions will be taken care by generateMips
-		//transitionImageLayout(textureImage, mipLevelsCount, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		//	VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		copyBufferToImageMips(stagingBuffer, data.textureImage, pyramid.mips);
+		transitionImageLayout(data.textureImage, data.mipLevelsCount, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 		vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
 		vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
@@ -1937,133 +4732,9 @@ private:
 		// Creating View
 		createImageView(data.textureImage, data.mipLevelsCount, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, data.textureImageView);
 
-	}
-
-	void generateMipMaps(VkImage &image, uint32_t mipMapLevels, uint32_t texWidth, uint32_t texHeight)
-	{
-		VkImageMemoryBarrier barrier = {};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.image = image;
-		barrier.srcQueueFamilyIndex = barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-		barrier.subresourceRange.levelCount = 1;
-
-		int32_t mipWidth = texWidth, mipHeight = texHeight;
-
-		VkCommandBuffer cmdBuffer = startOneTimeCmdBuffer(&graphicsCmdPool);
-
-		for (uint32_t i = 1; i < mipMapLevels; i++)
-		{
-			barrier.subresourceRange.baseMipLevel = i - 1;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-			vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
-				nullptr, 0, nullptr, 1, &barrier);
-
-			VkImageBlit blit = {};
-			blit.srcOffsets[0] = { 0,0,0 };
-			blit.srcOffsets[1] = { mipWidth,mipHeight,1 };
-			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			blit.srcSubresource.baseArrayLayer = 0;
-			blit.srcSubresource.layerCount = 1;
-			blit.srcSubresource.mipLevel = i - 1;
-			blit.dstOffsets[0] = { 0,0,0 };
-			blit.dstOffsets[1] = { mipWidth>1 ? mipWidth / 2 : 1,mipHeight>1 ? mipHeight / 2 : 1,1 };
-			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			blit.dstSubresource.baseArrayLayer = 0;
-			blit.dstSubresource.layerCount = 1;
-			blit.dstSubresource.mipLevel = i;
-
-			vkCmdBlitImage(cmdBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1, &blit, VK_FILTER_LINEAR);
-
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
-				nullptr, 0, nullptr, 1, &barrier);
-
-			if (mipWidth > 1)
-				mipWidth /= 2;
-			if (mipHeight > 1)
-				mipHeight /= 2;
-		}
-
-		// Final mipmap transition to shader read layout
-		barrier.subresourceRange.baseMipLevel = mipMapLevels - 1;
-		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
-			nullptr, 0, nullptr, 1, &barrier);
-
-		endOneTimeCmdBuffer(cmdBuffer, &graphicsCmdPool);
-	}
-
-	void createImageResources()
-	{
-		VkFormat imageFormat = choosenSurfaceFormat.format;
-		createImageMemory(imageFormat, imageExtend.width, imageExtend.height, msaaSampleBitsCount, 1,
-			VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			msaaColorRenderTarget, colorRenderTargetMemory);
-
-		createImageView(msaaColorRenderTarget, 1, imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, colorRenderTargetImageView);
-
-		transitionImageLayout(msaaColorRenderTarget, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-
-		// Multiview image resource
-		createImageMemory(imageFormat, imageExtend.width, imageExtend.height, VK_SAMPLE_COUNT_1_BIT, 1, 
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mvColorTexture, mvColorTextureMemory, noOfViews);
-
-		createImageView(mvColorTexture, 1, imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, mvColorTextureImageView,noOfViews,VK_IMAGE_VIEW_TYPE_2D_ARRAY);
-
-		transitionImageLayout(mvColorTexture, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, noOfViews);
-	}
-
-	void cleanImageResources()
-	{
-		vkDestroyImageView(logicalDevice, colorRenderTargetImageView, nullptr);
-		vkDestroyImage(logicalDevice, msaaColorRenderTarget, nullptr);
-		vkFreeMemory(logicalDevice, colorRenderTargetMemory, nullptr);
-
-		vkDestroyImageView(logicalDevice, mvColorTextureImageView, nullptr);
-		vkDestroyImage(logicalDevice, mvColorTexture, nullptr);
-		vkFreeMemory(logicalDevice, mvColorTextureMemory, nullptr);
-	}
-
-	void createDepthResources()
-	{
-		depthFormat = chooseDepthImageFormat();
-		createImageMemory(depthFormat, imageExtend.width, imageExtend.height, msaaSampleBitsCount, 1,
-			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthTexture, depthTextureMemory);
-		VkImageAspectFlags flags = hasStencilFormat(depthFormat) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
-		createImageView(depthTexture, 1, depthFormat, flags, depthTextureImageView);
-		transitionImageLayout(depthTexture, 1, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-
-		createImageMemory(depthFormat, imageExtend.width, imageExtend.height, VK_SAMPLE_COUNT_1_BIT, 1,
-			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mvDepthTexture, mvDepthTextureMemory, noOfViews);
-		createImageView(mvDepthTexture, 1, depthFormat, flags, mvDepthTextureImageView,noOfViews, VK_IMAGE_VIEW_TYPE_2D_ARRAY);
-		transitionImageLayout(mvDepthTexture, 1, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,noOfViews);
-	}
-
-	void cleanDepthResource()
-	{
-		vkDestroyImageView(logicalDevice, depthTextureImageView, nullptr);
-		vkDestroyImage(logicalDevice, depthTexture, nullptr);
-		vkFreeMemory(logicalDevice, depthTextureMemory, nullptr);
-
-		vkDestroyImageView(logicalDevice, mvDepthTextureImageView, nullptr);
-		vkDestroyImage(logicalDevice, mvDepthTexture,nullptr);
-		vkFreeMemory(logicalDevice, mvDepthTextureMemory, nullptr);
+		float loadTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - startTime).count();
+		std::cout << "Texture " << path << " : " << (bIsCacheHit ? "Cache hit" : "Cache miss") << ", " << pyramid.width << "x" << pyramid.height
+			<< " with " << data.mipLevelsCount << " mips loaded in " << loadTime << "ms" << std::endl;
 	}
 
 	void createTextureSampler()
@@ -2080,8 +4751,8 @@ private:
 		samplerCreateInfo.compareEnable = VK_FALSE;
 		samplerCreateInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 
-		samplerCreateInfo.anisotropyEnable = VK_TRUE;
-		samplerCreateInfo.maxAnisotropy = 16;
+		samplerCreateInfo.anisotropyEnable = samplerAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+		samplerCreateInfo.maxAnisotropy = samplerAnisotropy;
 
 		samplerCreateInfo.mipLodBias = 0;
 		samplerCreateInfo.minLod = 0;
@@ -2102,8 +4773,8 @@ private:
 		samplerCreateInfo.compareEnable = VK_FALSE;
 		samplerCreateInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 
-		samplerCreateInfo.anisotropyEnable = VK_TRUE;
-		samplerCreateInfo.maxAnisotropy = 16;
+		samplerCreateInfo.anisotropyEnable = samplerAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+		samplerCreateInfo.maxAnisotropy = samplerAnisotropy;
 
 		samplerCreateInfo.mipLodBias = 0;
 		samplerCreateInfo.minLod = 0;
@@ -2280,6 +4951,33 @@ private:
 		endOneTimeCmdBuffer(copyCmdBuffer);
 	}
 
+	void copyBufferToImageMips(VkBuffer &buffer, VkImage &image, const std::vector<TextureMipInfo>& mips)
+	{
+
+		VkCommandBuffer copyCmdBuffer = startOneTimeCmdBuffer();
+
+		std::vector<VkBufferImageCopy> bufferToImageRegions(mips.size());
+		for (uint32_t i = 0; i < mips.size(); i++)
+		{
+			VkBufferImageCopy& bufferToImage = bufferToImageRegions[i];
+			bufferToImage.bufferImageHeight = 0;
+			bufferToImage.bufferRowLength = 0;
+			bufferToImage.bufferOffset = mips[i].offset;
+
+			bufferToImage.imageExtent = { mips[i].width,mips[i].height,1 };
+			bufferToImage.imageOffset = { 0,0,0 };
+			bufferToImage.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			bufferToImage.imageSubresource.baseArrayLayer = 0;
+			bufferToImage.imageSubresource.layerCount = 1;
+			bufferToImage.imageSubresource.mipLevel = i;
+		}
+
+		vkCmdCopyBufferToImage(copyCmdBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)bufferToImageRegions.size(),
+			bufferToImageRegions.data());
+
+		endOneTimeCmdBuffer(copyCmdBuffer);
+	}
+
 	void transitionImageLayout(VkImage image, uint32_t mipLevels, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t arrayLayers = 1)
 	{
 
@@ -2314,11 +5012,19 @@ private:
 			srcStageFlags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
 			dstStageFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
 		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		{
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			srcStageFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dstStageFlags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			pool = &graphicsCmdPool;
+		}
+		else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
 		{
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.srcAccessMask = 0;
 			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			srcStageFlags = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			srcStageFlags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
 			dstStageFlags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 			pool = &graphicsCmdPool;
 		}
@@ -2386,27 +5092,45 @@ private:
 
 		VkQueue queueToSubmitTo = pool ? graphicsQueue : transferQueue;
 
-		vkQueueSubmit(queueToSubmitTo, 1, &cmdSubmitInfo, nullptr);
+		// Only this batch is waited on with timeline semaphores, Frames in flight on same queue keep going
+		if (bHasTimelineSemaphores)
+		{
+			QueueTimeline& timeline = pool ? graphicsTimeline : transferTimeline;
+			uint64_t value;
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				value = timeline.submit(cmdSubmitInfo);
+			}
+			timeline.wait(value);
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			vkQueueSubmit(queueToSubmitTo, 1, &cmdSubmitInfo, nullptr);
 
-		vkQueueWaitIdle(queueToSubmitTo);
+			vkQueueWaitIdle(queueToSubmitTo);
+		}
 
 		vkFreeCommandBuffers(logicalDevice, pool ? *pool : transferCmdPool, 1, &cmdBuffer);
 	}
 
-	VkSampleCountFlagBits getMsaaSampleCount()
+	// Highest sample count supported for color and depth attachments that does not exceed requestedSamples
+	VkSampleCountFlagBits getMsaaSampleCount(uint32_t requestedSamples)
 	{
 		VkPhysicalDeviceProperties deviceProps;
 		vkGetPhysicalDeviceProperties(vulkanDevice, &deviceProps);
 
-		VkSampleCountFlags countFlags = std::min(deviceProps.limits.framebufferColorSampleCounts,
-			deviceProps.limits.framebufferDepthSampleCounts);
+		// Both color and depth attachments need to support the count
+		VkSampleCountFlags countFlags = deviceProps.limits.framebufferColorSampleCounts & deviceProps.limits.framebufferDepthSampleCounts;
 
-		if (countFlags & VK_SAMPLE_COUNT_64_BIT) return VK_SAMPLE_COUNT_64_BIT;
-		if (countFlags & VK_SAMPLE_COUNT_32_BIT) return VK_SAMPLE_COUNT_32_BIT;
-		if (countFlags & VK_SAMPLE_COUNT_16_BIT) return VK_SAMPLE_COUNT_16_BIT;
-		if (countFlags & VK_SAMPLE_COUNT_8_BIT) return VK_SAMPLE_COUNT_8_BIT;
-		if (countFlags & VK_SAMPLE_COUNT_4_BIT) return VK_SAMPLE_COUNT_4_BIT;
-		if (countFlags & VK_SAMPLE_COUNT_2_BIT) return VK_SAMPLE_COUNT_2_BIT;
+		// Sample count flag bits equal their sample count
+		for (uint32_t samples = 64; samples > 1; samples >>= 1)
+		{
+			if (samples <= requestedSamples && (countFlags & samples))
+			{
+				return (VkSampleCountFlagBits)samples;
+			}
+		}
 
 		return VK_SAMPLE_COUNT_1_BIT;
 	}
@@ -2442,22 +5166,46 @@ private:
 	static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 	{
 		RenderingApplication* app = reinterpret_cast<RenderingApplication*>(glfwGetWindowUserPointer(window));
-		if (key == GLFW_KEY_W && action == GLFW_RELEASE)
-		{
-			// Increase distortion value by 0.1;
-			app->currentDistAlpha += 0.1f;
-			app->currentDistAlpha = glm::clamp(app->currentDistAlpha, -1.f, 1.f);
-		}
-		else if (key == GLFW_KEY_S && action == GLFW_RELEASE)
+		if (action != GLFW_RELEASE)
 		{
-			// descreases distortion value by 0.1;
-			app->currentDistAlpha -= 0.1f;
-			app->currentDistAlpha = glm::clamp(app->currentDistAlpha, -1.f, 1.f);
+			return;
 		}
-		if (key == GLFW_KEY_T && action == GLFW_RELEASE)
+		app->latencyTracker.stampSample(LatencyTracker::Source::Input);
+
+		switch (key)
 		{
-			// Toggles distortionAlpha
-			app->currentDistAlpha = app->currentDistAlpha == 0.0f ? app->defaultDistortionAlpha : 0.0f;
+		case GLFW_KEY_W:
+			app->recordInput(InputAction::IncreaseDistortion);
+			break;
+		case GLFW_KEY_S:
+			app->recordInput(InputAction::DecreaseDistortion);
+			break;
+		case GLFW_KEY_T:
+			app->recordInput(InputAction::ToggleDistortion);
+			break;
+		case GLFW_KEY_P:
+			app->recordInput(InputAction::CycleSurface);
+			break;
+		case GLFW_KEY_A:
+			app->recordInput(InputAction::NarrowSurface);
+			break;
+		case GLFW_KEY_D:
+			app->recordInput(InputAction::WidenSurface);
+			break;
+		case GLFW_KEY_I:
+			app->recordInput(InputAction::CycleInstances);
+			break;
+		case GLFW_KEY_L:
+			app->recordInput(InputAction::CycleLodError);
+			break;
+		case GLFW_KEY_M:
+			app->recordInput(InputAction::SwapModel);
+			break;
+		case GLFW_KEY_F:
+			app->recordInput(InputAction::CycleLatencyProfile);
+			break;
+		default:
+			break;
 		}
 	}
 
@@ -2479,18 +5227,29 @@ private:
 		return fileData;
 	}
 	
-	ProjectionData getProjectionData()
+	glm::mat4 getModelTransform() const
 	{
-		static auto initTime = std::chrono::high_resolution_clock::now();
-		auto currentTime = std::chrono::high_resolution_clock::now();
-
-		float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - initTime).count();
+		glm::mat4 modelTransform = glm::rotate(glm::mat4(1.0f), glm::radians(270.0f)/* *time*/, glm::vec3(0.0f, 0.0f, 1.0f));
+		return glm::rotate(modelTransform, glm::radians(180.f), glm::vec3(1.0f, 0.0f, 0.0f));
+	}
 
+	// Brings positions of compact vertices from normalized mesh bounds back to model space
+	glm::mat4 getVertexDecodeTransform() const
+	{
+		const MeshData& mesh = geometrySlots[activeGeometrySlot].mesh;
+		if (bUseProceduralSurface || (VertexLayout)mesh.vertexLayout != VertexLayout::Compact)
+		{
+			return glm::mat4(1.0f);
+		}
 
-		ProjectionData data;
-		data.modelTransform = glm::rotate(glm::mat4(1.0f), glm::radians(270.0f)/* *time*/, glm::vec3(0.0f, 0.0f, 1.0f));
-		data.modelTransform = glm::rotate(data.modelTransform, glm::radians(180.f), glm::vec3(1.0f, 0.0f, 0.0f));
+		glm::vec3 boundsMin(mesh.bounds.min[0], mesh.bounds.min[1], mesh.bounds.min[2]);
+		glm::vec3 boundsMax(mesh.bounds.max[0], mesh.bounds.max[1], mesh.bounds.max[2]);
+		return glm::scale(glm::translate(glm::mat4(1.0f), boundsMin), boundsMax - boundsMin);
+	}
 
+	// Views and projections of both eyes with head at headPose, Only reads state that stays the same while late stage thread runs
+	void getEyeTransforms(glm::mat4 (&viewTransforms)[2], glm::mat4 (&projectionTransforms)[2], const Pose& headPose) const
+	{
 		float halfEyeSeperation = 0.5f*eyeSeperation;
 
 		// Calculating from resolution
@@ -2500,24 +5259,258 @@ private:
 
 		// Left eye
 
-		data.projectionTransforms[0] = glm::perspective(glm::radians(fovY), aspectRatio, nearClip, farClip);
-		data.projectionTransforms[0][1][1] *= -1;// since GLM is for OpenGL and Y clip coordinate is inverted in OpenGL
+		projectionTransforms[0] = glm::perspective(glm::radians(fovY), aspectRatio, nearClip, farClip);
+		projectionTransforms[0][1][1] *= -1;// since GLM is for OpenGL and Y clip coordinate is inverted in OpenGL
 
-		data.viewTransforms[0] = glm::lookAt(cameraPos - (right*halfEyeSeperation), glm::vec3(0, 0, 0) - (right*halfEyeSeperation), glm::vec3(0, 0, 1));
+		// Eyes turn with head around the point between them
+		glm::mat4 cameraView = glm::lookAt(cameraPos, glm::vec3(0, 0, 0), glm::vec3(0, 0, 1));
+		glm::mat4 headView = glm::inverse(headPose.getTransform()) * cameraView;
+		glm::vec3 eyeOffset = glm::vec3(cameraView * glm::vec4(right*halfEyeSeperation, 0.0f));
+
+		viewTransforms[0] = glm::translate(glm::mat4(1.0f), eyeOffset) * headView;
 
 		// Right eye
 		
-		data.projectionTransforms[1] = glm::perspective(glm::radians(fovY), aspectRatio, nearClip,farClip);
-		data.projectionTransforms[1][1][1] *= -1;
+		projectionTransforms[1] = glm::perspective(glm::radians(fovY), aspectRatio, nearClip,farClip);
+		projectionTransforms[1][1][1] *= -1;
+
+		viewTransforms[1] = glm::translate(glm::mat4(1.0f), -eyeOffset) * headView;
+	}
+
+	ProjectionData getProjectionData(const Pose& headPose)
+	{
+		static auto initTime = std::chrono::high_resolution_clock::now();
+		auto currentTime = std::chrono::high_resolution_clock::now();
+
+		float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - initTime).count();
+
+
+		ProjectionData data;
+		data.modelTransform = getModelTransform() * getVertexDecodeTransform();
+		getEyeTransforms(data.viewTransforms, data.projectionTransforms, headPose);
 
-		data.viewTransforms[1] = glm::lookAt(cameraPos + (right*halfEyeSeperation), glm::vec3(0, 0, 0) + (right*halfEyeSeperation), glm::vec3(0, 0, 1));
+		// Instances are culled once against a frustum enclosing both eyes instead of once per eye
+		Frustum cullingFrustum = Frustum::combineStereo(Frustum::fromViewProjection(data.projectionTransforms[0] * data.viewTransforms[0]),
+			Frustum::fromViewProjection(data.projectionTransforms[1] * data.viewTransforms[1]));
+		std::copy(std::begin(cullingFrustum.planes), std::end(cullingFrustum.planes), data.cullingPlanes);
 
 		data.distortionAlpha = currentDistAlpha;
 		data.timeSinceStart = time;
 		return data;
 	}
 
+	// Imports model from mesh cache when source is unchanged, Otherwise parses and welds the OBJ and caches the result
 	void loadModel(std::string path)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		uint64_t sourceHash;
+		{
+			MappedFile sourceFile;
+			if (!sourceFile.open(path))
+			{
+				throw std::runtime_error("Failed to open model " + path);
+			}
+			sourceHash = ContentHash::hashBytes(sourceFile.data(), sourceFile.size());
+		}
+
+		MeshCacheSettings settings;
+		settings.vertexLayout = (uint32_t)preferredVertexLayout;
+		settings.layoutHash = 0;
+		for (VertexLayout layout : { VertexLayout::Full, VertexLayout::Compact })
+		{
+			std::vector<VkVertexInputAttributeDescription> attributeDesc = Vertex::getAttributeDesc(layout);
+			settings.layoutHash = ContentHash::combine(settings.layoutHash, ContentHash::hashBytes(attributeDesc.data(),
+				sizeof(attributeDesc[0]) * attributeDesc.size()));
+		}
+		MeshOptimizerSettings optimizerSettings = getMeshOptimizerSettings();
+		MeshSimplifierSettings simplifierSettings;
+		settings.processingHash = ContentHash::combine(MeshOptimizer::hashSettings(optimizerSettings), MeshSimplifier::hashSettings(simplifierSettings));
+
+		uint64_t cacheKey = MeshCache::computeKey(sourceHash, settings);
+		bool bIsCacheHit = meshCache.find(cacheKey, modelMeshMapping, modelMesh);
+		if (!bIsCacheHit)
+		{
+			std::vector<Vertex> unweldedVertices;
+			readObjVertices(path, unweldedVertices);
+
+			VertexWelder<Vertex>::weldStream(unweldedVertices, vertices, indices);
+			optimizeWeldedGeometry(optimizerSettings);
+
+			MeshLod lods[MAX_MESH_LOD_COUNT];
+			uint32_t lodCount = simplifyWeldedGeometry(simplifierSettings, lods);
+
+			encodeWeldedGeometry(sourceHash);
+			modelMesh.lodCount = lodCount;
+			std::copy(lods, lods + lodCount, modelMesh.lods);
+			meshCache.store(cacheKey, modelMesh);
+		}
+
+		float loadTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - startTime).count();
+		std::cout << "Model " << path << " : " << (bIsCacheHit ? "Cache hit" : "Cache miss") << ", " << modelMesh.vertexCount << " vertices "
+			<< modelMesh.indexCount << " indices loaded in " << loadTime << "ms" << std::endl;
+	}
+
+	// Reorders welded geometry for vertex cache reuse, overdraw and vertex fetch, Reporting vertex cache efficiency before and after
+	void optimizeWeldedGeometry(const MeshOptimizerSettings& optimizerSettings)
+	{
+		MeshOptimizationReport report = MeshOptimizer::optimize(reinterpret_cast<uint8_t*>(vertices.data()), vertices.size(), sizeof(Vertex),
+			offsetof(Vertex, position), indices, optimizerSettings);
+		vertices.resize(report.vertexCount);
+
+		std::cout << "Mesh optimization : ACMR " << report.before.acmr << " -> " << report.after.acmr << ", ATVR " << report.before.atvr << " -> "
+			<< report.after.atvr << ", " << report.clusterCount << " overdraw clusters" << std::endl;
+	}
+
+	// Appends detail levels to welded indices, Reporting triangles and error of every level
+	uint32_t simplifyWeldedGeometry(const MeshSimplifierSettings& simplifierSettings, MeshLod* lods)
+	{
+		uint32_t lodCount = MeshSimplifier::buildLodChain(reinterpret_cast<const uint8_t*>(vertices.data()) + offsetof(Vertex, position), vertices.size(),
+			sizeof(Vertex), indices, simplifierSettings, lods);
+
+		std::cout << "Mesh LODs :";
+		for (uint32_t lod = 0; lod < lodCount; lod++)
+		{
+			std::cout << " " << lods[lod].indexCount / 3 << " triangles(error " << lods[lod].error << ")";
+		}
+		std::cout << std::endl;
+		return lodCount;
+	}
+
+	MeshOptimizerSettings getMeshOptimizerSettings() const
+	{
+		MeshOptimizerSettings optimizerSettings;
+
+		// Clusters are sorted in model space so camera is brought into it
+		glm::vec4 viewPosition = glm::inverse(getModelTransform()) * glm::vec4(cameraPos, 1.0f);
+		optimizerSettings.bUseViewPosition = true;
+		optimizerSettings.viewPosition[0] = viewPosition.x;
+		optimizerSettings.viewPosition[1] = viewPosition.y;
+		optimizerSettings.viewPosition[2] = viewPosition.z;
+		return optimizerSettings;
+	}
+
+	// Encodes vertices and indices in the smallest layout and index size that can represent them and points model mesh at them
+	void encodeWeldedGeometry(uint64_t sourceHash)
+	{
+		modelMesh = MeshData();
+		modelMesh.sourceHash = sourceHash;
+		modelMesh.vertexCount = vertices.size();
+		modelMesh.indexCount = indices.size();
+		// Single level drawing every index, Replaced by callers that built a LOD chain
+		modelMesh.lodCount = 1;
+		modelMesh.lods[0] = { 0, (uint32_t)indices.size(), 0.0f };
+		modelMesh.bounds = MeshCache::computeBounds(vertices.empty() ? nullptr : &vertices[0].position.x, vertices.size(), sizeof(Vertex));
+
+		VertexLayout layout = preferredVertexLayout;
+		if (layout == VertexLayout::Compact)
+		{
+			for (const Vertex& vertex : vertices)
+			{
+				if (vertex.textureCoord.x < 0.0f || vertex.textureCoord.x > 1.0f || vertex.textureCoord.y < 0.0f || vertex.textureCoord.y > 1.0f)
+				{
+					std::cout << "Texture coordinates are outside 0 to 1 range, Using full vertex layout" << std::endl;
+					layout = VertexLayout::Full;
+					break;
+				}
+			}
+		}
+
+		modelMesh.vertexLayout = (uint32_t)layout;
+		modelMesh.vertexStride = Vertex::getBindingDesc(layout).stride;
+		encodedVertices.resize((size_t)modelMesh.getVertexDataSize());
+		if (layout == VertexLayout::Compact)
+		{
+			glm::vec3 boundsMin(modelMesh.bounds.min[0], modelMesh.bounds.min[1], modelMesh.bounds.min[2]);
+			glm::vec3 boundsExtent = glm::vec3(modelMesh.bounds.max[0], modelMesh.bounds.max[1], modelMesh.bounds.max[2]) - boundsMin;
+
+			CompactVertex* compactVertices = reinterpret_cast<CompactVertex*>(encodedVertices.data());
+			for (size_t i = 0; i < vertices.size(); i++)
+			{
+				compactVertices[i] = CompactVertex::quantize(vertices[i].position, vertices[i].textureCoord, boundsMin, boundsExtent);
+			}
+		}
+		else
+		{
+			memcpy(encodedVertices.data(), vertices.data(), encodedVertices.size());
+		}
+
+		modelMesh.indexSize = vertices.size() < 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+		encodedIndices.resize((size_t)modelMesh.getIndexDataSize());
+		if (modelMesh.indexSize == sizeof(uint16_t))
+		{
+			uint16_t* shortIndices = reinterpret_cast<uint16_t*>(encodedIndices.data());
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				shortIndices[i] = (uint16_t)indices[i];
+			}
+		}
+		else
+		{
+			memcpy(encodedIndices.data(), indices.data(), encodedIndices.size());
+		}
+
+		modelMesh.vertexData = encodedVertices.data();
+		modelMesh.indexData = encodedIndices.data();
+
+		std::cout << "Vertex layout : " << (layout == VertexLayout::Compact ? "Compact" : "Full") << " with " << modelMesh.vertexStride
+			<< " bytes per vertex and " << modelMesh.indexSize * 8 << " bit indices" << std::endl;
+	}
+
+	void releaseModelMeshSource()
+	{
+		modelMeshMapping.close();
+		modelMesh.vertexData = nullptr;
+		modelMesh.indexData = nullptr;
+		std::vector<Vertex>().swap(vertices);
+		std::vector<uint32_t>().swap(indices);
+		std::vector<uint8_t>().swap(encodedVertices);
+		std::vector<uint8_t>().swap(encodedIndices);
+	}
+
+	// Reads OBJ file as triangle list with a vertex per index, threadCount of 0 lets ObjReader pick it based on file size
+	static void readObjVertices(const std::string& path, std::vector<Vertex>& unweldedVertices, uint32_t threadCount = 0)
+	{
+		ObjData objData;
+		std::string err;
+
+		if (!ObjReader::read(path, objData, err, threadCount))
+		{
+			throw std::runtime_error(err);
+		}
+
+		unweldedVertices.reserve(unweldedVertices.size() + objData.indices.size());
+
+		for (const ObjIndex& index : objData.indices)
+		{
+			Vertex vert = {};
+
+			if (index.textureCoord >= 0)
+			{
+				vert.textureCoord = {
+					objData.textureCoords[2 * index.textureCoord + 0],
+					1.0f - objData.textureCoords[2 * index.textureCoord + 1]
+				};
+			}
+			else
+			{
+				vert.textureCoord = { 0.0f, 1.0f };
+			}
+
+			vert.position = {
+				objData.positions[3 * index.position + 0],
+				objData.positions[3 * index.position + 1],
+				objData.positions[3 * index.position + 2]
+			};
+
+			vert.color = { 1.0f,1.0f ,1.0f };
+
+			unweldedVertices.push_back(vert);
+		}
+	}
+
+	// Reads OBJ file through tinyobj the way loadModel did before ObjReader, Kept as baseline for benchmarkObjParsing
+	static void readObjVerticesTinyObj(const std::string& path, std::vector<Vertex>& unweldedVertices)
 	{
 		tinyobj::attrib_t attribs;
 		std::vector<tinyobj::shape_t> shapes;
@@ -2530,7 +5523,13 @@ private:
 			throw std::runtime_error(err);
 		}
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertexIndexMap;
+		size_t totalIndices = 0;
+		for (tinyobj::shape_t &shape : shapes)
+		{
+			totalIndices += shape.mesh.indices.size();
+		}
+
+		unweldedVertices.reserve(totalIndices);
 
 		for (tinyobj::shape_t &shape : shapes)
 		{
@@ -2551,22 +5550,15 @@ private:
 
 				vert.color = { 1.0f,1.0f ,1.0f };
 
-				if (uniqueVertexIndexMap.find(vert) == uniqueVertexIndexMap.end())
-				{
-					uniqueVertexIndexMap[vert] = (uint32_t)vertices.size();
-					vertices.push_back(vert);
-				}
-
-				indices.push_back(uniqueVertexIndexMap[vert]);
+				unweldedVertices.push_back(vert);
 			}
 		}
-
-		std::cout << "Number of vertices : " << vertices.size() << std::endl;
 	}
 
 	void createCylinder(float height,float radius,int numberOfSlices,float angle)
 	{
-		std::unordered_map<Vertex, uint32_t> uniqueVertexIndexMap;
+		// 4 triangles per slice
+		VertexWelder<Vertex> welder(vertices, numberOfSlices * 12);
 
 		float myAngle = glm::clamp(angle, 0.0f, 360.0f);
 
@@ -2576,24 +5568,20 @@ private:
 		Vertex middleT = {};
 		middleT.position= glm::vec3(0, 0, halfHeight);
 		middleT.textureCoord = { 0,1 };
-		uint32_t mT = 0;
-		uniqueVertexIndexMap[middleT] = mT;
-		vertices.push_back(middleT);
+		uint32_t mT = welder.weld(middleT);
 		Vertex middleB = {};
 		middleB.position =-1.0f * middleT.position;
 		middleB.textureCoord = { 0,0 };
-		uint32_t mB = 1;
-		uniqueVertexIndexMap[middleB] = mB;
-		vertices.push_back(middleB);
+		uint32_t mB = welder.weld(middleB);
 
 		Vertex firstT = {};
 		firstT.position = glm::vec3(radius * cos(glm::radians(startAngle)), radius * sin(glm::radians(startAngle)), halfHeight);
 		firstT.textureCoord = { 0,1 };
-		uint32_t fT=0;
+		uint32_t fT = welder.weld(firstT);
 		Vertex firstB = {};
 		firstB.position = glm::vec3(firstT.position.x, firstT.position.y, -halfHeight);
 		firstB.textureCoord = { 0,0 };
-		uint32_t fB=0;
+		uint32_t fB = welder.weld(firstB);
 
 		for (int i = 0; i < numberOfSlices; i++)
 		{
@@ -2603,41 +5591,21 @@ private:
 			Vertex secondT = {}; 
 			secondT.position = glm::vec3(radius * cos(glm::radians(cAngle)), radius * sin(glm::radians(cAngle)), halfHeight);
 			secondT.textureCoord = { ratio,1 };
-			uint32_t sT;
+			uint32_t sT = welder.weld(secondT);
 
 			Vertex secondB = {};
 			secondB.position= glm::vec3(secondT.position.x, secondT.position.y, -halfHeight);
 			secondB.textureCoord = { ratio,0 };
-			uint32_t sB;
+			uint32_t sB = welder.weld(secondB);
 
 			// First Triangle
-			if (uniqueVertexIndexMap.find(secondT) == uniqueVertexIndexMap.end())
-			{
-				uniqueVertexIndexMap[secondT] = sT = (uint32_t)vertices.size();
-				vertices.push_back(secondT);
-			}
-			indices.push_back(uniqueVertexIndexMap[secondT]);
-			if (vertices[fB] != firstB && uniqueVertexIndexMap.find(firstB) == uniqueVertexIndexMap.end())
-			{
-				uniqueVertexIndexMap[firstB] = fB =(uint32_t)vertices.size();
-				vertices.push_back(firstB);
-			}
+			indices.push_back(sT);
 			indices.push_back(fB);
-			if (vertices[fT] != firstT && uniqueVertexIndexMap.find(firstT) == uniqueVertexIndexMap.end())
-			{
-				uniqueVertexIndexMap[firstT] = fT = (uint32_t)vertices.size();
-				vertices.push_back(firstT);
-			}
 			indices.push_back(fT);
 
 			// Second Triangle
 			indices.push_back(sT);
-			if (uniqueVertexIndexMap.find(secondB) == uniqueVertexIndexMap.end())
-			{
-				uniqueVertexIndexMap[secondB] = sB = (uint32_t)vertices.size();
-				vertices.push_back(secondB);
-			}
-			indices.push_back(uniqueVertexIndexMap[secondB]);
+			indices.push_back(sB);
 			indices.push_back(fB);
 			
 			// Top Triangle
@@ -2651,11 +5619,12 @@ private:
 			indices.push_back(fB);
 			indices.push_back(sB);
 
-			firstT = secondT;
 			fT = sT;
-			firstB = secondB;
 			fB = sB;
 		}
+
+		optimizeWeldedGeometry(getMeshOptimizerSettings());
+		encodeWeldedGeometry(0);
 		
 		std::cout << "Number of vertices : " << vertices.size() << std::endl;
 	}
@@ -2673,17 +5642,484 @@ private:
 	float cylinderR = 300;
 	float cylinderAngle =180;
 	int noOfSlices = 45;
+
+	// Generates projection surface in vertex shader instead of createCylinder
+	bool bUseProceduralSurface = true;
+	SurfaceParameters surfaceParameters;
+	uint32_t sphereStacks = 24;
+	// Bumped on every surface parameter or geometry change so that eye pass command buffers recorded before it gets re-recorded
+	uint32_t eyePassVersion = 0;
+	std::vector<uint32_t> recordedEyePassVersions;
+	// Eye pass inputs that eye image was last rendered from, Contents are undefined after render graph gets created until eye pass runs
+	uint64_t renderedEyePassInputsHash = 0;
+	bool bIsEyeImageValid = false;
+	// Views eye image was last rendered with, Distortion pass rotates it to pose latched right before its submit
+	glm::mat4 renderedEyeViewTransforms[2];
+	uint64_t skippedEyePassCount = 0;
+
+	// Timeline of drawFrame, Measures how much newer latched pose is than eye pass pose
+	FrameTracer frameTracer;
+	FrameTracer::EventId traceEyePoseSampled;
+	FrameTracer::EventId traceDistortionLatched;
+
+	// Input and pose latency up to every stage of the frames showing them, Display stage needs VK_GOOGLE_display_timing
+	LatencyTracker latencyTracker;
+	bool bHasDisplayTiming = false;
+	std::string latencyHistogramPath;
+
+	// Adaptive quality from GPU time of a frame, Span from eye pass begin to distortion pass end is queried per swap chain image
+	static const uint32_t TIMED_FRAME_SPAN = 0;
+	static const uint32_t TIMED_EYE_PASS = 0;
+	static const uint32_t TIMED_DISTORTION_PASS = 1;
+	static constexpr float MIN_EYE_RESOLUTION_SCALE = 0.5f;
+	bool bUseQualityGovernor = false;
+	QualityGovernor::Config qualityGovernorConfig;
+	std::string qualityLogPath;
+	QualityGovernor qualityGovernor;
+	GpuPassTimer passTimer;
+	// Passes submitted per swap chain image since its frame span was last read, Span is measured only when both were
+	std::vector<uint32_t> timedPassMasks;
+	uint32_t appliedQualityLevel = 0;
+	// Part of eye image width and height eye pass renders into, And what the eye image being shown was rendered with
+	float eyeResolutionScale = 1.0f;
+	float renderedEyeImageScale = 1.0f;
+	static const uint32_t COMPLETION_FENCE_COUNT = 4;
+	std::thread completionWatcherThread;
+	std::mutex completionMutex;
+	std::condition_variable completionCondition;
+	std::vector<VkFence> freeCompletionFences;
+	// Fence of marker batch or value of graphics timeline when fence is null
+	struct CompletionMarker
+	{
+		VkFence fence;
+		uint64_t timelineValue;
+		LatencyTracker::FrameId latencyFrame;
+	};
+	std::deque<CompletionMarker> pendingCompletions;
+	bool bStopCompletionWatcher = false;
+	// Latest input that eye frames published to late stage reflect
+	std::atomic<LatencyTracker::SampleId> timewarpShownInputSample{ 0 };
+
+	// Head pose, Replayed trajectory is the ground truth predictions are measured against
+	std::unique_ptr<TrajectoryPoseSource> trajectory;
+	std::unique_ptr<PosePredictor> posePredictor;
+	PoseSource* poseSource = nullptr;
+	double poseStartTime = 0;
+	std::mutex poseErrorMutex;
+	PoseError poseError;
+
+	// Main thread only handles window events, Simulation thread turns input into frame states and render thread draws them. They hand
+	// whole states over through triple buffers so that none of them ever waits on another, Idle threads only wait to be woken up
+	bool bUseRenderThread = true;
+	std::thread simulationThread;
+	std::thread renderThread;
+	std::atomic<bool> bStopThreads{ false };
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+	uint64_t wakeCount = 0;
+	std::exception_ptr renderThreadError;
+	InputState inputState;
+	TripleBuffer<InputState> inputStates;
+	FrameState simulatedState;
+	uint32_t simulatedActionCounts[(uint32_t)InputAction::Count] = {};
+	TripleBuffer<FrameState> frameStates;
+	uint32_t appliedModelSwapCount = 0;
+	double appliedInputTime = -1.0;
+	LatencyTracker::SampleId appliedInputSample = 0;
+	// Frame tracer times the next frame records
+	double pendingInputTime = -1.0;
+	double lastFrameStartTime = -1.0;
+	FrameTracer::EventId traceFrameStarted;
+	FrameTracer::EventId tracePreviousFrameStarted;
+	FrameTracer::EventId traceInputReceived;
+
+	// Idle mode, Frames are only drawn when frame inputs differ from presented ones or window needs repainting
+	double maxIdleLatency = 0.1;
+	std::atomic<bool> bIsFrameDirty{ true };
+	uint64_t presentedFrameInputsHash = 0;
+	uint64_t idleWaitCount = 0;
+
+	// Asynchronous timewarp, Late stage thread runs distortion pass at display rate on latest completed eye frame while main thread renders them
+	bool bUseAsyncTimewarp = false;
+	float timewarpPositionalDepth = 0.0f;
+	// Late stage wakes up this long before vertical blank
+	double timewarpLeadTime = 0.004;
+	AsyncTimewarp asyncTimewarp;
+	std::unique_ptr<DisplayClock> displayClock;
+	uint64_t timewarpEyeFrameCount = 0;
+	// Same queue as graphics queue when its family has only one, Every submit and present goes through queueMutex while late stage runs
+	VkQueue lateQueue = VK_NULL_HANDLE;
+	VkQueue latePresentQueue = VK_NULL_HANDLE;
+	std::mutex queueMutex;
+	VkCommandPool lateCmdPool = VK_NULL_HANDLE;
+	// One per distortion strip
+	std::vector<VkCommandBuffer> lateCmdBuffers;
+	VkSemaphore lateImageAvailableSemaphore = VK_NULL_HANDLE;
+	std::vector<VkSemaphore> lateRenderedSemaphores;
+	VkFence lateFence = VK_NULL_HANDLE;
+	VkBuffer lateUniformBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory lateUniformBufferMemory = VK_NULL_HANDLE;
+	uint8_t* lateUniformData = nullptr;
+	VkDeviceSize lateUniformStride = 0;
+	std::vector<VkDescriptorSet> lateDescriptorSets;
+	// Distortion pass in horizontal strips on late stage, Whole frames when late stage cannot run them
+	uint32_t distortionStripCount = 0;
+	double distortionStripLead = 0.002;
+	uint32_t lateStripCount = 0;
+	StripScheduler stripScheduler;
+	VkRenderPass stripRenderPass = VK_NULL_HANDLE;
+	std::vector<VkFramebuffer> stripFramebuffers;
+	// Known when display reports its timing, 0 otherwise
+	double displayRefreshPeriod = 0.0;
+	// Shared with late stage thread
+	std::atomic<float> timewarpDistortionAlpha{ 0.0f };
+	std::atomic<bool> bIsTimewarpSwapchainOutOfDate{ false };
+	std::atomic<bool> bHasLateStageError{ false };
+	std::exception_ptr lateStageError;
+
+	// Pose, model transform, textures and geometry that eye pass renders, Distortion alpha only counts while it picks detail levels of model instances
+	uint64_t getEyePassInputsHash(const ProjectionData& projectionData) const
+	{
+		uint64_t hash = ContentHash::hashValue(projectionData.modelTransform);
+		hash = ContentHash::combine(hash, ContentHash::hashBytes(projectionData.viewTransforms, sizeof(projectionData.viewTransforms)));
+		hash = ContentHash::combine(hash, ContentHash::hashBytes(projectionData.projectionTransforms, sizeof(projectionData.projectionTransforms)));
+		hash = ContentHash::combine(hash, ContentHash::hashValue(textureDescriptorSet));
+		// Covers surface parameters, geometry slot, instance count and LOD threshold
+		hash = ContentHash::combine(hash, ContentHash::hashValue(eyePassVersion));
+		if (!bUseProceduralSurface && lodErrorThreshold > 0.0f)
+		{
+			hash = ContentHash::combine(hash, ContentHash::hashValue(projectionData.distortionAlpha));
+		}
+		return hash;
+	}
+
+	// Everything presented image depends on, timeSinceStart is left out as no shader animates with it
+	uint64_t getFrameInputsHash(const ProjectionData& projectionData, uint64_t eyePassInputsHash) const
+	{
+		return ContentHash::combine(eyePassInputsHash, ContentHash::hashValue(projectionData.distortionAlpha));
+	}
+
+	// Nothing has changed since last present and no geometry upload or release is waiting for frames to advance
+	bool isFrameUnchanged()
+	{
+		if (bIsFrameDirty || geometryUploadState == GeometryUploadState::Staged || geometryUploadState == GeometryUploadState::Copying ||
+			!retiredGeometry.empty() || poseSource != nullptr)
+		{
+			return false;
+		}
+
+		ProjectionData projectionData = getProjectionData(Pose());
+		return getFrameInputsHash(projectionData, getEyePassInputsHash(projectionData)) == presentedFrameInputsHash;
+	}
+
+	void initSurfaceParameters()
+	{
+		surfaceParameters.slices = noOfSlices;
+		surfaceParameters.stacks = 1;
+		surfaceParameters.angle = glm::clamp(cylinderAngle, 0.0f, 360.0f);
+		surfaceParameters.radius = cylinderR;
+		surfaceParameters.height = cylinderH;
+	}
+
+	void setSurfaceType(SurfaceType surfaceType)
+	{
+		surfaceParameters.surfaceType = (uint32_t)surfaceType;
+		surfaceParameters.stacks = surfaceType == SurfaceType::Sphere ? sphereStacks : 1;
+		eyePassVersion++;
+	}
+
+	// Runtime geometry replacement
+	enum class GeometryUploadState : uint32_t
+	{
+		Idle,
+		// Loader thread is importing model into staging buffer
+		Loading,
+		// Waiting for copy to be submitted at next frame boundary
+		Staged,
+		// Copy into shadow slot is in flight on transfer queue
+		Copying
+	};
+
+	struct RetiredGeometry
+	{
+		GeometrySlot slot;
+		// Frame that was first to be recorded without this slot
+		uint64_t retireFrame;
+		// Value of last graphics submit that could have read this slot
+		uint64_t retireTimelineValue;
+	};
+
+	std::atomic<GeometryUploadState> geometryUploadState{ GeometryUploadState::Idle };
+	std::thread geometryLoaderThread;
+	VkBuffer geometryStagingBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory geometryStagingBufferMemory = VK_NULL_HANDLE;
+	VkCommandBuffer geometryCopyCmdBuffer = VK_NULL_HANDLE;
+	VkFence geometryUploadFence = VK_NULL_HANDLE;
+	uint64_t geometryUploadTimelineValue = 0;
+	std::vector<RetiredGeometry> retiredGeometry;
+	uint64_t frameNumber = 0;
 };
 
 
 
-int main()
+namespace
+{
+	// Command line that cannot be parsed, main prints usage after its message
+	class UsageError : public std::runtime_error
+	{
+	public:
+		explicit UsageError(const std::string& message) : std::runtime_error(message)
+		{}
+	};
+
+	// Whole argument has to be a number, So typos are reported instead of being read up to first bad character
+	uint32_t parseUnsignedArg(const std::string& option, const std::string& text)
+	{
+		size_t parsedLength = 0;
+		unsigned long long value = 0;
+		try
+		{
+			value = std::stoull(text, &parsedLength);
+		}
+		catch (const std::exception&)
+		{
+			parsedLength = 0;
+		}
+
+		if (parsedLength == 0 || parsedLength != text.size() || text[0] == '-' || value > UINT32_MAX)
+		{
+			throw UsageError("Invalid value " + text + " for " + option);
+		}
+		return (uint32_t)value;
+	}
+
+	double parseNumberArg(const std::string& option, const std::string& text)
+	{
+		size_t parsedLength = 0;
+		double value = 0;
+		try
+		{
+			value = std::stod(text, &parsedLength);
+		}
+		catch (const std::exception&)
+		{
+			parsedLength = 0;
+		}
+
+		if (parsedLength == 0 || parsedLength != text.size() || !std::isfinite(value))
+		{
+			throw UsageError("Invalid value " + text + " for " + option);
+		}
+		return value;
+	}
+
+	void printUsage()
+	{
+		std::cerr << "Usage: QComTest [options]\n"
+			"  --msaa <eye pass samples> [distortion pass samples]\n"
+			"  --timewarp [positional depth]\n"
+			"  --distortion-strips [strip count] [lead milliseconds]\n"
+			"  --quality-governor <target milliseconds> [csv path]\n"
+			"  --pose-trajectory <path> [none|velocity|acceleration|kalman]\n"
+			"  --single-thread\n"
+			"  --latency-profile <low-latency|balanced|throughput> [frames in flight] [swap chain images] [present modes] [limit|no-limit]\n"
+			"  --binary-sync\n"
+			"  --latency-histograms [csv path]\n"
+			"  --max-idle-latency <milliseconds>\n"
+			"Or a single benchmark:\n"
+			"  --benchmark-weld [obj path]\n"
+			"  --benchmark-obj [obj path]\n"
+			"  --benchmark-obj-synthetic [size MB]\n"
+			"  --benchmark-cull [object count]\n"
+			"  --benchmark-pose-prediction [trajectory path] [latency milliseconds]\n"
+			"  --simulate-timewarp [seconds] [positional depth]\n"
+			"  --simulate-strips [seconds] [strip count] [lead milliseconds] [GPU milliseconds per strip]" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
 {
+	std::vector<std::string> args(argv + 1, argv + argc);
+
 	RenderingApplication app;
 
 	try
 	{
-		app.run();
+		if (!args.empty() && args[0] == "--benchmark-weld")
+		{
+			RenderingApplication::benchmarkVertexWelding(args.size() > 1 ? args[1] : "Models/earth.obj", 20);
+		}
+		else if (!args.empty() && args[0] == "--benchmark-obj")
+		{
+			RenderingApplication::benchmarkObjParsing(args.size() > 1 ? args[1] : "Models/earth.obj", 20);
+		}
+		else if (!args.empty() && args[0] == "--benchmark-obj-synthetic")
+		{
+			uint64_t sizeMB = args.size() > 1 ? parseUnsignedArg(args[0], args[1]) : 1024;
+			std::string path = (std::filesystem::temp_directory_path() / ("synthetic_" + std::to_string(sizeMB) + "MB.obj")).string();
+			if (!std::filesystem::exists(path))
+			{
+				std::cout << "Writing synthetic OBJ " << path << std::endl;
+				RenderingApplication::writeSyntheticObj(path, sizeMB);
+			}
+			RenderingApplication::benchmarkObjParsing(path, 1);
+		}
+		else if (!args.empty() && args[0] == "--benchmark-cull")
+		{
+			RenderingApplication::benchmarkCulling(args.size() > 1 ? parseUnsignedArg(args[0], args[1]) : 100000, 100);
+		}
+		else if (!args.empty() && args[0] == "--benchmark-pose-prediction")
+		{
+			RenderingApplication::benchmarkPosePrediction(args.size() > 1 ? args[1] : "", args.size() > 2 ? parseNumberArg(args[0], args[2]) / 1000.0 : 0.025);
+		}
+		else if (!args.empty() && args[0] == "--simulate-timewarp")
+		{
+			RenderingApplication::simulateTimewarp(args.size() > 1 ? parseNumberArg(args[0], args[1]) : 2.0,
+				args.size() > 2 ? (float)parseNumberArg(args[0], args[2]) : 0.0f);
+		}
+		// --simulate-strips [seconds] [strip count] [lead milliseconds] [GPU milliseconds per strip]
+		else if (!args.empty() && args[0] == "--simulate-strips")
+		{
+			RenderingApplication::simulateDistortionStrips(args.size() > 1 ? parseNumberArg(args[0], args[1]) : 2.0,
+				args.size() > 2 ? parseUnsignedArg(args[0], args[2]) : 4, args.size() > 3 ? parseNumberArg(args[0], args[3]) / 1000.0 : 0.002,
+				args.size() > 4 ? parseNumberArg(args[0], args[4]) / 1000.0 : 0.0005);
+		}
+		else
+		{
+			for (size_t i = 0; i < args.size(); i++)
+			{
+				auto hasValue = [&](size_t index) { return index < args.size() && args[index].compare(0, 2, "--") != 0; };
+				const std::string& option = args[i];
+
+				// --msaa <eye pass samples> [distortion pass samples]
+				if (args[i] == "--msaa")
+				{
+					uint32_t eyePassSamples = hasValue(i + 1) ? parseUnsignedArg(option, args[++i]) : 4;
+					uint32_t distortionPassSamples = hasValue(i + 1) ? parseUnsignedArg(option, args[++i]) : 1;
+					app.setMsaaSamples(eyePassSamples, distortionPassSamples);
+				}
+				// --timewarp [positional depth]
+				else if (args[i] == "--timewarp")
+				{
+					app.setAsyncTimewarp(true, hasValue(i + 1) ? (float)parseNumberArg(option, args[++i]) : 0.0f);
+				}
+				// --distortion-strips [strip count] [lead milliseconds]
+				else if (args[i] == "--distortion-strips")
+				{
+					uint32_t stripCount = hasValue(i + 1) ? parseUnsignedArg(option, args[++i]) : 4;
+					app.setDistortionStrips(stripCount, hasValue(i + 1) ? parseNumberArg(option, args[++i]) / 1000.0 : 0.002);
+				}
+				// --quality-governor <target milliseconds> [csv path]
+				else if (args[i] == "--quality-governor" && hasValue(i + 1))
+				{
+					double targetFrameTime = parseNumberArg(option, args[++i]) / 1000.0;
+					app.setQualityGovernor(targetFrameTime, hasValue(i + 1) ? args[++i] : "");
+				}
+				// --pose-trajectory <path> [none|velocity|acceleration|kalman]
+				else if (args[i] == "--pose-trajectory" && hasValue(i + 1))
+				{
+					std::string path = args[++i];
+					std::string predictor = hasValue(i + 1) ? args[++i] : "kalman";
+					if (predictor != "none" && predictor != "velocity" && predictor != "acceleration" && predictor != "kalman")
+					{
+						throw UsageError("Unknown pose predictor " + predictor);
+					}
+					PosePredictor::Model model = predictor == "velocity" ? PosePredictor::Model::ConstantVelocity :
+						predictor == "acceleration" ? PosePredictor::Model::ConstantAcceleration : PosePredictor::Model::Kalman;
+					app.setPoseTrajectory(path, predictor == "none" ? nullptr : &model);
+				}
+				// --single-thread
+				else if (args[i] == "--single-thread")
+				{
+					app.setRenderThread(false);
+				}
+				// --latency-profile <low-latency|balanced|throughput> [frames in flight] [swap chain images] [present modes] [limit|no-limit]
+				else if (args[i] == "--latency-profile" && hasValue(i + 1))
+				{
+					LatencyProfile profile;
+					if (!LatencyProfile::getPreset(args[++i], profile))
+					{
+						throw UsageError("Unknown latency profile " + args[i]);
+					}
+					size_t presetArg = i;
+					if (hasValue(i + 1))
+					{
+						profile.framesInFlight = parseUnsignedArg(option, args[++i]);
+						if (profile.framesInFlight < LatencyProfile::MIN_FRAMES_IN_FLIGHT || profile.framesInFlight > LatencyProfile::MAX_FRAMES_IN_FLIGHT)
+						{
+							throw UsageError("Frames in flight has to be between " + std::to_string(LatencyProfile::MIN_FRAMES_IN_FLIGHT) + " and " +
+								std::to_string(LatencyProfile::MAX_FRAMES_IN_FLIGHT));
+						}
+					}
+					// 0 keeps surface minimum plus one
+					if (hasValue(i + 1))
+					{
+						profile.swapchainImageCount = parseUnsignedArg(option, args[++i]);
+						if (profile.swapchainImageCount > LatencyProfile::MAX_SWAPCHAIN_IMAGES)
+						{
+							throw UsageError("Swap chain images has to be at most " + std::to_string(LatencyProfile::MAX_SWAPCHAIN_IMAGES));
+						}
+					}
+					// Comma separated in order of preference
+					if (hasValue(i + 1))
+					{
+						profile.presentModes.clear();
+						std::stringstream modes(args[++i]);
+						std::string modeName;
+						while (std::getline(modes, modeName, ','))
+						{
+							VkPresentModeKHR mode;
+							if (!LatencyProfile::parsePresentMode(modeName, mode))
+							{
+								throw UsageError("Unknown present mode " + modeName);
+							}
+							profile.presentModes.push_back(mode);
+						}
+					}
+					if (hasValue(i + 1))
+					{
+						const std::string& limit = args[++i];
+						if (limit != "limit" && limit != "no-limit")
+						{
+							throw UsageError("Frame rate limit has to be limit or no-limit, Not " + limit);
+						}
+						profile.bLimitFrameRate = limit == "limit";
+					}
+					if (i > presetArg)
+					{
+						profile.name = "custom";
+					}
+					app.setLatencyProfile(profile);
+				}
+				// --binary-sync
+				else if (args[i] == "--binary-sync")
+				{
+					app.setTimelineSemaphores(false);
+				}
+				// --latency-histograms [csv path]
+				else if (args[i] == "--latency-histograms")
+				{
+					app.setLatencyHistogramPath(hasValue(i + 1) ? args[++i] : "latency_histograms.csv");
+				}
+				// --max-idle-latency <milliseconds>
+				else if (args[i] == "--max-idle-latency" && hasValue(i + 1))
+				{
+					app.setMaxIdleLatency(parseNumberArg(option, args[++i]) / 1000.0);
+				}
+				// Also options missing their required value
+				else
+				{
+					throw UsageError("Unknown option " + option);
+				}
+			}
+			app.run();
+		}
+	}
+	catch (const UsageError& e)
+	{
+		std::cerr << e.what() << std::endl;
+		printUsage();
+		return EXIT_FAILURE;
 	}
 	catch (const std::exception& e)
 	{
@@ -5,11 +5,19 @@ for %%f in (*.frag.glsl) do (
 
 	E:/EduPrograms/Vulkan/1.1.82.1/Bin32/glslangValidator.exe -V %%f
 	move /y "frag.spv" "%%~nf.spv"
+	E:/EduPrograms/Vulkan/1.1.82.1/Bin32/spirv-val.exe "%%~nf.spv"
 )
 
 for %%f in (*.vert.glsl) do (
 	E:/EduPrograms/Vulkan/1.1.82.1/Bin32/glslangValidator.exe -V %%f
 	move /y "vert.spv" "%%~nf.spv"
+	E:/EduPrograms/Vulkan/1.1.82.1/Bin32/spirv-val.exe "%%~nf.spv"
+)
+
+for %%f in (*.comp.glsl) do (
+	E:/EduPrograms/Vulkan/1.1.82.1/Bin32/glslangValidator.exe -V %%f
+	move /y "comp.spv" "%%~nf.spv"
+	E:/EduPrograms/Vulkan/1.1.82.1/Bin32/spirv-val.exe "%%~nf.spv"
 )
 
 
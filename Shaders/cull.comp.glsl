@@ -0,0 +1,113 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(local_size_x = 64) in;
+
+struct DrawCommand{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+layout(set=0,binding =0) uniform ProjectionData{
+    mat4 modelTrans;
+    mat4 viewTrans[2];
+    mat4 projectionTrans[2];
+    float distortionAlpha;
+    float timeSinceStart;
+    // Frustum enclosing both eyes, xyz is inward normal and w distance of each plane
+    vec4 cullingPlanes[6];
+} projectionData;
+
+layout(set=2,binding=0) readonly buffer Instances{
+    mat4 instanceTransforms[];
+};
+
+layout(set=2,binding=1) writeonly buffer VisibleInstances{
+    uint visibleInstances[];
+};
+
+// Command per detail level, Instance counts gets reset to 0 before dispatch and first instance is where visible instances of level starts
+layout(set=2,binding=2) buffer DrawCommands{
+    DrawCommand drawCommands[];
+};
+
+// Follows SurfaceParameters of surface.vert.glsl
+layout(push_constant) uniform CullParameters{
+    layout(offset = 32) vec4 boundingSphere;
+    uint instanceCount;
+    uint lodCount;
+    float pixelsPerNdc;
+    float lodErrorThreshold;
+    float lodErrors[8];
+} cullParameters;
+
+// Size of a feature on display relative to its size in eye image, frame.frag.glsl samples eye image at p / (1 - alpha * |p|)
+// for display position p, So eye image radius r ends up at r / (1 + alpha * r) on display
+float getLensMagnification(float radius)
+{
+    float scale = 1.0 / max(1.0 + projectionData.distortionAlpha * radius, 0.05);
+    // Tangential and radial magnification, Larger one bounds error in any direction
+    return max(scale, scale * scale);
+}
+
+// Pixels on display per unit of vertex space at sphere, Largest of both eyes
+float getProjectedScale(vec3 center, float radius, float scale)
+{
+    float projectedScale = 0.0;
+    for (int eye = 0; eye < 2; eye++)
+    {
+        vec4 viewCenter = projectionData.viewTrans[eye] * vec4(center, 1.0);
+        float viewDistance = -viewCenter.z;
+        if (viewDistance <= radius)
+        {
+            // Eye is inside bounding sphere, Full detail
+            return 1e30;
+        }
+
+        vec4 clipCenter = projectionData.projectionTrans[eye] * viewCenter;
+        float magnification = getLensMagnification(length(clipCenter.xy / clipCenter.w));
+        float ndcPerUnit = max(abs(projectionData.projectionTrans[eye][0][0]), abs(projectionData.projectionTrans[eye][1][1])) / (viewDistance - radius);
+        projectedScale = max(projectedScale, scale * ndcPerUnit * cullParameters.pixelsPerNdc * magnification);
+    }
+    return projectedScale;
+}
+
+void main()
+{
+    uint instanceIdx = gl_GlobalInvocationID.x;
+    if (instanceIdx >= cullParameters.instanceCount)
+    {
+        return;
+    }
+
+    mat4 transform = instanceTransforms[instanceIdx] * projectionData.modelTrans;
+    vec3 center = (transform * vec4(cullParameters.boundingSphere.xyz, 1.0)).xyz;
+    float scale = max(length(transform[0].xyz), max(length(transform[1].xyz), length(transform[2].xyz)));
+    float radius = cullParameters.boundingSphere.w * scale;
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (dot(projectionData.cullingPlanes[i].xyz, center) + projectionData.cullingPlanes[i].w < -radius)
+        {
+            return;
+        }
+    }
+
+    // Errors grow along the chain so the last level that is still below threshold is the coarsest acceptable one
+    float projectedScale = getProjectedScale(center, radius, scale);
+    uint lod = 0;
+    for (uint i = 1; i < cullParameters.lodCount; i++)
+    {
+        if (cullParameters.lodErrors[i] * projectedScale <= cullParameters.lodErrorThreshold)
+        {
+            lod = i;
+        }
+    }
+
+    uint visibleIdx = atomicAdd(drawCommands[lod].instanceCount, 1);
+    visibleInstances[drawCommands[lod].firstInstance + visibleIdx] = instanceIdx;
+}
@@ -6,7 +6,6 @@ layout(location = 0)out vec4 outColor;
 
 layout(set=1,binding = 0) uniform sampler2D textureSampler[2];
 
-layout(location = 0)in vec3 inFragColor;
 layout(location = 1)in vec2 inFragCoord;
 
 void main()
@@ -7,11 +7,10 @@ out gl_PerVertex{
     vec4 gl_Position;
 };
 
-layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragCoord;
 
+// Position is either in model space or normalized against mesh bounds, modelTrans brings both to world space
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 textureCoord;
 
 layout(set=0,binding =0) uniform ProjectionData{
@@ -20,10 +19,18 @@ layout(set=0,binding =0) uniform ProjectionData{
     mat4 projectionTrans[2];
 } projectionTransforms;
 
+// Instances that survived culling in cull.comp.glsl, Indexed by instance index of indirect draw
+layout(set=2,binding=0) readonly buffer Instances{
+    mat4 instanceTransforms[];
+};
+
+layout(set=2,binding=1) readonly buffer VisibleInstances{
+    uint visibleInstances[];
+};
+
 void main()
 {
     gl_Position=projectionTransforms.projectionTrans[gl_ViewIndex]* projectionTransforms.viewTrans[gl_ViewIndex]
-     * projectionTransforms.modelTrans *vec4(inPosition,1.0);
-    fragColor = inColor;
+     * instanceTransforms[visibleInstances[gl_InstanceIndex]] * projectionTransforms.modelTrans *vec4(inPosition,1.0);
     fragCoord = textureCoord;
 }
\ No newline at end of file
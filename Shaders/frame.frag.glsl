@@ -7,20 +7,29 @@ layout(set=0,binding = 1) uniform sampler2DArray textureSampler;
 
 layout(location = 0)in vec2 inFragCoord;
 
-layout(set=0,binding =0) uniform UBO{
-    layout(offset = 320) float distortionAlpha;
-} ubo;
+layout(set=0,binding =0) uniform DistortionData{
+    mat4 timewarpTransforms[2];
+    float distortionAlpha;
+    float eyeLayerOffset;
+    float eyeImageScale;
+} distortion;
 
 layout (constant_id = 0) const float LAYER_ID = 0.0f;
 
 void main()
 {
-    const float alpha = ubo.distortionAlpha;
+    const float alpha = distortion.distortionAlpha;
 
 	vec2 p1 = vec2(2.0 * inFragCoord - 1.0);
 	vec2 p2 = p1 / (1.0 - alpha * length(p1));
+	// Reprojects into eye image rendered with an older pose
+	vec4 warped = distortion.timewarpTransforms[int(LAYER_ID)] * vec4(p2, 1.0, 1.0);
+	p2 = warped.xy / warped.w;
 	p2 = (p2 + 1.0) * 0.5;
 
-	bool inside = ((p2.x >= 0.0) && (p2.x <= 1.0) && (p2.y >= 0.0 ) && (p2.y <= 1.0));
-	outColor = inside ? texture(textureSampler, vec3(p2, LAYER_ID)) : vec4(0.0);
+	bool inside = (warped.w > 0.0) && ((p2.x >= 0.0) && (p2.x <= 1.0) && (p2.y >= 0.0 ) && (p2.y <= 1.0));
+	// Eye pass may have rendered into top left part of eye image only, Filtering is kept from reaching past it
+	vec2 eyeImageSize = vec2(textureSize(textureSampler, 0).xy);
+	vec2 uv = min(p2 * distortion.eyeImageScale, vec2(distortion.eyeImageScale) - 0.5 / eyeImageSize);
+	outColor = inside ? texture(textureSampler, vec3(uv, LAYER_ID + distortion.eyeLayerOffset)) : vec4(0.0);
 }
\ No newline at end of file
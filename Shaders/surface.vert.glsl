@@ -0,0 +1,92 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_multiview : enable
+
+out gl_PerVertex{
+    vec4 gl_Position;
+};
+
+layout(location = 1) out vec2 fragCoord;
+
+layout(set=0,binding =0) uniform ProjectionData{
+    mat4 modelTrans;
+    mat4 viewTrans[2];
+    mat4 projectionTrans[2];
+} projectionTransforms;
+
+// Same layout as SurfaceParameters
+layout(push_constant) uniform SurfaceParameters{
+    uint surfaceType;
+    uint slices;
+    uint stacks;
+    float angle;
+    float radius;
+    float height;
+    float verticalAngle;
+} surface;
+
+const uint SURFACE_CYLINDER = 0;
+const uint SURFACE_SPHERE = 1;
+const uint SURFACE_PLANE = 2;
+
+// Slice and stack offsets of grid quad corners, Same winding as side triangles of createCylinder
+const uvec2 QUAD_CORNERS[6] = uvec2[](uvec2(1, 1), uvec2(0, 0), uvec2(0, 1), uvec2(1, 1), uvec2(1, 0), uvec2(0, 0));
+
+vec3 gridPosition(float u, float v)
+{
+    float sliceAngle = radians(surface.angle * (u - 0.5));
+    if (surface.surfaceType == SURFACE_SPHERE)
+    {
+        float stackAngle = radians(surface.verticalAngle * (v - 0.5));
+        return surface.radius * vec3(cos(stackAngle) * cos(sliceAngle), cos(stackAngle) * sin(sliceAngle), sin(stackAngle));
+    }
+    else if (surface.surfaceType == SURFACE_PLANE)
+    {
+        // Plane tangent to cylinder at its center with same width as arc of cylinder
+        float width = surface.radius * radians(surface.angle);
+        return vec3(surface.radius, width * (u - 0.5), surface.height * (v - 0.5));
+    }
+    return vec3(surface.radius * cos(sliceAngle), surface.radius * sin(sliceAngle), surface.height * (v - 0.5));
+}
+
+void main()
+{
+    uint vertexIndex = uint(gl_VertexIndex);
+    uint gridVertexCount = surface.slices * surface.stacks * 6;
+    vec3 position;
+
+    if (vertexIndex < gridVertexCount)
+    {
+        uint quad = vertexIndex / 6;
+        uvec2 corner = QUAD_CORNERS[vertexIndex % 6];
+        float u = float(quad % surface.slices + corner.x) / float(surface.slices);
+        float v = float(quad / surface.slices + corner.y) / float(surface.stacks);
+
+        position = gridPosition(u, v);
+        fragCoord = vec2(u, v);
+    }
+    else
+    {
+        // Cylinder caps, Middle top, second top, first top then middle bottom, first bottom, second bottom
+        uint capVertex = vertexIndex - gridVertexCount;
+        uint slice = capVertex / 6;
+        uint corner = capVertex % 6;
+        float v = corner < 3 ? 1.0 : 0.0;
+
+        if (corner == 0 || corner == 3)
+        {
+            position = vec3(0.0, 0.0, surface.height * (v - 0.5));
+            fragCoord = vec2(0.0, v);
+        }
+        else
+        {
+            float u = float(slice + ((corner == 1 || corner == 5) ? 1u : 0u)) / float(surface.slices);
+            position = gridPosition(u, v);
+            fragCoord = vec2(u, v);
+        }
+    }
+
+    gl_Position = projectionTransforms.projectionTrans[gl_ViewIndex] * projectionTransforms.viewTrans[gl_ViewIndex]
+     * projectionTransforms.modelTrans * vec4(position, 1.0);
+}
@@ -0,0 +1,144 @@
+#include "AsyncTimewarp.h"
+
+#include <algorithm>
+#include <cmath>
+
+vulkan::AsyncTimewarp::~AsyncTimewarp()
+{
+	stop();
+}
+
+void vulkan::AsyncTimewarp::start(const DisplayClock& displayClock, double leadTime, LateStage stage)
+{
+	stop();
+
+	clock = &displayClock;
+	lead = leadTime;
+	lateStage = stage;
+
+	bHasEyeFrame = false;
+	latestEyeFrame = EyeFrame();
+	lastShownEyeFrame = 0;
+	lateFrameCount = 0;
+	retiredLateFrame = 0;
+	std::fill(std::begin(lastLateFrameReading), std::end(lastLateFrameReading), 0);
+	stats = Stats();
+
+	bIsRunning = true;
+	thread = std::thread(&AsyncTimewarp::run, this);
+}
+
+void vulkan::AsyncTimewarp::stop()
+{
+	bIsRunning = false;
+	if (thread.joinable())
+	{
+		thread.join();
+	}
+
+	// Late stage is expected to have waited for its frames when it returned last time
+	std::lock_guard<std::mutex> lock(mutex);
+	retiredLateFrame = lateFrameCount;
+	retiredCondition.notify_all();
+}
+
+uint32_t vulkan::AsyncTimewarp::beginEyeFrame()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	// Latest frame keeps being shown until the next one is published so it is never rendered over
+	uint32_t eyeBuffer = bHasEyeFrame ? (latestEyeFrame.eyeBuffer + 1) % EYE_BUFFER_COUNT : 0;
+	retiredCondition.wait(lock, [&]() { return retiredLateFrame >= lastLateFrameReading[eyeBuffer]; });
+	return eyeBuffer;
+}
+
+void vulkan::AsyncTimewarp::publishEyeFrame(const EyeFrame& eyeFrame)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	latestEyeFrame = eyeFrame;
+	bHasEyeFrame = true;
+	stats.publishedEyeFrameCount++;
+}
+
+void vulkan::AsyncTimewarp::retireLateFrame(uint64_t lateFrameIndex)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	retiredLateFrame = std::max(retiredLateFrame, lateFrameIndex);
+	retiredCondition.notify_all();
+}
+
+vulkan::AsyncTimewarp::Stats vulkan::AsyncTimewarp::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+glm::mat4 vulkan::AsyncTimewarp::computeTimewarpTransform(const glm::mat4& projection, const glm::mat4& renderView, const glm::mat4& displayView,
+	float positionalDepth)
+{
+	glm::mat4 inverseProjection = glm::inverse(projection);
+
+	// Views are rigid so transposed rotation is the inverse one, Directions do not depend on depth without translation
+	if (positionalDepth <= 0.0f)
+	{
+		glm::mat4 displayToRender = glm::mat4(glm::mat3(renderView) * glm::transpose(glm::mat3(displayView)));
+		return projection * displayToRender * inverseProjection;
+	}
+
+	// Puts (x, y, 1, 1) onto plane positionalDepth in front of eye before it gets unprojected
+	glm::vec4 planePoint = projection * glm::vec4(0.0f, 0.0f, -positionalDepth, 1.0f);
+	glm::mat4 toPlane(1.0f);
+	toPlane[2][2] = 0.0f;
+	toPlane[3][2] = planePoint.z / planePoint.w;
+
+	glm::mat4 displayToRender = renderView * glm::inverse(displayView);
+	return projection * displayToRender * inverseProjection * toPlane;
+}
+
+void vulkan::AsyncTimewarp::run()
+{
+	const double period = clock->getRefreshPeriod();
+	double lastVsync = -1.0;
+
+	while (bIsRunning)
+	{
+		// Waking up a little early must not target the vertical blank just served again
+		double vsync = clock->getNextVsync(lead);
+		if (lastVsync >= 0.0 && vsync < lastVsync + 0.5 * period)
+		{
+			vsync = lastVsync + period;
+		}
+		clock->sleepUntil(vsync - lead);
+
+		LateFrame lateFrame;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (lastVsync >= 0.0 && bHasEyeFrame)
+			{
+				stats.missedVsyncCount += (uint64_t)std::max(std::llround((vsync - lastVsync) / period) - 1, 0LL);
+			}
+			lastVsync = vsync;
+
+			if (!bHasEyeFrame)
+			{
+				continue;
+			}
+
+			lateFrame.index = ++lateFrameCount;
+			lateFrame.displayTime = vsync;
+			lateFrame.eyeFrame = latestEyeFrame;
+			lateFrame.bIsRepeated = latestEyeFrame.index == lastShownEyeFrame;
+			lastShownEyeFrame = latestEyeFrame.index;
+			lastLateFrameReading[latestEyeFrame.eyeBuffer] = lateFrame.index;
+
+			stats.lateFrameCount++;
+			stats.repeatedFrameCount += lateFrame.bIsRepeated ? 1 : 0;
+		}
+
+		double startTime = clock->now();
+		lateStage(lateFrame);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.maxLateStageTime = std::max(stats.maxLateStageTime, clock->now() - startTime);
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+#include <glm/glm.hpp>
+
+#include "DisplayClock.h"
+
+namespace vulkan
+{
+	// Late stage scheduling of asynchronous timewarp. Its thread wakes up shortly before every vertical blank of a display clock and hands
+	// the most recently completed eye frame to a late stage callback that reprojects it with the newest pose, Whether or not eye rendering
+	// kept up. Eye frames rotate through EYE_BUFFER_COUNT copies of the eye image and a copy is only handed out for rendering once no late
+	// frame in flight samples it
+	class AsyncTimewarp
+	{
+	public:
+		static const uint32_t EYE_BUFFER_COUNT = 2;
+
+		struct EyeFrame
+		{
+			uint64_t index = 0;
+			// Copy of eye image holding this frame
+			uint32_t eyeBuffer = 0;
+			// Views of both eyes the frame got rendered with
+			glm::mat4 viewTransforms[2];
+		};
+
+		struct LateFrame
+		{
+			uint64_t index;
+			// Vertical blank the frame is meant for
+			double displayTime;
+			EyeFrame eyeFrame;
+			// Eye frame was shown on an earlier vertical blank already and is only reprojected again
+			bool bIsRepeated;
+		};
+
+		struct Stats
+		{
+			uint64_t lateFrameCount = 0;
+			uint64_t repeatedFrameCount = 0;
+			// Vertical blanks passing without a late frame because the late stage itself ran too long
+			uint64_t missedVsyncCount = 0;
+			uint64_t publishedEyeFrameCount = 0;
+			double maxLateStageTime = 0;
+		};
+
+		// Runs on late stage thread, Has to call retireLateFrame once GPU is done with the frame, Either before returning or later
+		typedef std::function<void(const LateFrame&)> LateStage;
+
+		AsyncTimewarp() = default;
+		AsyncTimewarp(const AsyncTimewarp&) = delete;
+		AsyncTimewarp& operator=(const AsyncTimewarp&) = delete;
+		~AsyncTimewarp();
+
+		// Late stage runs lead seconds before every vertical blank of clock, Earlier eye frames and stats are forgotten
+		void start(const DisplayClock& clock, double lead, LateStage lateStage);
+		void stop();
+
+		bool isRunning() const
+		{
+			return bIsRunning;
+		}
+
+		// Copy of eye image next eye frame renders into, Waits until late frames sampling it are retired
+		uint32_t beginEyeFrame();
+
+		// Eye frame finished rendering on GPU, Late frames pick it up from next vertical blank on
+		void publishEyeFrame(const EyeFrame& eyeFrame);
+
+		void retireLateFrame(uint64_t lateFrameIndex);
+
+		Stats getStats() const;
+
+		// Maps undistorted normalized device coordinates of an eye at display time to where the eye image rendered with renderView holds them,
+		// Applied to (x, y, 1, 1) followed by perspective divide. Rotation alone is corrected when positionalDepth is 0, Otherwise translation
+		// too as if everything was positionalDepth away from the eye
+		static glm::mat4 computeTimewarpTransform(const glm::mat4& projection, const glm::mat4& renderView, const glm::mat4& displayView,
+			float positionalDepth = 0.0f);
+
+	private:
+		void run();
+
+		const DisplayClock* clock = nullptr;
+		double lead = 0;
+		LateStage lateStage;
+		std::thread thread;
+		std::atomic<bool> bIsRunning{ false };
+
+		mutable std::mutex mutex;
+		std::condition_variable retiredCondition;
+		bool bHasEyeFrame = false;
+		EyeFrame latestEyeFrame;
+		uint64_t lastShownEyeFrame = 0;
+		uint64_t lateFrameCount = 0;
+		// Late frames retire in the order they got submitted in
+		uint64_t retiredLateFrame = 0;
+		uint64_t lastLateFrameReading[EYE_BUFFER_COUNT] = {};
+		Stats stats;
+	};
+}
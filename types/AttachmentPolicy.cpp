@@ -0,0 +1,53 @@
+#include "AttachmentPolicy.h"
+
+namespace vulkan
+{
+	VkAttachmentDescription AttachmentPolicy::getDescription() const
+	{
+		VkAttachmentDescription desc = {};
+		desc.format = format;
+		desc.samples = samples;
+
+		desc.loadOp = contents == Contents::Cleared ? VK_ATTACHMENT_LOAD_OP_CLEAR :
+			(contents == Contents::Preserved ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+		desc.storeOp = bIsUsedAfterPass ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		// Previous contents are only needed when preserved
+		desc.initialLayout = contents == Contents::Preserved ? initialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+		desc.finalLayout = finalLayout;
+
+		return desc;
+	}
+
+	uint64_t AttachmentPolicy::getByteSize(uint32_t width, uint32_t height) const
+	{
+		return (uint64_t)width * height * layers * (uint32_t)samples * getFormatSize(format);
+	}
+
+	uint32_t AttachmentPolicy::getFormatSize(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_D16_UNORM:
+			return 2;
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return 5;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+			return 8;
+		default:
+			// 8 bit RGBA and BGRA surfaces, D24S8 and D32
+			return 4;
+		}
+	}
+
+	void AttachmentTraffic::add(const AttachmentPolicy& policy, uint32_t width, uint32_t height)
+	{
+		uint64_t size = policy.getByteSize(width, height);
+
+		unconditionalBytes += 2 * size;
+		bytes += (policy.contents != AttachmentPolicy::Contents::Overwritten ? size : 0) + (policy.bIsUsedAfterPass ? size : 0);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vulkan
+{
+	// Describes what a render pass needs from an attachment, Load and store ops are derived from it
+	// so that nothing gets loaded, cleared or written back to memory unless something actually depends on it
+	struct AttachmentPolicy
+	{
+		enum class Contents : uint32_t
+		{
+			// Pass starts from a cleared attachment
+			Cleared,
+			// Every pixel gets written before anything reads it, Previous contents are neither loaded nor cleared
+			Overwritten,
+			// Pass draws on top of what an earlier pass left in it
+			Preserved,
+		};
+
+		const char* name;
+		VkFormat format;
+		VkSampleCountFlagBits samples;
+		uint32_t layers;
+		Contents contents;
+		// Sampled, presented or otherwise read after the pass, Everything else is never written back to memory
+		bool bIsUsedAfterPass;
+		VkImageLayout finalLayout;
+		// Layout preserved contents are in when pass starts
+		VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		VkAttachmentDescription getDescription() const;
+
+		uint64_t getByteSize(uint32_t width, uint32_t height) const;
+
+		static uint32_t getFormatSize(VkFormat format);
+	};
+
+	// Bytes moved between attachments and memory in one frame, Clears count as a full write and loads as a full read
+	struct AttachmentTraffic
+	{
+		uint64_t bytes = 0;
+		// Same attachments cleared and stored unconditionally
+		uint64_t unconditionalBytes = 0;
+
+		void add(const AttachmentPolicy& policy, uint32_t width, uint32_t height);
+	};
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace vulkan
+{
+	// 64 bit hashing used for keying cached assets and for welding vertices, based on MurmurHash64A
+	class ContentHash
+	{
+	public:
+
+		static uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0)
+		{
+			const uint64_t m = 0xc6a4a7935bd1e995ULL;
+			const int r = 47;
+
+			uint64_t hash = seed ^ (size * m);
+
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+			const uint8_t* wordsEnd = bytes + (size & ~size_t(7));
+
+			for (; bytes != wordsEnd; bytes += 8)
+			{
+				uint64_t word;
+				memcpy(&word, bytes, sizeof(word));
+
+				word *= m;
+				word ^= word >> r;
+				word *= m;
+
+				hash ^= word;
+				hash *= m;
+			}
+
+			size_t remaining = size & 7;
+			if (remaining > 0)
+			{
+				uint64_t tail = 0;
+				memcpy(&tail, bytes, remaining);
+				hash ^= tail;
+				hash *= m;
+			}
+
+			hash ^= hash >> r;
+			hash *= m;
+			hash ^= hash >> r;
+
+			return hash;
+		}
+
+		template<typename Type>
+		static uint64_t hashValue(const Type& value, uint64_t seed = 0)
+		{
+			return hashBytes(&value, sizeof(Type), seed);
+		}
+
+		static uint64_t combine(uint64_t hash, uint64_t otherHash)
+		{
+			return hash ^ (otherHash + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+		}
+	};
+}
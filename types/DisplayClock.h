@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+#include "PresentationClock.h"
+
+namespace vulkan
+{
+	// Vertical blank timeline of a display refreshing every refreshPeriod seconds. Vulkan 1.0 exposes no vertical blank events so the timeline
+	// is kept on steady clock from creation, In headless runs it stands in for the display altogether. When presentation engine reports
+	// display times the timeline is moved onto them with synchronize
+	class DisplayClock
+	{
+	public:
+		explicit DisplayClock(double refreshPeriod) : refreshPeriod(refreshPeriod), origin(std::chrono::steady_clock::now())
+		{
+		}
+
+		DisplayClock(const DisplayClock&) = delete;
+		DisplayClock& operator=(const DisplayClock&) = delete;
+
+		double getRefreshPeriod() const
+		{
+			return refreshPeriod;
+		}
+
+		// Seconds since clock was created
+		double now() const
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - origin).count();
+		}
+
+		// First vertical blank that is at least lead seconds away
+		double getNextVsync(double lead) const
+		{
+			double period = refreshPeriod;
+			double offset = phase;
+			return (std::floor((now() + lead - offset) / period) + 1.0) * period + offset;
+		}
+
+		// First vertical blank at or after time
+		double getVsyncAfter(double time) const
+		{
+			double period = refreshPeriod;
+			double offset = phase;
+			return std::ceil((time - offset) / period) * period + offset;
+		}
+
+		// Time scanout of vertical blank at vsync reaches rowFraction of display height, Rows are scanned out evenly over the whole
+		// refresh period as vertical blanking interval is not known
+		double getScanoutTime(double vsync, double rowFraction) const
+		{
+			return vsync + rowFraction * refreshPeriod;
+		}
+
+		// Moves timeline onto a vertical blank reported at presentation engine time in nanoseconds, Refresh period is taken over when
+		// presentation engine knows it. Safe to call while other threads read the clock
+		void synchronize(uint64_t vsyncNanoseconds, double period = 0.0)
+		{
+			if (period > 0.0)
+			{
+				refreshPeriod = period;
+			}
+
+			double vsyncTime = std::chrono::duration<double>(PresentationClock::toSteady(vsyncNanoseconds) - origin).count();
+			double offset = std::fmod(vsyncTime, (double)refreshPeriod);
+			phase = offset < 0.0 ? offset + refreshPeriod : offset;
+		}
+
+		void sleepUntil(double time) const
+		{
+			std::this_thread::sleep_until(origin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time)));
+		}
+
+	private:
+		std::atomic<double> refreshPeriod;
+		// Time of first vertical blank after creation
+		std::atomic<double> phase{ 0.0 };
+		std::chrono::steady_clock::time_point origin;
+	};
+}
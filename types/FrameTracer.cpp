@@ -0,0 +1,85 @@
+#include "FrameTracer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+vulkan::FrameTracer::FrameTracer(uint32_t capacity) : capacity(std::max(capacity, 1u)), origin(std::chrono::steady_clock::now())
+{
+}
+
+vulkan::FrameTracer::EventId vulkan::FrameTracer::registerEvent(const std::string& name)
+{
+	if (frameCount > 0)
+	{
+		throw std::runtime_error("Frame tracer events have to be registered before tracing starts");
+	}
+
+	eventNames.push_back(name);
+	return (EventId)(eventNames.size() - 1);
+}
+
+void vulkan::FrameTracer::beginFrame()
+{
+	if (timestamps.empty())
+	{
+		timestamps.resize((size_t)capacity * eventNames.size());
+	}
+
+	uint32_t row = (uint32_t)(frameCount % capacity);
+	std::fill_n(timestamps.begin() + (size_t)row * eventNames.size(), eventNames.size(), -1.0);
+	frameCount++;
+}
+
+void vulkan::FrameTracer::mark(EventId event)
+{
+	mark(event, now());
+}
+
+void vulkan::FrameTracer::mark(EventId event, double time)
+{
+	if (frameCount == 0)
+	{
+		return;
+	}
+
+	uint32_t row = (uint32_t)((frameCount - 1) % capacity);
+	timestamps[(size_t)row * eventNames.size() + event] = time;
+}
+
+double vulkan::FrameTracer::now() const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - origin).count();
+}
+
+vulkan::FrameTracer::Interval vulkan::FrameTracer::measure(EventId from, EventId to) const
+{
+	Interval interval;
+	double sum = 0;
+	double squareSum = 0;
+
+	uint32_t rowCount = (uint32_t)std::min<uint64_t>(frameCount, capacity);
+	for (uint32_t row = 0; row < rowCount; row++)
+	{
+		double fromTime = timestamps[(size_t)row * eventNames.size() + from];
+		double toTime = timestamps[(size_t)row * eventNames.size() + to];
+		if (fromTime < 0.0 || toTime < 0.0)
+		{
+			continue;
+		}
+
+		double duration = toTime - fromTime;
+		interval.min = interval.frameCount == 0 ? duration : std::min(interval.min, duration);
+		interval.max = interval.frameCount == 0 ? duration : std::max(interval.max, duration);
+		sum += duration;
+		squareSum += duration * duration;
+		interval.frameCount++;
+	}
+
+	if (interval.frameCount > 0)
+	{
+		interval.average = sum / interval.frameCount;
+		interval.deviation = std::sqrt(std::max(squareSum / interval.frameCount - interval.average * interval.average, 0.0));
+	}
+	return interval;
+}
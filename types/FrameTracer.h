@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace vulkan
+{
+	// Timestamps of named points within every frame on steady clock. Last capacity frames are kept in a ring so that marking
+	// never allocates, Intervals between two points are measured over frames that recorded both
+	class FrameTracer
+	{
+	public:
+		typedef uint32_t EventId;
+
+		struct Interval
+		{
+			uint64_t frameCount = 0;
+			double average = 0;
+			double min = 0;
+			double max = 0;
+			// Standard deviation, Jitter of the interval
+			double deviation = 0;
+		};
+
+		explicit FrameTracer(uint32_t capacity = 1024);
+
+		// Events can only be registered before first frame begins
+		EventId registerEvent(const std::string& name);
+
+		void beginFrame();
+		void mark(EventId event);
+		// Event of current frame happened at time earlier on, Such as on another thread
+		void mark(EventId event, double time);
+
+		// Seconds since tracer was created
+		double now() const;
+
+		Interval measure(EventId from, EventId to) const;
+
+		const std::string& getEventName(EventId event) const
+		{
+			return eventNames[event];
+		}
+
+	private:
+		uint32_t capacity;
+		std::vector<std::string> eventNames;
+		// capacity rows of one timestamp per event, Negative when frame did not reach the event
+		std::vector<double> timestamps;
+		uint64_t frameCount = 0;
+		std::chrono::steady_clock::time_point origin;
+	};
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace vulkan
+{
+	// Frustum as 6 planes, xyz of a plane is its inward facing unit normal and w its distance so that inside points has dot(xyz, p) + w >= 0
+	struct Frustum
+	{
+		enum Plane
+		{
+			Left = 0,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			PlaneCount
+		};
+
+		glm::vec4 planes[PlaneCount];
+
+		// Extracts planes from rows of view projection matrix, Expects 0 to 1 clip space depth
+		static Frustum fromViewProjection(const glm::mat4& viewProjection)
+		{
+			glm::vec4 rows[4];
+			for (int row = 0; row < 4; row++)
+			{
+				rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+			}
+
+			Frustum frustum;
+			frustum.planes[Left] = rows[3] + rows[0];
+			frustum.planes[Right] = rows[3] - rows[0];
+			frustum.planes[Bottom] = rows[3] + rows[1];
+			frustum.planes[Top] = rows[3] - rows[1];
+			frustum.planes[Near] = rows[2];
+			frustum.planes[Far] = rows[3] - rows[2];
+
+			for (glm::vec4& plane : frustum.planes)
+			{
+				plane /= glm::length(glm::vec3(plane));
+			}
+			return frustum;
+		}
+
+		// Frustum enclosing both eyes of a parallel stereo pair, Eyes only differ by an offset along their right axis so side planes
+		// of both eyes are parallel and the outer one of each side is kept, Remaining planes are shared by both eyes
+		static Frustum combineStereo(const Frustum& firstEye, const Frustum& secondEye)
+		{
+			Frustum frustum = firstEye;
+			for (Plane side : { Left, Right })
+			{
+				if (secondEye.planes[side].w > firstEye.planes[side].w)
+				{
+					frustum.planes[side] = secondEye.planes[side];
+				}
+			}
+			return frustum;
+		}
+
+		bool intersectsSphere(const glm::vec3& center, float radius) const
+		{
+			for (const glm::vec4& plane : planes)
+			{
+				if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+}
@@ -0,0 +1,77 @@
+#include "GpuPassTimer.h"
+
+#include <stdexcept>
+#include <vector>
+
+bool vulkan::GpuPassTimer::create(VkPhysicalDevice physicalDevice, VkDevice vkDevice, uint32_t queueFamily, uint32_t slots, uint32_t spans)
+{
+	VkPhysicalDeviceProperties deviceProps;
+	vkGetPhysicalDeviceProperties(physicalDevice, &deviceProps);
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+	uint32_t validBits = queueFamily < familyCount ? families[queueFamily].timestampValidBits : 0;
+	if (validBits == 0)
+	{
+		return false;
+	}
+
+	device = vkDevice;
+	slotCount = slots;
+	spanCount = spans;
+	timestampPeriod = deviceProps.limits.timestampPeriod;
+	timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = 2 * slotCount * spanCount;
+
+	if (vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &queryPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create timestamp query pool");
+	}
+	return true;
+}
+
+void vulkan::GpuPassTimer::destroy()
+{
+	if (queryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+}
+
+void vulkan::GpuPassTimer::recordBegin(VkCommandBuffer cmdBuffer, uint32_t slot, uint32_t span) const
+{
+	uint32_t firstQuery = getFirstQuery(slot, span);
+	vkCmdResetQueryPool(cmdBuffer, queryPool, firstQuery, 1);
+	vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, firstQuery);
+}
+
+// End resets its own query since it can be in a command buffer submitted without the one stamping begin
+void vulkan::GpuPassTimer::recordEnd(VkCommandBuffer cmdBuffer, uint32_t slot, uint32_t span) const
+{
+	uint32_t endQuery = getFirstQuery(slot, span) + 1;
+	vkCmdResetQueryPool(cmdBuffer, queryPool, endQuery, 1);
+	vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, endQuery);
+}
+
+bool vulkan::GpuPassTimer::getSpanTime(uint32_t slot, uint32_t span, double& seconds) const
+{
+	// Value and availability of each query
+	uint64_t results[2][2];
+	VkResult result = vkGetQueryPoolResults(device, queryPool, getFirstQuery(slot, span), 2, sizeof(results), results, sizeof(results[0]),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if ((result != VK_SUCCESS && result != VK_NOT_READY) || results[0][1] == 0 || results[1][1] == 0)
+	{
+		return false;
+	}
+
+	seconds = ((results[1][0] - results[0][0]) & timestampMask) * timestampPeriod * 1e-9;
+	return true;
+}
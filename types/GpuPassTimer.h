@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include <cstdint>
+
+namespace vulkan
+{
+	// GPU time of spans from timestamp queries, Every slot times each span once. Begin and end of a span may be recorded into different command
+	// buffers submitted in that order to one queue. A slot is read back only after submits that wrote it are waited for, Like once the swap chain
+	// image it belongs to has been acquired again and its last frame waited on, and commands timing it again reset its queries first
+	class GpuPassTimer
+	{
+	public:
+		GpuPassTimer() = default;
+		GpuPassTimer(const GpuPassTimer&) = delete;
+		GpuPassTimer& operator=(const GpuPassTimer&) = delete;
+
+		// False without timestamps on queues of queueFamily, Timer stays unusable then
+		bool create(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t slotCount, uint32_t spanCount);
+		void destroy();
+
+		bool isCreated() const
+		{
+			return queryPool != VK_NULL_HANDLE;
+		}
+
+		// Outside render passes, Both are stamped at bottom of pipe so a stamp is written once all commands submitted before it are done.
+		// Later commands are not held back by a stamp so they may start before it is written
+		void recordBegin(VkCommandBuffer cmdBuffer, uint32_t slot, uint32_t span) const;
+		void recordEnd(VkCommandBuffer cmdBuffer, uint32_t slot, uint32_t span) const;
+
+		// False while either stamp of span in slot is not available
+		bool getSpanTime(uint32_t slot, uint32_t span, double& seconds) const;
+
+	private:
+		uint32_t getFirstQuery(uint32_t slot, uint32_t span) const
+		{
+			return 2 * (slot * spanCount + span);
+		}
+
+		VkDevice device = VK_NULL_HANDLE;
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		uint32_t slotCount = 0;
+		uint32_t spanCount = 0;
+		// Nanoseconds per timestamp tick
+		double timestampPeriod = 1.0;
+		uint64_t timestampMask = 0;
+	};
+}
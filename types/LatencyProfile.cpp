@@ -0,0 +1,77 @@
+#include "LatencyProfile.h"
+
+bool vulkan::LatencyProfile::getPreset(const std::string& name, LatencyProfile& profile)
+{
+	profile = LatencyProfile();
+	profile.name = name;
+
+	if (name == "low-latency")
+	{
+		// Swap chain images are clamped up to surface minimum
+		profile.framesInFlight = 1;
+		profile.swapchainImageCount = 2;
+		profile.presentModes = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+		profile.bLimitFrameRate = true;
+		return true;
+	}
+	else if (name == "balanced")
+	{
+		return true;
+	}
+	else if (name == "throughput")
+	{
+		profile.framesInFlight = MAX_FRAMES_IN_FLIGHT;
+		profile.swapchainImageCount = 4;
+		profile.presentModes = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+		return true;
+	}
+	return false;
+}
+
+const std::vector<std::string>& vulkan::LatencyProfile::getPresetNames()
+{
+	static const std::vector<std::string> names = { "low-latency", "balanced", "throughput" };
+	return names;
+}
+
+bool vulkan::LatencyProfile::parsePresentMode(const std::string& name, VkPresentModeKHR& mode)
+{
+	if (name == "mailbox")
+	{
+		mode = VK_PRESENT_MODE_MAILBOX_KHR;
+	}
+	else if (name == "immediate")
+	{
+		mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+	}
+	else if (name == "fifo")
+	{
+		mode = VK_PRESENT_MODE_FIFO_KHR;
+	}
+	else if (name == "fifo-relaxed")
+	{
+		mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+const char* vulkan::LatencyProfile::getPresentModeName(VkPresentModeKHR mode)
+{
+	switch (mode)
+	{
+	case VK_PRESENT_MODE_MAILBOX_KHR:
+		return "mailbox";
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:
+		return "immediate";
+	case VK_PRESENT_MODE_FIFO_KHR:
+		return "fifo";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+		return "fifo-relaxed";
+	default:
+		return "unknown";
+	}
+}
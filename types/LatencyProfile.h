@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LatencyTracker.h"
+
+namespace vulkan
+{
+	// How far CPU runs ahead of the display. Fewer frames in flight and swap chain images and waiting for present before starting a frame
+	// show input sooner, More of them keep GPU busy when frame times vary
+	struct LatencyProfile
+	{
+		static constexpr uint32_t MIN_FRAMES_IN_FLIGHT = 1;
+		static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+		// Resources per swap chain image are created for this many up front, So switching profiles never outgrows them
+		static constexpr uint32_t MAX_SWAPCHAIN_IMAGES = 8;
+
+		std::string name = "balanced";
+		// Frames recorded and submitted before waiting for oldest one to complete, Clamped to swap chain image count
+		uint32_t framesInFlight = 2;
+		// Requested swap chain images clamped to what surface supports, 0 asks for one more than surface minimum
+		uint32_t swapchainImageCount = 0;
+		// Present modes in order of preference, FIFO is used when surface has none of them since every surface supports it
+		std::vector<VkPresentModeKHR> presentModes = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+		// Frame starts only once previous one was presented, So its input and pose are sampled right before they can be shown
+		bool bLimitFrameRate = false;
+
+		// Measured while profile was in use
+		struct Stats
+		{
+			std::string profileName;
+			uint32_t framesInFlight = 0;
+			uint32_t swapchainImageCount = 0;
+			VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+			bool bLimitFrameRate = false;
+
+			uint64_t frameCount = 0;
+			double seconds = 0;
+			// Idle waits while nothing changes are included, Replaying a pose trajectory draws every frame
+			double framesPerSecond = 0;
+			// Display when presentation engine reports display times, Present return otherwise
+			LatencyTracker::Stage latencyStage = LatencyTracker::Stage::PresentReturn;
+			LatencyTracker::Histogram inputLatency;
+			LatencyTracker::Histogram poseLatency;
+		};
+
+		// low-latency, balanced or throughput, False for any other name
+		static bool getPreset(const std::string& name, LatencyProfile& profile);
+		static const std::vector<std::string>& getPresetNames();
+
+		// mailbox, immediate, fifo or fifo-relaxed
+		static bool parsePresentMode(const std::string& name, VkPresentModeKHR& mode);
+		static const char* getPresentModeName(VkPresentModeKHR mode);
+	};
+}
@@ -0,0 +1,167 @@
+#include "LatencyTracker.h"
+#include "PresentationClock.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+void vulkan::LatencyTracker::Histogram::add(double seconds)
+{
+	uint32_t bin = (uint32_t)std::min(std::max(seconds, 0.0) / BIN_WIDTH, (double)(BIN_COUNT - 1));
+	bins[bin]++;
+	count++;
+	sum += seconds;
+	max = std::max(max, seconds);
+}
+
+double vulkan::LatencyTracker::Histogram::getPercentile(double fraction) const
+{
+	uint64_t target = (uint64_t)(fraction * count);
+	uint64_t accumulated = 0;
+	for (uint32_t bin = 0; bin < BIN_COUNT; bin++)
+	{
+		accumulated += bins[bin];
+		if (accumulated > target)
+		{
+			return (bin + 1) * BIN_WIDTH;
+		}
+	}
+	return BIN_COUNT * BIN_WIDTH;
+}
+
+vulkan::LatencyTracker::LatencyTracker() : origin(std::chrono::steady_clock::now())
+{
+}
+
+double vulkan::LatencyTracker::now() const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - origin).count();
+}
+
+double vulkan::LatencyTracker::fromPresentationTime(uint64_t nanoseconds) const
+{
+	return std::chrono::duration<double>(PresentationClock::toSteady(nanoseconds) - origin).count();
+}
+
+vulkan::LatencyTracker::SampleId vulkan::LatencyTracker::stampSample(Source source)
+{
+	double time = now();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	SampleId id = ++sampleCounts[(uint32_t)source];
+	pendingSamples[(uint32_t)source].push_back({ id, time });
+	return id;
+}
+
+vulkan::LatencyTracker::SampleId vulkan::LatencyTracker::getLatestSample(Source source) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return sampleCounts[(uint32_t)source];
+}
+
+vulkan::LatencyTracker::FrameId vulkan::LatencyTracker::beginFrame(SampleId inputSample, SampleId poseSample)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Frame frame;
+	frame.id = ++frameCount;
+
+	const SampleId shownSamples[] = { inputSample, poseSample };
+	for (uint32_t source = 0; source < (uint32_t)Source::Count; source++)
+	{
+		std::deque<Sample>& pending = pendingSamples[source];
+		while (!pending.empty() && pending.front().id <= shownSamples[source])
+		{
+			frame.samples[source].push_back(pending.front());
+			pending.pop_front();
+		}
+	}
+
+	frames.push_back(std::move(frame));
+	if (frames.size() > TRACKED_FRAME_COUNT)
+	{
+		frames.pop_front();
+	}
+	return frameCount;
+}
+
+void vulkan::LatencyTracker::markStage(FrameId frame, Stage stage, double time)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Frames are kept in order of their ids
+	if (frame == INVALID_FRAME || frames.empty() || frame < frames.front().id || frame > frames.back().id)
+	{
+		return;
+	}
+
+	const Frame& trackedFrame = frames[(size_t)(frame - frames.front().id)];
+	for (uint32_t source = 0; source < (uint32_t)Source::Count; source++)
+	{
+		for (const Sample& sample : trackedFrame.samples[source])
+		{
+			// Samples taken after a stage did not go through it
+			if (time >= sample.time)
+			{
+				histograms[source][(uint32_t)stage].add(time - sample.time);
+			}
+		}
+	}
+}
+
+vulkan::LatencyTracker::Histogram vulkan::LatencyTracker::getHistogram(Source source, Stage stage) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return histograms[(uint32_t)source][(uint32_t)stage];
+}
+
+void vulkan::LatencyTracker::resetHistograms()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (uint32_t source = 0; source < (uint32_t)Source::Count; source++)
+	{
+		for (uint32_t stage = 0; stage < (uint32_t)Stage::Count; stage++)
+		{
+			histograms[source][stage] = Histogram();
+		}
+	}
+}
+
+void vulkan::LatencyTracker::exportCsv(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Unable to write latency histograms to " + path);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	file << "source,stage,bin_start_ms,bin_end_ms,count" << std::endl;
+	for (uint32_t source = 0; source < (uint32_t)Source::Count; source++)
+	{
+		for (uint32_t stage = 0; stage < (uint32_t)Stage::Count; stage++)
+		{
+			const Histogram& histogram = histograms[source][stage];
+			for (uint32_t bin = 0; bin < Histogram::BIN_COUNT; bin++)
+			{
+				if (histogram.bins[bin] > 0)
+				{
+					file << getSourceName((Source)source) << "," << getStageName((Stage)stage) << "," << bin * Histogram::BIN_WIDTH * 1000.0 << ","
+						<< (bin + 1) * Histogram::BIN_WIDTH * 1000.0 << "," << histogram.bins[bin] << std::endl;
+				}
+			}
+		}
+	}
+}
+
+const char* vulkan::LatencyTracker::getSourceName(Source source)
+{
+	static const char* names[] = { "Input", "Pose" };
+	return names[(uint32_t)source];
+}
+
+const char* vulkan::LatencyTracker::getStageName(Stage stage)
+{
+	static const char* names[] = { "Eye submit", "Distortion submit", "GPU complete", "Present return", "Display" };
+	return names[(uint32_t)stage];
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <chrono>
+
+namespace vulkan
+{
+	// Motion to photon latency. Input events and pose samples get an id and a steady clock timestamp when they happen and frames name the
+	// last sample of every source they show. Every stage a frame reaches adds the time since each sample the frame is first to show to a
+	// histogram of that source and stage. Stages can be marked from any thread and after later frames began
+	class LatencyTracker
+	{
+	public:
+		enum class Source : uint32_t
+		{
+			Input,
+			Pose,
+			Count
+		};
+
+		enum class Stage : uint32_t
+		{
+			EyeSubmit,
+			DistortionSubmit,
+			GpuComplete,
+			PresentReturn,
+			// Reported by presentation engine when display timing is available
+			Display,
+			Count
+		};
+
+		typedef uint64_t SampleId;
+		typedef uint64_t FrameId;
+
+		static const FrameId INVALID_FRAME = 0;
+
+		struct Histogram
+		{
+			// Half millisecond bins up to 100ms, Last one collects everything longer
+			static constexpr double BIN_WIDTH = 0.0005;
+			static const uint32_t BIN_COUNT = 200;
+
+			uint64_t bins[BIN_COUNT] = {};
+			uint64_t count = 0;
+			double sum = 0;
+			double max = 0;
+
+			void add(double seconds);
+			// Upper edge of bin holding given fraction of samples
+			double getPercentile(double fraction) const;
+		};
+
+		LatencyTracker();
+
+		// Seconds since tracker was created
+		double now() const;
+
+		// Seconds since tracker was created at presentation engine time in nanoseconds
+		double fromPresentationTime(uint64_t nanoseconds) const;
+
+		SampleId stampSample(Source source);
+		SampleId getLatestSample(Source source) const;
+
+		// Frame shows every sample up to given ones, Samples an earlier frame showed already are not counted again
+		FrameId beginFrame(SampleId inputSample, SampleId poseSample);
+		void markStage(FrameId frame, Stage stage, double time);
+
+		Histogram getHistogram(Source source, Stage stage) const;
+		// Histograms start over, Samples and frames in flight are kept
+		void resetHistograms();
+
+		// One row per source, stage and non empty bin
+		void exportCsv(const std::string& path) const;
+
+		static const char* getSourceName(Source source);
+		static const char* getStageName(Stage stage);
+
+	private:
+		struct Sample
+		{
+			SampleId id;
+			double time;
+		};
+
+		struct Frame
+		{
+			FrameId id;
+			// Samples of every source shown first by this frame
+			std::vector<Sample> samples[(uint32_t)Source::Count];
+		};
+
+		// Frames whose stages can still be marked, Display timing comes back a few frames late
+		static const uint32_t TRACKED_FRAME_COUNT = 64;
+
+		mutable std::mutex mutex;
+		std::chrono::steady_clock::time_point origin;
+		SampleId sampleCounts[(uint32_t)Source::Count] = {};
+		std::deque<Sample> pendingSamples[(uint32_t)Source::Count];
+		std::deque<Frame> frames;
+		FrameId frameCount = 0;
+		Histogram histograms[(uint32_t)Source::Count][(uint32_t)Stage::Count];
+	};
+}
@@ -0,0 +1,147 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+vulkan::MappedFile& vulkan::MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		mappedData = other.mappedData;
+		mappedSize = other.mappedSize;
+		bIsOpen = other.bIsOpen;
+#ifdef _WIN32
+		fileHandle = other.fileHandle;
+		mappingHandle = other.mappingHandle;
+		other.fileHandle = nullptr;
+		other.mappingHandle = nullptr;
+#else
+		fileDescriptor = other.fileDescriptor;
+		other.fileDescriptor = -1;
+#endif
+		other.mappedData = nullptr;
+		other.mappedSize = 0;
+		other.bIsOpen = false;
+	}
+	return *this;
+}
+
+bool vulkan::MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL |
+		FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappedSize = (size_t)fileSize.QuadPart;
+	bIsOpen = true;
+
+	// Empty files cannot be mapped but are still valid to open
+	if (mappedSize == 0)
+	{
+		return true;
+	}
+
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	mappedData = reinterpret_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (mappedData == nullptr)
+	{
+		close();
+		return false;
+	}
+#else
+	fileDescriptor = ::open(path.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fileDescriptor, &fileStat) != 0)
+	{
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+		return false;
+	}
+
+	mappedSize = (size_t)fileStat.st_size;
+	bIsOpen = true;
+
+	if (mappedSize == 0)
+	{
+		return true;
+	}
+
+	void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (mapping == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	mappedData = reinterpret_cast<const uint8_t*>(mapping);
+#endif
+
+	return true;
+}
+
+void vulkan::MappedFile::close()
+{
+#ifdef _WIN32
+	if (mappedData)
+	{
+		UnmapViewOfFile(mappedData);
+	}
+	if (mappingHandle)
+	{
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle)
+	{
+		CloseHandle(fileHandle);
+	}
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	if (mappedData)
+	{
+		munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+	}
+	if (fileDescriptor >= 0)
+	{
+		::close(fileDescriptor);
+	}
+	fileDescriptor = -1;
+#endif
+
+	mappedData = nullptr;
+	mappedSize = 0;
+	bIsOpen = false;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace vulkan
+{
+	// Read only memory mapping of a whole file, used for loading cached assets without copying them through streams
+	class MappedFile
+	{
+	private:
+		const uint8_t* mappedData = nullptr;
+		size_t mappedSize = 0;
+		bool bIsOpen = false;
+
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		int fileDescriptor = -1;
+#endif
+
+	public:
+		MappedFile() = default;
+
+		explicit MappedFile(const std::string& path)
+		{
+			open(path);
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept
+		{
+			*this = std::move(other);
+		}
+
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		~MappedFile()
+		{
+			close();
+		}
+
+		bool open(const std::string& path);
+
+		void close();
+
+		bool isOpen() const
+		{
+			return bIsOpen;
+		}
+
+		const uint8_t* data() const
+		{
+			return mappedData;
+		}
+
+		size_t size() const
+		{
+			return mappedSize;
+		}
+	};
+}
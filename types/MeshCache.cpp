@@ -0,0 +1,177 @@
+#include "MeshCache.h"
+#include "ContentHash.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+std::string vulkan::MeshCache::getCachePath(uint64_t key) const
+{
+	std::stringstream pathStream;
+	pathStream << cacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".mesh";
+	return pathStream.str();
+}
+
+uint64_t vulkan::MeshCache::computeKey(uint64_t sourceHash, const MeshCacheSettings& settings)
+{
+	uint64_t key = sourceHash;
+	key = ContentHash::combine(key, ContentHash::hashValue(settings.vertexLayout));
+	key = ContentHash::combine(key, settings.layoutHash);
+	key = ContentHash::combine(key, settings.processingHash);
+	key = ContentHash::combine(key, ContentHash::hashValue(CACHE_VERSION));
+	return key;
+}
+
+bool vulkan::MeshCache::find(uint64_t key, MappedFile& mapping, MeshData& mesh)
+{
+	if (!mapping.open(getCachePath(key)) || mapping.size() < sizeof(FileHeader))
+	{
+		mapping.close();
+		misses++;
+		return false;
+	}
+
+	FileHeader header;
+	memcpy(&header, mapping.data(), sizeof(FileHeader));
+
+	// Counts are bounded by what fits in file before stream sizes are computed, So none of the sums below can wrap around
+	uint64_t fileSize = mapping.size();
+	bool bIsValid = header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.key == key &&
+		header.vertexStride > 0 && (header.indexSize == 2 || header.indexSize == 4) &&
+		header.vertexOffset >= sizeof(FileHeader) && header.vertexOffset <= fileSize &&
+		header.vertexCount <= (fileSize - header.vertexOffset) / header.vertexStride;
+	bIsValid = bIsValid && header.indexOffset >= header.vertexOffset + header.vertexCount * header.vertexStride &&
+		header.indexOffset <= fileSize && header.indexOffset % header.indexSize == 0 &&
+		header.indexCount <= (fileSize - header.indexOffset) / header.indexSize;
+
+	bIsValid = bIsValid && header.lodCount <= MAX_MESH_LOD_COUNT;
+	for (uint32_t lod = 0; bIsValid && lod < header.lodCount; lod++)
+	{
+		bIsValid = (uint64_t)header.lods[lod].firstIndex + header.lods[lod].indexCount <= header.indexCount;
+	}
+
+	bIsValid = bIsValid && hasValidIndices(mapping.data() + header.indexOffset, header.indexSize, header.indexCount, header.vertexCount);
+
+	if (!bIsValid)
+	{
+		std::cerr << "Mesh cache entry " << getCachePath(key) << " is invalid, Ignoring it" << std::endl;
+		mapping.close();
+		misses++;
+		return false;
+	}
+
+	mesh.sourceHash = header.sourceHash;
+	mesh.vertexLayout = header.vertexLayout;
+	mesh.vertexStride = header.vertexStride;
+	mesh.indexSize = header.indexSize;
+	mesh.vertexCount = header.vertexCount;
+	mesh.indexCount = header.indexCount;
+	mesh.bounds = header.bounds;
+	mesh.lodCount = header.lodCount;
+	std::copy(header.lods, header.lods + MAX_MESH_LOD_COUNT, mesh.lods);
+	mesh.vertexData = mapping.data() + header.vertexOffset;
+	mesh.indexData = mapping.data() + header.indexOffset;
+
+	hits++;
+	return true;
+}
+
+// Index stream is checked once at load so that draws from a damaged entry never fetch outside of vertex buffer
+bool vulkan::MeshCache::hasValidIndices(const uint8_t* indexData, uint32_t indexSize, uint64_t indexCount, uint64_t vertexCount)
+{
+	if (indexSize == 2)
+	{
+		const uint16_t* indices = reinterpret_cast<const uint16_t*>(indexData);
+		return std::all_of(indices, indices + indexCount, [vertexCount](uint16_t index) { return index < vertexCount; });
+	}
+
+	const uint32_t* indices = reinterpret_cast<const uint32_t*>(indexData);
+	return std::all_of(indices, indices + indexCount, [vertexCount](uint32_t index) { return index < vertexCount; });
+}
+
+bool vulkan::MeshCache::store(uint64_t key, const MeshData& mesh)
+{
+	std::error_code errorCode;
+	std::filesystem::create_directories(cacheDirectory, errorCode);
+
+	FileHeader header = {};
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.key = key;
+	header.sourceHash = mesh.sourceHash;
+	header.vertexLayout = mesh.vertexLayout;
+	header.vertexStride = mesh.vertexStride;
+	header.indexSize = mesh.indexSize;
+	header.vertexCount = mesh.vertexCount;
+	header.indexCount = mesh.indexCount;
+	header.bounds = mesh.bounds;
+	header.lodCount = mesh.lodCount;
+	std::copy(mesh.lods, mesh.lods + MAX_MESH_LOD_COUNT, header.lods);
+	// Streams starts at 16 byte aligned offsets so that mapped data can be copied with aligned loads
+	header.vertexOffset = (sizeof(FileHeader) + 15) & ~uint64_t(15);
+	header.indexOffset = (header.vertexOffset + mesh.getVertexDataSize() + 15) & ~uint64_t(15);
+
+	// Writing to temporary file first so that a crash in between never leaves a partially written entry
+	std::string cachePath = getCachePath(key);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open mesh cache file " << tempPath << " for writing" << std::endl;
+			std::filesystem::remove(tempPath, errorCode);
+			return false;
+		}
+
+		static const char padding[16] = {};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+		file.write(padding, header.vertexOffset - sizeof(FileHeader));
+		file.write(reinterpret_cast<const char*>(mesh.vertexData), mesh.getVertexDataSize());
+		file.write(padding, header.indexOffset - (header.vertexOffset + mesh.getVertexDataSize()));
+		file.write(reinterpret_cast<const char*>(mesh.indexData), mesh.getIndexDataSize());
+
+		if (!file.good())
+		{
+			std::cerr << "Failed writing mesh cache file " << tempPath << std::endl;
+			file.close();
+			std::filesystem::remove(tempPath, errorCode);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, cachePath, errorCode);
+	if (errorCode)
+	{
+		std::cerr << "Failed to move mesh cache file " << tempPath << " to " << cachePath << std::endl;
+		std::filesystem::remove(tempPath, errorCode);
+		return false;
+	}
+	return true;
+}
+
+vulkan::MeshBounds vulkan::MeshCache::computeBounds(const float* positions, uint64_t count, uint32_t stride)
+{
+	MeshBounds bounds = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+	if (count == 0)
+	{
+		return MeshBounds();
+	}
+
+	const uint8_t* positionBytes = reinterpret_cast<const uint8_t*>(positions);
+	for (uint64_t i = 0; i < count; i++, positionBytes += stride)
+	{
+		float position[3];
+		memcpy(position, positionBytes, sizeof(position));
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bounds.min[axis] = std::min(bounds.min[axis], position[axis]);
+			bounds.max[axis] = std::max(bounds.max[axis], position[axis]);
+		}
+	}
+	return bounds;
+}
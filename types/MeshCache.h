@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace vulkan
+{
+	struct MeshBounds
+	{
+		float min[3];
+		float max[3];
+	};
+
+	// Upper bound of detail levels of a mesh, cull.comp.glsl has room for errors of this many
+	static const uint32_t MAX_MESH_LOD_COUNT = 8;
+
+	// Range of index stream drawn for a detail level, error is the largest distance simplification moved surface by in model space
+	struct MeshLod
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;
+	};
+
+	// Settings that changes the imported result, Everything in here is part of the cache key
+	struct MeshCacheSettings
+	{
+		// Preferred vertex layout, Mesh may still end up in another layout if it cannot be represented in this one
+		uint32_t vertexLayout;
+		// Hash of vertex attribute layouts so that cache gets invalidated when vertex format changes
+		uint64_t layoutHash;
+		// Hash of settings of processing done after welding like mesh optimization
+		uint64_t processingHash = 0;
+	};
+
+	// Welded mesh ready for upload, Streams are either owned by caller or point into a mapped cache file
+	struct MeshData
+	{
+		uint64_t sourceHash = 0;
+		uint32_t vertexLayout = 0;
+		uint32_t vertexStride = 0;
+		uint32_t indexSize = 0;
+		uint64_t vertexCount = 0;
+		uint64_t indexCount = 0;
+		MeshBounds bounds = {};
+		// Detail levels from full to coarsest, All share the vertex stream and indexCount covers the indices of all of them
+		uint32_t lodCount = 0;
+		MeshLod lods[MAX_MESH_LOD_COUNT] = {};
+		const uint8_t* vertexData = nullptr;
+		const uint8_t* indexData = nullptr;
+
+		uint64_t getVertexDataSize() const
+		{
+			return vertexCount * vertexStride;
+		}
+
+		uint64_t getIndexDataSize() const
+		{
+			return indexCount * indexSize;
+		}
+	};
+
+	// Disk cache of imported meshes as raw vertex and index streams, keyed by content of the source model and import settings
+	class MeshCache
+	{
+	private:
+		static constexpr uint32_t CACHE_MAGIC = 0x48434D53;// SMCH
+		static constexpr uint32_t CACHE_VERSION = 3;
+
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t key;
+			uint64_t sourceHash;
+			uint32_t vertexLayout;
+			uint32_t vertexStride;
+			uint32_t indexSize;
+			uint32_t reserved;
+			uint64_t vertexCount;
+			uint64_t indexCount;
+			MeshBounds bounds;
+			uint32_t lodCount;
+			MeshLod lods[MAX_MESH_LOD_COUNT];
+			uint64_t vertexOffset;
+			uint64_t indexOffset;
+		};
+
+		std::string cacheDirectory;
+
+		uint32_t hits = 0;
+		uint32_t misses = 0;
+
+		std::string getCachePath(uint64_t key) const;
+
+		static bool hasValidIndices(const uint8_t* indexData, uint32_t indexSize, uint64_t indexCount, uint64_t vertexCount);
+
+	public:
+		explicit MeshCache(const std::string& directory = "Cache/Meshes") : cacheDirectory(directory)
+		{}
+
+		static uint64_t computeKey(uint64_t sourceHash, const MeshCacheSettings& settings);
+
+		// Maps the cached mesh for key if present, mesh streams are valid as long as mapping is open
+		bool find(uint64_t key, MappedFile& mapping, MeshData& mesh);
+
+		bool store(uint64_t key, const MeshData& mesh);
+
+		// Bounds of positions made of 3 floats, that are stride bytes apart
+		static MeshBounds computeBounds(const float* positions, uint64_t count, uint32_t stride);
+
+		uint32_t getHits() const
+		{
+			return hits;
+		}
+
+		uint32_t getMisses() const
+		{
+			return misses;
+		}
+	};
+}
@@ -0,0 +1,392 @@
+#include "MeshOptimizer.h"
+#include "ContentHash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	struct Vector3
+	{
+		float x, y, z;
+	};
+
+	Vector3 readPosition(const uint8_t* positions, uint32_t stride, uint32_t vertexIndex)
+	{
+		Vector3 position;
+		memcpy(&position, positions + (size_t)vertexIndex * stride, sizeof(Vector3));
+		return position;
+	}
+
+	Vector3 sub(const Vector3& a, const Vector3& b)
+	{
+		return { a.x - b.x, a.y - b.y, a.z - b.z };
+	}
+
+	float dot(const Vector3& a, const Vector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	Vector3 cross(const Vector3& a, const Vector3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+}
+
+vulkan::VertexCacheStatistics vulkan::MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStatistics statistics;
+	if (indices.empty() || vertexCount == 0)
+	{
+		return statistics;
+	}
+
+	// Vertex is in FIFO cache while less than cacheSize vertices got transformed after it
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+
+	for (uint32_t vertexIndex : indices)
+	{
+		if (timestamp - cacheTimestamps[vertexIndex] > cacheSize)
+		{
+			cacheTimestamps[vertexIndex] = timestamp++;
+			statistics.vertexTransforms++;
+		}
+	}
+
+	statistics.acmr = statistics.vertexTransforms / (float)(indices.size() / 3);
+	statistics.atvr = statistics.vertexTransforms / (float)vertexCount;
+	return statistics;
+}
+
+void vulkan::MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* outClusters)
+{
+	const size_t triangleCount = indices.size() / 3;
+
+	// Triangles using each vertex
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (uint32_t vertexIndex : indices)
+	{
+		liveTriangles[vertexIndex]++;
+	}
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+	}
+
+	std::vector<uint32_t> adjacentTriangles(triangleCount * 3);
+	{
+		std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacentTriangles[fillOffsets[indices[i]]++] = (uint32_t)(i / 3);
+		}
+	}
+
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+
+	std::vector<bool> bIsEmitted(triangleCount, false);
+	std::vector<uint32_t> deadEndStack;
+	deadEndStack.reserve(triangleCount * 3);
+	std::vector<uint32_t> candidates;
+
+	std::vector<uint32_t> reordered;
+	reordered.reserve(triangleCount * 3);
+
+	uint32_t inputCursor = 0;
+	while (inputCursor < vertexCount && liveTriangles[inputCursor] == 0)
+	{
+		inputCursor++;
+	}
+	uint32_t fanningVertex = inputCursor < vertexCount ? inputCursor : INVALID_INDEX;
+	bool bIsColdStart = true;
+
+	while (fanningVertex != INVALID_INDEX)
+	{
+		if (outClusters && bIsColdStart)
+		{
+			outClusters->push_back((uint32_t)(reordered.size() / 3));
+		}
+
+		// Emitting all remaining triangles around fanning vertex
+		candidates.clear();
+		for (uint32_t i = adjacencyOffsets[fanningVertex]; i < adjacencyOffsets[fanningVertex + 1]; i++)
+		{
+			uint32_t triangle = adjacentTriangles[i];
+			if (bIsEmitted[triangle])
+			{
+				continue;
+			}
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t vertexIndex = indices[triangle * 3 + corner];
+				reordered.push_back(vertexIndex);
+				deadEndStack.push_back(vertexIndex);
+				candidates.push_back(vertexIndex);
+				liveTriangles[vertexIndex]--;
+
+				if (timestamp - cacheTimestamps[vertexIndex] > cacheSize)
+				{
+					cacheTimestamps[vertexIndex] = timestamp++;
+				}
+			}
+			bIsEmitted[triangle] = true;
+		}
+
+		// Next fanning vertex is the oldest candidate that would still be in cache after fanning around it
+		uint32_t nextVertex = INVALID_INDEX;
+		int64_t bestPriority = -1;
+		for (uint32_t vertexIndex : candidates)
+		{
+			if (liveTriangles[vertexIndex] == 0)
+			{
+				continue;
+			}
+
+			int64_t priority = 0;
+			if (timestamp - cacheTimestamps[vertexIndex] + 2 * liveTriangles[vertexIndex] <= cacheSize)
+			{
+				priority = timestamp - cacheTimestamps[vertexIndex];
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = vertexIndex;
+			}
+		}
+
+		bIsColdStart = false;
+		if (nextVertex == INVALID_INDEX)
+		{
+			while (!deadEndStack.empty())
+			{
+				uint32_t vertexIndex = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveTriangles[vertexIndex] > 0)
+				{
+					nextVertex = vertexIndex;
+					break;
+				}
+			}
+		}
+
+		if (nextVertex == INVALID_INDEX)
+		{
+			// Nothing recently used is left, Continuing from an unrelated part of the mesh
+			while (inputCursor < vertexCount && liveTriangles[inputCursor] == 0)
+			{
+				inputCursor++;
+			}
+			if (inputCursor < vertexCount)
+			{
+				nextVertex = inputCursor;
+				bIsColdStart = true;
+			}
+		}
+
+		fanningVertex = nextVertex;
+	}
+
+	indices.swap(reordered);
+}
+
+uint32_t vulkan::MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const uint8_t* positions, size_t vertexCount, uint32_t stride,
+	const std::vector<uint32_t>& hardClusters, const MeshOptimizerSettings& settings)
+{
+	const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+	if (triangleCount == 0)
+	{
+		return 0;
+	}
+
+	const float targetAcmr = analyzeVertexCache(indices, vertexCount, settings.cacheSize).acmr * settings.overdrawThreshold;
+
+	// Cutting a cluster starts next one with a cold cache, So cuts are only placed where cluster so far is cache efficient enough
+	std::vector<uint32_t> clusterStarts;
+	{
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = settings.cacheSize + 1;
+
+		for (size_t hardCluster = 0; hardCluster < hardClusters.size(); hardCluster++)
+		{
+			uint32_t clusterEnd = hardCluster + 1 < hardClusters.size() ? hardClusters[hardCluster + 1] : triangleCount;
+			uint32_t clusterStart = hardClusters[hardCluster];
+			uint32_t misses = 0;
+
+			clusterStarts.push_back(clusterStart);
+			timestamp += settings.cacheSize + 1;
+
+			for (uint32_t triangle = clusterStart; triangle < clusterEnd; triangle++)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t vertexIndex = indices[triangle * 3 + corner];
+					if (timestamp - cacheTimestamps[vertexIndex] > settings.cacheSize)
+					{
+						cacheTimestamps[vertexIndex] = timestamp++;
+						misses++;
+					}
+				}
+
+				if (triangle + 1 < clusterEnd && misses <= targetAcmr * (triangle + 1 - clusterStart))
+				{
+					clusterStart = triangle + 1;
+					misses = 0;
+					clusterStarts.push_back(clusterStart);
+					timestamp += settings.cacheSize + 1;
+				}
+			}
+		}
+	}
+
+	const uint32_t clusterCount = (uint32_t)clusterStarts.size();
+	clusterStarts.push_back(triangleCount);
+
+	struct ClusterInfo
+	{
+		Vector3 centroid;
+		Vector3 normal;
+		float area;
+	};
+
+	std::vector<ClusterInfo> clusters(clusterCount);
+	Vector3 meshCentroid = { 0, 0, 0 };
+	float meshArea = 0;
+
+	for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+	{
+		ClusterInfo info = { { 0, 0, 0 }, { 0, 0, 0 }, 0 };
+		for (uint32_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; triangle++)
+		{
+			Vector3 p0 = readPosition(positions, stride, indices[triangle * 3 + 0]);
+			Vector3 p1 = readPosition(positions, stride, indices[triangle * 3 + 1]);
+			Vector3 p2 = readPosition(positions, stride, indices[triangle * 3 + 2]);
+
+			Vector3 normal = cross(sub(p1, p0), sub(p2, p0));
+			float area = std::sqrt(dot(normal, normal));
+
+			info.centroid.x += (p0.x + p1.x + p2.x) * area;
+			info.centroid.y += (p0.y + p1.y + p2.y) * area;
+			info.centroid.z += (p0.z + p1.z + p2.z) * area;
+			info.normal.x += normal.x;
+			info.normal.y += normal.y;
+			info.normal.z += normal.z;
+			info.area += area;
+		}
+
+		meshCentroid.x += info.centroid.x;
+		meshCentroid.y += info.centroid.y;
+		meshCentroid.z += info.centroid.z;
+		meshArea += info.area;
+
+		float inverseArea = info.area > 0 ? 1.0f / (3 * info.area) : 0;
+		info.centroid = { info.centroid.x * inverseArea, info.centroid.y * inverseArea, info.centroid.z * inverseArea };
+		clusters[cluster] = info;
+	}
+
+	float inverseMeshArea = meshArea > 0 ? 1.0f / (3 * meshArea) : 0;
+	meshCentroid = { meshCentroid.x * inverseMeshArea, meshCentroid.y * inverseMeshArea, meshCentroid.z * inverseMeshArea };
+
+	// Lower sort keys gets drawn first, Back facing clusters can only be occluded so they go after all front facing ones
+	std::vector<std::pair<bool, float>> sortKeys(clusterCount);
+	const Vector3 viewPosition = { settings.viewPosition[0], settings.viewPosition[1], settings.viewPosition[2] };
+	for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+	{
+		const ClusterInfo& info = clusters[cluster];
+		float normalLength = std::sqrt(dot(info.normal, info.normal));
+		Vector3 normal = normalLength > 0 ? Vector3{ info.normal.x / normalLength, info.normal.y / normalLength, info.normal.z / normalLength } :
+			Vector3{ 0, 0, 0 };
+
+		if (settings.bUseViewPosition)
+		{
+			Vector3 toView = sub(viewPosition, info.centroid);
+			sortKeys[cluster] = { dot(normal, toView) < 0, std::sqrt(dot(toView, toView)) };
+		}
+		else
+		{
+			// Clusters far out along their normal are likely to occlude the rest from most view points
+			sortKeys[cluster] = { false, -dot(sub(info.centroid, meshCentroid), normal) };
+		}
+	}
+
+	std::vector<uint32_t> clusterOrder(clusterCount);
+	for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+	{
+		clusterOrder[cluster] = cluster;
+	}
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t a, uint32_t b)
+	{
+		return sortKeys[a] < sortKeys[b];
+	});
+
+	std::vector<uint32_t> sorted;
+	sorted.reserve(indices.size());
+	for (uint32_t cluster : clusterOrder)
+	{
+		sorted.insert(sorted.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+	}
+	indices.swap(sorted);
+
+	return clusterCount;
+}
+
+size_t vulkan::MeshOptimizer::optimizeVertexFetch(uint8_t* vertexData, size_t vertexCount, uint32_t stride, std::vector<uint32_t>& indices)
+{
+	std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+	uint32_t usedVertexCount = 0;
+
+	for (uint32_t& vertexIndex : indices)
+	{
+		if (remap[vertexIndex] == INVALID_INDEX)
+		{
+			remap[vertexIndex] = usedVertexCount++;
+		}
+		vertexIndex = remap[vertexIndex];
+	}
+
+	std::vector<uint8_t> reordered((size_t)usedVertexCount * stride);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		if (remap[i] != INVALID_INDEX)
+		{
+			memcpy(reordered.data() + (size_t)remap[i] * stride, vertexData + i * stride, stride);
+		}
+	}
+	memcpy(vertexData, reordered.data(), reordered.size());
+
+	return usedVertexCount;
+}
+
+vulkan::MeshOptimizationReport vulkan::MeshOptimizer::optimize(uint8_t* vertexData, size_t vertexCount, uint32_t stride, uint32_t positionOffset,
+	std::vector<uint32_t>& indices, const MeshOptimizerSettings& settings)
+{
+	MeshOptimizationReport report;
+	report.before = analyzeVertexCache(indices, vertexCount, settings.cacheSize);
+
+	std::vector<uint32_t> hardClusters;
+	optimizeVertexCache(indices, vertexCount, settings.cacheSize, &hardClusters);
+	report.clusterCount = optimizeOverdraw(indices, vertexData + positionOffset, vertexCount, stride, hardClusters, settings);
+	report.vertexCount = optimizeVertexFetch(vertexData, vertexCount, stride, indices);
+
+	report.after = analyzeVertexCache(indices, report.vertexCount, settings.cacheSize);
+	return report;
+}
+
+uint64_t vulkan::MeshOptimizer::hashSettings(const MeshOptimizerSettings& settings)
+{
+	uint64_t hash = ContentHash::hashValue(settings.cacheSize);
+	hash = ContentHash::combine(hash, ContentHash::hashValue(settings.overdrawThreshold));
+	if (settings.bUseViewPosition)
+	{
+		hash = ContentHash::combine(hash, ContentHash::hashBytes(settings.viewPosition, sizeof(settings.viewPosition)));
+	}
+	return hash;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vulkan
+{
+	// Results of simulating FIFO post transform vertex cache over an index stream
+	struct VertexCacheStatistics
+	{
+		uint32_t vertexTransforms = 0;
+		// Average cache miss ratio, Transformed vertices per triangle
+		float acmr = 0;
+		// Average transform to vertex ratio, Transformed vertices per unique vertex
+		float atvr = 0;
+	};
+
+	struct MeshOptimizerSettings
+	{
+		uint32_t cacheSize = 16;
+		// Clusters gets cut only where their own ACMR stays within this factor of the cache optimized mesh
+		float overdrawThreshold = 1.05f;
+		// When set clusters are sorted front to back from this position, Otherwise from outside to inside of the mesh
+		bool bUseViewPosition = false;
+		float viewPosition[3] = {};
+	};
+
+	struct MeshOptimizationReport
+	{
+		VertexCacheStatistics before;
+		VertexCacheStatistics after;
+		uint32_t clusterCount = 0;
+		size_t vertexCount = 0;
+	};
+
+	// Reorders triangle lists for post transform vertex cache reuse, early depth rejection and vertex fetch locality
+	class MeshOptimizer
+	{
+	public:
+		static VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize);
+
+		// Tipsify triangle reordering, Start triangle of every cluster that begun with a cold cache is appended to outClusters
+		static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* outClusters = nullptr);
+
+		// Splits cache optimized clusters further where it costs little cache efficiency and sorts clusters to reduce overdraw
+		static uint32_t optimizeOverdraw(std::vector<uint32_t>& indices, const uint8_t* positions, size_t vertexCount, uint32_t stride,
+			const std::vector<uint32_t>& hardClusters, const MeshOptimizerSettings& settings);
+
+		// Reorders vertices in order of first use by indices and drops unused ones, Returns new vertex count
+		static size_t optimizeVertexFetch(uint8_t* vertexData, size_t vertexCount, uint32_t stride, std::vector<uint32_t>& indices);
+
+		// Runs all optimizations in order, positionOffset is byte offset of 3 float position inside each vertex
+		static MeshOptimizationReport optimize(uint8_t* vertexData, size_t vertexCount, uint32_t stride, uint32_t positionOffset,
+			std::vector<uint32_t>& indices, const MeshOptimizerSettings& settings);
+
+		// Hash of everything in settings that changes the optimized result
+		static uint64_t hashSettings(const MeshOptimizerSettings& settings);
+	};
+}
@@ -0,0 +1,330 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "ContentHash.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_set>
+
+namespace
+{
+	// Passes collapse an independent set of edges each, Bounds the number of passes when conflicts leave only few collapses per pass
+	const uint32_t MAX_COLLAPSE_PASSES = 64;
+	// Collapses of a pass may cost this much more than the one that would have reached the target on its own
+	const double PASS_ERROR_FACTOR = 1.5;
+
+	struct Vector3
+	{
+		double x, y, z;
+	};
+
+	Vector3 readPosition(const uint8_t* positions, uint32_t stride, uint32_t vertexIndex)
+	{
+		float position[3];
+		memcpy(position, positions + (size_t)vertexIndex * stride, sizeof(position));
+		return { position[0], position[1], position[2] };
+	}
+
+	Vector3 sub(const Vector3& a, const Vector3& b)
+	{
+		return { a.x - b.x, a.y - b.y, a.z - b.z };
+	}
+
+	double dot(const Vector3& a, const Vector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	Vector3 cross(const Vector3& a, const Vector3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	uint64_t makeEdgeKey(uint32_t from, uint32_t to)
+	{
+		return (uint64_t(from) << 32) | to;
+	}
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double error;
+	};
+}
+
+void vulkan::MeshSimplifier::Quadric::addPlane(double nx, double ny, double nz, double d)
+{
+	a00 += nx * nx;
+	a01 += nx * ny;
+	a02 += nx * nz;
+	a11 += ny * ny;
+	a12 += ny * nz;
+	a22 += nz * nz;
+	b0 += nx * d;
+	b1 += ny * d;
+	b2 += nz * d;
+	c += d * d;
+}
+
+void vulkan::MeshSimplifier::Quadric::add(const Quadric& other)
+{
+	a00 += other.a00;
+	a01 += other.a01;
+	a02 += other.a02;
+	a11 += other.a11;
+	a12 += other.a12;
+	a22 += other.a22;
+	b0 += other.b0;
+	b1 += other.b1;
+	b2 += other.b2;
+	c += other.c;
+}
+
+double vulkan::MeshSimplifier::Quadric::evaluate(const float* position) const
+{
+	double x = position[0], y = position[1], z = position[2];
+	return a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+}
+
+std::vector<vulkan::MeshSimplifier::Quadric> vulkan::MeshSimplifier::computeQuadrics(const uint8_t* positions, size_t vertexCount, uint32_t stride,
+	const std::vector<uint32_t>& indices)
+{
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		Vector3 p0 = readPosition(positions, stride, indices[i]);
+		Vector3 normal = cross(sub(readPosition(positions, stride, indices[i + 1]), p0), sub(readPosition(positions, stride, indices[i + 2]), p0));
+		double length = std::sqrt(dot(normal, normal));
+		if (length == 0.0)
+		{
+			continue;
+		}
+
+		// Planes are unweighted so that quadric error stays a sum of squared distances
+		normal = { normal.x / length, normal.y / length, normal.z / length };
+		Quadric plane;
+		plane.addPlane(normal.x, normal.y, normal.z, -dot(normal, p0));
+		for (int corner = 0; corner < 3; corner++)
+		{
+			quadrics[indices[i + corner]].add(plane);
+		}
+	}
+	return quadrics;
+}
+
+float vulkan::MeshSimplifier::simplify(const uint8_t* positions, size_t vertexCount, uint32_t stride, std::vector<Quadric>& quadrics,
+	std::vector<uint32_t>& indices, size_t targetIndexCount)
+{
+	double maxError = 0.0;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<bool> bIsLocked(vertexCount);
+	std::vector<bool> bIsTouched(vertexCount);
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+	std::vector<uint32_t> vertexTriangles;
+	std::unordered_set<uint64_t> directedEdges;
+	std::vector<Collapse> collapses;
+
+	auto getPosition = [&](uint32_t vertexIndex)
+	{
+		return reinterpret_cast<const float*>(positions + (size_t)vertexIndex * stride);
+	};
+
+	for (uint32_t pass = 0; pass < MAX_COLLAPSE_PASSES && indices.size() > targetIndexCount; pass++)
+	{
+		size_t triangleCount = indices.size() / 3;
+
+		// Edge without a twin in opposite direction lies on an open border or a texture seam, Its vertices must stay
+		directedEdges.clear();
+		directedEdges.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				directedEdges.insert(makeEdgeKey(indices[i + corner], indices[i + (corner + 1) % 3]));
+			}
+		}
+
+		std::fill(bIsLocked.begin(), bIsLocked.end(), false);
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t a = indices[i + corner], b = indices[i + (corner + 1) % 3];
+				if (directedEdges.find(makeEdgeKey(b, a)) == directedEdges.end())
+				{
+					bIsLocked[a] = true;
+					bIsLocked[b] = true;
+				}
+			}
+		}
+
+		// Triangles around every vertex for flip checks
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (uint32_t index : indices)
+		{
+			triangleOffsets[index + 1]++;
+		}
+		std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+		vertexTriangles.resize(indices.size());
+		{
+			std::vector<uint32_t> fillOffsets(triangleOffsets.begin(), triangleOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				vertexTriangles[fillOffsets[indices[i]]++] = (uint32_t)(i / 3);
+			}
+		}
+
+		// Cheaper direction of every interior edge, Each one is visited once from its lower vertex
+		collapses.clear();
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t a = indices[i + corner], b = indices[i + (corner + 1) % 3];
+				if (a > b || (bIsLocked[a] && bIsLocked[b]))
+				{
+					continue;
+				}
+
+				Quadric edgeQuadric = quadrics[a];
+				edgeQuadric.add(quadrics[b]);
+				Collapse collapse = { a, b, bIsLocked[a] ? DBL_MAX : edgeQuadric.evaluate(getPosition(b)) };
+				if (!bIsLocked[b])
+				{
+					double reverseError = edgeQuadric.evaluate(getPosition(a));
+					if (reverseError < collapse.error)
+					{
+						collapse = { b, a, reverseError };
+					}
+				}
+				collapses.push_back(collapse);
+			}
+		}
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+		// Every interior collapse removes 2 triangles
+		size_t collapseGoal = (triangleCount - targetIndexCount / 3) / 2 + 1;
+		double errorLimit = collapses[std::min(collapseGoal, collapses.size()) - 1].error * PASS_ERROR_FACTOR;
+
+		std::iota(remap.begin(), remap.end(), 0);
+		std::fill(bIsTouched.begin(), bIsTouched.end(), false);
+		size_t performedCount = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (performedCount >= collapseGoal || collapse.error > errorLimit)
+			{
+				break;
+			}
+			if (bIsTouched[collapse.from] || bIsTouched[collapse.to])
+			{
+				continue;
+			}
+
+			// Rejecting collapses that turn a remaining triangle around the moved vertex upside down
+			bool bFlipsTriangle = false;
+			Vector3 target = readPosition(positions, stride, collapse.to);
+			for (uint32_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && !bFlipsTriangle; t++)
+			{
+				const uint32_t* triangle = &indices[(size_t)vertexTriangles[t] * 3];
+				uint32_t corners[3] = { remap[triangle[0]], remap[triangle[1]], remap[triangle[2]] };
+				if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to ||
+					corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+				{
+					continue;
+				}
+
+				Vector3 before[3], after[3];
+				for (int corner = 0; corner < 3; corner++)
+				{
+					before[corner] = readPosition(positions, stride, corners[corner]);
+					after[corner] = corners[corner] == collapse.from ? target : before[corner];
+				}
+				Vector3 normalBefore = cross(sub(before[1], before[0]), sub(before[2], before[0]));
+				Vector3 normalAfter = cross(sub(after[1], after[0]), sub(after[2], after[0]));
+				bFlipsTriangle = dot(normalBefore, normalAfter) <= 0.0;
+			}
+			if (bFlipsTriangle)
+			{
+				continue;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+			bIsTouched[collapse.from] = true;
+			bIsTouched[collapse.to] = true;
+			maxError = std::max(maxError, collapse.error);
+			performedCount++;
+		}
+		if (performedCount == 0)
+		{
+			break;
+		}
+
+		size_t writeIdx = 0;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+			if (a != b && b != c && a != c)
+			{
+				indices[writeIdx++] = a;
+				indices[writeIdx++] = b;
+				indices[writeIdx++] = c;
+			}
+		}
+		indices.resize(writeIdx);
+	}
+
+	return (float)std::sqrt(std::max(maxError, 0.0));
+}
+
+uint32_t vulkan::MeshSimplifier::buildLodChain(const uint8_t* positions, size_t vertexCount, uint32_t stride, std::vector<uint32_t>& indices,
+	const MeshSimplifierSettings& settings, MeshLod* lods)
+{
+	lods[0] = { 0, (uint32_t)indices.size(), 0.0f };
+	uint32_t lodCount = 1;
+
+	std::vector<Quadric> quadrics = computeQuadrics(positions, vertexCount, stride, indices);
+	std::vector<uint32_t> levelIndices = indices;
+	float error = 0.0f;
+	while (lodCount < std::min(settings.maxLodCount, MAX_MESH_LOD_COUNT))
+	{
+		size_t previousCount = levelIndices.size();
+		size_t targetCount = (size_t)(previousCount / 3 * settings.reductionRatio) * 3;
+		if (targetCount / 3 < settings.minTriangleCount)
+		{
+			break;
+		}
+
+		// Each level continues from the previous one with its accumulated quadrics, So errors only grow along the chain
+		error = std::max(error, simplify(positions, vertexCount, stride, quadrics, levelIndices, targetCount));
+
+		// Level that did not get half way to its target is mostly locked borders and seams, Coarser ones would not do better
+		if (levelIndices.size() > previousCount - (previousCount - targetCount) / 2)
+		{
+			break;
+		}
+
+		MeshOptimizer::optimizeVertexCache(levelIndices, vertexCount, settings.cacheSize);
+		lods[lodCount++] = { (uint32_t)indices.size(), (uint32_t)levelIndices.size(), error };
+		indices.insert(indices.end(), levelIndices.begin(), levelIndices.end());
+	}
+	return lodCount;
+}
+
+uint64_t vulkan::MeshSimplifier::hashSettings(const MeshSimplifierSettings& settings)
+{
+	uint64_t hash = ContentHash::hashValue(settings.reductionRatio);
+	hash = ContentHash::combine(hash, ContentHash::hashValue(settings.minTriangleCount));
+	hash = ContentHash::combine(hash, ContentHash::hashValue(settings.maxLodCount));
+	hash = ContentHash::combine(hash, ContentHash::hashValue(settings.cacheSize));
+	return hash;
+}
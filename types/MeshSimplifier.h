@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MeshCache.h"
+
+namespace vulkan
+{
+	struct MeshSimplifierSettings
+	{
+		// Every level aims at this fraction of triangles of the level before it
+		float reductionRatio = 0.5f;
+		// Chain ends below this many triangles or once a level gets stuck well above its target
+		uint32_t minTriangleCount = 64;
+		uint32_t maxLodCount = MAX_MESH_LOD_COUNT;
+		// Simplified levels are reordered for a vertex cache of this size
+		uint32_t cacheSize = 16;
+	};
+
+	// Quadric error edge collapse simplification, Vertices are collapsed onto neighbouring vertices so that every level shares the vertex stream.
+	// Vertices on open borders and texture seams never move so that simplified levels keep their outline and texture mapping
+	class MeshSimplifier
+	{
+	public:
+		// Sum of squared distances to a set of planes, Stored as symmetric 4x4 matrix
+		struct Quadric
+		{
+			double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+			double b0 = 0, b1 = 0, b2 = 0;
+			double c = 0;
+
+			void addPlane(double nx, double ny, double nz, double d);
+			void add(const Quadric& other);
+			double evaluate(const float* position) const;
+		};
+
+		// Collapses edges in order of error until indices are down to targetIndexCount or nothing can be collapsed,
+		// quadrics accumulates error of collapsed vertices between calls, Returns largest error of performed collapses as a distance
+		static float simplify(const uint8_t* positions, size_t vertexCount, uint32_t stride, std::vector<Quadric>& quadrics,
+			std::vector<uint32_t>& indices, size_t targetIndexCount);
+
+		// Plane quadrics of every vertex from triangles of indices
+		static std::vector<Quadric> computeQuadrics(const uint8_t* positions, size_t vertexCount, uint32_t stride, const std::vector<uint32_t>& indices);
+
+		// Appends simplified levels to indices and fills lods starting with the original triangles, Returns number of levels
+		static uint32_t buildLodChain(const uint8_t* positions, size_t vertexCount, uint32_t stride, std::vector<uint32_t>& indices,
+			const MeshSimplifierSettings& settings, MeshLod* lods);
+
+		// Hash of everything in settings that changes the simplified result
+		static uint64_t hashSettings(const MeshSimplifierSettings& settings);
+	};
+}
@@ -0,0 +1,505 @@
+#include "ObjReader.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	enum class Statement
+	{
+		Position,
+		TextureCoord,
+		Normal,
+		Face,
+		Other
+	};
+
+	// Powers of ten that are exactly representable as double
+	const double EXACT_POWERS_OF_TEN[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	bool isSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	const char* skipSpaces(const char* text, const char* end)
+	{
+		while (text < end && isSpace(*text))
+		{
+			text++;
+		}
+		return text;
+	}
+
+	const char* skipToken(const char* text, const char* end)
+	{
+		while (text < end && !isSpace(*text))
+		{
+			text++;
+		}
+		return text;
+	}
+
+	const char* findLineEnd(const char* text, const char* end)
+	{
+		const char* newLine = static_cast<const char*>(memchr(text, '\n', end - text));
+		return newLine ? newLine : end;
+	}
+
+	// Reads statement keyword of line and moves text past it
+	Statement readStatement(const char*& text, const char* lineEnd)
+	{
+		text = skipSpaces(text, lineEnd);
+		size_t length = skipToken(text, lineEnd) - text;
+
+		Statement statement = Statement::Other;
+		if (length == 1 && text[0] == 'v')
+		{
+			statement = Statement::Position;
+		}
+		else if (length == 2 && text[0] == 'v' && text[1] == 't')
+		{
+			statement = Statement::TextureCoord;
+		}
+		else if (length == 2 && text[0] == 'v' && text[1] == 'n')
+		{
+			statement = Statement::Normal;
+		}
+		else if (length == 1 && text[0] == 'f')
+		{
+			statement = Statement::Face;
+		}
+
+		text += length;
+		return statement;
+	}
+
+	// Integers with more digits than this are parse errors, Way past any index or exponent that could be valid
+	const int64_t MAX_PARSED_INT = 999999999999999999;
+
+	const char* parseInt(const char* text, const char* end, int64_t& value)
+	{
+		bool bIsNegative = false;
+		if (text < end && (*text == '-' || *text == '+'))
+		{
+			bIsNegative = *text == '-';
+			text++;
+		}
+
+		if (text == end || !isDigit(*text))
+		{
+			return nullptr;
+		}
+
+		value = 0;
+		while (text < end && isDigit(*text))
+		{
+			if (value > (MAX_PARSED_INT - (*text - '0')) / 10)
+			{
+				return nullptr;
+			}
+			value = value * 10 + (*text - '0');
+			text++;
+		}
+		value = bIsNegative ? -value : value;
+		return text;
+	}
+
+	// OBJ indices are one based, Negative ones are relative to attributes read so far
+	bool resolveIndex(int64_t value, uint64_t readCount, uint64_t totalCount, int32_t& index)
+	{
+		int64_t resolved = value > 0 ? value - 1 : (int64_t)readCount + value;
+		if (value == 0 || resolved < 0 || resolved >= (int64_t)totalCount)
+		{
+			return false;
+		}
+		index = (int32_t)resolved;
+		return true;
+	}
+}
+
+const char* vulkan::ObjReader::parseFloat(const char* text, const char* end, float& value)
+{
+	const char* current = text;
+	bool bIsNegative = false;
+	if (current < end && (*current == '-' || *current == '+'))
+	{
+		bIsNegative = *current == '-';
+		current++;
+	}
+
+	// Up to 19 significant digits are kept, which is way past float precision
+	uint64_t mantissa = 0;
+	int32_t exponent = 0;
+	bool bHasDigits = false;
+	while (current < end && isDigit(*current))
+	{
+		if (mantissa < 1000000000000000000ull)
+		{
+			mantissa = mantissa * 10 + (*current - '0');
+		}
+		else
+		{
+			exponent++;
+		}
+		bHasDigits = true;
+		current++;
+	}
+
+	if (current < end && *current == '.')
+	{
+		current++;
+		while (current < end && isDigit(*current))
+		{
+			if (mantissa < 1000000000000000000ull)
+			{
+				mantissa = mantissa * 10 + (*current - '0');
+				exponent--;
+			}
+			bHasDigits = true;
+			current++;
+		}
+	}
+
+	if (!bHasDigits)
+	{
+		// Rare forms like inf and nan goes through strtof on a null terminated copy
+		char token[64];
+		size_t length = std::min<size_t>(skipToken(text, end) - text, sizeof(token) - 1);
+		memcpy(token, text, length);
+		token[length] = 0;
+
+		char* parsedEnd;
+		value = strtof(token, &parsedEnd);
+		return parsedEnd == token ? nullptr : text + (parsedEnd - token);
+	}
+
+	if (current < end && (*current == 'e' || *current == 'E'))
+	{
+		const char* exponentDigits = current + 1;
+		if (exponentDigits < end && (*exponentDigits == '-' || *exponentDigits == '+'))
+		{
+			exponentDigits++;
+		}
+
+		// An e without digits after it is not part of the number
+		if (exponentDigits < end && isDigit(*exponentDigits))
+		{
+			int64_t exponentPart;
+			current = parseInt(current + 1, end, exponentPart);
+			if (!current)
+			{
+				return nullptr;
+			}
+			exponent += (int32_t)std::max<int64_t>(std::min<int64_t>(exponentPart, 1000), -1000);
+		}
+	}
+
+	// Mantissa below 2^53 scaled by an exact power of ten is correctly rounded, Other cases are within an ulp of double
+	double result = (double)mantissa;
+	if (exponent < 0 && exponent >= -22)
+	{
+		result /= EXACT_POWERS_OF_TEN[-exponent];
+	}
+	else if (exponent > 0 && exponent <= 22)
+	{
+		result *= EXACT_POWERS_OF_TEN[exponent];
+	}
+	else if (exponent != 0)
+	{
+		result *= std::pow(10.0, (double)exponent);
+	}
+
+	value = (float)(bIsNegative ? -result : result);
+	return current;
+}
+
+void vulkan::ObjReader::countChunk(const char* begin, const char* end, ChunkCounts& counts)
+{
+	const char* lineBegin = begin;
+	while (lineBegin < end)
+	{
+		const char* lineEnd = findLineEnd(lineBegin, end);
+		const char* text = lineBegin;
+
+		switch (readStatement(text, lineEnd))
+		{
+		case Statement::Position:
+			counts.positions++;
+			break;
+		case Statement::TextureCoord:
+			counts.textureCoords++;
+			break;
+		case Statement::Normal:
+			counts.normals++;
+			break;
+		case Statement::Face:
+		{
+			// Polygons are triangulated as fans
+			uint64_t cornerCount = 0;
+			for (text = skipSpaces(text, lineEnd); text < lineEnd; text = skipSpaces(skipToken(text, lineEnd), lineEnd))
+			{
+				cornerCount++;
+			}
+			counts.indices += cornerCount >= 3 ? (cornerCount - 2) * 3 : 0;
+			break;
+		}
+		default:
+			break;
+		}
+
+		counts.lines++;
+		lineBegin = lineEnd + 1;
+	}
+}
+
+bool vulkan::ObjReader::parseChunk(const char* begin, const char* end, const ChunkCounts& base, const ChunkCounts& totals, ObjData& data,
+	std::string& error)
+{
+	ChunkCounts read = base;
+	std::vector<ObjIndex> faceCorners;
+
+	auto fail = [&](const char* message)
+	{
+		error = "OBJ line " + std::to_string(read.lines + 1) + " : " + message;
+		return false;
+	};
+
+	auto parseFloats = [&](const char* text, const char* lineEnd, float* values, uint32_t requiredCount, uint32_t maxCount)
+	{
+		uint32_t count = 0;
+		for (text = skipSpaces(text, lineEnd); text < lineEnd && count < maxCount; text = skipSpaces(text, lineEnd))
+		{
+			text = parseFloat(text, lineEnd, values[count]);
+			if (!text)
+			{
+				return false;
+			}
+			count++;
+		}
+		for (uint32_t i = count; i < maxCount; i++)
+		{
+			values[i] = 0.0f;
+		}
+		return count >= requiredCount;
+	};
+
+	const char* lineBegin = begin;
+	while (lineBegin < end)
+	{
+		const char* lineEnd = findLineEnd(lineBegin, end);
+		const char* text = lineBegin;
+
+		switch (readStatement(text, lineEnd))
+		{
+		case Statement::Position:
+			// Optional w and vertex colors after the 3 coordinates are ignored
+			if (!parseFloats(text, lineEnd, &data.positions[read.positions * 3], 3, 3))
+			{
+				return fail("Expected 3 position coordinates");
+			}
+			read.positions++;
+			break;
+		case Statement::TextureCoord:
+			if (!parseFloats(text, lineEnd, &data.textureCoords[read.textureCoords * 2], 1, 2))
+			{
+				return fail("Expected texture coordinates");
+			}
+			read.textureCoords++;
+			break;
+		case Statement::Normal:
+			if (!parseFloats(text, lineEnd, &data.normals[read.normals * 3], 3, 3))
+			{
+				return fail("Expected 3 normal coordinates");
+			}
+			read.normals++;
+			break;
+		case Statement::Face:
+		{
+			faceCorners.clear();
+			for (text = skipSpaces(text, lineEnd); text < lineEnd; text = skipSpaces(text, lineEnd))
+			{
+				// Corners are v, v/vt, v//vn or v/vt/vn
+				ObjIndex corner = { -1, -1, -1 };
+				int64_t value;
+
+				text = parseInt(text, lineEnd, value);
+				if (!text || !resolveIndex(value, read.positions, totals.positions, corner.position))
+				{
+					return fail("Invalid position index in face");
+				}
+
+				if (text < lineEnd && *text == '/')
+				{
+					text++;
+					if (text < lineEnd && *text != '/')
+					{
+						text = parseInt(text, lineEnd, value);
+						if (!text || !resolveIndex(value, read.textureCoords, totals.textureCoords, corner.textureCoord))
+						{
+							return fail("Invalid texture coordinate index in face");
+						}
+					}
+
+					if (text < lineEnd && *text == '/')
+					{
+						text = parseInt(text + 1, lineEnd, value);
+						if (!text || !resolveIndex(value, read.normals, totals.normals, corner.normal))
+						{
+							return fail("Invalid normal index in face");
+						}
+					}
+				}
+
+				if (text < lineEnd && !isSpace(*text))
+				{
+					return fail("Unexpected character in face");
+				}
+				faceCorners.push_back(corner);
+			}
+
+			if (faceCorners.size() < 3)
+			{
+				return fail("Face has less than 3 corners");
+			}
+
+			ObjIndex* outIndices = &data.indices[read.indices];
+			for (size_t i = 2; i < faceCorners.size(); i++)
+			{
+				*outIndices++ = faceCorners[0];
+				*outIndices++ = faceCorners[i - 1];
+				*outIndices++ = faceCorners[i];
+			}
+			read.indices += (faceCorners.size() - 2) * 3;
+			break;
+		}
+		default:
+			break;
+		}
+
+		read.lines++;
+		lineBegin = lineEnd + 1;
+	}
+	return true;
+}
+
+bool vulkan::ObjReader::read(const std::string& path, ObjData& data, std::string& error, uint32_t threadCount)
+{
+	MappedFile file;
+	if (!file.open(path))
+	{
+		error = "Failed to open " + path;
+		return false;
+	}
+	return parse(reinterpret_cast<const char*>(file.data()), file.size(), data, error, threadCount);
+}
+
+bool vulkan::ObjReader::parse(const char* text, size_t size, ObjData& data, std::string& error, uint32_t threadCount)
+{
+	data = ObjData();
+	if (size == 0)
+	{
+		return true;
+	}
+
+	if (threadCount == 0)
+	{
+		threadCount = size >= PARALLEL_PARSE_THRESHOLD ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+	}
+	uint32_t chunkCount = (uint32_t)std::max<size_t>(1, std::min<size_t>(threadCount, size / MIN_CHUNK_SIZE));
+
+	// Chunks starts right after a new line so that no line is split between two chunks
+	const char* end = text + size;
+	std::vector<const char*> chunkStarts(chunkCount + 1);
+	chunkStarts[0] = text;
+	chunkStarts[chunkCount] = end;
+	for (uint32_t chunk = 1; chunk < chunkCount; chunk++)
+	{
+		const char* start = std::max(text + size * chunk / chunkCount, chunkStarts[chunk - 1]);
+		if (start > text && start < end && start[-1] != '\n')
+		{
+			start = std::min(findLineEnd(start, end) + 1, end);
+		}
+		chunkStarts[chunk] = start;
+	}
+
+	auto runParallel = [chunkCount](auto&& function)
+	{
+		if (chunkCount == 1)
+		{
+			function(0);
+			return;
+		}
+
+		std::vector<std::thread> workers;
+		workers.reserve(chunkCount);
+		for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			workers.emplace_back(function, chunk);
+		}
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	};
+
+	std::vector<ChunkCounts> chunkCounts(chunkCount);
+	runParallel([&](uint32_t chunk)
+	{
+		countChunk(chunkStarts[chunk], chunkStarts[chunk + 1], chunkCounts[chunk]);
+	});
+
+	// Output of every chunk starts where the ones before it ends
+	std::vector<ChunkCounts> chunkBases(chunkCount);
+	ChunkCounts totals;
+	for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		chunkBases[chunk] = totals;
+		totals.positions += chunkCounts[chunk].positions;
+		totals.textureCoords += chunkCounts[chunk].textureCoords;
+		totals.normals += chunkCounts[chunk].normals;
+		totals.indices += chunkCounts[chunk].indices;
+		totals.lines += chunkCounts[chunk].lines;
+	}
+
+	if (std::max({ totals.positions, totals.textureCoords, totals.normals }) > (uint64_t)INT32_MAX)
+	{
+		error = "OBJ has more attributes than 32 bit indices can address";
+		return false;
+	}
+
+	data.positions.resize((size_t)totals.positions * 3);
+	data.textureCoords.resize((size_t)totals.textureCoords * 2);
+	data.normals.resize((size_t)totals.normals * 3);
+	data.indices.resize((size_t)totals.indices);
+
+	std::vector<std::string> chunkErrors(chunkCount);
+	std::vector<char> chunkResults(chunkCount, 0);
+	runParallel([&](uint32_t chunk)
+	{
+		chunkResults[chunk] = parseChunk(chunkStarts[chunk], chunkStarts[chunk + 1], chunkBases[chunk], totals, data, chunkErrors[chunk]);
+	});
+
+	for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		if (!chunkResults[chunk])
+		{
+			error = chunkErrors[chunk];
+			data = ObjData();
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vulkan
+{
+	// Zero based attribute indices of a face corner, -1 when corner has no such attribute
+	struct ObjIndex
+	{
+		int32_t position;
+		int32_t textureCoord;
+		int32_t normal;
+	};
+
+	// Attributes and triangulated face corners of an OBJ file, Every 3 indices make a triangle
+	struct ObjData
+	{
+		std::vector<float> positions;
+		std::vector<float> textureCoords;
+		std::vector<float> normals;
+		std::vector<ObjIndex> indices;
+	};
+
+	// Memory mapped OBJ reader that splits file at line boundaries and parses chunks in parallel.
+	// Only geometry statements v, vt, vn and f are read, Everything else like groups and materials is skipped
+	class ObjReader
+	{
+	private:
+		// Files smaller than this are parsed on calling thread when threadCount is 0
+		static const size_t PARALLEL_PARSE_THRESHOLD = 4 << 20;
+		// Lower bound of chunk size so that small files are not split into more chunks than worth it
+		static const size_t MIN_CHUNK_SIZE = 256 << 10;
+
+		struct ChunkCounts
+		{
+			uint64_t positions = 0;
+			uint64_t textureCoords = 0;
+			uint64_t normals = 0;
+			uint64_t indices = 0;
+			uint64_t lines = 0;
+		};
+
+		// First pass, Counts statements of chunk so that every chunk knows where its output starts
+		static void countChunk(const char* begin, const char* end, ChunkCounts& counts);
+
+		// Second pass, Parses chunk straight into its range of output arrays
+		static bool parseChunk(const char* begin, const char* end, const ChunkCounts& base, const ChunkCounts& totals, ObjData& data,
+			std::string& error);
+
+	public:
+		// Returns false and sets error when file cannot be opened or is malformed, threadCount of 0 picks it based on file size
+		static bool read(const std::string& path, ObjData& data, std::string& error, uint32_t threadCount = 0);
+
+		static bool parse(const char* text, size_t size, ObjData& data, std::string& error, uint32_t threadCount = 0);
+
+		// Parses decimal number at text, Returns pointer past it or nullptr when there is no number
+		static const char* parseFloat(const char* text, const char* end, float& value);
+	};
+}
@@ -0,0 +1,452 @@
+#include "PoseSource.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+	// Axis scaled by angle of rotation, Shorter way around
+	glm::vec3 toRotationVector(const glm::quat& rotation)
+	{
+		glm::quat q = rotation.w < 0.0f ? -rotation : rotation;
+		glm::vec3 v(q.x, q.y, q.z);
+		float sine = glm::length(v);
+		if (sine < 1e-7f)
+		{
+			return 2.0f * v;
+		}
+		return v * (2.0f * std::atan2(sine, q.w) / sine);
+	}
+
+	glm::quat fromRotationVector(const glm::vec3& rotationVector)
+	{
+		float angle = glm::length(rotationVector);
+		if (angle < 1e-7f)
+		{
+			return glm::normalize(glm::quat(1.0f, 0.5f * rotationVector.x, 0.5f * rotationVector.y, 0.5f * rotationVector.z));
+		}
+		return glm::angleAxis(angle, rotationVector / angle);
+	}
+
+	bool isSampleEarlier(double time, const vulkan::PoseSample& sample)
+	{
+		return time < sample.time;
+	}
+}
+
+glm::mat4 vulkan::Pose::getTransform() const
+{
+	return glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(orientation);
+}
+
+void vulkan::PoseError::add(const Pose& pose, const Pose& truePose)
+{
+	double positionError = glm::length(pose.position - truePose.position);
+	double angleError = glm::degrees(glm::length(toRotationVector(pose.orientation * glm::conjugate(truePose.orientation))));
+
+	count++;
+	positionSum += positionError;
+	positionMax = std::max(positionMax, positionError);
+	angleSum += angleError;
+	angleMax = std::max(angleMax, angleError);
+}
+
+vulkan::TrajectoryPoseSource::TrajectoryPoseSource(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Unable to open pose trajectory " + path);
+	}
+
+	std::string line;
+	for (uint32_t lineNumber = 1; std::getline(file, line); lineNumber++)
+	{
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == std::string::npos || line[start] == '#')
+		{
+			continue;
+		}
+
+		PoseSample sample;
+		glm::vec3& p = sample.pose.position;
+		glm::quat& q = sample.pose.orientation;
+		std::istringstream values(line);
+		if (!(values >> sample.time >> p.x >> p.y >> p.z >> q.w >> q.x >> q.y >> q.z))
+		{
+			throw std::runtime_error("Malformed pose sample on line " + std::to_string(lineNumber) + " of " + path);
+		}
+		q = glm::normalize(q);
+		samples.push_back(sample);
+	}
+	init();
+}
+
+vulkan::TrajectoryPoseSource::TrajectoryPoseSource(std::vector<PoseSample> samples) : samples(std::move(samples))
+{
+	init();
+}
+
+void vulkan::TrajectoryPoseSource::init()
+{
+	if (samples.size() < 2)
+	{
+		throw std::runtime_error("Pose trajectory needs at least 2 samples");
+	}
+
+	double startTime = samples.front().time;
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		samples[i].time -= startTime;
+		if (i > 0 && samples[i].time <= samples[i - 1].time)
+		{
+			throw std::runtime_error("Pose trajectory samples are not in increasing time order");
+		}
+	}
+	duration = samples.back().time + samples.back().time / (samples.size() - 1);
+}
+
+vulkan::PoseSample vulkan::TrajectoryPoseSource::getLoopSample(int64_t loop, size_t index) const
+{
+	PoseSample sample = samples[index];
+	sample.time += loop * duration;
+	sample.bIsDiscontinuous = loop > 0 && index == 0;
+	return sample;
+}
+
+bool vulkan::TrajectoryPoseSource::getLatestSample(double now, PoseSample& sample) const
+{
+	if (now < 0.0)
+	{
+		return false;
+	}
+
+	int64_t loop = (int64_t)std::floor(now / duration);
+	double loopTime = std::max(now - loop * duration, 0.0);
+	size_t index = std::upper_bound(samples.begin(), samples.end(), loopTime, isSampleEarlier) - samples.begin() - 1;
+	sample = getLoopSample(loop, index);
+	return true;
+}
+
+bool vulkan::TrajectoryPoseSource::getNextSample(double after, double now, PoseSample& sample) const
+{
+	int64_t loop = 0;
+	size_t index = 0;
+	if (after >= 0.0)
+	{
+		loop = (int64_t)std::floor(after / duration);
+		index = std::upper_bound(samples.begin(), samples.end(), after - loop * duration, isSampleEarlier) - samples.begin();
+	}
+
+	// Moving time into the loop can round it below the sample it came from
+	while (true)
+	{
+		if (index == samples.size())
+		{
+			loop++;
+			index = 0;
+		}
+		sample = getLoopSample(loop, index);
+		if (sample.time > after)
+		{
+			break;
+		}
+		index++;
+	}
+	return sample.time <= now;
+}
+
+vulkan::Pose vulkan::TrajectoryPoseSource::getPose(double now, double displayTime)
+{
+	PoseSample sample;
+	return getLatestSample(now, sample) ? sample.pose : Pose();
+}
+
+vulkan::Pose vulkan::TrajectoryPoseSource::getTruePose(double time) const
+{
+	int64_t loop = (int64_t)std::floor(std::max(time, 0.0) / duration);
+	double loopTime = std::max(time - loop * duration, 0.0);
+	size_t index = std::upper_bound(samples.begin(), samples.end(), loopTime, isSampleEarlier) - samples.begin() - 1;
+
+	// Last sample is held until replay starts over
+	const PoseSample& sample = samples[index];
+	if (index + 1 == samples.size())
+	{
+		return sample.pose;
+	}
+	const PoseSample& nextSample = samples[index + 1];
+	float fraction = (float)glm::clamp((loopTime - sample.time) / (nextSample.time - sample.time), 0.0, 1.0);
+
+	Pose pose;
+	pose.position = glm::mix(sample.pose.position, nextSample.pose.position, fraction);
+	pose.orientation = glm::slerp(sample.pose.orientation, nextSample.pose.orientation, fraction);
+	return pose;
+}
+
+void vulkan::TrajectoryPoseSource::save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Unable to write pose trajectory to " + path);
+	}
+
+	file << "# time px py pz qw qx qy qz" << std::endl;
+	file.precision(9);
+	for (const PoseSample& sample : samples)
+	{
+		const glm::vec3& p = sample.pose.position;
+		const glm::quat& q = sample.pose.orientation;
+		file << sample.time << " " << p.x << " " << p.y << " " << p.z << " " << q.w << " " << q.x << " " << q.y << " " << q.z << "\n";
+	}
+}
+
+std::vector<vulkan::PoseSample> vulkan::TrajectoryPoseSource::generateHeadMotion(double seconds, double sampleRate, uint32_t seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::normal_distribution<float> positionNoise(0.0f, 0.01f);
+	std::normal_distribution<float> orientationNoise(0.0f, 0.0005f);
+
+	// Turns toward a new yaw take 0.15 to 0.35 seconds and come every 0.8 to 2 seconds
+	double turnStart = 0.5, turnLength = 0.25;
+	double turnFromYaw = 0.0, turnToYaw = glm::radians(40.0);
+
+	std::vector<PoseSample> samples((size_t)(seconds * sampleRate));
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		double time = i / sampleRate;
+		if (time > turnStart + turnLength)
+		{
+			turnFromYaw = turnToYaw;
+			turnToYaw = glm::radians(-60.0 + 120.0 * uniform(random));
+			turnStart = time + 0.8 + 1.2 * uniform(random);
+			turnLength = 0.15 + 0.2 * uniform(random);
+		}
+		double turn = glm::clamp((time - turnStart) / turnLength, 0.0, 1.0);
+		double yaw = glm::mix(turnFromYaw, turnToYaw, turn * turn * (3.0 - 2.0 * turn)) + glm::radians(5.0) * std::sin(time * 1.3);
+		double pitch = glm::radians(10.0) * std::sin(time * 0.7) + glm::radians(3.0) * std::sin(time * 2.9);
+
+		PoseSample& sample = samples[i];
+		sample.time = time;
+		sample.pose.position = glm::vec3(2.0f * std::sin(time * 0.9), 1.0f * std::sin(time * 1.7), 1.5f * std::sin(time * 0.4)) +
+			glm::vec3(positionNoise(random), positionNoise(random), positionNoise(random));
+		glm::quat orientation = glm::angleAxis((float)yaw, glm::vec3(0, 1, 0)) * glm::angleAxis((float)pitch, glm::vec3(1, 0, 0));
+		sample.pose.orientation = glm::normalize(fromRotationVector(glm::vec3(orientationNoise(random), orientationNoise(random),
+			orientationNoise(random))) * orientation);
+	}
+	return samples;
+}
+
+void vulkan::PosePredictor::KalmanAxis::predict(double deltaTime, double processNoise)
+{
+	value += rate * deltaTime;
+
+	double (&p)[2][2] = covariance;
+	double dt = deltaTime;
+	p[0][0] += dt * (p[0][1] + p[1][0]) + dt * dt * p[1][1] + processNoise * dt * dt * dt / 3.0;
+	p[0][1] += dt * p[1][1] + processNoise * dt * dt / 2.0;
+	p[1][0] += dt * p[1][1] + processNoise * dt * dt / 2.0;
+	p[1][1] += processNoise * dt;
+}
+
+void vulkan::PosePredictor::KalmanAxis::update(double measurement, double measurementNoise)
+{
+	double (&p)[2][2] = covariance;
+	double innovationVariance = p[0][0] + measurementNoise * measurementNoise;
+	double valueGain = p[0][0] / innovationVariance;
+	double rateGain = p[1][0] / innovationVariance;
+	double innovation = measurement - value;
+
+	value += valueGain * innovation;
+	rate += rateGain * innovation;
+
+	double p00 = p[0][0], p01 = p[0][1];
+	p[0][0] -= valueGain * p00;
+	p[0][1] -= valueGain * p01;
+	p[1][0] -= rateGain * p00;
+	p[1][1] -= rateGain * p01;
+}
+
+vulkan::PosePredictor::PosePredictor(const PoseSource& tracker, Model model) : PosePredictor(tracker, model, KalmanSettings())
+{
+}
+
+vulkan::PosePredictor::PosePredictor(const PoseSource& tracker, Model model, const KalmanSettings& kalmanSettings)
+	: tracker(tracker), model(model), kalmanSettings(kalmanSettings)
+{
+}
+
+bool vulkan::PosePredictor::getLatestSample(double now, PoseSample& sample) const
+{
+	return tracker.getLatestSample(now, sample);
+}
+
+bool vulkan::PosePredictor::getNextSample(double after, double now, PoseSample& sample) const
+{
+	return tracker.getNextSample(after, now, sample);
+}
+
+const char* vulkan::PosePredictor::getModelName(Model model)
+{
+	switch (model)
+	{
+	case Model::ConstantVelocity:
+		return "Constant velocity";
+	case Model::ConstantAcceleration:
+		return "Constant acceleration";
+	case Model::Kalman:
+		return "Kalman";
+	}
+	return "Unknown";
+}
+
+void vulkan::PosePredictor::reset(const PoseSample& sample)
+{
+	bHasSample = true;
+	history[0] = sample;
+	sampleCount = 1;
+
+	double positionVariance = kalmanSettings.positionNoise * kalmanSettings.positionNoise;
+	double orientationVariance = kalmanSettings.orientationNoise * kalmanSettings.orientationNoise;
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		positionAxes[axis] = KalmanAxis();
+		positionAxes[axis].value = sample.pose.position[axis];
+		positionAxes[axis].covariance[0][0] = positionVariance;
+		positionAxes[axis].covariance[1][1] = 100.0;
+
+		rotationAxes[axis] = KalmanAxis();
+		rotationAxes[axis].covariance[0][0] = orientationVariance;
+		rotationAxes[axis].covariance[1][1] = 100.0;
+	}
+	filteredOrientation = sample.pose.orientation;
+	filterTime = sample.time;
+}
+
+void vulkan::PosePredictor::addSample(const PoseSample& sample)
+{
+	history[sampleCount % HISTORY_SIZE] = sample;
+	sampleCount++;
+
+	if (model != Model::Kalman)
+	{
+		return;
+	}
+
+	double deltaTime = sample.time - filterTime;
+	filterTime = sample.time;
+
+	glm::vec3 rotation = toRotationVector(sample.pose.orientation * glm::conjugate(filteredOrientation));
+	glm::vec3 filteredRotation;
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		positionAxes[axis].predict(deltaTime, kalmanSettings.positionAcceleration);
+		positionAxes[axis].update(sample.pose.position[axis], kalmanSettings.positionNoise);
+
+		rotationAxes[axis].predict(deltaTime, kalmanSettings.angularAcceleration);
+		rotationAxes[axis].update(rotation[axis], kalmanSettings.orientationNoise);
+		filteredRotation[axis] = (float)rotationAxes[axis].value;
+		rotationAxes[axis].value = 0.0;
+	}
+	filteredOrientation = glm::normalize(fromRotationVector(filteredRotation) * filteredOrientation);
+}
+
+uint64_t vulkan::PosePredictor::getEarlierSample(uint64_t index, double interval) const
+{
+	double time = history[index % HISTORY_SIZE].time - interval;
+	uint64_t oldest = sampleCount > HISTORY_SIZE ? sampleCount - HISTORY_SIZE : 0;
+	while (index > oldest && history[index % HISTORY_SIZE].time > time)
+	{
+		index--;
+	}
+	return index;
+}
+
+vulkan::Pose vulkan::PosePredictor::getPose(double now, double displayTime)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	PoseSample sample;
+	double lastTime = bHasSample ? history[(sampleCount - 1) % HISTORY_SIZE].time : 0.0;
+	if (!bHasSample || now < lastTime || now - lastTime > MAX_SAMPLE_GAP)
+	{
+		if (!tracker.getLatestSample(now, sample))
+		{
+			return Pose();
+		}
+		if (!bHasSample || sample.time != lastTime)
+		{
+			reset(sample);
+		}
+	}
+	else
+	{
+		while (tracker.getNextSample(lastTime, now, sample))
+		{
+			if (sample.bIsDiscontinuous)
+			{
+				reset(sample);
+			}
+			else
+			{
+				addSample(sample);
+			}
+			lastTime = sample.time;
+		}
+	}
+
+	uint64_t newestIndex = sampleCount - 1;
+	const PoseSample& newest = history[newestIndex % HISTORY_SIZE];
+	Pose pose;
+
+	if (model == Model::Kalman)
+	{
+		double leadTime = displayTime - filterTime;
+		pose.position = glm::vec3((float)(positionAxes[0].value + positionAxes[0].rate * leadTime),
+			(float)(positionAxes[1].value + positionAxes[1].rate * leadTime), (float)(positionAxes[2].value + positionAxes[2].rate * leadTime));
+		glm::vec3 angularVelocity((float)rotationAxes[0].rate, (float)rotationAxes[1].rate, (float)rotationAxes[2].rate);
+		pose.orientation = glm::normalize(fromRotationVector(angularVelocity * (float)leadTime) * filteredOrientation);
+		return pose;
+	}
+
+	uint64_t middleIndex = getEarlierSample(newestIndex, DIFFERENCE_INTERVAL);
+	if (middleIndex == newestIndex)
+	{
+		return newest.pose;
+	}
+
+	// Velocities are those halfway between the samples they are differenced from
+	const PoseSample& middle = history[middleIndex % HISTORY_SIZE];
+	float newerInterval = (float)(newest.time - middle.time);
+	glm::vec3 velocity = (newest.pose.position - middle.pose.position) / newerInterval;
+	glm::vec3 angularVelocity = toRotationVector(newest.pose.orientation * glm::conjugate(middle.pose.orientation)) / newerInterval;
+	glm::vec3 acceleration(0.0f), angularAcceleration(0.0f);
+
+	uint64_t oldestIndex = getEarlierSample(middleIndex, DIFFERENCE_INTERVAL);
+	if (model == Model::ConstantAcceleration && oldestIndex != middleIndex)
+	{
+		const PoseSample& oldest = history[oldestIndex % HISTORY_SIZE];
+		float olderInterval = (float)(middle.time - oldest.time);
+		glm::vec3 olderVelocity = (middle.pose.position - oldest.pose.position) / olderInterval;
+		glm::vec3 olderAngularVelocity = toRotationVector(middle.pose.orientation * glm::conjugate(oldest.pose.orientation)) / olderInterval;
+
+		float velocityInterval = 0.5f * (newerInterval + olderInterval);
+		acceleration = (velocity - olderVelocity) / velocityInterval;
+		angularAcceleration = (angularVelocity - olderAngularVelocity) / velocityInterval;
+		velocity += acceleration * (0.5f * newerInterval);
+		angularVelocity += angularAcceleration * (0.5f * newerInterval);
+	}
+
+	float leadTime = (float)(displayTime - newest.time);
+	pose.position = newest.pose.position + velocity * leadTime + acceleration * (0.5f * leadTime * leadTime);
+	pose.orientation = glm::normalize(fromRotationVector(angularVelocity * leadTime + angularAcceleration * (0.5f * leadTime * leadTime)) *
+		newest.pose.orientation);
+	return pose;
+}
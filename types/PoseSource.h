@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace vulkan
+{
+	// Head pose relative to the default camera in its view space, Identity pose keeps the default camera
+	struct Pose
+	{
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::quat orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+		glm::mat4 getTransform() const;
+	};
+
+	struct PoseSample
+	{
+		// Seconds on the clock of whoever samples the source
+		double time;
+		Pose pose;
+		// Pose jumped here, Earlier samples tell nothing about it
+		bool bIsDiscontinuous = false;
+	};
+
+	// Difference of poses frames got built with from the recorded ones at their display time
+	struct PoseError
+	{
+		uint64_t count = 0;
+		double positionSum = 0;
+		double positionMax = 0;
+		// Degrees
+		double angleSum = 0;
+		double angleMax = 0;
+
+		void add(const Pose& pose, const Pose& truePose);
+	};
+
+	// Tracker reporting head poses at its own timestamps
+	class PoseSource
+	{
+	public:
+		virtual ~PoseSource() = default;
+
+		// Latest sample reported no later than now, False when there is none yet
+		virtual bool getLatestSample(double now, PoseSample& sample) const = 0;
+
+		// Earliest sample reported after time after and no later than now, False when there is none
+		virtual bool getNextSample(double after, double now, PoseSample& sample) const = 0;
+
+		// Pose for a frame reaching the display at displayTime out of samples reported up to now
+		virtual Pose getPose(double now, double displayTime) = 0;
+	};
+
+	// Recorded head trajectory replayed in a loop from time 0. Text file holds one "time px py pz qw qx qy qz" sample per line in increasing
+	// time order with '#' starting comments. Samples are reported at their recorded timestamps only and the latest one is held in between
+	// like a tracker would, So replaying alone shows every frame its pose as of when it got sampled
+	class TrajectoryPoseSource : public PoseSource
+	{
+	public:
+		explicit TrajectoryPoseSource(const std::string& path);
+		explicit TrajectoryPoseSource(std::vector<PoseSample> samples);
+
+		bool getLatestSample(double now, PoseSample& sample) const override;
+		bool getNextSample(double after, double now, PoseSample& sample) const override;
+		Pose getPose(double now, double displayTime) override;
+
+		// Ground truth, Recorded poses interpolated at time. Replay jumps back to the first pose when it starts over
+		Pose getTruePose(double time) const;
+
+		// Times in different loops of replay have the jump back in between
+		bool isSameLoop(double time, double otherTime) const
+		{
+			return std::floor(time / duration) == std::floor(otherTime / duration);
+		}
+
+		void save(const std::string& path) const;
+
+		// Looking around with slow sway, Turns that start and stop sharply and sensor noise on top, Same seed gives the same trajectory
+		static std::vector<PoseSample> generateHeadMotion(double seconds, double sampleRate, uint32_t seed);
+
+		double getDuration() const
+		{
+			return duration;
+		}
+
+		size_t getSampleCount() const
+		{
+			return samples.size();
+		}
+
+	private:
+		void init();
+		// Sample at index of loop, Time is moved into the loop
+		PoseSample getLoopSample(int64_t loop, size_t index) const;
+
+		std::vector<PoseSample> samples;
+		// Last sample is held as long as the average sample interval before replay starts over
+		double duration = 0;
+	};
+
+	// Extrapolates poses of a tracker to the time a frame reaches the display. Constant velocity and constant acceleration models difference
+	// samples DIFFERENCE_INTERVAL apart, Kalman model filters sensor noise out of position, orientation and their rates sample by sample
+	class PosePredictor : public PoseSource
+	{
+	public:
+		enum class Model : uint32_t
+		{
+			ConstantVelocity,
+			ConstantAcceleration,
+			Kalman,
+		};
+
+		// Noise in units of the trajectory, Orientation in radians
+		struct KalmanSettings
+		{
+			double positionNoise = 0.01;
+			double orientationNoise = 0.001;
+			// Spectral density of acceleration the models leave out
+			double positionAcceleration = 50.0;
+			double angularAcceleration = 200.0;
+		};
+
+		static const uint32_t HISTORY_SIZE = 64;
+		static constexpr double DIFFERENCE_INTERVAL = 0.005;
+		// Samples are caught up one by one until tracker went quiet longer than this, Prediction starts over then
+		static constexpr double MAX_SAMPLE_GAP = 0.25;
+
+		PosePredictor(const PoseSource& tracker, Model model);
+		PosePredictor(const PoseSource& tracker, Model model, const KalmanSettings& kalmanSettings);
+
+		bool getLatestSample(double now, PoseSample& sample) const override;
+		bool getNextSample(double after, double now, PoseSample& sample) const override;
+		Pose getPose(double now, double displayTime) override;
+
+		Model getModel() const
+		{
+			return model;
+		}
+
+		static const char* getModelName(Model model);
+
+	private:
+		// Value and rate along one axis under constant velocity
+		struct KalmanAxis
+		{
+			double value = 0;
+			double rate = 0;
+			double covariance[2][2] = { { 1.0, 0.0 }, { 0.0, 1.0 } };
+
+			void predict(double deltaTime, double processNoise);
+			void update(double measurement, double measurementNoise);
+		};
+
+		void reset(const PoseSample& sample);
+		void addSample(const PoseSample& sample);
+		// Index of newest sample at least interval older than sample at index, Oldest one in history otherwise
+		uint64_t getEarlierSample(uint64_t index, double interval) const;
+
+		const PoseSource& tracker;
+		Model model;
+		KalmanSettings kalmanSettings;
+
+		std::mutex mutex;
+		bool bHasSample = false;
+		PoseSample history[HISTORY_SIZE];
+		uint64_t sampleCount = 0;
+
+		// Rotation axes filter rotation from filteredOrientation which is folded back into it after every sample
+		KalmanAxis positionAxes[3];
+		KalmanAxis rotationAxes[3];
+		glm::quat filteredOrientation;
+		double filterTime = 0;
+	};
+}
@@ -0,0 +1,55 @@
+#include "PresentationClock.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+uint64_t vulkan::PresentationClock::now()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	// Whole seconds apart so that counter times one billion does not overflow
+	uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+	uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+	return seconds * 1000000000ull + remainder * 1000000000ull / frequency.QuadPart;
+#else
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+}
+
+std::chrono::steady_clock::time_point vulkan::PresentationClock::toSteady(uint64_t nanoseconds)
+{
+	static const std::chrono::nanoseconds offset = measureOffset();
+	return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::nanoseconds((int64_t)nanoseconds) + offset));
+}
+
+std::chrono::nanoseconds vulkan::PresentationClock::measureOffset()
+{
+	// Presentation engine clock is read between two steady clock reads, Shortest of a few tries bounds the error best
+	std::chrono::nanoseconds shortestWindow = std::chrono::nanoseconds::max();
+	std::chrono::nanoseconds offset(0);
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+		uint64_t presentationTime = now();
+		std::chrono::steady_clock::time_point after = std::chrono::steady_clock::now();
+
+		std::chrono::nanoseconds window = std::chrono::duration_cast<std::chrono::nanoseconds>(after - before);
+		if (window < shortestWindow)
+		{
+			shortestWindow = window;
+			std::chrono::nanoseconds middle = std::chrono::duration_cast<std::chrono::nanoseconds>(before.time_since_epoch()) + window / 2;
+			offset = middle - std::chrono::nanoseconds((int64_t)presentationTime);
+		}
+	}
+	return offset;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace vulkan
+{
+	// Clock presentation engine stamps display times with, CLOCK_MONOTONIC on POSIX and performance counter on Windows. Its epoch is
+	// unrelated to the one of steady clock, So time points are moved over by an offset measured against both clocks
+	class PresentationClock
+	{
+	public:
+		// Nanoseconds on presentation engine clock
+		static uint64_t now();
+
+		// Steady clock time point of presentation engine time in nanoseconds
+		static std::chrono::steady_clock::time_point toSteady(uint64_t nanoseconds);
+
+	private:
+		// Steady clock time minus presentation engine time, Measured once on first use
+		static std::chrono::nanoseconds measureOffset();
+	};
+}
@@ -0,0 +1,171 @@
+#include "QualityGovernor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+std::vector<vulkan::QualityGovernor::Level> vulkan::QualityGovernor::buildLevels(float minResolutionScale, uint32_t maxEyePassSamples,
+	float maxAnisotropy, bool bHasMultisampledDistortion)
+{
+	Level level;
+	level.eyePassSamples = std::max(maxEyePassSamples, 1u);
+	level.anisotropy = std::max(maxAnisotropy, 1.0f);
+	level.distortionMode = bHasMultisampledDistortion ? DistortionMode::Multisampled : DistortionMode::SingleSampled;
+	std::vector<Level> levels = { level };
+
+	if (level.anisotropy > 4.0f)
+	{
+		level.anisotropy = 4.0f;
+		levels.push_back(level);
+	}
+	if (level.distortionMode == DistortionMode::Multisampled)
+	{
+		level.distortionMode = DistortionMode::SingleSampled;
+		levels.push_back(level);
+	}
+
+	// Counted in tenths so that scale ends on minimum exactly
+	int scaleTenths = 10;
+	int minScaleTenths = std::min(std::max((int)std::ceil(minResolutionScale * 10.0f - 0.001f), 1), 10);
+	bool bIsChanged = true;
+	while (bIsChanged)
+	{
+		bIsChanged = false;
+		if (scaleTenths > minScaleTenths)
+		{
+			level.resolutionScale = --scaleTenths / 10.0f;
+			levels.push_back(level);
+			bIsChanged = true;
+		}
+		if (level.eyePassSamples > 1)
+		{
+			level.eyePassSamples /= 2;
+			levels.push_back(level);
+			bIsChanged = true;
+		}
+	}
+
+	if (level.anisotropy > 1.0f)
+	{
+		level.anisotropy = 1.0f;
+		levels.push_back(level);
+	}
+	return levels;
+}
+
+void vulkan::QualityGovernor::start(const Config& governorConfig, const std::vector<Level>& qualityLevels)
+{
+	config = governorConfig;
+	config.windowFrames = std::max(config.windowFrames, 1u);
+	levels = qualityLevels;
+	upHoldFrames.assign(levels.size(), config.upHoldFrames);
+	levelIndex = 0;
+
+	window.assign(config.windowFrames, 0.0);
+	windowNext = 0;
+	windowCount = 0;
+	windowSum = 0;
+	settleFramesLeft = 0;
+	framesBelowUpThreshold = 0;
+	bWasSteppedUp = false;
+	stepUpFrame = 0;
+
+	changes.clear();
+	stats = Stats();
+}
+
+bool vulkan::QualityGovernor::addFrameTime(double frameTime)
+{
+	stats.frameCount++;
+	stats.frameTimeSum += frameTime;
+	if (frameTime > config.targetFrameTime)
+	{
+		stats.overBudgetCount++;
+	}
+
+	if (settleFramesLeft > 0)
+	{
+		settleFramesLeft--;
+		return false;
+	}
+
+	if (windowCount == window.size())
+	{
+		windowSum -= window[windowNext];
+	}
+	else
+	{
+		windowCount++;
+	}
+	window[windowNext] = frameTime;
+	windowSum += frameTime;
+	windowNext = (windowNext + 1) % (uint32_t)window.size();
+	if (windowCount < window.size())
+	{
+		return false;
+	}
+
+	double average = windowSum / windowCount;
+	if (average > config.targetFrameTime * config.downThreshold && levelIndex + 1 < levels.size())
+	{
+		// Step up into this level did not hold, Next one waits longer up to 32 times base hold
+		if (bWasSteppedUp && stats.frameCount - stepUpFrame < upHoldFrames[levelIndex])
+		{
+			upHoldFrames[levelIndex] = std::min(upHoldFrames[levelIndex] * 2, config.upHoldFrames * 32);
+		}
+		bWasSteppedUp = false;
+		changeLevel(levelIndex + 1, average);
+		return true;
+	}
+
+	framesBelowUpThreshold = average < config.targetFrameTime * config.upThreshold ? framesBelowUpThreshold + 1 : 0;
+	if (levelIndex > 0 && framesBelowUpThreshold >= upHoldFrames[levelIndex - 1])
+	{
+		bWasSteppedUp = true;
+		stepUpFrame = stats.frameCount;
+		changeLevel(levelIndex - 1, average);
+		return true;
+	}
+	return false;
+}
+
+void vulkan::QualityGovernor::changeLevel(uint32_t newLevel, double averageFrameTime)
+{
+	Change change;
+	change.frame = stats.frameCount;
+	change.fromLevel = levelIndex;
+	change.toLevel = newLevel;
+	change.averageFrameTime = averageFrameTime;
+	changes.push_back(change);
+
+	levelIndex = newLevel;
+	settleFramesLeft = config.settleFrames;
+	windowNext = 0;
+	windowCount = 0;
+	windowSum = 0;
+	framesBelowUpThreshold = 0;
+}
+
+void vulkan::QualityGovernor::exportCsv(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Unable to write quality level changes to " + path);
+	}
+
+	file << "frame,from_level,to_level,average_gpu_ms,target_ms,resolution_scale,eye_pass_samples,anisotropy,distortion_mode" << std::endl;
+	for (const Change& change : changes)
+	{
+		const Level& level = levels[change.toLevel];
+		file << change.frame << "," << change.fromLevel << "," << change.toLevel << "," << change.averageFrameTime * 1000.0 << ","
+			<< config.targetFrameTime * 1000.0 << "," << level.resolutionScale << "," << level.eyePassSamples << "," << level.anisotropy << ","
+			<< getDistortionModeName(level.distortionMode) << std::endl;
+	}
+}
+
+const char* vulkan::QualityGovernor::getDistortionModeName(DistortionMode mode)
+{
+	return mode == DistortionMode::Multisampled ? "multisampled" : "single-sampled";
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vulkan
+{
+	// Holds GPU frame time within a budget by stepping through quality levels, Each a combination of eye image resolution scale, eye pass
+	// samples, texture anisotropy and distortion pass mode ordered from best to cheapest. Frame times are averaged over a window and a step
+	// down needs the average above one threshold while a step up needs it below a lower one for longer. Stepping up into a level that had
+	// to be left again soon makes the next step up into it wait twice as long, So a level whose cost sits right at the budget is not
+	// entered and left over and over
+	class QualityGovernor
+	{
+	public:
+		enum class DistortionMode : uint32_t
+		{
+			// Distortion pass renders with as many samples as configured and resolves into swap chain image
+			Multisampled = 0,
+			SingleSampled
+		};
+
+		struct Level
+		{
+			// Part of eye image width and height eye pass renders into
+			float resolutionScale = 1.0f;
+			uint32_t eyePassSamples = 1;
+			float anisotropy = 1.0f;
+			DistortionMode distortionMode = DistortionMode::SingleSampled;
+		};
+
+		struct Config
+		{
+			double targetFrameTime = 1.0 / 90.0;
+			// Fractions of target frame time average has to rise above to step down and stay below to step up
+			double downThreshold = 0.95;
+			double upThreshold = 0.75;
+			uint32_t windowFrames = 30;
+			// Frames after a change that are not measured, Their GPU work may have been recorded or submitted before it
+			uint32_t settleFrames = 10;
+			// Frames average has to stay below up threshold before stepping up
+			uint32_t upHoldFrames = 120;
+		};
+
+		struct Change
+		{
+			uint64_t frame = 0;
+			uint32_t fromLevel = 0;
+			uint32_t toLevel = 0;
+			double averageFrameTime = 0;
+		};
+
+		struct Stats
+		{
+			uint64_t frameCount = 0;
+			uint64_t overBudgetCount = 0;
+			double frameTimeSum = 0;
+		};
+
+		// Best level first, Anisotropy drops to 4 first, Then distortion pass stops multisampling and resolution scale steps down by tenths
+		// to minResolutionScale alternating with halving eye pass samples. Anisotropy goes off last
+		static std::vector<Level> buildLevels(float minResolutionScale, uint32_t maxEyePassSamples, float maxAnisotropy, bool bHasMultisampledDistortion);
+
+		// Starts at best level, Earlier changes and stats are forgotten
+		void start(const Config& governorConfig, const std::vector<Level>& qualityLevels);
+
+		// GPU time of one frame, True when it made the level change
+		bool addFrameTime(double frameTime);
+
+		uint32_t getLevelIndex() const
+		{
+			return levelIndex;
+		}
+
+		const Level& getLevel() const
+		{
+			return levels[levelIndex];
+		}
+
+		const std::vector<Level>& getLevels() const
+		{
+			return levels;
+		}
+
+		const Config& getConfig() const
+		{
+			return config;
+		}
+
+		const std::vector<Change>& getChanges() const
+		{
+			return changes;
+		}
+
+		const Stats& getStats() const
+		{
+			return stats;
+		}
+
+		// One row per level change with the level it changed to
+		void exportCsv(const std::string& path) const;
+
+		static const char* getDistortionModeName(DistortionMode mode);
+
+	private:
+		void changeLevel(uint32_t newLevel, double averageFrameTime);
+
+		Config config;
+		std::vector<Level> levels;
+		// Frames a step up into each level has to wait for
+		std::vector<uint32_t> upHoldFrames;
+		uint32_t levelIndex = 0;
+
+		std::vector<double> window;
+		uint32_t windowNext = 0;
+		uint32_t windowCount = 0;
+		double windowSum = 0;
+		uint32_t settleFramesLeft = 0;
+		uint32_t framesBelowUpThreshold = 0;
+		// Current level was stepped up into at that frame, Leaving it again within its hold time counts as a failed step up
+		bool bWasSteppedUp = false;
+		uint64_t stepUpFrame = 0;
+
+		std::vector<Change> changes;
+		Stats stats;
+	};
+}
@@ -0,0 +1,128 @@
+#include "QueueTimeline.h"
+#include "VulkanTypes.h"
+
+#include <limits>
+#include <stdexcept>
+
+void vulkan::QueueTimeline::create(VkDevice vkDevice, VkQueue vkQueue)
+{
+	device = vkDevice;
+	queue = vkQueue;
+	submittedValue = 0;
+	completedValue = 0;
+
+	VkSemaphoreTypeCreateInfoKHR typeCreateInfo = {};
+	typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+	typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+	typeCreateInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreCreateInfo.pNext = &typeCreateInfo;
+
+	if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphore) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create timeline semaphore");
+	}
+}
+
+void vulkan::QueueTimeline::destroy()
+{
+	if (semaphore != VK_NULL_HANDLE)
+	{
+		vkDestroySemaphore(device, semaphore, nullptr);
+		semaphore = VK_NULL_HANDLE;
+	}
+}
+
+uint64_t vulkan::QueueTimeline::submit(const VkSubmitInfo& submitInfo, const uint64_t* waitValues)
+{
+	if (submitInfo.signalSemaphoreCount >= MAX_SIGNAL_SEMAPHORES)
+	{
+		throw std::runtime_error("Too many signal semaphores for a timeline submit");
+	}
+
+	std::lock_guard<std::mutex> lock(submitMutex);
+	uint64_t value = submittedValue + 1;
+
+	// Binary semaphores are signaled as usual, Their values are ignored
+	VkSemaphore signalSemaphores[MAX_SIGNAL_SEMAPHORES];
+	uint64_t signalValues[MAX_SIGNAL_SEMAPHORES] = {};
+	for (uint32_t i = 0; i < submitInfo.signalSemaphoreCount; i++)
+	{
+		signalSemaphores[i] = submitInfo.pSignalSemaphores[i];
+	}
+	signalSemaphores[submitInfo.signalSemaphoreCount] = semaphore;
+	signalValues[submitInfo.signalSemaphoreCount] = value;
+
+	VkTimelineSemaphoreSubmitInfoKHR timelineSubmitInfo = {};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+	timelineSubmitInfo.pNext = submitInfo.pNext;
+	timelineSubmitInfo.waitSemaphoreValueCount = waitValues ? submitInfo.waitSemaphoreCount : 0;
+	timelineSubmitInfo.pWaitSemaphoreValues = waitValues;
+	timelineSubmitInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount + 1;
+	timelineSubmitInfo.pSignalSemaphoreValues = signalValues;
+
+	VkSubmitInfo timelineBatch = submitInfo;
+	timelineBatch.pNext = &timelineSubmitInfo;
+	timelineBatch.signalSemaphoreCount = submitInfo.signalSemaphoreCount + 1;
+	timelineBatch.pSignalSemaphores = signalSemaphores;
+
+	if (vkQueueSubmit(queue, 1, &timelineBatch, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Error when submitting command to the queue");
+	}
+	submittedValue = value;
+	return value;
+}
+
+void vulkan::QueueTimeline::wait(uint64_t value) const
+{
+	wait(value, std::numeric_limits<uint64_t>::max());
+}
+
+bool vulkan::QueueTimeline::wait(uint64_t value, uint64_t timeoutNanoseconds) const
+{
+	if (value <= completedValue)
+	{
+		return true;
+	}
+
+	VkSemaphoreWaitInfoKHR waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &semaphore;
+	waitInfo.pValues = &value;
+
+	VkResult result = VulkanTypes::fnVkWaitSemaphoresKhr(device, &waitInfo, timeoutNanoseconds);
+	if (result == VK_TIMEOUT)
+	{
+		return false;
+	}
+	else if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed waiting on timeline semaphore");
+	}
+
+	uint64_t seenValue = completedValue;
+	while (seenValue < value && !completedValue.compare_exchange_weak(seenValue, value))
+	{
+	}
+	return true;
+}
+
+bool vulkan::QueueTimeline::isReached(uint64_t value) const
+{
+	uint64_t seenValue = completedValue;
+	if (value <= seenValue)
+	{
+		return true;
+	}
+
+	uint64_t counterValue = 0;
+	VulkanTypes::fnVkGetSemaphoreCounterValueKhr(device, semaphore, &counterValue);
+	while (seenValue < counterValue && !completedValue.compare_exchange_weak(seenValue, counterValue))
+	{
+	}
+	return value <= counterValue;
+}
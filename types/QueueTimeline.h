@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace vulkan
+{
+	// Timeline semaphore of one queue that every batch submitted through it signals the next value of. Work is waited on or polled by the
+	// value its submit returned, So there is no fence to reset and any number of waiters can wait on the same value. Needs
+	// VK_KHR_timeline_semaphore enabled and its device functions set up in VulkanTypes
+	class QueueTimeline
+	{
+	public:
+		static const uint32_t MAX_SIGNAL_SEMAPHORES = 4;
+
+		QueueTimeline() = default;
+		QueueTimeline(const QueueTimeline&) = delete;
+		QueueTimeline& operator=(const QueueTimeline&) = delete;
+
+		void create(VkDevice device, VkQueue queue);
+		void destroy();
+
+		// Submits batch signaling next value besides semaphores of its own and returns that value. Waits of batch on timelines take their
+		// values from waitValues which has one value per wait semaphore, Ones for binary semaphores are ignored. Caller keeps queue
+		// externally synchronized like for any submit
+		uint64_t submit(const VkSubmitInfo& submitInfo, const uint64_t* waitValues = nullptr);
+
+		// Blocks until batch that signals value is complete, Values not submitted yet are never reached
+		void wait(uint64_t value) const;
+		// False when batch is not complete after timeout
+		bool wait(uint64_t value, uint64_t timeoutNanoseconds) const;
+		bool isReached(uint64_t value) const;
+
+		// Value of last batch submitted, Everything submitted so far is complete once it is reached
+		uint64_t getSubmittedValue() const
+		{
+			return submittedValue;
+		}
+
+		VkSemaphore getSemaphore() const
+		{
+			return semaphore;
+		}
+
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkQueue queue = VK_NULL_HANDLE;
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+
+		// Values have to be signaled in submission order, Taking next value and submitting happen together
+		std::mutex submitMutex;
+		std::atomic<uint64_t> submittedValue{ 0 };
+		// Highest value seen completed, Polling values below it needs no query
+		mutable std::atomic<uint64_t> completedValue{ 0 };
+	};
+}
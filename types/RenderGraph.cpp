@@ -0,0 +1,828 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	const VkPipelineStageFlags COLOR_STAGES = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	const VkPipelineStageFlags DEPTH_STAGES = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+	uint32_t findMemoryType(const VkPhysicalDeviceMemoryProperties& memProperties, uint32_t typeBits, VkMemoryPropertyFlags propertyFlags)
+	{
+		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+		{
+			if ((typeBits & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags)
+			{
+				return i;
+			}
+		}
+		return vulkan::RenderGraph::INVALID_ID;
+	}
+}
+
+vulkan::RenderGraph::ResourceId vulkan::RenderGraph::createImage(const std::string& name, const ImageDesc& desc)
+{
+	if (desc.copyCount > 1 && !desc.bIsPersistent)
+	{
+		throw std::runtime_error("Render graph image " + name + " has copies without being persistent");
+	}
+
+	Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+	resources.push_back(resource);
+	return (ResourceId)resources.size() - 1;
+}
+
+vulkan::RenderGraph::ResourceId vulkan::RenderGraph::importImage(const std::string& name, VkFormat format, const std::vector<VkImageView>& views,
+	VkImageLayout finalLayout)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc.format = format;
+	resource.bIsImported = true;
+	resource.importedViews = views;
+	resource.importedFinalLayout = finalLayout;
+	resources.push_back(resource);
+	return (ResourceId)resources.size() - 1;
+}
+
+vulkan::RenderGraph::PassId vulkan::RenderGraph::addPass(const std::string& name, uint32_t viewMask)
+{
+	Pass pass;
+	pass.name = name;
+	pass.viewMask = viewMask;
+	passes.push_back(pass);
+	return (PassId)passes.size() - 1;
+}
+
+void vulkan::RenderGraph::writeColor(PassId pass, ResourceId image, ResourceId resolveTarget)
+{
+	passes[pass].uses.push_back({ image, Access::Color, false, {}, resolveTarget, 0 });
+	if (resolveTarget != INVALID_ID)
+	{
+		passes[pass].uses.push_back({ resolveTarget, Access::Resolve, false, {}, INVALID_ID, 0 });
+	}
+}
+
+void vulkan::RenderGraph::clearColor(PassId pass, ResourceId image, const VkClearColorValue& clearValue, ResourceId resolveTarget)
+{
+	writeColor(pass, image, resolveTarget);
+	for (Use& use : passes[pass].uses)
+	{
+		if (use.resource == image && use.access == Access::Color)
+		{
+			use.bClear = true;
+			use.clearValue.color = clearValue;
+		}
+	}
+}
+
+void vulkan::RenderGraph::writeDepth(PassId pass, ResourceId image)
+{
+	passes[pass].uses.push_back({ image, Access::Depth, false, {}, INVALID_ID, 0 });
+}
+
+void vulkan::RenderGraph::clearDepth(PassId pass, ResourceId image, const VkClearDepthStencilValue& clearValue)
+{
+	Use use = { image, Access::Depth, true, {}, INVALID_ID, 0 };
+	use.clearValue.depthStencil = clearValue;
+	passes[pass].uses.push_back(use);
+}
+
+void vulkan::RenderGraph::readSampled(PassId pass, ResourceId image, VkPipelineStageFlags stages)
+{
+	passes[pass].uses.push_back({ image, Access::Sampled, false, {}, INVALID_ID, stages });
+}
+
+void vulkan::RenderGraph::compile(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t frameWidth, uint32_t frameHeight)
+{
+	width = frameWidth;
+	height = frameHeight;
+	stats = Stats();
+
+	cullPasses();
+	computeLifetimes();
+	deriveAttachments();
+	createImages(physicalDevice, device);
+	deriveDependencies();
+	createRenderPasses(device);
+	createFramebuffers(device);
+}
+
+void vulkan::RenderGraph::destroy(VkDevice device)
+{
+	for (Pass& pass : passes)
+	{
+		for (VkFramebuffer framebuffer : pass.framebuffers)
+		{
+			vkDestroyFramebuffer(device, framebuffer, nullptr);
+		}
+		vkDestroyRenderPass(device, pass.renderPass, nullptr);
+	}
+
+	for (Resource& resource : resources)
+	{
+		if (!resource.bIsImported)
+		{
+			for (VkImageView copyView : resource.copyViews)
+			{
+				vkDestroyImageView(device, copyView, nullptr);
+			}
+			vkDestroyImageView(device, resource.view, nullptr);
+			vkDestroyImage(device, resource.image, nullptr);
+		}
+	}
+
+	for (MemoryBlock& block : memoryBlocks)
+	{
+		vkFreeMemory(device, block.memory, nullptr);
+	}
+
+	passes.clear();
+	activePasses.clear();
+	resources.clear();
+	memoryBlocks.clear();
+}
+
+// Walks passes backwards keeping only those that write something a kept pass or an imported image needs
+void vulkan::RenderGraph::cullPasses()
+{
+	std::vector<bool> bIsNeeded(resources.size(), false);
+	for (uint32_t i = 0; i < resources.size(); i++)
+	{
+		bIsNeeded[i] = resources[i].bIsImported;
+	}
+
+	for (uint32_t passIdx = (uint32_t)passes.size(); passIdx-- > 0;)
+	{
+		Pass& pass = passes[passIdx];
+		pass.bIsActive = false;
+		for (const Use& use : pass.uses)
+		{
+			pass.bIsActive |= use.access != Access::Sampled && bIsNeeded[use.resource];
+		}
+
+		if (!pass.bIsActive)
+		{
+			stats.culledPassCount++;
+			continue;
+		}
+
+		// Earlier contents of cleared and resolved images are never seen, Anything drawn on top of might be
+		for (const Use& use : pass.uses)
+		{
+			if (use.bClear || use.access == Access::Resolve)
+			{
+				bIsNeeded[use.resource] = false;
+			}
+		}
+		for (const Use& use : pass.uses)
+		{
+			if (use.access == Access::Sampled || ((use.access == Access::Color || use.access == Access::Depth) && !use.bClear))
+			{
+				bIsNeeded[use.resource] = true;
+			}
+		}
+	}
+
+	activePasses.clear();
+	for (PassId passIdx = 0; passIdx < passes.size(); passIdx++)
+	{
+		if (passes[passIdx].bIsActive)
+		{
+			activePasses.push_back(passIdx);
+		}
+	}
+	stats.activePassCount = (uint32_t)activePasses.size();
+}
+
+void vulkan::RenderGraph::computeLifetimes()
+{
+	for (Resource& resource : resources)
+	{
+		resource.firstPass = resource.lastPass = INVALID_ID;
+		resource.usage = 0;
+		resource.bIsTransientAttachment = !resource.bIsImported && !resource.desc.bIsPersistent;
+	}
+
+	for (uint32_t activeIdx = 0; activeIdx < activePasses.size(); activeIdx++)
+	{
+		for (const Use& use : passes[activePasses[activeIdx]].uses)
+		{
+			Resource& resource = resources[use.resource];
+			if (resource.firstPass == INVALID_ID)
+			{
+				resource.firstPass = activeIdx;
+			}
+			resource.lastPass = activeIdx;
+
+			switch (use.access)
+			{
+			case Access::Color:
+			case Access::Resolve:
+				resource.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+				break;
+			case Access::Depth:
+				resource.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+				break;
+			case Access::Sampled:
+				resource.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+				resource.bIsTransientAttachment = false;
+				break;
+			}
+		}
+	}
+}
+
+void vulkan::RenderGraph::deriveAttachments()
+{
+	for (uint32_t activeIdx = 0; activeIdx < activePasses.size(); activeIdx++)
+	{
+		Pass& pass = passes[activePasses[activeIdx]];
+		pass.attachments.clear();
+		pass.attachmentPolicies.clear();
+		pass.clearValues.clear();
+		pass.resolveAttachments.clear();
+		pass.depthAttachment = VK_ATTACHMENT_UNUSED;
+
+		auto addAttachment = [&](const Use& use)
+		{
+			Resource& resource = resources[use.resource];
+			VkImageLayout layout = getLayout(use.access);
+
+			AttachmentPolicy policy = {};
+			policy.name = resource.name.c_str();
+			policy.format = resource.desc.format;
+			policy.samples = resource.desc.samples;
+			policy.layers = resource.desc.layers;
+			if (use.bClear)
+			{
+				policy.contents = AttachmentPolicy::Contents::Cleared;
+			}
+			else if (use.access != Access::Resolve && isUsedBefore(use.resource, activeIdx))
+			{
+				policy.contents = AttachmentPolicy::Contents::Preserved;
+			}
+			else
+			{
+				policy.contents = AttachmentPolicy::Contents::Overwritten;
+			}
+			policy.bIsUsedAfterPass = resource.bIsImported || resource.desc.bIsPersistent || isUsedAfter(use.resource, activeIdx);
+			// Next use finds image in the layout it needs so that no separate barrier has to transition it
+			policy.finalLayout = getNextLayout(use.resource, activeIdx, layout);
+			policy.initialLayout = layout;
+
+			if (policy.bIsUsedAfterPass || policy.contents == AttachmentPolicy::Contents::Preserved)
+			{
+				resource.bIsTransientAttachment = false;
+			}
+
+			pass.attachments.push_back(use.resource);
+			pass.attachmentPolicies.push_back(policy);
+			pass.clearValues.push_back(use.clearValue);
+			return (uint32_t)pass.attachments.size() - 1;
+		};
+
+		for (const Use& use : pass.uses)
+		{
+			if (use.access == Access::Color)
+			{
+				addAttachment(use);
+			}
+		}
+		pass.colorAttachmentCount = (uint32_t)pass.attachments.size();
+
+		for (const Use& use : pass.uses)
+		{
+			if (use.access == Access::Depth)
+			{
+				if (pass.depthAttachment != VK_ATTACHMENT_UNUSED)
+				{
+					throw std::runtime_error("Render graph pass " + pass.name + " writes more than one depth attachment");
+				}
+				pass.depthAttachment = addAttachment(use);
+			}
+			else if (use.access == Access::Sampled && !isUsedBefore(use.resource, activeIdx) && !resources[use.resource].desc.bIsPersistent &&
+				!resources[use.resource].bIsImported)
+			{
+				throw std::runtime_error("Render graph pass " + pass.name + " samples " + resources[use.resource].name + " before anything writes it");
+			}
+		}
+
+		// Resolve targets follow color attachments they resolve
+		for (const Use& colorUse : pass.uses)
+		{
+			if (colorUse.access != Access::Color)
+			{
+				continue;
+			}
+
+			uint32_t resolveAttachment = VK_ATTACHMENT_UNUSED;
+			for (const Use& use : pass.uses)
+			{
+				if (use.access == Access::Resolve && use.resource == colorUse.resolveTarget)
+				{
+					resolveAttachment = addAttachment(use);
+				}
+			}
+			pass.resolveAttachments.push_back(resolveAttachment);
+		}
+	}
+
+	for (Resource& resource : resources)
+	{
+		if (resource.bIsTransientAttachment)
+		{
+			resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+	}
+}
+
+// Images that do not outlive the frame share memory blocks with images whose pass ranges do not overlap, Largest images are placed first
+void vulkan::RenderGraph::createImages(VkPhysicalDevice physicalDevice, VkDevice device)
+{
+	std::vector<ResourceId> images;
+	for (ResourceId resourceId = 0; resourceId < resources.size(); resourceId++)
+	{
+		Resource& resource = resources[resourceId];
+		if (resource.bIsImported || resource.firstPass == INVALID_ID)
+		{
+			continue;
+		}
+
+		VkImageCreateInfo imageCreateInfo = {};
+		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageCreateInfo.format = resource.desc.format;
+		imageCreateInfo.extent = { width, height, 1 };
+		imageCreateInfo.mipLevels = 1;
+		imageCreateInfo.arrayLayers = resource.desc.layers * resource.desc.copyCount;
+		imageCreateInfo.samples = resource.desc.samples;
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCreateInfo.usage = resource.usage;
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(device, &imageCreateInfo, nullptr, &resource.image) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed creating render graph image " + resource.name);
+		}
+		vkGetImageMemoryRequirements(device, resource.image, &resource.memoryRequirements);
+		images.push_back(resourceId);
+	}
+
+	std::stable_sort(images.begin(), images.end(), [&](ResourceId a, ResourceId b)
+	{
+		return resources[a].memoryRequirements.size > resources[b].memoryRequirements.size;
+	});
+
+	memoryBlocks.clear();
+	for (ResourceId resourceId : images)
+	{
+		Resource& resource = resources[resourceId];
+		const bool bIsPersistent = resource.desc.bIsPersistent;
+
+		uint32_t blockIdx = INVALID_ID;
+		for (uint32_t i = 0; i < memoryBlocks.size() && !bIsPersistent && blockIdx == INVALID_ID; i++)
+		{
+			const MemoryBlock& block = memoryBlocks[i];
+			if (block.bIsPersistent || block.bIsTransientAttachment != resource.bIsTransientAttachment ||
+				!(block.memoryTypeBits & resource.memoryRequirements.memoryTypeBits))
+			{
+				continue;
+			}
+
+			bool bOverlaps = false;
+			for (ResourceId otherId : block.resources)
+			{
+				const Resource& other = resources[otherId];
+				bOverlaps |= !(other.lastPass < resource.firstPass || resource.lastPass < other.firstPass);
+			}
+			if (!bOverlaps)
+			{
+				blockIdx = i;
+			}
+		}
+
+		if (blockIdx == INVALID_ID)
+		{
+			MemoryBlock block;
+			block.memoryTypeBits = resource.memoryRequirements.memoryTypeBits;
+			block.bIsTransientAttachment = resource.bIsTransientAttachment;
+			block.bIsPersistent = bIsPersistent;
+			memoryBlocks.push_back(block);
+			blockIdx = (uint32_t)memoryBlocks.size() - 1;
+		}
+
+		MemoryBlock& block = memoryBlocks[blockIdx];
+		block.size = std::max(block.size, resource.memoryRequirements.size);
+		block.memoryTypeBits &= resource.memoryRequirements.memoryTypeBits;
+		block.resources.push_back(resourceId);
+		resource.memoryBlock = blockIdx;
+
+		if (!bIsPersistent)
+		{
+			stats.transientBytes += resource.memoryRequirements.size;
+		}
+	}
+
+	VkPhysicalDeviceMemoryProperties memProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+	for (MemoryBlock& block : memoryBlocks)
+	{
+		// Lazily allocated memory is optional, Desktop devices usually have none
+		uint32_t memoryType = INVALID_ID;
+		if (block.bIsTransientAttachment)
+		{
+			memoryType = findMemoryType(memProperties, block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+			if (memoryType != INVALID_ID)
+			{
+				stats.lazilyAllocatedBytes += block.size;
+			}
+		}
+		if (memoryType == INVALID_ID)
+		{
+			memoryType = findMemoryType(memProperties, block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+		if (memoryType == INVALID_ID)
+		{
+			throw std::runtime_error("No device local memory type is available for render graph images");
+		}
+
+		VkMemoryAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = block.size;
+		allocateInfo.memoryTypeIndex = memoryType;
+
+		if (vkAllocateMemory(device, &allocateInfo, nullptr, &block.memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed allocating device memory to render graph images");
+		}
+
+		if (!block.bIsPersistent)
+		{
+			stats.allocatedTransientBytes += block.size;
+		}
+
+		for (ResourceId resourceId : block.resources)
+		{
+			Resource& resource = resources[resourceId];
+			vkBindImageMemory(device, resource.image, block.memory, 0);
+
+			const uint32_t layerCount = resource.desc.layers * resource.desc.copyCount;
+
+			VkImageViewCreateInfo viewCreateInfo = {};
+			viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewCreateInfo.image = resource.image;
+			viewCreateInfo.viewType = layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+			viewCreateInfo.format = resource.desc.format;
+			viewCreateInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+				VK_COMPONENT_SWIZZLE_IDENTITY };
+			viewCreateInfo.subresourceRange.aspectMask = !isDepthFormat(resource.desc.format) ? VK_IMAGE_ASPECT_COLOR_BIT :
+				(hasStencilFormat(resource.desc.format) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT);
+			viewCreateInfo.subresourceRange.baseMipLevel = 0;
+			viewCreateInfo.subresourceRange.levelCount = 1;
+			viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+			viewCreateInfo.subresourceRange.layerCount = layerCount;
+
+			if (vkCreateImageView(device, &viewCreateInfo, nullptr, &resource.view) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed creating view of render graph image " + resource.name);
+			}
+
+			resource.copyViews.assign(resource.desc.copyCount > 1 ? resource.desc.copyCount : 0, VK_NULL_HANDLE);
+			for (uint32_t copy = 0; copy < resource.copyViews.size(); copy++)
+			{
+				viewCreateInfo.viewType = resource.desc.layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+				viewCreateInfo.subresourceRange.baseArrayLayer = copy * resource.desc.layers;
+				viewCreateInfo.subresourceRange.layerCount = resource.desc.layers;
+
+				if (vkCreateImageView(device, &viewCreateInfo, nullptr, &resource.copyViews[copy]) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed creating view of render graph image copy " + resource.name);
+				}
+			}
+		}
+	}
+}
+
+// Every pass gets at most one dependency on what came before it and one on what follows it.
+// Hazards within the frame are covered by the earlier pass so that its final layout transitions are ordered too,
+// Hazards against previous frame and imported images are covered by the pass itself
+void vulkan::RenderGraph::deriveDependencies()
+{
+	auto hasHazard = [](const PassAccess& first, const PassAccess& second)
+	{
+		return first.writeAccessMask != 0 || second.writeAccessMask != 0 || first.layout != second.layout;
+	};
+
+	for (uint32_t activeIdx = 0; activeIdx < activePasses.size(); activeIdx++)
+	{
+		Pass& pass = passes[activePasses[activeIdx]];
+
+		VkSubpassDependency incoming = {};
+		incoming.srcSubpass = VK_SUBPASS_EXTERNAL;
+		incoming.dstSubpass = 0;
+
+		VkSubpassDependency outgoing = {};
+		outgoing.srcSubpass = 0;
+		outgoing.dstSubpass = VK_SUBPASS_EXTERNAL;
+
+		std::vector<uint32_t> hazardKeys;
+		for (const Use& use : pass.uses)
+		{
+			uint32_t key = getHazardKey(use.resource);
+			if (std::find(hazardKeys.begin(), hazardKeys.end(), key) == hazardKeys.end())
+			{
+				hazardKeys.push_back(key);
+			}
+		}
+
+		for (uint32_t key : hazardKeys)
+		{
+			PassAccess current = getPassAccess(pass, key);
+
+			bool bHasEarlierAccess = false;
+			for (uint32_t i = activeIdx; i-- > 0 && !bHasEarlierAccess;)
+			{
+				bHasEarlierAccess = getPassAccess(passes[activePasses[i]], key).stages != 0;
+			}
+
+			if (!bHasEarlierAccess)
+			{
+				PassAccess previous;
+				if (key < resources.size() && resources[key].bIsImported)
+				{
+					previous.stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				}
+				else
+				{
+					// Last access of previous frame, Which is this pass itself when nothing after it uses the memory
+					for (uint32_t i = (uint32_t)activePasses.size(); i-- > activeIdx && previous.stages == 0;)
+					{
+						previous = getPassAccess(passes[activePasses[i]], key);
+					}
+				}
+
+				if (hasHazard(previous, current))
+				{
+					incoming.srcStageMask |= previous.stages;
+					incoming.srcAccessMask |= previous.writeAccessMask;
+					incoming.dstStageMask |= current.stages;
+					incoming.dstAccessMask |= current.accessMask;
+				}
+			}
+
+			for (uint32_t i = activeIdx + 1; i < activePasses.size(); i++)
+			{
+				PassAccess next = getPassAccess(passes[activePasses[i]], key);
+				if (next.stages == 0)
+				{
+					continue;
+				}
+
+				if (hasHazard(current, next))
+				{
+					outgoing.srcStageMask |= current.stages;
+					outgoing.srcAccessMask |= current.writeAccessMask;
+					outgoing.dstStageMask |= next.stages;
+					outgoing.dstAccessMask |= next.accessMask;
+				}
+				break;
+			}
+		}
+
+		pass.dependencies.clear();
+		if (incoming.srcStageMask != 0)
+		{
+			pass.dependencies.push_back(incoming);
+		}
+		if (outgoing.srcStageMask != 0)
+		{
+			pass.dependencies.push_back(outgoing);
+		}
+		stats.dependencyCount += (uint32_t)pass.dependencies.size();
+	}
+}
+
+void vulkan::RenderGraph::createRenderPasses(VkDevice device)
+{
+	for (PassId passIdx : activePasses)
+	{
+		Pass& pass = passes[passIdx];
+
+		std::vector<VkAttachmentDescription> attachmentDescs;
+		for (const AttachmentPolicy& policy : pass.attachmentPolicies)
+		{
+			attachmentDescs.push_back(policy.getDescription());
+		}
+
+		std::vector<VkAttachmentReference> colorRefs;
+		std::vector<VkAttachmentReference> resolveRefs;
+		bool bHasResolves = false;
+		for (uint32_t i = 0; i < pass.colorAttachmentCount; i++)
+		{
+			colorRefs.push_back({ i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+			resolveRefs.push_back({ pass.resolveAttachments[i], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+			bHasResolves |= pass.resolveAttachments[i] != VK_ATTACHMENT_UNUSED;
+		}
+		VkAttachmentReference depthRef = { pass.depthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+		VkSubpassDescription subpassDesc = {};
+		subpassDesc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpassDesc.colorAttachmentCount = (uint32_t)colorRefs.size();
+		subpassDesc.pColorAttachments = colorRefs.data();
+		subpassDesc.pResolveAttachments = bHasResolves ? resolveRefs.data() : nullptr;
+		subpassDesc.pDepthStencilAttachment = pass.depthAttachment != VK_ATTACHMENT_UNUSED ? &depthRef : nullptr;
+
+		VkRenderPassCreateInfo renderPassCreateInfo = {};
+		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassCreateInfo.attachmentCount = (uint32_t)attachmentDescs.size();
+		renderPassCreateInfo.pAttachments = attachmentDescs.data();
+		renderPassCreateInfo.subpassCount = 1;
+		renderPassCreateInfo.pSubpasses = &subpassDesc;
+		renderPassCreateInfo.dependencyCount = (uint32_t)pass.dependencies.size();
+		renderPassCreateInfo.pDependencies = pass.dependencies.data();
+
+		VkRenderPassMultiviewCreateInfo multiviewCreateInfo = {};
+		if (pass.viewMask != 0)
+		{
+			multiviewCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+			multiviewCreateInfo.subpassCount = 1;
+			multiviewCreateInfo.pViewMasks = &pass.viewMask;
+			multiviewCreateInfo.correlationMaskCount = 1;
+			multiviewCreateInfo.pCorrelationMasks = &pass.viewMask;
+			renderPassCreateInfo.pNext = &multiviewCreateInfo;
+		}
+
+		if (vkCreateRenderPass(device, &renderPassCreateInfo, nullptr, &pass.renderPass) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed creating render pass of render graph pass " + pass.name);
+		}
+	}
+}
+
+void vulkan::RenderGraph::createFramebuffers(VkDevice device)
+{
+	for (PassId passIdx : activePasses)
+	{
+		Pass& pass = passes[passIdx];
+
+		size_t framebufferCount = 1;
+		for (ResourceId resourceId : pass.attachments)
+		{
+			framebufferCount = std::max(framebufferCount, std::max(resources[resourceId].importedViews.size(), resources[resourceId].copyViews.size()));
+		}
+
+		pass.framebuffers.resize(framebufferCount);
+		for (size_t i = 0; i < framebufferCount; i++)
+		{
+			std::vector<VkImageView> views;
+			for (ResourceId resourceId : pass.attachments)
+			{
+				const Resource& resource = resources[resourceId];
+				if (resource.bIsImported)
+				{
+					views.push_back(resource.importedViews[i % resource.importedViews.size()]);
+				}
+				else
+				{
+					views.push_back(resource.copyViews.empty() ? resource.view : resource.copyViews[i % resource.copyViews.size()]);
+				}
+			}
+
+			// Multiview renders to layers through view mask so framebuffers always have one layer
+			VkFramebufferCreateInfo framebufferCreateInfo = {};
+			framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferCreateInfo.renderPass = pass.renderPass;
+			framebufferCreateInfo.attachmentCount = (uint32_t)views.size();
+			framebufferCreateInfo.pAttachments = views.data();
+			framebufferCreateInfo.width = width;
+			framebufferCreateInfo.height = height;
+			framebufferCreateInfo.layers = 1;
+
+			if (vkCreateFramebuffer(device, &framebufferCreateInfo, nullptr, &pass.framebuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed creating framebuffer of render graph pass " + pass.name);
+			}
+		}
+	}
+}
+
+uint32_t vulkan::RenderGraph::getHazardKey(ResourceId resource) const
+{
+	uint32_t memoryBlock = resources[resource].memoryBlock;
+	return memoryBlock == INVALID_ID ? resource : (uint32_t)resources.size() + memoryBlock;
+}
+
+vulkan::RenderGraph::PassAccess vulkan::RenderGraph::getPassAccess(const Pass& pass, uint32_t hazardKey) const
+{
+	PassAccess passAccess;
+	for (const Use& use : pass.uses)
+	{
+		if (getHazardKey(use.resource) != hazardKey)
+		{
+			continue;
+		}
+
+		switch (use.access)
+		{
+		case Access::Color:
+		case Access::Resolve:
+			passAccess.stages |= COLOR_STAGES;
+			passAccess.writeAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			break;
+		case Access::Depth:
+			passAccess.stages |= DEPTH_STAGES;
+			passAccess.accessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+			passAccess.writeAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			break;
+		case Access::Sampled:
+			passAccess.stages |= use.stages;
+			passAccess.accessMask |= VK_ACCESS_SHADER_READ_BIT;
+			break;
+		}
+
+		// Blending reads preserved color
+		for (size_t i = 0; i < pass.attachments.size(); i++)
+		{
+			if (pass.attachments[i] == use.resource && pass.attachmentPolicies[i].contents == AttachmentPolicy::Contents::Preserved &&
+				use.access == Access::Color)
+			{
+				passAccess.accessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+			}
+		}
+		passAccess.layout = getLayout(use.access);
+	}
+	passAccess.accessMask |= passAccess.writeAccessMask;
+	return passAccess;
+}
+
+VkImageLayout vulkan::RenderGraph::getNextLayout(ResourceId resourceId, uint32_t activeIndex, VkImageLayout currentLayout) const
+{
+	const Resource& resource = resources[resourceId];
+	for (uint32_t i = activeIndex + 1; i < activePasses.size(); i++)
+	{
+		for (const Use& use : passes[activePasses[i]].uses)
+		{
+			if (use.resource == resourceId)
+			{
+				return getLayout(use.access);
+			}
+		}
+	}
+
+	if (resource.bIsImported)
+	{
+		return resource.importedFinalLayout;
+	}
+
+	// Persistent images are left for their first use in next frame
+	if (resource.desc.bIsPersistent)
+	{
+		for (const Use& use : passes[activePasses[resource.firstPass]].uses)
+		{
+			if (use.resource == resourceId)
+			{
+				return getLayout(use.access);
+			}
+		}
+	}
+	return currentLayout;
+}
+
+bool vulkan::RenderGraph::isUsedBefore(ResourceId resource, uint32_t activeIndex) const
+{
+	return resources[resource].firstPass < activeIndex;
+}
+
+bool vulkan::RenderGraph::isUsedAfter(ResourceId resource, uint32_t activeIndex) const
+{
+	return resources[resource].lastPass != INVALID_ID && resources[resource].lastPass > activeIndex;
+}
+
+VkImageLayout vulkan::RenderGraph::getLayout(Access access)
+{
+	switch (access)
+	{
+	case Access::Depth:
+		return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	case Access::Sampled:
+		return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	default:
+		return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	}
+}
+
+bool vulkan::RenderGraph::isDepthFormat(VkFormat format)
+{
+	return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32 || format == VK_FORMAT_D32_SFLOAT || hasStencilFormat(format);
+}
+
+bool vulkan::RenderGraph::hasStencilFormat(VkFormat format)
+{
+	return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
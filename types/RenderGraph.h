@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "AttachmentPolicy.h"
+
+namespace vulkan
+{
+	// Frame described as render passes that declare which images they read and write in submission order.
+	// Compiling culls passes whose results never reach an imported image, derives load and store ops, layouts and dependencies
+	// of every attachment and creates render passes, framebuffers and graph owned images. Transient images whose lifetimes
+	// within a frame do not overlap share memory
+	class RenderGraph
+	{
+	public:
+		typedef uint32_t ResourceId;
+		typedef uint32_t PassId;
+
+		static const uint32_t INVALID_ID = UINT32_MAX;
+
+		struct ImageDesc
+		{
+			VkFormat format;
+			VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+			uint32_t layers = 1;
+			// Contents are kept from one frame to the next so image never shares memory
+			bool bIsPersistent = false;
+			// Persistent images can have several copies laid out as consecutive ranges of layers so that one is read while another is written,
+			// Framebuffers rotate through copies by frame index and views of the image cover all of them
+			uint32_t copyCount = 1;
+		};
+
+		struct Stats
+		{
+			uint32_t activePassCount = 0;
+			uint32_t culledPassCount = 0;
+			uint32_t dependencyCount = 0;
+			// Memory of graph owned images whose contents do not outlive the frame, Before and after aliasing
+			uint64_t transientBytes = 0;
+			uint64_t allocatedTransientBytes = 0;
+			// Part of allocated memory that device only commits when attachments spill out of tile memory
+			uint64_t lazilyAllocatedBytes = 0;
+		};
+
+	private:
+		enum class Access : uint32_t
+		{
+			Color,
+			Depth,
+			Resolve,
+			Sampled,
+		};
+
+		struct Use
+		{
+			ResourceId resource;
+			Access access;
+			bool bClear;
+			VkClearValue clearValue;
+			// Color uses only
+			ResourceId resolveTarget;
+			// Sampled uses only
+			VkPipelineStageFlags stages;
+		};
+
+		struct Resource
+		{
+			std::string name;
+			ImageDesc desc;
+			bool bIsImported = false;
+			// Imported images have one view per frame index
+			std::vector<VkImageView> importedViews;
+			VkImageLayout importedFinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VkImageUsageFlags usage = 0;
+			// Only ever used as attachment within one pass at a time and never stored, Can live in lazily allocated memory
+			bool bIsTransientAttachment = false;
+			// Range of active passes using it
+			uint32_t firstPass = INVALID_ID;
+			uint32_t lastPass = INVALID_ID;
+			uint32_t memoryBlock = INVALID_ID;
+			VkMemoryRequirements memoryRequirements = {};
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			// Attachment views of every copy when there is more than one
+			std::vector<VkImageView> copyViews;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			uint32_t viewMask;
+			std::vector<Use> uses;
+
+			bool bIsActive = false;
+			// Color attachments, Depth attachment and resolve targets in that order
+			std::vector<ResourceId> attachments;
+			uint32_t colorAttachmentCount = 0;
+			uint32_t depthAttachment = VK_ATTACHMENT_UNUSED;
+			// Attachment index of resolve target for every color attachment
+			std::vector<uint32_t> resolveAttachments;
+			std::vector<AttachmentPolicy> attachmentPolicies;
+			std::vector<VkClearValue> clearValues;
+			std::vector<VkSubpassDependency> dependencies;
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			std::vector<VkFramebuffer> framebuffers;
+		};
+
+		struct MemoryBlock
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			uint32_t memoryTypeBits = 0;
+			bool bIsTransientAttachment = false;
+			bool bIsPersistent = false;
+			std::vector<ResourceId> resources;
+		};
+
+		// Stages and accesses of every use of one memory range in one pass
+		struct PassAccess
+		{
+			VkPipelineStageFlags stages = 0;
+			VkAccessFlags accessMask = 0;
+			// Only writes have to be made available to later accesses
+			VkAccessFlags writeAccessMask = 0;
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		};
+
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		std::vector<PassId> activePasses;
+		std::vector<MemoryBlock> memoryBlocks;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		Stats stats;
+
+		void cullPasses();
+		void computeLifetimes();
+		void createImages(VkPhysicalDevice physicalDevice, VkDevice device);
+		void deriveAttachments();
+		void deriveDependencies();
+		void createRenderPasses(VkDevice device);
+		void createFramebuffers(VkDevice device);
+
+		// Images sharing memory are one hazard, Everything else is tracked per image
+		uint32_t getHazardKey(ResourceId resource) const;
+		PassAccess getPassAccess(const Pass& pass, uint32_t hazardKey) const;
+		// Layout resource needs for its next use after active pass index, Or at end of frame
+		VkImageLayout getNextLayout(ResourceId resource, uint32_t activeIndex, VkImageLayout currentLayout) const;
+		bool isUsedBefore(ResourceId resource, uint32_t activeIndex) const;
+		bool isUsedAfter(ResourceId resource, uint32_t activeIndex) const;
+
+		static VkImageLayout getLayout(Access access);
+		static bool isDepthFormat(VkFormat format);
+		static bool hasStencilFormat(VkFormat format);
+
+	public:
+		RenderGraph() = default;
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+
+		ResourceId createImage(const std::string& name, const ImageDesc& desc);
+
+		// Image owned outside of graph with one view per frame index such as swap chain images, Passes writing it are never culled.
+		// It is handed over by a semaphore waited at color attachment output and left in finalLayout
+		ResourceId importImage(const std::string& name, VkFormat format, const std::vector<VkImageView>& views, VkImageLayout finalLayout);
+
+		// Passes are submitted in the order they are added, Multiview passes render to every view of viewMask at once
+		PassId addPass(const std::string& name, uint32_t viewMask = 0);
+
+		// Draws on top of earlier contents, Or overwrites every pixel when nothing wrote image before in this frame
+		void writeColor(PassId pass, ResourceId image, ResourceId resolveTarget = INVALID_ID);
+		void clearColor(PassId pass, ResourceId image, const VkClearColorValue& clearValue, ResourceId resolveTarget = INVALID_ID);
+		void writeDepth(PassId pass, ResourceId image);
+		void clearDepth(PassId pass, ResourceId image, const VkClearDepthStencilValue& clearValue);
+		void readSampled(PassId pass, ResourceId image, VkPipelineStageFlags stages);
+
+		void compile(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t frameWidth, uint32_t frameHeight);
+
+		// Destroys everything compile created and forgets declared passes and resources
+		void destroy(VkDevice device);
+
+		bool isPassActive(PassId pass) const
+		{
+			return passes[pass].bIsActive;
+		}
+
+		VkRenderPass getRenderPass(PassId pass) const
+		{
+			return passes[pass].renderPass;
+		}
+
+		uint32_t getFramebufferCount(PassId pass) const
+		{
+			return (uint32_t)passes[pass].framebuffers.size();
+		}
+
+		// Passes writing imported images or images with copies have one framebuffer per frame index, Others have one in total
+		VkFramebuffer getFramebuffer(PassId pass, uint32_t frameIndex) const
+		{
+			const std::vector<VkFramebuffer>& framebuffers = passes[pass].framebuffers;
+			return framebuffers[frameIndex % framebuffers.size()];
+		}
+
+		const std::vector<VkClearValue>& getClearValues(PassId pass) const
+		{
+			return passes[pass].clearValues;
+		}
+
+		const std::vector<AttachmentPolicy>& getAttachmentPolicies(PassId pass) const
+		{
+			return passes[pass].attachmentPolicies;
+		}
+
+		VkImage getImage(ResourceId image) const
+		{
+			return resources[image].image;
+		}
+
+		VkImageView getImageView(ResourceId image) const
+		{
+			return resources[image].view;
+		}
+
+		const Stats& getStats() const
+		{
+			return stats;
+		}
+	};
+}
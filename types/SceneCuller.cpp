@@ -0,0 +1,638 @@
+#include "SceneCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SCENE_CULLER_HAS_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC allows AVX2 intrinsics without /arch:AVX2, They just must not run on CPUs lacking it
+#define SCENE_CULLER_AVX2_TARGET
+#else
+#define SCENE_CULLER_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#else
+#define SCENE_CULLER_HAS_AVX2 0
+#endif
+
+namespace
+{
+	const uint32_t ALL_PLANES = (1u << vulkan::Frustum::PlaneCount) - 1;
+
+	inline uint32_t countTrailingZeros(uint32_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return index;
+#else
+		return __builtin_ctz(value);
+#endif
+	}
+}
+
+vulkan::SceneCuller::SceneCuller(uint32_t workerCount)
+{
+	bUseAvx2 = isAvx2Supported();
+	threadOutputs.resize(workerCount + 1);
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		workers.emplace_back(&SceneCuller::workerLoop, this, i);
+	}
+}
+
+vulkan::SceneCuller::~SceneCuller()
+{
+	{
+		std::lock_guard<std::mutex> lock(workMutex);
+		bIsStopping = true;
+	}
+	workCondition.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+bool vulkan::SceneCuller::isAvx2Supported()
+{
+#if !SCENE_CULLER_HAS_AVX2
+	return false;
+#elif defined(_MSC_VER)
+	static const bool bIsSupported = []()
+	{
+		int cpuInfo[4];
+		__cpuid(cpuInfo, 0);
+		if (cpuInfo[0] < 7)
+		{
+			return false;
+		}
+
+		// OS has to preserve upper halves of ymm registers, Which needs OSXSAVE and enabled AVX state
+		__cpuid(cpuInfo, 1);
+		bool bHasOsAvx = (cpuInfo[2] & (1 << 27)) != 0 && (cpuInfo[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+		__cpuidex(cpuInfo, 7, 0);
+		return bHasOsAvx && (cpuInfo[1] & (1 << 5)) != 0;
+	}();
+	return bIsSupported;
+#else
+	static const bool bIsSupported = __builtin_cpu_supports("avx2") != 0;
+	return bIsSupported;
+#endif
+}
+
+void vulkan::SceneCuller::workerLoop(uint32_t workerIndex)
+{
+	uint64_t seenGeneration = 0;
+	std::unique_lock<std::mutex> lock(workMutex);
+	while (true)
+	{
+		workCondition.wait(lock, [&]() { return bIsStopping || workGeneration != seenGeneration; });
+		if (bIsStopping)
+		{
+			return;
+		}
+		seenGeneration = workGeneration;
+
+		lock.unlock();
+		workFunction(workerIndex);
+		lock.lock();
+
+		if (--pendingWorkers == 0)
+		{
+			doneCondition.notify_one();
+		}
+	}
+}
+
+void vulkan::SceneCuller::runParallel(const std::function<void(uint32_t)>& function)
+{
+	{
+		std::lock_guard<std::mutex> lock(workMutex);
+		workFunction = function;
+		pendingWorkers = (uint32_t)workers.size();
+		workGeneration++;
+	}
+	workCondition.notify_all();
+
+	function((uint32_t)workers.size());
+
+	std::unique_lock<std::mutex> lock(workMutex);
+	doneCondition.wait(lock, [&]() { return pendingWorkers == 0; });
+}
+
+void vulkan::SceneCuller::setSlot(uint32_t slot, float x, float y, float z, float r)
+{
+	centerX[slot] = x;
+	centerY[slot] = y;
+	centerZ[slot] = z;
+	radius[slot] = r;
+}
+
+uint32_t vulkan::SceneCuller::addObject(const glm::vec3& center, float sphereRadius)
+{
+	uint32_t objectId = (uint32_t)objectSlots.size();
+	uint32_t slot = objectCount++;
+	objectSlots.push_back(slot);
+	slotObjects.push_back(objectId);
+
+	// Padding spheres have center at origin and a radius no distance can reach so that they never pass a plane test
+	centerX.resize(objectCount + LANE_PADDING, 0.0f);
+	centerY.resize(objectCount + LANE_PADDING, 0.0f);
+	centerZ.resize(objectCount + LANE_PADDING, 0.0f);
+	radius.resize(objectCount + LANE_PADDING, -FLT_MAX);
+	setSlot(slot, center.x, center.y, center.z, sphereRadius);
+
+	bIsHierarchyValid = false;
+	return objectId;
+}
+
+void vulkan::SceneCuller::moveObject(uint32_t objectId, const glm::vec3& center, float sphereRadius)
+{
+	if (objectId >= objectSlots.size())
+	{
+		throw std::runtime_error("Moving unknown scene object");
+	}
+
+	uint32_t slot = objectSlots[objectId];
+	setSlot(slot, center.x, center.y, center.z, sphereRadius);
+
+	if (bIsHierarchyValid)
+	{
+		uint32_t leaf = slotLeaves[slot];
+		if (!bIsLeafDirty[leaf])
+		{
+			bIsLeafDirty[leaf] = true;
+			dirtyLeaves.push_back(leaf);
+		}
+	}
+}
+
+void vulkan::SceneCuller::clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	radius.clear();
+	slotObjects.clear();
+	objectSlots.clear();
+	objectCount = 0;
+
+	nodes.clear();
+	slotLeaves.clear();
+	dirtyLeaves.clear();
+	bIsLeafDirty.clear();
+	bIsHierarchyValid = false;
+}
+
+double vulkan::SceneCuller::getSurfaceArea(const Node& node)
+{
+	double x = node.boundsMax[0] - node.boundsMin[0];
+	double y = node.boundsMax[1] - node.boundsMin[1];
+	double z = node.boundsMax[2] - node.boundsMin[2];
+	return 2.0 * (x * y + y * z + z * x);
+}
+
+void vulkan::SceneCuller::computeLeafBounds(Node& node) const
+{
+	const float* centers[3] = { centerX.data(), centerY.data(), centerZ.data() };
+	for (int axis = 0; axis < 3; axis++)
+	{
+		node.boundsMin[axis] = FLT_MAX;
+		node.boundsMax[axis] = -FLT_MAX;
+		for (uint32_t slot = node.firstSlot; slot < node.firstSlot + node.slotCount; slot++)
+		{
+			node.boundsMin[axis] = std::min(node.boundsMin[axis], centers[axis][slot] - radius[slot]);
+			node.boundsMax[axis] = std::max(node.boundsMax[axis], centers[axis][slot] + radius[slot]);
+		}
+	}
+}
+
+uint32_t vulkan::SceneCuller::buildNode(std::vector<BuildItem>& items, uint32_t firstSlot, uint32_t slotCount, uint32_t parent)
+{
+	uint32_t nodeIdx = (uint32_t)nodes.size();
+	nodes.push_back(Node());
+
+	Node node = {};
+	node.firstSlot = firstSlot;
+	node.slotCount = slotCount;
+	node.parent = parent;
+
+	if (slotCount <= MAX_LEAF_SIZE)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			node.boundsMin[axis] = FLT_MAX;
+			node.boundsMax[axis] = -FLT_MAX;
+			for (uint32_t i = firstSlot; i < firstSlot + slotCount; i++)
+			{
+				node.boundsMin[axis] = std::min(node.boundsMin[axis], items[i].center[axis] - items[i].radius);
+				node.boundsMax[axis] = std::max(node.boundsMax[axis], items[i].center[axis] + items[i].radius);
+			}
+		}
+		for (uint32_t slot = firstSlot; slot < firstSlot + slotCount; slot++)
+		{
+			slotLeaves[slot] = nodeIdx;
+		}
+		nodes[nodeIdx] = node;
+		return nodeIdx;
+	}
+
+	float centerMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float centerMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (uint32_t i = firstSlot; i < firstSlot + slotCount; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			centerMin[axis] = std::min(centerMin[axis], items[i].center[axis]);
+			centerMax[axis] = std::max(centerMax[axis], items[i].center[axis]);
+		}
+	}
+
+	int splitAxis = 0;
+	for (int axis = 1; axis < 3; axis++)
+	{
+		if (centerMax[axis] - centerMin[axis] > centerMax[splitAxis] - centerMin[splitAxis])
+		{
+			splitAxis = axis;
+		}
+	}
+
+	// Median split keeps tree balanced and leaves full, Which matters more for culling than a tighter SAH split
+	uint32_t leftCount = slotCount / 2;
+	std::nth_element(items.begin() + firstSlot, items.begin() + firstSlot + leftCount, items.begin() + firstSlot + slotCount,
+		[splitAxis](const BuildItem& a, const BuildItem& b)
+	{
+		return a.center[splitAxis] < b.center[splitAxis];
+	});
+
+	uint32_t leftChild = buildNode(items, firstSlot, leftCount, nodeIdx);
+	node.rightChild = buildNode(items, firstSlot + leftCount, slotCount - leftCount, nodeIdx);
+
+	const Node& left = nodes[leftChild];
+	const Node& right = nodes[node.rightChild];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		node.boundsMin[axis] = std::min(left.boundsMin[axis], right.boundsMin[axis]);
+		node.boundsMax[axis] = std::max(left.boundsMax[axis], right.boundsMax[axis]);
+	}
+	nodes[nodeIdx] = node;
+	return nodeIdx;
+}
+
+void vulkan::SceneCuller::rebuildHierarchy()
+{
+	std::vector<BuildItem> items(objectCount);
+	for (uint32_t slot = 0; slot < objectCount; slot++)
+	{
+		items[slot] = { { centerX[slot], centerY[slot], centerZ[slot] }, radius[slot], slotObjects[slot] };
+	}
+
+	nodes.clear();
+	nodes.reserve(2 * (objectCount / MAX_LEAF_SIZE + 1));
+	slotLeaves.assign(objectCount, 0);
+	dirtyLeaves.clear();
+
+	if (objectCount > 0)
+	{
+		buildNode(items, 0, objectCount, 0);
+	}
+
+	// Reordering spheres to leaf order so that every subtree is a contiguous run of slots
+	for (uint32_t slot = 0; slot < objectCount; slot++)
+	{
+		const BuildItem& item = items[slot];
+		setSlot(slot, item.center[0], item.center[1], item.center[2], item.radius);
+		slotObjects[slot] = item.objectId;
+		objectSlots[item.objectId] = slot;
+	}
+
+	bIsLeafDirty.assign(nodes.size(), false);
+	surfaceArea = 0;
+	for (const Node& node : nodes)
+	{
+		surfaceArea += getSurfaceArea(node);
+	}
+	builtSurfaceArea = surfaceArea;
+	bIsHierarchyValid = true;
+}
+
+void vulkan::SceneCuller::refitLeaf(uint32_t nodeIdx)
+{
+	Node& leaf = nodes[nodeIdx];
+	surfaceArea -= getSurfaceArea(leaf);
+	computeLeafBounds(leaf);
+	surfaceArea += getSurfaceArea(leaf);
+
+	// Walking up until a parent already has the right bounds, Other dirty leaves below it may still change it later
+	while (nodeIdx != 0)
+	{
+		nodeIdx = nodes[nodeIdx].parent;
+		Node& node = nodes[nodeIdx];
+		const Node& left = nodes[nodeIdx + 1];
+		const Node& right = nodes[node.rightChild];
+
+		Node refitted = node;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			refitted.boundsMin[axis] = std::min(left.boundsMin[axis], right.boundsMin[axis]);
+			refitted.boundsMax[axis] = std::max(left.boundsMax[axis], right.boundsMax[axis]);
+		}
+		if (std::equal(refitted.boundsMin, refitted.boundsMin + 3, node.boundsMin) &&
+			std::equal(refitted.boundsMax, refitted.boundsMax + 3, node.boundsMax))
+		{
+			break;
+		}
+
+		surfaceArea += getSurfaceArea(refitted) - getSurfaceArea(node);
+		node = refitted;
+	}
+}
+
+void vulkan::SceneCuller::updateHierarchy()
+{
+	if (!bIsHierarchyValid)
+	{
+		rebuildHierarchy();
+		return;
+	}
+
+	for (uint32_t leaf : dirtyLeaves)
+	{
+		bIsLeafDirty[leaf] = false;
+		refitLeaf(leaf);
+	}
+	dirtyLeaves.clear();
+
+	// Objects that moved far apart leave large overlapping nodes behind, Rebuilding is cheaper than traversing them every frame
+	if (surfaceArea > builtSurfaceArea * REBUILD_AREA_FACTOR)
+	{
+		rebuildHierarchy();
+	}
+}
+
+void vulkan::SceneCuller::testSpheres(uint32_t firstSlot, uint32_t slotCount, const Frustum& frustum, uint32_t planeMask,
+	std::vector<uint32_t>& visibleObjects) const
+{
+#if SCENE_CULLER_HAS_AVX2
+	if (bUseAvx2)
+	{
+		testSpheresAvx2(firstSlot, slotCount, frustum, planeMask, visibleObjects);
+		return;
+	}
+#endif
+	testSpheresScalar(firstSlot, slotCount, frustum, planeMask, visibleObjects);
+}
+
+void vulkan::SceneCuller::testSpheresScalar(uint32_t firstSlot, uint32_t slotCount, const Frustum& frustum, uint32_t planeMask,
+	std::vector<uint32_t>& visibleObjects) const
+{
+	for (uint32_t slot = firstSlot; slot < firstSlot + slotCount; slot++)
+	{
+		bool bIsVisible = true;
+		for (uint32_t plane = 0; plane < Frustum::PlaneCount && bIsVisible; plane++)
+		{
+			if (planeMask & (1u << plane))
+			{
+				const glm::vec4& p = frustum.planes[plane];
+				float distance = centerX[slot] * p.x + centerY[slot] * p.y + centerZ[slot] * p.z + p.w;
+				bIsVisible = distance >= -radius[slot];
+			}
+		}
+
+		if (bIsVisible)
+		{
+			visibleObjects.push_back(slotObjects[slot]);
+		}
+	}
+}
+
+#if SCENE_CULLER_HAS_AVX2
+SCENE_CULLER_AVX2_TARGET
+void vulkan::SceneCuller::testSpheresAvx2(uint32_t firstSlot, uint32_t slotCount, const Frustum& frustum, uint32_t planeMask,
+	std::vector<uint32_t>& visibleObjects) const
+{
+	__m256 planeX[Frustum::PlaneCount];
+	__m256 planeY[Frustum::PlaneCount];
+	__m256 planeZ[Frustum::PlaneCount];
+	__m256 planeW[Frustum::PlaneCount];
+	uint32_t activePlaneCount = 0;
+	for (uint32_t plane = 0; plane < Frustum::PlaneCount; plane++)
+	{
+		if (planeMask & (1u << plane))
+		{
+			const glm::vec4& p = frustum.planes[plane];
+			planeX[activePlaneCount] = _mm256_set1_ps(p.x);
+			planeY[activePlaneCount] = _mm256_set1_ps(p.y);
+			planeZ[activePlaneCount] = _mm256_set1_ps(p.z);
+			planeW[activePlaneCount] = _mm256_set1_ps(p.w);
+			activePlaneCount++;
+		}
+	}
+
+	// Same operation order as scalar path, Compiler may still contract scalar path into FMA so spheres within rounding of a plane can land differently
+	for (uint32_t offset = 0; offset < slotCount; offset += 8)
+	{
+		uint32_t slot = firstSlot + offset;
+		__m256 x = _mm256_loadu_ps(centerX.data() + slot);
+		__m256 y = _mm256_loadu_ps(centerY.data() + slot);
+		__m256 z = _mm256_loadu_ps(centerZ.data() + slot);
+		__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius.data() + slot));
+
+		__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (uint32_t plane = 0; plane < activePlaneCount; plane++)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(x, planeX[plane]), _mm256_mul_ps(y, planeY[plane])), _mm256_mul_ps(z, planeZ[plane])), planeW[plane]);
+			visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+		}
+
+		uint32_t laneMask = (uint32_t)_mm256_movemask_ps(visible);
+		if (slotCount - offset < 8)
+		{
+			laneMask &= (1u << (slotCount - offset)) - 1;
+		}
+		while (laneMask != 0)
+		{
+			visibleObjects.push_back(slotObjects[slot + countTrailingZeros(laneMask)]);
+			laneMask &= laneMask - 1;
+		}
+	}
+}
+#else
+void vulkan::SceneCuller::testSpheresAvx2(uint32_t firstSlot, uint32_t slotCount, const Frustum& frustum, uint32_t planeMask,
+	std::vector<uint32_t>& visibleObjects) const
+{
+	testSpheresScalar(firstSlot, slotCount, frustum, planeMask, visibleObjects);
+}
+#endif
+
+bool vulkan::SceneCuller::classifyNode(const Node& node, const Frustum& frustum, uint32_t& planeMask) const
+{
+	for (uint32_t plane = 0; plane < Frustum::PlaneCount; plane++)
+	{
+		if ((planeMask & (1u << plane)) == 0)
+		{
+			continue;
+		}
+
+		// Corner furthest along plane normal decides whether box is outside, Nearest corner whether it is completely inside
+		const glm::vec4& p = frustum.planes[plane];
+		float furthest = p.w;
+		float nearest = p.w;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float minDistance = p[axis] * node.boundsMin[axis];
+			float maxDistance = p[axis] * node.boundsMax[axis];
+			furthest += std::max(minDistance, maxDistance);
+			nearest += std::min(minDistance, maxDistance);
+		}
+
+		if (furthest < 0)
+		{
+			return false;
+		}
+		if (nearest >= 0)
+		{
+			planeMask &= ~(1u << plane);
+		}
+	}
+	return true;
+}
+
+void vulkan::SceneCuller::appendSubtree(const Node& node, std::vector<uint32_t>& visibleObjects) const
+{
+	visibleObjects.insert(visibleObjects.end(), slotObjects.begin() + node.firstSlot, slotObjects.begin() + node.firstSlot + node.slotCount);
+}
+
+void vulkan::SceneCuller::traverse(uint32_t nodeIdx, const Frustum& frustum, uint32_t planeMask, std::vector<uint32_t>& visibleObjects) const
+{
+	const Node& node = nodes[nodeIdx];
+	if (!classifyNode(node, frustum, planeMask))
+	{
+		return;
+	}
+
+	if (planeMask == 0)
+	{
+		appendSubtree(node, visibleObjects);
+	}
+	else if (node.rightChild == 0)
+	{
+		testSpheres(node.firstSlot, node.slotCount, frustum, planeMask, visibleObjects);
+	}
+	else
+	{
+		traverse(nodeIdx + 1, frustum, planeMask, visibleObjects);
+		traverse(node.rightChild, frustum, planeMask, visibleObjects);
+	}
+}
+
+void vulkan::SceneCuller::cullLinear(const Frustum& frustum, std::vector<uint32_t>& visibleObjects)
+{
+	visibleObjects.clear();
+	visibleObjects.reserve(objectCount);
+	if (workers.empty())
+	{
+		testSpheres(0, objectCount, frustum, ALL_PLANES, visibleObjects);
+		return;
+	}
+
+	// Chunks are whole batches of 8 so that no sphere is loaded by two threads
+	uint32_t threadCount = (uint32_t)workers.size() + 1;
+	uint32_t chunkSize = ((objectCount + threadCount - 1) / threadCount + 7) & ~7u;
+	runParallel([&](uint32_t thread)
+	{
+		std::vector<uint32_t>& output = threadOutputs[thread];
+		output.clear();
+		uint32_t firstSlot = std::min(thread * chunkSize, objectCount);
+		testSpheres(firstSlot, std::min(chunkSize, objectCount - firstSlot), frustum, ALL_PLANES, output);
+	});
+
+	for (const std::vector<uint32_t>& output : threadOutputs)
+	{
+		visibleObjects.insert(visibleObjects.end(), output.begin(), output.end());
+	}
+}
+
+void vulkan::SceneCuller::cullHierarchy(const Frustum& frustum, std::vector<uint32_t>& visibleObjects)
+{
+	updateHierarchy();
+
+	visibleObjects.clear();
+	visibleObjects.reserve(objectCount);
+	if (objectCount == 0)
+	{
+		return;
+	}
+	if (workers.empty())
+	{
+		traverse(0, frustum, ALL_PLANES, visibleObjects);
+		return;
+	}
+
+	struct Subtree
+	{
+		uint32_t node;
+		uint32_t planeMask;
+	};
+
+	// Expanding top of tree on calling thread until there are enough subtrees to balance threads
+	uint32_t threadCount = (uint32_t)workers.size() + 1;
+	std::vector<Subtree> frontier = { { 0, ALL_PLANES } };
+	std::vector<Subtree> expanded;
+	while (frontier.size() < threadCount * 4)
+	{
+		bool bHasInnerNodes = false;
+		expanded.clear();
+		for (const Subtree& subtree : frontier)
+		{
+			const Node& node = nodes[subtree.node];
+			uint32_t planeMask = subtree.planeMask;
+			if (!classifyNode(node, frustum, planeMask))
+			{
+				continue;
+			}
+
+			if (planeMask == 0)
+			{
+				appendSubtree(node, visibleObjects);
+			}
+			else if (node.rightChild == 0)
+			{
+				expanded.push_back({ subtree.node, planeMask });
+			}
+			else
+			{
+				expanded.push_back({ subtree.node + 1, planeMask });
+				expanded.push_back({ node.rightChild, planeMask });
+				bHasInnerNodes = true;
+			}
+		}
+		frontier.swap(expanded);
+
+		if (!bHasInnerNodes)
+		{
+			break;
+		}
+	}
+
+	runParallel([&](uint32_t thread)
+	{
+		std::vector<uint32_t>& output = threadOutputs[thread];
+		output.clear();
+		for (size_t i = thread; i < frontier.size(); i += threadCount)
+		{
+			traverse(frontier[i].node, frustum, frontier[i].planeMask, output);
+		}
+	});
+
+	for (const std::vector<uint32_t>& output : threadOutputs)
+	{
+		visibleObjects.insert(visibleObjects.end(), output.begin(), output.end());
+	}
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "Frustum.h"
+
+namespace vulkan
+{
+	// Frustum culling of scene objects bounded by spheres, Either linearly over all objects or through a bounding volume hierarchy.
+	// Spheres are kept in structure of arrays layout so that 8 of them are tested against a plane at once with AVX2 when available
+	class SceneCuller
+	{
+	private:
+		// Objects per BVH leaf, One AVX2 batch
+		static const uint32_t MAX_LEAF_SIZE = 8;
+		// Arrays are padded with never visible spheres so that batches can always load 8 lanes
+		static const uint32_t LANE_PADDING = 8;
+		// Refitted hierarchy gets rebuilt once its total node surface area grew past this factor of the freshly built one
+		static constexpr float REBUILD_AREA_FACTOR = 1.5f;
+
+		struct Node
+		{
+			float boundsMin[3];
+			float boundsMax[3];
+			// Slots of all objects below this node are contiguous
+			uint32_t firstSlot;
+			uint32_t slotCount;
+			// Left child directly follows its parent, 0 for leaves
+			uint32_t rightChild;
+			uint32_t parent;
+		};
+
+		struct BuildItem
+		{
+			float center[3];
+			float radius;
+			uint32_t objectId;
+		};
+
+		// Sphere of slot i is centerX[i], centerY[i], centerZ[i], radius[i], Slots are in BVH leaf order after a rebuild
+		std::vector<float> centerX;
+		std::vector<float> centerY;
+		std::vector<float> centerZ;
+		std::vector<float> radius;
+		std::vector<uint32_t> slotObjects;
+		std::vector<uint32_t> objectSlots;
+		uint32_t objectCount = 0;
+
+		std::vector<Node> nodes;
+		std::vector<uint32_t> slotLeaves;
+		std::vector<uint32_t> dirtyLeaves;
+		std::vector<bool> bIsLeafDirty;
+		double builtSurfaceArea = 0;
+		double surfaceArea = 0;
+		bool bIsHierarchyValid = false;
+
+		bool bUseAvx2;
+
+		// Persistent workers so that culling every frame does not pay for thread creation, Calling thread takes the last share
+		std::vector<std::thread> workers;
+		std::mutex workMutex;
+		std::condition_variable workCondition;
+		std::condition_variable doneCondition;
+		std::function<void(uint32_t)> workFunction;
+		uint64_t workGeneration = 0;
+		uint32_t pendingWorkers = 0;
+		bool bIsStopping = false;
+		std::vector<std::vector<uint32_t>> threadOutputs;
+
+		void workerLoop(uint32_t workerIndex);
+		void runParallel(const std::function<void(uint32_t)>& function);
+
+		void setSlot(uint32_t slot, float x, float y, float z, float r);
+		// Splits items at median of longest axis until leaves fit, Returns index of created node
+		uint32_t buildNode(std::vector<BuildItem>& items, uint32_t firstSlot, uint32_t slotCount, uint32_t parent);
+		void computeLeafBounds(Node& node) const;
+		void refitLeaf(uint32_t nodeIdx);
+		static double getSurfaceArea(const Node& node);
+
+		// Appends objects of slot range whose spheres intersect every plane in planeMask
+		void testSpheres(uint32_t firstSlot, uint32_t slotCount, const Frustum& frustum, uint32_t planeMask, std::vector<uint32_t>& visibleObjects) const;
+		void testSpheresScalar(uint32_t firstSlot, uint32_t slotCount, const Frustum& frustum, uint32_t planeMask,
+			std::vector<uint32_t>& visibleObjects) const;
+		void testSpheresAvx2(uint32_t firstSlot, uint32_t slotCount, const Frustum& frustum, uint32_t planeMask,
+			std::vector<uint32_t>& visibleObjects) const;
+
+		// Clears planes of planeMask that node is completely inside of, Returns false when node is outside of one
+		bool classifyNode(const Node& node, const Frustum& frustum, uint32_t& planeMask) const;
+		void traverse(uint32_t nodeIdx, const Frustum& frustum, uint32_t planeMask, std::vector<uint32_t>& visibleObjects) const;
+		void appendSubtree(const Node& node, std::vector<uint32_t>& visibleObjects) const;
+
+	public:
+		// workerCount threads are started in addition to the calling thread
+		explicit SceneCuller(uint32_t workerCount = 0);
+		~SceneCuller();
+
+		SceneCuller(const SceneCuller&) = delete;
+		SceneCuller& operator=(const SceneCuller&) = delete;
+
+		// Returns id of the new object, Hierarchy gets rebuilt on next cull
+		uint32_t addObject(const glm::vec3& center, float sphereRadius);
+
+		// Moved objects only refit the hierarchy on next cull
+		void moveObject(uint32_t objectId, const glm::vec3& center, float sphereRadius);
+
+		void clear();
+
+		// Tests every object, Suits small or mostly moving scenes
+		void cullLinear(const Frustum& frustum, std::vector<uint32_t>& visibleObjects);
+
+		// Brings hierarchy up to date and skips whole subtrees that are completely outside or inside of frustum
+		void cullHierarchy(const Frustum& frustum, std::vector<uint32_t>& visibleObjects);
+
+		void rebuildHierarchy();
+
+		// Refits nodes above moved objects, Rebuilds when refitting made the hierarchy too loose
+		void updateHierarchy();
+
+		uint32_t getObjectCount() const
+		{
+			return objectCount;
+		}
+
+		uint32_t getWorkerCount() const
+		{
+			return (uint32_t)workers.size();
+		}
+
+		// AVX2 is used by default whenever CPU supports it
+		void setUseAvx2(bool bEnable)
+		{
+			bUseAvx2 = bEnable && isAvx2Supported();
+		}
+
+		bool isUsingAvx2() const
+		{
+			return bUseAvx2;
+		}
+
+		static bool isAvx2Supported();
+	};
+}
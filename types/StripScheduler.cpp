@@ -0,0 +1,65 @@
+#include "StripScheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+void vulkan::StripScheduler::configure(uint32_t count, uint32_t rowCount, double leadTime)
+{
+	if (count == 0 || count > MAX_STRIPS || count > rowCount)
+	{
+		throw std::runtime_error("Strip count has to be between 1 and " + std::to_string(MAX_STRIPS) + " and at most the row count");
+	}
+
+	lead = leadTime;
+	if (count == stripCount && rowCount == height)
+	{
+		return;
+	}
+	stripCount = count;
+	height = rowCount;
+
+	std::lock_guard<std::mutex> lock(statsMutex);
+	stats.assign(stripCount, StripStats());
+	for (uint32_t i = 0; i < stripCount; i++)
+	{
+		stats[i].firstRow = i * height / stripCount;
+		stats[i].rowCount = (i + 1) * height / stripCount - stats[i].firstRow;
+	}
+}
+
+vulkan::StripScheduler::Strip vulkan::StripScheduler::getStrip(const DisplayClock& clock, double vsync, uint32_t index) const
+{
+	Strip strip;
+	strip.index = index;
+	strip.firstRow = index * height / stripCount;
+	strip.rowCount = (index + 1) * height / stripCount - strip.firstRow;
+	strip.deadline = clock.getScanoutTime(vsync, (double)strip.firstRow / height);
+	strip.releaseTime = strip.deadline - lead;
+	return strip;
+}
+
+void vulkan::StripScheduler::addCompletion(const Strip& strip, double completionTime)
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	if (strip.index >= stats.size())
+	{
+		return;
+	}
+
+	StripStats& stripStats = stats[strip.index];
+	double margin = strip.deadline - completionTime;
+	stripStats.minMargin = stripStats.frameCount == 0 ? margin : std::min(stripStats.minMargin, margin);
+	stripStats.marginSum += margin;
+	stripStats.frameCount++;
+	if (margin < 0.0)
+	{
+		stripStats.missCount++;
+	}
+}
+
+std::vector<vulkan::StripScheduler::StripStats> vulkan::StripScheduler::getStats() const
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	return stats;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "DisplayClock.h"
+
+namespace vulkan
+{
+	// Splits distortion pass of a frame into horizontal strips in scanout order, Each released for submission lead seconds before scanout
+	// of display clock reaches its first row so that it samples pose as late as its own rows allow. Completions are checked against that
+	// scanout time and deadline misses are counted per strip
+	class StripScheduler
+	{
+	public:
+		static constexpr uint32_t MAX_STRIPS = 16;
+
+		struct Strip
+		{
+			uint32_t index = 0;
+			uint32_t firstRow = 0;
+			uint32_t rowCount = 0;
+			double releaseTime = 0;
+			// Scanout reaches first row of strip, Strip has to be complete on GPU by then
+			double deadline = 0;
+		};
+
+		struct StripStats
+		{
+			uint32_t firstRow = 0;
+			uint32_t rowCount = 0;
+			uint64_t frameCount = 0;
+			uint64_t missCount = 0;
+			// Completion ahead of deadline, Negative for misses
+			double marginSum = 0;
+			double minMargin = 0;
+		};
+
+		StripScheduler() = default;
+		StripScheduler(const StripScheduler&) = delete;
+		StripScheduler& operator=(const StripScheduler&) = delete;
+
+		// Strips split height rows evenly, Stats are kept while strips stay the same. Not to be called while strips are in flight
+		void configure(uint32_t stripCount, uint32_t height, double lead);
+
+		uint32_t getStripCount() const
+		{
+			return stripCount;
+		}
+
+		double getLead() const
+		{
+			return lead;
+		}
+
+		// Strip index of frame whose scanout starts at vertical blank vsync of clock
+		Strip getStrip(const DisplayClock& clock, double vsync, uint32_t index) const;
+
+		// Strip got complete on GPU at completionTime of display clock, Any thread
+		void addCompletion(const Strip& strip, double completionTime);
+
+		std::vector<StripStats> getStats() const;
+
+	private:
+		uint32_t stripCount = 0;
+		uint32_t height = 0;
+		double lead = 0;
+
+		mutable std::mutex statsMutex;
+		std::vector<StripStats> stats;
+	};
+}
@@ -0,0 +1,209 @@
+#include "TextureCache.h"
+#include "ContentHash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+std::string vulkan::TextureCache::getCachePath(uint64_t key) const
+{
+	std::stringstream pathStream;
+	pathStream << cacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".tex";
+	return pathStream.str();
+}
+
+uint64_t vulkan::TextureCache::computeKey(const void* sourceData, size_t sourceSize, const TextureCacheSettings& settings)
+{
+	uint64_t key = ContentHash::hashBytes(sourceData, sourceSize);
+	key = ContentHash::combine(key, ContentHash::hashValue(settings.format));
+	key = ContentHash::combine(key, ContentHash::hashValue(settings.bytesPerPixel));
+	key = ContentHash::combine(key, ContentHash::hashValue(settings.mipLevels));
+	key = ContentHash::combine(key, ContentHash::hashValue(CACHE_VERSION));
+	return key;
+}
+
+uint32_t vulkan::TextureCache::getFullMipLevels(uint32_t width, uint32_t height)
+{
+	uint32_t mipLevels = 1;
+	for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+	{
+		mipLevels++;
+	}
+	return mipLevels;
+}
+
+bool vulkan::TextureCache::find(uint64_t key, const TextureCacheSettings& settings, MappedFile& mapping, TexturePyramid& pyramid)
+{
+	if (!mapping.open(getCachePath(key)) || mapping.size() < sizeof(FileHeader))
+	{
+		mapping.close();
+		misses++;
+		return false;
+	}
+
+	FileHeader header;
+	memcpy(&header, mapping.data(), sizeof(FileHeader));
+
+	// Mip count is bounded before it sizes anything, Offsets and sizes are compared without sums that could wrap around
+	bool bIsValid = header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.key == key && header.format == settings.format &&
+		settings.bytesPerPixel > 0 && header.width > 0 && header.height > 0 && header.mipLevels > 0 &&
+		header.mipLevels <= getFullMipLevels(header.width, header.height) && (settings.mipLevels == 0 || header.mipLevels == settings.mipLevels);
+	uint64_t mipTableSize = sizeof(TextureMipInfo) * (uint64_t)header.mipLevels;
+	bIsValid = bIsValid && header.pixelsOffset <= mapping.size() && header.pixelsSize <= mapping.size() - header.pixelsOffset &&
+		sizeof(FileHeader) + mipTableSize <= header.pixelsOffset;
+
+	if (bIsValid)
+	{
+		pyramid.mips.resize(header.mipLevels);
+		memcpy(pyramid.mips.data(), mapping.data() + sizeof(FileHeader), (size_t)mipTableSize);
+		bIsValid = isValidMipChain(pyramid.mips, header.width, header.height, settings.bytesPerPixel, header.pixelsSize);
+	}
+
+	if (!bIsValid)
+	{
+		std::cerr << "Texture cache entry " << getCachePath(key) << " is invalid, Ignoring it" << std::endl;
+		pyramid.mips.clear();
+		mapping.close();
+		misses++;
+		return false;
+	}
+
+	pyramid.format = header.format;
+	pyramid.width = header.width;
+	pyramid.height = header.height;
+	pyramid.pixels = mapping.data() + header.pixelsOffset;
+	pyramid.pixelsSize = header.pixelsSize;
+
+	hits++;
+	return true;
+}
+
+// Every level halves previous one down to 1 like buildMipChain and lies within pixels, So copies made from the table stay in bounds
+bool vulkan::TextureCache::isValidMipChain(const std::vector<TextureMipInfo>& mips, uint32_t width, uint32_t height, uint32_t bytesPerPixel,
+	uint64_t pixelsSize)
+{
+	uint32_t mipWidth = width, mipHeight = height;
+	for (const TextureMipInfo& mip : mips)
+	{
+		if (mip.width != mipWidth || mip.height != mipHeight || mip.size % bytesPerPixel != 0 ||
+			mip.size / bytesPerPixel != (uint64_t)mipWidth * mipHeight || mip.offset > pixelsSize || mip.size > pixelsSize - mip.offset)
+		{
+			return false;
+		}
+
+		mipWidth = std::max(1u, mipWidth / 2);
+		mipHeight = std::max(1u, mipHeight / 2);
+	}
+	return true;
+}
+
+bool vulkan::TextureCache::store(uint64_t key, const TexturePyramid& pyramid)
+{
+	std::error_code errorCode;
+	std::filesystem::create_directories(cacheDirectory, errorCode);
+
+	FileHeader header = {};
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.key = key;
+	header.format = pyramid.format;
+	header.width = pyramid.width;
+	header.height = pyramid.height;
+	header.mipLevels = (uint32_t)pyramid.mips.size();
+	// Pixels starts at 16 byte aligned offset so that mapped data can be copied with aligned loads
+	header.pixelsOffset = (sizeof(FileHeader) + sizeof(TextureMipInfo) * pyramid.mips.size() + 15) & ~uint64_t(15);
+	header.pixelsSize = pyramid.pixelsSize;
+
+	// Writing to temporary file first so that a crash in between never leaves a partially written entry
+	std::string cachePath = getCachePath(key);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << "Failed to open texture cache file " << tempPath << " for writing" << std::endl;
+			std::filesystem::remove(tempPath, errorCode);
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+		file.write(reinterpret_cast<const char*>(pyramid.mips.data()), sizeof(TextureMipInfo) * pyramid.mips.size());
+
+		static const char padding[16] = {};
+		file.write(padding, header.pixelsOffset - (sizeof(FileHeader) + sizeof(TextureMipInfo) * pyramid.mips.size()));
+		file.write(reinterpret_cast<const char*>(pyramid.pixels), pyramid.pixelsSize);
+
+		if (!file.good())
+		{
+			std::cerr << "Failed writing texture cache file " << tempPath << std::endl;
+			file.close();
+			std::filesystem::remove(tempPath, errorCode);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, cachePath, errorCode);
+	if (errorCode)
+	{
+		std::cerr << "Failed to move texture cache file " << tempPath << " to " << cachePath << std::endl;
+		std::filesystem::remove(tempPath, errorCode);
+		return false;
+	}
+	return true;
+}
+
+void vulkan::TextureCache::buildMipChain(const uint8_t* basePixels, uint32_t width, uint32_t height, uint32_t mipLevels, uint32_t bytesPerPixel,
+	std::vector<uint8_t>& outPixels, std::vector<TextureMipInfo>& outMips)
+{
+	outMips.resize(mipLevels);
+	uint64_t totalSize = 0;
+	uint32_t mipWidth = width, mipHeight = height;
+	for (uint32_t i = 0; i < mipLevels; i++)
+	{
+		outMips[i].offset = totalSize;
+		outMips[i].size = (uint64_t)mipWidth * mipHeight * bytesPerPixel;
+		outMips[i].width = mipWidth;
+		outMips[i].height = mipHeight;
+		totalSize += outMips[i].size;
+
+		mipWidth = std::max(1u, mipWidth / 2);
+		mipHeight = std::max(1u, mipHeight / 2);
+	}
+
+	outPixels.resize((size_t)totalSize);
+	memcpy(outPixels.data(), basePixels, (size_t)outMips[0].size);
+
+	for (uint32_t i = 1; i < mipLevels; i++)
+	{
+		const TextureMipInfo& srcMip = outMips[i - 1];
+		const TextureMipInfo& dstMip = outMips[i];
+		const uint8_t* src = outPixels.data() + srcMip.offset;
+		uint8_t* dst = outPixels.data() + dstMip.offset;
+
+		for (uint32_t y = 0; y < dstMip.height; y++)
+		{
+			uint32_t srcY0 = std::min(y * 2, srcMip.height - 1);
+			uint32_t srcY1 = std::min(y * 2 + 1, srcMip.height - 1);
+			for (uint32_t x = 0; x < dstMip.width; x++)
+			{
+				uint32_t srcX0 = std::min(x * 2, srcMip.width - 1);
+				uint32_t srcX1 = std::min(x * 2 + 1, srcMip.width - 1);
+
+				const uint8_t* p00 = src + ((size_t)srcY0 * srcMip.width + srcX0) * bytesPerPixel;
+				const uint8_t* p01 = src + ((size_t)srcY0 * srcMip.width + srcX1) * bytesPerPixel;
+				const uint8_t* p10 = src + ((size_t)srcY1 * srcMip.width + srcX0) * bytesPerPixel;
+				const uint8_t* p11 = src + ((size_t)srcY1 * srcMip.width + srcX1) * bytesPerPixel;
+				uint8_t* out = dst + ((size_t)y * dstMip.width + x) * bytesPerPixel;
+
+				for (uint32_t c = 0; c < bytesPerPixel; c++)
+				{
+					out[c] = (uint8_t)((p00[c] + p01[c] + p10[c] + p11[c] + 2) >> 2);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace vulkan
+{
+	struct TextureMipInfo
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	// Settings that changes the decoded result, Everything in here is part of the cache key
+	struct TextureCacheSettings
+	{
+		uint32_t format;
+		uint32_t bytesPerPixel = 4;
+		uint32_t mipLevels;
+	};
+
+	// Fully decoded mip pyramid, Pixels are either owned by caller or point into a mapped cache file
+	struct TexturePyramid
+	{
+		uint32_t format;
+		uint32_t width;
+		uint32_t height;
+		std::vector<TextureMipInfo> mips;
+		const uint8_t* pixels = nullptr;
+		uint64_t pixelsSize = 0;
+	};
+
+	// Disk cache of decoded textures with their whole mip chain, keyed by content of the source image and decode settings
+	class TextureCache
+	{
+	private:
+		static constexpr uint32_t CACHE_MAGIC = 0x48435453;// STCH
+		static constexpr uint32_t CACHE_VERSION = 1;
+
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t key;
+			uint32_t format;
+			uint32_t width;
+			uint32_t height;
+			uint32_t mipLevels;
+			uint64_t pixelsOffset;
+			uint64_t pixelsSize;
+		};
+
+		std::string cacheDirectory;
+
+		uint32_t hits = 0;
+		uint32_t misses = 0;
+
+		std::string getCachePath(uint64_t key) const;
+
+		static bool isValidMipChain(const std::vector<TextureMipInfo>& mips, uint32_t width, uint32_t height, uint32_t bytesPerPixel,
+			uint64_t pixelsSize);
+
+	public:
+		explicit TextureCache(const std::string& directory = "Cache/Textures") : cacheDirectory(directory)
+		{}
+
+		static uint64_t computeKey(const void* sourceData, size_t sourceSize, const TextureCacheSettings& settings);
+
+		// Maps the cached pyramid for key if present and laid out as settings ask for, pyramid pixels are valid as long as mapping is open
+		bool find(uint64_t key, const TextureCacheSettings& settings, MappedFile& mapping, TexturePyramid& pyramid);
+
+		bool store(uint64_t key, const TexturePyramid& pyramid);
+
+		// Levels of a full mip chain, Halving the larger side down to 1
+		static uint32_t getFullMipLevels(uint32_t width, uint32_t height);
+
+		// Box filters base level of 8 bit channels down to mipLevels levels, Same halving rule as image blit based generation
+		static void buildMipChain(const uint8_t* basePixels, uint32_t width, uint32_t height, uint32_t mipLevels, uint32_t bytesPerPixel,
+			std::vector<uint8_t>& outPixels, std::vector<TextureMipInfo>& outMips);
+
+		uint32_t getHits() const
+		{
+			return hits;
+		}
+
+		uint32_t getMisses() const
+		{
+			return misses;
+		}
+	};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace vulkan
+{
+	// Hands the latest value of one writer thread to one reader thread without either of them ever waiting. Writer and reader own a slot each
+	// and trade it for the middle one, Writer when it publishes and reader when something newer than what it holds got published.
+	// Values published in between reads are skipped so they have to describe whole state rather than changes
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer() = default;
+
+		explicit TripleBuffer(const T& initialValue) : slots{ initialValue, initialValue, initialValue }
+		{
+		}
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		// Writer thread only
+		void publish(const T& value)
+		{
+			slots[writeSlot] = value;
+			uint32_t previousMiddle = middle.exchange(writeSlot | FRESH_BIT, std::memory_order_acq_rel);
+			writeSlot = previousMiddle & SLOT_MASK;
+		}
+
+		// Reader thread only, Takes over latest published value when there is one it does not hold yet
+		bool update()
+		{
+			if ((middle.load(std::memory_order_acquire) & FRESH_BIT) == 0)
+			{
+				return false;
+			}
+
+			uint32_t previousMiddle = middle.exchange(readSlot, std::memory_order_acq_rel);
+			readSlot = previousMiddle & SLOT_MASK;
+			return true;
+		}
+
+		// Reader thread only, Value taken over by last update
+		const T& read() const
+		{
+			return slots[readSlot];
+		}
+
+	private:
+		static const uint32_t SLOT_MASK = 3;
+		// Middle slot holds a value reader did not take over yet
+		static const uint32_t FRESH_BIT = 4;
+
+		T slots[3];
+		// Writer and reader indices sit on their own cache lines so that neither thread invalidates the other's
+		alignas(64) uint32_t writeSlot = 0;
+		alignas(64) std::atomic<uint32_t> middle{ 1 };
+		alignas(64) uint32_t readSlot = 2;
+	};
+}
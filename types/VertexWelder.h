@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include "ContentHash.h"
+
+namespace vulkan
+{
+	// Deduplicates vertices into unique vertex and index lists using flat open addressing table
+	// Vertices are compared and hashed as raw bytes so VertexType must not have uninitialized padding
+	// VertexType must be made of 32 bit floats, -0.0f gets canonicalized to 0.0f so both weld into same vertex
+	template<typename VertexType>
+	class VertexWelder
+	{
+	private:
+		static_assert(sizeof(VertexType) % sizeof(uint32_t) == 0, "VertexType must be made of 32 bit floats");
+
+		static const uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+
+		// Indices above this count gets welded in parallel shards when using weldStream
+		static const size_t PARALLEL_WELD_THRESHOLD = 1 << 20;
+
+		struct Slot
+		{
+			uint32_t hashTag;
+			uint32_t vertexIndex;
+		};
+
+		std::vector<Slot> table;
+		size_t tableMask;
+		size_t usedSlots = 0;
+
+		std::vector<VertexType>& vertices;
+
+		static size_t getCapacityFor(size_t expectedVertices)
+		{
+			// Keeping load factor under 0.75
+			size_t capacity = 16;
+			while (capacity * 3 < expectedVertices * 4)
+			{
+				capacity <<= 1;
+			}
+			return capacity;
+		}
+
+		void grow()
+		{
+			std::vector<Slot> oldTable;
+			oldTable.swap(table);
+
+			table.assign(oldTable.size() * 2, { 0, EMPTY_SLOT });
+			tableMask = table.size() - 1;
+
+			for (const Slot& slot : oldTable)
+			{
+				if (slot.vertexIndex != EMPTY_SLOT)
+				{
+					insertSlot(ContentHash::hashValue(vertices[slot.vertexIndex]), slot.vertexIndex);
+				}
+			}
+		}
+
+		static VertexType canonicalize(const VertexType& vertex)
+		{
+			uint32_t words[sizeof(VertexType) / sizeof(uint32_t)];
+			memcpy(words, &vertex, sizeof(VertexType));
+			for (uint32_t& word : words)
+			{
+				if (word == 0x80000000u)
+				{
+					word = 0;
+				}
+			}
+
+			VertexType canonical;
+			memcpy(&canonical, words, sizeof(VertexType));
+			return canonical;
+		}
+
+		void insertSlot(uint64_t hash, uint32_t vertexIndex)
+		{
+			size_t slotIdx = (size_t)hash & tableMask;
+			while (table[slotIdx].vertexIndex != EMPTY_SLOT)
+			{
+				slotIdx = (slotIdx + 1) & tableMask;
+			}
+			table[slotIdx] = { (uint32_t)(hash >> 32), vertexIndex };
+		}
+
+	public:
+		// Vertices already in outVertices are not considered for welding, New vertices gets appended to it
+		VertexWelder(std::vector<VertexType>& outVertices, size_t expectedIndexCount) : vertices(outVertices)
+		{
+			table.assign(getCapacityFor(expectedIndexCount), { 0, EMPTY_SLOT });
+			tableMask = table.size() - 1;
+			vertices.reserve(vertices.size() + expectedIndexCount);
+		}
+
+		uint32_t weld(const VertexType& vertex)
+		{
+			return weld(vertex, hashVertex(vertex));
+		}
+
+		// Hash of vertex after signed zeros are canonicalized, Precomputed hashes passed to weld must come from here
+		static uint64_t hashVertex(const VertexType& vertex)
+		{
+			return ContentHash::hashValue(canonicalize(vertex));
+		}
+
+		// Returns index of vertex in vertices, Adding it if not already present
+		uint32_t weld(const VertexType& inputVertex, uint64_t hash)
+		{
+			const VertexType vertex = canonicalize(inputVertex);
+			uint32_t hashTag = (uint32_t)(hash >> 32);
+			size_t slotIdx = (size_t)hash & tableMask;
+
+			while (true)
+			{
+				Slot& slot = table[slotIdx];
+				if (slot.vertexIndex == EMPTY_SLOT)
+				{
+					break;
+				}
+				if (slot.hashTag == hashTag && memcmp(&vertices[slot.vertexIndex], &vertex, sizeof(VertexType)) == 0)
+				{
+					return slot.vertexIndex;
+				}
+				slotIdx = (slotIdx + 1) & tableMask;
+			}
+
+			uint32_t vertexIndex = (uint32_t)vertices.size();
+			vertices.push_back(vertex);
+			table[slotIdx] = { hashTag, vertexIndex };
+
+			if (++usedSlots * 4 > table.size() * 3)
+			{
+				grow();
+			}
+			return vertexIndex;
+		}
+
+		// Welds unwelded triangle list stream appending unique vertices and an index per input vertex
+		// threadCount of 0 picks serial or sharded parallel welding based on size of stream
+		static void weldStream(const std::vector<VertexType>& unwelded, std::vector<VertexType>& outVertices, std::vector<uint32_t>& outIndices,
+			uint32_t threadCount = 0)
+		{
+			if (threadCount == 0)
+			{
+				threadCount = unwelded.size() >= PARALLEL_WELD_THRESHOLD ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+			}
+
+			if (threadCount <= 1)
+			{
+				VertexWelder welder(outVertices, unwelded.size());
+				outIndices.reserve(outIndices.size() + unwelded.size());
+				for (const VertexType& vertex : unwelded)
+				{
+					outIndices.push_back(welder.weld(vertex));
+				}
+				return;
+			}
+
+			weldStreamSharded(unwelded, outVertices, outIndices, threadCount);
+		}
+
+		// Vertices are partitioned into shards by hash, Each shard is welded independently so no synchronization is needed.
+		// Output vertices are grouped by shard, order within a shard follows first occurrence in stream
+		static void weldStreamSharded(const std::vector<VertexType>& unwelded, std::vector<VertexType>& outVertices, std::vector<uint32_t>& outIndices,
+			uint32_t threadCount)
+		{
+			const size_t count = unwelded.size();
+			const uint32_t shardBits = 6;
+			const uint32_t shardCount = 1 << shardBits;
+
+			std::vector<uint64_t> hashes(count);
+			std::vector<std::vector<uint32_t>> chunkShardCounts(threadCount, std::vector<uint32_t>(shardCount, 0));
+
+			auto runParallel = [threadCount](auto&& function)
+			{
+				std::vector<std::thread> workers;
+				workers.reserve(threadCount);
+				for (uint32_t t = 0; t < threadCount; t++)
+				{
+					workers.emplace_back(function, t);
+				}
+				for (std::thread& worker : workers)
+				{
+					worker.join();
+				}
+			};
+
+			auto chunkBegin = [count, threadCount](uint32_t chunk) { return count * chunk / threadCount; };
+
+			// Hashing and counting per shard in each chunk
+			runParallel([&](uint32_t chunk)
+			{
+				std::vector<uint32_t>& shardCounts = chunkShardCounts[chunk];
+				for (size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++)
+				{
+					hashes[i] = hashVertex(unwelded[i]);
+					shardCounts[hashes[i] >> (64 - shardBits)]++;
+				}
+			});
+
+			// Stable scatter of stream indices into their shards
+			std::vector<uint32_t> shardStart(shardCount + 1, 0);
+			std::vector<std::vector<uint32_t>> chunkShardOffsets(threadCount, std::vector<uint32_t>(shardCount, 0));
+			{
+				uint32_t offset = 0;
+				for (uint32_t shard = 0; shard < shardCount; shard++)
+				{
+					shardStart[shard] = offset;
+					for (uint32_t chunk = 0; chunk < threadCount; chunk++)
+					{
+						chunkShardOffsets[chunk][shard] = offset;
+						offset += chunkShardCounts[chunk][shard];
+					}
+				}
+				shardStart[shardCount] = offset;
+			}
+
+			std::vector<uint32_t> shardedStream(count);
+			runParallel([&](uint32_t chunk)
+			{
+				std::vector<uint32_t>& offsets = chunkShardOffsets[chunk];
+				for (size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++)
+				{
+					shardedStream[offsets[hashes[i] >> (64 - shardBits)]++] = (uint32_t)i;
+				}
+			});
+
+			// Welding each shard, Indices are shard local until shard bases are known
+			std::vector<std::vector<VertexType>> shardVertices(shardCount);
+			std::vector<uint32_t> localIndices(count);
+			runParallel([&](uint32_t worker)
+			{
+				for (uint32_t shard = worker; shard < shardCount; shard += threadCount)
+				{
+					VertexWelder welder(shardVertices[shard], shardStart[shard + 1] - shardStart[shard]);
+					for (uint32_t i = shardStart[shard]; i < shardStart[shard + 1]; i++)
+					{
+						uint32_t streamIdx = shardedStream[i];
+						localIndices[streamIdx] = welder.weld(unwelded[streamIdx], hashes[streamIdx]);
+					}
+				}
+			});
+
+			std::vector<uint32_t> shardVertexBase(shardCount);
+			uint32_t vertexBase = (uint32_t)outVertices.size();
+			for (uint32_t shard = 0; shard < shardCount; shard++)
+			{
+				shardVertexBase[shard] = vertexBase;
+				vertexBase += (uint32_t)shardVertices[shard].size();
+			}
+
+			outVertices.resize(vertexBase);
+			size_t indexBase = outIndices.size();
+			outIndices.resize(indexBase + count);
+
+			runParallel([&](uint32_t worker)
+			{
+				for (uint32_t shard = worker; shard < shardCount; shard += threadCount)
+				{
+					std::copy(shardVertices[shard].begin(), shardVertices[shard].end(), outVertices.begin() + shardVertexBase[shard]);
+					for (uint32_t i = shardStart[shard]; i < shardStart[shard + 1]; i++)
+					{
+						uint32_t streamIdx = shardedStream[i];
+						outIndices[indexBase + streamIdx] = shardVertexBase[shard] + localIndices[streamIdx];
+					}
+				}
+			});
+		}
+	};
+}
@@ -3,3 +3,14 @@
 PFN_vkCreateDebugUtilsMessengerEXT vulkan::VulkanTypes::fnVkCreateDebugUtilsMessengerExt;
 
 PFN_vkDestroyDebugUtilsMessengerEXT vulkan::VulkanTypes::fnVkDestroyDebugUtilsMessengerExt;
+
+PFN_vkGetPhysicalDeviceFeatures2KHR vulkan::VulkanTypes::fnVkGetPhysicalDeviceFeatures2Khr;
+
+PFN_vkGetPastPresentationTimingGOOGLE vulkan::VulkanTypes::fnVkGetPastPresentationTimingGoogle;
+PFN_vkGetRefreshCycleDurationGOOGLE vulkan::VulkanTypes::fnVkGetRefreshCycleDurationGoogle;
+
+PFN_vkWaitSemaphoresKHR vulkan::VulkanTypes::fnVkWaitSemaphoresKhr;
+
+PFN_vkGetSemaphoreCounterValueKHR vulkan::VulkanTypes::fnVkGetSemaphoreCounterValueKhr;
+
+PFN_vkWaitForPresentKHR vulkan::VulkanTypes::fnVkWaitForPresentKhr;
@@ -8,6 +8,8 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include "glm/gtx/hash.hpp"
 
+#include "MeshCache.h"
+
 namespace vulkan
 {
 	class VulkanTypes
@@ -25,6 +27,34 @@ namespace vulkan
 				"vkCreateDebugUtilsMessengerEXT"); 
 			fnVkDestroyDebugUtilsMessengerExt = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(vkInstance,
 				"vkDestroyDebugUtilsMessengerEXT");
+			fnVkGetPhysicalDeviceFeatures2Khr = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(vkInstance,
+				"vkGetPhysicalDeviceFeatures2KHR");
+		}
+
+		// Extension features of physical device, Null when instance does not have VK_KHR_get_physical_device_properties2 enabled
+		static PFN_vkGetPhysicalDeviceFeatures2KHR fnVkGetPhysicalDeviceFeatures2Khr;
+
+		// Past presentation timings of VK_GOOGLE_display_timing, Null when device does not have the extension enabled
+		static PFN_vkGetPastPresentationTimingGOOGLE fnVkGetPastPresentationTimingGoogle;
+		static PFN_vkGetRefreshCycleDurationGOOGLE fnVkGetRefreshCycleDurationGoogle;
+
+		// Timeline semaphore waits and counter queries of VK_KHR_timeline_semaphore, Null when device does not have the extension enabled
+		static PFN_vkWaitSemaphoresKHR fnVkWaitSemaphoresKhr;
+		static PFN_vkGetSemaphoreCounterValueKHR fnVkGetSemaphoreCounterValueKhr;
+		// Waits until present of given VK_KHR_present_id is on screen, Null when device does not have VK_KHR_present_wait enabled
+		static PFN_vkWaitForPresentKHR fnVkWaitForPresentKhr;
+
+		static void setupDeviceApi(VkDevice vkDevice, bool bHasDisplayTiming, bool bHasTimelineSemaphores, bool bHasPresentWait)
+		{
+			fnVkGetPastPresentationTimingGoogle = bHasDisplayTiming ? (PFN_vkGetPastPresentationTimingGOOGLE)vkGetDeviceProcAddr(vkDevice,
+				"vkGetPastPresentationTimingGOOGLE") : nullptr;
+			fnVkGetRefreshCycleDurationGoogle = bHasDisplayTiming ? (PFN_vkGetRefreshCycleDurationGOOGLE)vkGetDeviceProcAddr(vkDevice,
+				"vkGetRefreshCycleDurationGOOGLE") : nullptr;
+			fnVkWaitSemaphoresKhr = bHasTimelineSemaphores ? (PFN_vkWaitSemaphoresKHR)vkGetDeviceProcAddr(vkDevice,
+				"vkWaitSemaphoresKHR") : nullptr;
+			fnVkGetSemaphoreCounterValueKhr = bHasTimelineSemaphores ? (PFN_vkGetSemaphoreCounterValueKHR)vkGetDeviceProcAddr(vkDevice,
+				"vkGetSemaphoreCounterValueKHR") : nullptr;
+			fnVkWaitForPresentKhr = bHasPresentWait ? (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(vkDevice, "vkWaitForPresentKHR") : nullptr;
 		}
 	};
 	
@@ -69,21 +99,55 @@ namespace vulkan
 			return surfaceFormats[0];
 		}
 
-		VkPresentModeKHR choosePresentMode()
+		// First of preferred modes surface supports, FIFO is always available
+		VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR>& preferredModes)
 		{
-			VkPresentModeKHR bestMode = VK_PRESENT_MODE_FIFO_KHR;
-
-			for (VkPresentModeKHR &presentMode : presentModes)
+			for (VkPresentModeKHR preferredMode : preferredModes)
 			{
-				if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+				for (VkPresentModeKHR &presentMode : presentModes)
 				{
-					return presentMode;
+					if (presentMode == preferredMode)
+					{
+						return presentMode;
+					}
 				}
-				else if (presentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-					bestMode = presentMode;
 			}
 
-			return bestMode;
+			return VK_PRESENT_MODE_FIFO_KHR;
+		}
+	};
+
+	enum class VertexLayout : uint32_t
+	{
+		// Vertex as it is
+		Full = 0,
+		// CompactVertex
+		Compact = 1
+	};
+
+	// Quantized vertex, Position is normalized against mesh bounds and UV has to be in 0 to 1 range
+	// Position gets dequantized by model transform and there is no color stream
+	struct CompactVertex
+	{
+		uint16_t position[4];
+		uint16_t textureCoord[2];
+
+		static uint16_t quantizeUnorm(float value)
+		{
+			float clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+			return (uint16_t)(clamped * 65535.0f + 0.5f);
+		}
+
+		static CompactVertex quantize(const glm::vec3& position, const glm::vec2& textureCoord, const glm::vec3& boundsMin, const glm::vec3& boundsExtent)
+		{
+			CompactVertex compactVertex = {};
+			for (int axis = 0; axis < 3; axis++)
+			{
+				compactVertex.position[axis] = quantizeUnorm(boundsExtent[axis] > 0 ? (position[axis] - boundsMin[axis]) / boundsExtent[axis] : 0);
+			}
+			compactVertex.textureCoord[0] = quantizeUnorm(textureCoord.x);
+			compactVertex.textureCoord[1] = quantizeUnorm(textureCoord.y);
+			return compactVertex;
 		}
 	};
 
@@ -93,19 +157,39 @@ namespace vulkan
 		glm::vec3 color = {1.0f,1.0f,1.0f};
 		glm::vec2 textureCoord;
 
-		static VkVertexInputBindingDescription getBindingDesc()
+		static VkVertexInputBindingDescription getBindingDesc(VertexLayout layout = VertexLayout::Full)
 		{
 			VkVertexInputBindingDescription bindingDesc = {};
 			bindingDesc.binding = 0;
-			bindingDesc.stride = sizeof(Vertex);
+			bindingDesc.stride = layout == VertexLayout::Compact ? sizeof(CompactVertex) : sizeof(Vertex);
 			bindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
 			return bindingDesc;
 		}
 
-		static std::array<VkVertexInputAttributeDescription, 3> getAttributeDesc()
+		// Locations stays same for all layouts, Compact layout has no color at location 1
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDesc(VertexLayout layout = VertexLayout::Full)
 		{
-			std::array<VkVertexInputAttributeDescription, 3> attributeDesc={};
+			std::vector<VkVertexInputAttributeDescription> attributeDesc;
+
+			if (layout == VertexLayout::Compact)
+			{
+				attributeDesc.resize(2);
+
+				attributeDesc[0].binding = 0;
+				attributeDesc[0].location = 0;
+				attributeDesc[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+				attributeDesc[0].offset = offsetof(CompactVertex, position);
+
+				attributeDesc[1].binding = 0;
+				attributeDesc[1].location = 2;
+				attributeDesc[1].format = VK_FORMAT_R16G16_UNORM;
+				attributeDesc[1].offset = offsetof(CompactVertex, textureCoord);
+
+				return attributeDesc;
+			}
+
+			attributeDesc.resize(3);
 
 			attributeDesc[0].binding = 0;
 			attributeDesc[0].location = 0;
@@ -143,6 +227,70 @@ namespace vulkan
 		glm::mat4 projectionTransforms[2];
 		float distortionAlpha = 0.8f;
 		float timeSinceStart;
+		// Frustum enclosing both eyes in world space for instance culling, Aligned to match std140 array offset
+		alignas(16) glm::vec4 cullingPlanes[6];
+	};
+
+	// Push constants of instance culling compute shader cull.comp.glsl, Placed after SurfaceParameters at OFFSET so that ranges of both never overlap
+	struct CullParameters
+	{
+		static const uint32_t OFFSET = 32;
+
+		// Bounding sphere of mesh in vertex space, xyz is center and w is radius
+		glm::vec4 boundingSphere;
+		uint32_t instanceCount;
+		uint32_t lodCount;
+		// Eye image pixels per unit of normalized device coordinates
+		float pixelsPerNdc;
+		// Coarsest detail level whose error stays below this many pixels after lens distortion gets drawn
+		float lodErrorThreshold;
+		// Simplification error of every detail level in vertex space
+		float lodErrors[MAX_MESH_LOD_COUNT];
+	};
+
+	// Uniforms of distortion pass frame.frag.glsl, Kept apart from ProjectionData so that they are written right before distortion pass
+	// gets submitted instead of before eye pass
+	struct DistortionData
+	{
+		// Maps undistorted coordinates of each eye at latest pose into eye image rendered with an older one
+		glm::mat4 timewarpTransforms[2];
+		float distortionAlpha;
+		// First layer of eye image copy to sample
+		float eyeLayerOffset;
+		// Part of eye image width and height eye pass rendered into
+		float eyeImageScale;
+		// Latest input and pose samples frame shows, Not read by shader but travel with uniforms so that captures can be matched to samples
+		uint32_t inputSampleId;
+		uint32_t poseSampleId;
+	};
+
+	enum class SurfaceType : uint32_t
+	{
+		Cylinder = 0,
+		Sphere = 1,
+		Plane = 2
+	};
+
+	// Projection surface generated from vertex index in surface.vert.glsl, Layout matches push constant block of it
+	struct SurfaceParameters
+	{
+		uint32_t surfaceType = (uint32_t)SurfaceType::Cylinder;
+		uint32_t slices = 45;
+		uint32_t stacks = 1;
+		// Horizontal span in degrees
+		float angle = 180;
+		float radius = 300;
+		// Height of cylinder and plane
+		float height = 600;
+		// Vertical span of sphere in degrees
+		float verticalAngle = 90;
+
+		// Grid of 2 triangles per slice and stack, Cylinder also has top and bottom cap triangle per slice
+		uint32_t getVertexCount() const
+		{
+			uint32_t gridVertexCount = slices * stacks * 6;
+			return surfaceType == (uint32_t)SurfaceType::Cylinder ? gridVertexCount + slices * 6 : gridVertexCount;
+		}
 	};
 }
 